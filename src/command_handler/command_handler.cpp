@@ -4,7 +4,13 @@
  * Github: https://github.com/VishankSingh
  */
 #include "command_handler.h"
+#include "assembler/assembler.h"
+#include "processor/branch_prediction/predictor_comparison.h"
+#include "processor/cache/cache_sweep.h"
+#include "processor/cache/stack_distance.h"
+#include "processor/cache/trace_replay.h"
 
+#include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -28,7 +34,7 @@ Command ParseCommand(const std::string &input)
     {
         command_type = command_handler::CommandType::LOAD;
     }
-    else if (command_str == "run")
+    else if (command_str == "run" || command_str == "run_fast" || command_str == "rf")
     {
         command_type = command_handler::CommandType::RUN;
     }
@@ -52,6 +58,18 @@ Command ParseCommand(const std::string &input)
     {
         command_type = command_handler::CommandType::REDO;
     }
+    else if (command_str == "reverse_step" || command_str == "rs")
+    {
+        command_type = command_handler::CommandType::REVERSE_STEP;
+    }
+    else if (command_str == "reverse_continue" || command_str == "rc")
+    {
+        command_type = command_handler::CommandType::REVERSE_CONTINUE;
+    }
+    else if (command_str == "goto_cycle" || command_str == "gc")
+    {
+        command_type = command_handler::CommandType::GOTO_CYCLE;
+    }
     else if (command_str == "reset")
     {
         command_type = command_handler::CommandType::RESET;
@@ -76,6 +94,30 @@ Command ParseCommand(const std::string &input)
     {
         command_type = command_handler::CommandType::DUMP_CACHE;
     }
+    else if (command_str == "trace_start")
+    {
+        command_type = command_handler::CommandType::TRACE_START;
+    }
+    else if (command_str == "trace_stop")
+    {
+        command_type = command_handler::CommandType::TRACE_STOP;
+    }
+    else if (command_str == "trace_replay")
+    {
+        command_type = command_handler::CommandType::TRACE_REPLAY;
+    }
+    else if (command_str == "trace_sweep")
+    {
+        command_type = command_handler::CommandType::TRACE_SWEEP;
+    }
+    else if (command_str == "trace_mrc")
+    {
+        command_type = command_handler::CommandType::TRACE_MISS_RATIO_CURVE;
+    }
+    else if (command_str == "branch_sweep")
+    {
+        command_type = command_handler::CommandType::BRANCH_SWEEP;
+    }
     else if (command_str == "add_breakpoint")
     {
         command_type = command_handler::CommandType::ADD_BREAKPOINT;
@@ -134,13 +176,235 @@ Command ParseCommand(const std::string &input)
         args.push_back(current_arg.str());
     }
 
+    if (command_str == "run_fast" || command_str == "rf")
+    {
+        args.insert(args.begin(), "fast");
+    }
+
     return Command(command_type, args);
 }
 
+namespace
+{
+void PrintReplayStats(const char *name, const CacheStats &stats)
+{
+    std::cout << name << " hits=" << stats.hitCount << " misses=" << stats.missCount
+              << " write_backs=" << stats.writeBackCount << " hit_rate=" << stats.hitRate
+              << std::endl;
+}
+
+// replays a trace through caches configured like the vm's, so a trace can be tried against the
+// current cache tab settings without running the program again
+CacheHierarchyConfig CurrentHierarchy(RVSSProcessor &vm)
+{
+    MemoryController &memory = vm.memory_controller_;
+    return CacheHierarchyConfig{
+        .l1 = memory.getL1Cache()->getConfig(),
+        .instruction = memory.getInstructionCache()->getConfig(),
+        .l2 = memory.getL2Cache()->getConfig(),
+        .customPolicyScriptPath = memory.getL1Cache()->getCustomPolicyScriptPath()};
+}
+
+void ReplayTrace(const std::string &path, RVSSProcessor &vm)
+{
+    const TraceReplayResult result = replayTrace(AddressTrace::load(path), CurrentHierarchy(vm));
+    std::cout << "VM_TRACE_REPLAY accesses=" << result.accesses << " seconds=" << result.seconds
+              << std::endl;
+    PrintReplayStats("L1", result.l1);
+    PrintReplayStats("I", result.instruction);
+    PrintReplayStats("L2", result.l2);
+}
+std::vector<size_t> ParseSizeList(const std::string &list)
+{
+    std::vector<size_t> values;
+    std::istringstream iss(list);
+    std::string value;
+    while (std::getline(iss, value, ','))
+    {
+        values.push_back(std::stoull(value));
+    }
+    return values;
+}
+
+// trace_sweep <trace> <sets> <ways> <line sizes> [threads], each a comma separated list; the l1
+// data cache is swept over these and every write, allocation and built-in replacement policy
+void SweepTrace(const std::vector<std::string> &args, RVSSProcessor &vm)
+{
+    CacheSweepSpace space;
+    space.setCounts = ParseSizeList(args[1]);
+    space.wayCounts = ParseSizeList(args[2]);
+    space.lineSizes = ParseSizeList(args[3]);
+    space.writePolicies = {WritePolicy::WriteThrough, WritePolicy::WriteBack};
+    space.allocationPolicies = {AllocationPolicy::WriteAllocate, AllocationPolicy::NoWriteAllocate};
+    space.replacementPolicies = {ReplacementPolicy::LRU,      ReplacementPolicy::FIFO,
+                                 ReplacementPolicy::TreePLRU, ReplacementPolicy::BitPLRU,
+                                 ReplacementPolicy::SRRIP,    ReplacementPolicy::BRRIP,
+                                 ReplacementPolicy::DRRIP,    ReplacementPolicy::LFU,
+                                 ReplacementPolicy::Random};
+    const unsigned int threads = args.size() > 4 ? std::stoul(args[4]) : 0;
+
+    const AddressTrace trace = AddressTrace::load(args[0]);
+    const std::vector<CacheSweepResult> results = runCacheSweep(
+        trace, enumerateSweep(space, CurrentHierarchy(vm)), space.level, {}, threads);
+    std::cout << "VM_TRACE_SWEEP_START" << std::endl;
+    std::cout << formatSweepTable(results);
+    std::cout << "VM_TRACE_SWEEP_END" << std::endl;
+}
+void PrintMissRatioCurve(const std::vector<MissRatioPoint> &curve)
+{
+    for (const MissRatioPoint &point : curve)
+    {
+        std::cout << point.setCount << " " << point.wayCount << " " << point.capacityInBytes << " "
+                  << point.hitCount << " " << point.missCount << " " << point.missRate << std::endl;
+    }
+}
+
+// trace_mrc <trace> [data|instruction|all]: LRU miss ratio curves at the line size and
+// associativity of the matching cache (l2 for all), fully associative first
+void MissRatioCurve(const std::vector<std::string> &args, RVSSProcessor &vm)
+{
+    const std::string stream_name = args.size() > 1 ? args[1] : "data";
+    TraceStream stream = TraceStream::DATA;
+    Cache *cache = vm.memory_controller_.getL1Cache();
+    if (stream_name == "instruction")
+    {
+        stream = TraceStream::INSTRUCTION;
+        cache = vm.memory_controller_.getInstructionCache();
+    }
+    else if (stream_name == "all")
+    {
+        stream = TraceStream::ALL;
+        cache = vm.memory_controller_.getL2Cache();
+    }
+
+    const std::vector<StackDistanceAnalyzer> analyzers = analyzeStackDistances(
+        AddressTrace::load(args[0]), stream, {cache->getLineSizeInBytes()});
+    const StackDistanceAnalyzer &analyzer = analyzers.front();
+    std::cout << "VM_TRACE_MRC_START accesses=" << analyzer.getAccessCount()
+              << " cold_misses=" << analyzer.getColdMissCount() << std::endl;
+    std::cout << "sets ways bytes hits misses miss_rate" << std::endl;
+    PrintMissRatioCurve(analyzer.fullyAssociativeCurve());
+    if (cache->getWayCount() <= StackDistanceAnalyzer::DEFAULT_MAX_WAYS)
+    {
+        PrintMissRatioCurve(analyzer.setAssociativeCurve(cache->getWayCount()));
+    }
+    std::cout << "VM_TRACE_MRC_END" << std::endl;
+}
+
+// branch_sweep <program> [predictors]: runs the program on the hazard detecting, forwarding
+// pipeline under each predictor in the comma separated list, all of them by default
+void SweepBranchPredictors(const std::vector<std::string> &args)
+{
+    std::vector<vm_config::BranchPredictorType> types;
+    if (args.size() > 1)
+    {
+        std::istringstream iss(args[1]);
+        std::string name;
+        while (std::getline(iss, name, ','))
+        {
+            types.push_back(vm_config::parseBranchPredictorType(name));
+        }
+    }
+    else
+    {
+        types = {vm_config::BranchPredictorType::NOT_TAKEN, vm_config::BranchPredictorType::BTFN,
+                 vm_config::BranchPredictorType::ONE_BIT,   vm_config::BranchPredictorType::TWO_BIT,
+                 vm_config::BranchPredictorType::GSHARE,
+                 vm_config::BranchPredictorType::TOURNAMENT,
+                 vm_config::BranchPredictorType::TAGE};
+    }
+
+    const std::vector<BranchPredictorResult> results = compareBranchPredictors(
+        assemble(args[0]), types, vm_config::config.getBranchPredictor());
+    std::cout << "VM_BRANCH_SWEEP_START" << std::endl;
+    std::cout << formatPredictorTable(results);
+    std::cout << "VM_BRANCH_SWEEP_END" << std::endl;
+}
+} // namespace
+
 void ExecuteCommand(const Command &command, RVSSProcessor &vm)
 {
-    (void)vm;
-    (void)command;
+    switch (command.type)
+    {
+    case CommandType::RUN:
+    {
+        // "run fast" skips the per-step dumps and console output
+        if (!command.args.empty() && command.args[0] == "fast")
+        {
+            vm.FastRun();
+        }
+        else
+        {
+            vm.Run();
+        }
+        break;
+    }
+    case CommandType::DEBUG_RUN:
+        vm.DebugRun();
+        break;
+    case CommandType::STEP:
+        vm.Step();
+        break;
+    case CommandType::UNDO:
+        vm.Undo();
+        break;
+    case CommandType::REDO:
+        vm.Redo();
+        break;
+    case CommandType::REVERSE_STEP:
+        vm.ReverseStep();
+        break;
+    case CommandType::REVERSE_CONTINUE:
+        vm.ReverseContinue();
+        break;
+    case CommandType::GOTO_CYCLE:
+        if (!command.args.empty())
+        {
+            vm.GoToCycle(std::stoull(command.args[0]));
+        }
+        break;
+    case CommandType::RESET:
+        vm.Reset();
+        break;
+    case CommandType::STOP:
+        vm.RequestStop();
+        break;
+    case CommandType::TRACE_START:
+        if (!command.args.empty())
+        {
+            vm.memory_controller_.startTrace(command.args[0]);
+        }
+        break;
+    case CommandType::TRACE_STOP:
+        std::cout << "VM_TRACE_STOPPED " << vm.memory_controller_.stopTrace() << std::endl;
+        break;
+    case CommandType::TRACE_REPLAY:
+        if (!command.args.empty())
+        {
+            ReplayTrace(command.args[0], vm);
+        }
+        break;
+    case CommandType::TRACE_SWEEP:
+        if (command.args.size() >= 4)
+        {
+            SweepTrace(command.args, vm);
+        }
+        break;
+    case CommandType::TRACE_MISS_RATIO_CURVE:
+        if (!command.args.empty())
+        {
+            MissRatioCurve(command.args, vm);
+        }
+        break;
+    case CommandType::BRANCH_SWEEP:
+        if (!command.args.empty())
+        {
+            SweepBranchPredictors(command.args);
+        }
+        break;
+    default:
+        break;
+    }
 }
 
 } // namespace command_handler
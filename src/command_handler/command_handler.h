@@ -25,12 +25,21 @@ enum class CommandType
     STEP,
     UNDO,
     REDO,
+    REVERSE_STEP,
+    REVERSE_CONTINUE,
+    GOTO_CYCLE,
     RESET,
     MODIFY_REGISTER,
     DUMP_MEMORY,
     PRINT_MEMORY,
     GET_MEMORY_POINT,
     DUMP_CACHE,
+    TRACE_START,
+    TRACE_STOP,
+    TRACE_REPLAY,
+    TRACE_SWEEP,
+    TRACE_MISS_RATIO_CURVE,
+    BRANCH_SWEEP,
     ADD_BREAKPOINT,
     REMOVE_BREAKPOINT,
     VM_STDIN,
@@ -1,4 +1,12 @@
 #pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
 namespace Kites
 {
 template <typename T>
@@ -6,7 +14,7 @@ class UndoBuffer
 {
 public:
     UndoBuffer(size_t capacity)
-    :m_oldest(0), m_size(0)
+    :m_capacity(capacity), m_oldest(0), m_size(0), m_current(0)
     {
         m_data.reserve(capacity);
     }
@@ -14,11 +22,13 @@ public:
     void setCapacity(size_t capacity)
     {
         clear();
+        m_data.clear();
         m_data.reserve(capacity);
+        m_capacity = capacity;
     }
     [[nodiscard]] size_t capacity() const
     {
-        return m_data.size();
+        return m_capacity;
     }
 
     void clear()
@@ -46,23 +56,7 @@ public:
 
     void push(const T& value)
     {
-        assert(capacity() > 0);
-        if(m_current + 1 < m_size)
-        {
-            m_size = m_current + 1;
-        }
-
-        if(m_size < capacity())
-        {
-            m_data[physicalIndex(m_size)] = value;
-            ++m_size;
-        }
-        else
-        {
-            m_data[m_oldest] = value;
-            m_oldest = (m_oldest + 1) % m_data.size();
-        }
-        m_current = m_size - 1;
+        push(T(value));
     }
 
     void push(T&& value)
@@ -75,13 +69,13 @@ public:
 
         if(m_size < capacity())
         {
-            m_data[physicalIndex(m_size)] = std::move(value);
+            store(physicalIndex(m_size), std::move(value));
             ++m_size;
         }
         else
         {
             m_data[m_oldest] = std::move(value);
-            m_oldest = (m_oldest + 1) % m_data.size();
+            m_oldest = (m_oldest + 1) % m_capacity;
         }
         m_current = m_size - 1;
     }
@@ -109,9 +103,22 @@ private:
 
     size_t physicalIndex(size_t logicalIndex) const
     {
-        return (m_oldest + logicalIndex) % m_data.size();
+        return (m_oldest + logicalIndex) % m_capacity;
+    }
+    // slots are only constructed the first time they are used, T need not be default constructible
+    void store(size_t slot, T&& value)
+    {
+        if(slot < m_data.size())
+        {
+            m_data[slot] = std::move(value);
+        }
+        else
+        {
+            m_data.push_back(std::move(value));
+        }
     }
     std::vector<T> m_data;
+    size_t m_capacity;
     size_t m_oldest;
     size_t m_size;
     size_t m_current;
@@ -13,6 +13,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 namespace Kites
 {
@@ -28,15 +29,108 @@ enum class VmTypes
     MULTI_STAGE
 };
 
+enum class MemoryBackend
+{
+    SPARSE, // page table only
+    MAPPED  // text, data and stack windows in lazily populated host mappings, page table elsewhere
+};
+
+/**
+ * @brief Latencies, in cycles, and limits of the memory hierarchy as the pipelined processors
+ * see it, see processor/memory_timing.h. Off by default, memory then takes a single cycle.
+ */
+struct MemoryTimingConfig
+{
+    bool enabled = false;
+    uint64_t l1_hit_latency = 1;
+    uint64_t instruction_hit_latency = 1;
+    uint64_t l2_hit_latency = 10;     // on top of the l1 lookup
+    uint64_t memory_latency = 100;    // on top of the l2 lookup
+    uint64_t memory_bandwidth = 8;    // bytes per cycle between l2 and main memory
+    uint64_t mshr_count = 4;          // misses the l1 caches can have outstanding
+};
+
+enum class BranchPredictorType
+{
+    NOT_TAKEN, // no predictor: fetch runs on sequentially and every taken branch or jump redirects
+    BTFN,      // backward taken, forward not taken
+    ONE_BIT,
+    TWO_BIT,
+    GSHARE,
+    TOURNAMENT,
+    TAGE
+};
+
+/**
+ * @brief The branch prediction unit of the pipelined processors, see
+ * processor/branch_prediction/branch_prediction_unit.h. Picked up on reset.
+ */
+struct BranchPredictorConfig
+{
+    BranchPredictorType type = BranchPredictorType::NOT_TAKEN;
+    uint64_t table_bits = 10;   // log2 of the counters in each pattern table
+    uint64_t history_bits = 10; // global history bits gshare and the tournament chooser use
+    uint64_t btb_entries = 64;  // direct mapped branch target buffer
+    uint64_t ras_entries = 8;   // return address stack
+};
+
+/**
+ * @brief Cycles the instructions of each functional unit of the pipelined processors spend in
+ * EX, see processor/rv5s/rv5s_functional_units.h. Picked up on reset. A single cycle each by
+ * default.
+ */
+struct FunctionalUnitConfig
+{
+    uint64_t fp_add_latency = 1;  // fadd, fsub and conversions, pipelined
+    uint64_t fp_mul_latency = 1;  // pipelined
+    uint64_t fp_fma_latency = 1;  // fused multiply-adds, pipelined
+    uint64_t fp_div_latency = 1;  // not pipelined, the divider also does fsqrt
+    uint64_t fp_sqrt_latency = 1;
+    uint64_t int_mul_latency = 1; // mul, mulh and mulw
+    bool int_mul_pipelined = true;
+    uint64_t int_div_latency = 1; // div, rem and their unsigned and word forms
+    bool int_div_pipelined = false;
+};
+
+inline BranchPredictorType parseBranchPredictorType(const std::string &name)
+{
+    static const std::pair<const char *, BranchPredictorType> names[] = {
+        {"not_taken", BranchPredictorType::NOT_TAKEN},
+        {"btfn", BranchPredictorType::BTFN},
+        {"one_bit", BranchPredictorType::ONE_BIT},
+        {"two_bit", BranchPredictorType::TWO_BIT},
+        {"gshare", BranchPredictorType::GSHARE},
+        {"tournament", BranchPredictorType::TOURNAMENT},
+        {"tage", BranchPredictorType::TAGE}};
+    for (const auto &[candidate, type] : names)
+    {
+        if (name == candidate)
+        {
+            return type;
+        }
+    }
+    throw std::invalid_argument("Unknown branch predictor: " + name);
+}
+
 struct VmConfig
 {
     VmTypes vm_type = VmTypes::SINGLE_STAGE;
     uint64_t run_step_delay = 300;
     uint64_t memory_size = 0xffffffffffffffff; // 64-bit address space
-    uint64_t memory_block_size = 1024;         // 1 KB blocks
     uint64_t data_section_start = 0x10000000;  // Default start address for data section
     uint64_t text_section_start = 0x0;         // Default start address for text section
     uint64_t bss_section_start = 0x11000000;   // Default start address for BSS section
+    MemoryBackend memory_backend = MemoryBackend::SPARSE; // MAPPED is opt-in, memory_backend=mmap
+    uint64_t data_window_size = 0x10000000;    // data, bss and heap window from data_section_start
+    uint64_t stack_window_size = 0x4000000;    // stack window ending at the top of the address space
+    uint64_t undo_history_depth = 100000;       // steps kept for undo
+    uint64_t undo_history_memory_cap = 16 * 1024 * 1024; // bytes of packed undo history
+    uint64_t checkpoint_interval = 100000;      // cycles between time-travel checkpoints
+    uint64_t checkpoint_max_count = 64;         // checkpoints kept before they are thinned out
+    MemoryTimingConfig memory_timing{};
+    BranchPredictorConfig branch_predictor{};
+    bool early_branch_resolution = false; // HF and HNF resolve branches and jumps in decode
+    FunctionalUnitConfig functional_units{};
 
     void setVmType(const VmTypes &type)
     {
@@ -64,14 +158,6 @@ struct VmConfig
     {
         return memory_size;
     }
-    void setMemoryBlockSize(uint64_t size)
-    {
-        memory_block_size = size;
-    }
-    uint64_t getMemoryBlockSize() const
-    {
-        return memory_block_size;
-    }
     void setDataSectionStart(uint64_t start)
     {
         data_section_start = start;
@@ -101,6 +187,116 @@ struct VmConfig
         return bss_section_start;
     }
 
+    void setMemoryBackend(MemoryBackend backend)
+    {
+        memory_backend = backend;
+    }
+
+    MemoryBackend getMemoryBackend() const
+    {
+        return memory_backend;
+    }
+
+    void setDataWindowSize(uint64_t size)
+    {
+        data_window_size = size;
+    }
+
+    uint64_t getDataWindowSize() const
+    {
+        return data_window_size;
+    }
+
+    void setStackWindowSize(uint64_t size)
+    {
+        stack_window_size = size;
+    }
+
+    uint64_t getStackWindowSize() const
+    {
+        return stack_window_size;
+    }
+
+    void setUndoHistoryDepth(uint64_t depth)
+    {
+        undo_history_depth = depth;
+    }
+
+    uint64_t getUndoHistoryDepth() const
+    {
+        return undo_history_depth;
+    }
+
+    void setUndoHistoryMemoryCap(uint64_t bytes)
+    {
+        undo_history_memory_cap = bytes;
+    }
+
+    uint64_t getUndoHistoryMemoryCap() const
+    {
+        return undo_history_memory_cap;
+    }
+
+    void setCheckpointInterval(uint64_t cycles)
+    {
+        checkpoint_interval = cycles;
+    }
+
+    uint64_t getCheckpointInterval() const
+    {
+        return checkpoint_interval;
+    }
+
+    void setCheckpointMaxCount(uint64_t count)
+    {
+        checkpoint_max_count = count;
+    }
+
+    uint64_t getCheckpointMaxCount() const
+    {
+        return checkpoint_max_count;
+    }
+
+    void setMemoryTiming(const MemoryTimingConfig &timing)
+    {
+        memory_timing = timing;
+    }
+
+    const MemoryTimingConfig &getMemoryTiming() const
+    {
+        return memory_timing;
+    }
+
+    void setBranchPredictor(const BranchPredictorConfig &predictor)
+    {
+        branch_predictor = predictor;
+    }
+
+    const BranchPredictorConfig &getBranchPredictor() const
+    {
+        return branch_predictor;
+    }
+
+    void setEarlyBranchResolution(bool early)
+    {
+        early_branch_resolution = early;
+    }
+
+    bool getEarlyBranchResolution() const
+    {
+        return early_branch_resolution;
+    }
+
+    void setFunctionalUnits(const FunctionalUnitConfig &units)
+    {
+        functional_units = units;
+    }
+
+    const FunctionalUnitConfig &getFunctionalUnits() const
+    {
+        return functional_units;
+    }
+
     void modifyConfig(const std::string &section, const std::string &key, const std::string &value)
     {
         if (section == "Execution")
@@ -124,6 +320,129 @@ struct VmConfig
             {
                 setRunStepDelay(std::stoull(value));
             }
+            else if (key == "undo_history_depth")
+            {
+                setUndoHistoryDepth(std::stoull(value));
+            }
+            else if (key == "undo_history_memory_cap")
+            {
+                setUndoHistoryMemoryCap(std::stoull(value));
+            }
+            else if (key == "checkpoint_interval")
+            {
+                setCheckpointInterval(std::stoull(value));
+            }
+            else if (key == "checkpoint_max_count")
+            {
+                setCheckpointMaxCount(std::stoull(value));
+            }
+            else if (key == "branch_predictor")
+            {
+                branch_predictor.type = parseBranchPredictorType(value);
+            }
+            else if (key == "branch_predictor_table_bits")
+            {
+                branch_predictor.table_bits = std::stoull(value);
+                if (branch_predictor.table_bits < 2 || branch_predictor.table_bits > 20)
+                {
+                    throw std::invalid_argument("Branch predictor table bits must be 2 to 20");
+                }
+            }
+            else if (key == "branch_history_bits")
+            {
+                branch_predictor.history_bits = std::stoull(value);
+                if (branch_predictor.history_bits > 64)
+                {
+                    throw std::invalid_argument("Branch history bits must be at most 64");
+                }
+            }
+            else if (key == "btb_entries")
+            {
+                branch_predictor.btb_entries = std::stoull(value);
+            }
+            else if (key == "ras_entries")
+            {
+                branch_predictor.ras_entries = std::stoull(value);
+            }
+            else if (key == "early_branch_resolution")
+            {
+                if (value == "on")
+                {
+                    setEarlyBranchResolution(true);
+                }
+                else if (value == "off")
+                {
+                    setEarlyBranchResolution(false);
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown early branch resolution setting: " +
+                                                value);
+                }
+            }
+            else if (key == "fp_add_latency" || key == "fp_mul_latency" ||
+                     key == "fp_fma_latency" || key == "fp_div_latency" ||
+                     key == "fp_sqrt_latency" || key == "int_mul_latency" ||
+                     key == "int_div_latency")
+            {
+                const uint64_t latency = std::stoull(value);
+                if (latency == 0)
+                {
+                    throw std::invalid_argument("Functional unit latencies must be at least 1");
+                }
+                if (key == "fp_add_latency")
+                {
+                    functional_units.fp_add_latency = latency;
+                }
+                else if (key == "fp_mul_latency")
+                {
+                    functional_units.fp_mul_latency = latency;
+                }
+                else if (key == "fp_fma_latency")
+                {
+                    functional_units.fp_fma_latency = latency;
+                }
+                else if (key == "fp_div_latency")
+                {
+                    functional_units.fp_div_latency = latency;
+                }
+                else if (key == "fp_sqrt_latency")
+                {
+                    functional_units.fp_sqrt_latency = latency;
+                }
+                else if (key == "int_mul_latency")
+                {
+                    functional_units.int_mul_latency = latency;
+                }
+                else
+                {
+                    functional_units.int_div_latency = latency;
+                }
+            }
+            else if (key == "int_mul_pipelined" || key == "int_div_pipelined")
+            {
+                bool pipelined;
+                if (value == "on")
+                {
+                    pipelined = true;
+                }
+                else if (value == "off")
+                {
+                    pipelined = false;
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown pipelining setting: " + value);
+                }
+                if (key == "int_mul_pipelined")
+                {
+                    functional_units.int_mul_pipelined = pipelined;
+                }
+                else
+                {
+                    functional_units.int_div_pipelined = pipelined;
+                }
+            }
             else
             {
                 throw std::invalid_argument("Unknown key: " + key);
@@ -135,10 +454,6 @@ struct VmConfig
             {
                 setMemorySize(std::stoull(value));
             }
-            else if (key == "memory_block_size")
-            {
-                setMemoryBlockSize(std::stoull(value));
-            }
             else if (key == "data_section_start")
             {
                 setDataSectionStart(std::stoull(value, nullptr, 16));
@@ -151,7 +466,68 @@ struct VmConfig
             {
                 setBssSectionStart(std::stoull(value, nullptr, 16));
             }
-
+            else if (key == "memory_backend")
+            {
+                if (value == "sparse")
+                {
+                    setMemoryBackend(MemoryBackend::SPARSE);
+                }
+                else if (value == "mmap")
+                {
+                    setMemoryBackend(MemoryBackend::MAPPED);
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown memory backend: " + value);
+                }
+            }
+            else if (key == "data_window_size")
+            {
+                setDataWindowSize(std::stoull(value, nullptr, 16));
+            }
+            else if (key == "stack_window_size")
+            {
+                setStackWindowSize(std::stoull(value, nullptr, 16));
+            }
+            else if (key == "memory_timing")
+            {
+                if (value == "on")
+                {
+                    memory_timing.enabled = true;
+                }
+                else if (value == "off")
+                {
+                    memory_timing.enabled = false;
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown memory timing setting: " + value);
+                }
+            }
+            else if (key == "l1_hit_latency")
+            {
+                memory_timing.l1_hit_latency = std::stoull(value);
+            }
+            else if (key == "instruction_hit_latency")
+            {
+                memory_timing.instruction_hit_latency = std::stoull(value);
+            }
+            else if (key == "l2_hit_latency")
+            {
+                memory_timing.l2_hit_latency = std::stoull(value);
+            }
+            else if (key == "memory_latency")
+            {
+                memory_timing.memory_latency = std::stoull(value);
+            }
+            else if (key == "memory_bandwidth")
+            {
+                memory_timing.memory_bandwidth = std::stoull(value);
+            }
+            else if (key == "mshr_count")
+            {
+                memory_timing.mshr_count = std::stoull(value);
+            }
             else
             {
                 throw std::invalid_argument("Unknown key: " + key);
@@ -0,0 +1,185 @@
+/**
+ * @file address_trace.cpp
+ * @brief Encoding and decoding of address traces.
+ */
+
+#include "processor/address_trace.h"
+
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace Kites
+{
+namespace
+{
+constexpr char TRACE_MAGIC[8] = {'K', 'I', 'T', 'E', 'S', 'T', 'R', 'C'};
+constexpr uint32_t TRACE_VERSION = 1;
+constexpr size_t TRACE_HEADER_SIZE = 16;
+constexpr size_t TRACE_BUFFER_SIZE = size_t{1} << 20;
+constexpr size_t MAX_RECORD_SIZE = 1 + 10 + 10; // tag and two 64-bit varints
+
+constexpr uint8_t TAG_ACCESS_MASK = 0x3;
+constexpr uint8_t TAG_SIZE_SHIFT = 2;
+constexpr uint8_t TAG_HAS_PC = 0x10;
+
+void putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putDelta(std::vector<uint8_t> &out, uint64_t value, uint64_t previous)
+{
+    const auto delta = static_cast<int64_t>(value - previous);
+    putVarint(out, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+}
+
+uint64_t getVarint(const uint8_t *&position, const uint8_t *end)
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (position == end)
+        {
+            break;
+        }
+        const uint8_t byte = *position++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+    throw std::runtime_error("Address trace is truncated or corrupt");
+}
+
+uint64_t getDelta(const uint8_t *&position, const uint8_t *end, uint64_t previous)
+{
+    const uint64_t zigzag = getVarint(position, end);
+    return previous + ((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
+} // namespace
+
+AddressTraceWriter::AddressTraceWriter(const std::string &path)
+    : out_(path, std::ios::binary | std::ios::trunc)
+{
+    if (!out_)
+    {
+        throw std::runtime_error("Could not open address trace for writing: " + path);
+    }
+    buffer_.reserve(TRACE_BUFFER_SIZE + MAX_RECORD_SIZE);
+    uint8_t header[TRACE_HEADER_SIZE] = {};
+    std::memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    std::memcpy(header + sizeof(TRACE_MAGIC), &TRACE_VERSION, sizeof(TRACE_VERSION));
+    buffer_.insert(buffer_.end(), std::begin(header), std::end(header));
+}
+
+AddressTraceWriter::~AddressTraceWriter()
+{
+    close();
+}
+
+void AddressTraceWriter::append(TraceAccess access, uint64_t address, uint8_t size, uint64_t pc)
+{
+    const bool fetch = access == TraceAccess::FETCH;
+    const bool has_pc = !fetch && pc != previous_pc_;
+    const auto size_log2 = static_cast<uint8_t>(std::countr_zero(static_cast<unsigned int>(size)));
+    buffer_.push_back(static_cast<uint8_t>(static_cast<uint8_t>(access) |
+                                           (size_log2 << TAG_SIZE_SHIFT) |
+                                           (has_pc ? TAG_HAS_PC : 0)));
+    putDelta(buffer_, address, previous_address_[fetch]);
+    previous_address_[fetch] = address;
+    if (has_pc)
+    {
+        putDelta(buffer_, pc, previous_pc_);
+    }
+    previous_pc_ = fetch ? address : pc;
+    ++record_count_;
+
+    if (buffer_.size() >= TRACE_BUFFER_SIZE)
+    {
+        flush();
+    }
+}
+
+void AddressTraceWriter::flush()
+{
+    out_.write(reinterpret_cast<const char *>(buffer_.data()),
+               static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void AddressTraceWriter::close()
+{
+    if (out_.is_open())
+    {
+        flush();
+        out_.close();
+    }
+}
+
+AddressTrace::AddressTrace(std::vector<uint8_t> bytes) : bytes_(std::move(bytes))
+{
+    uint32_t version = 0;
+    if (bytes_.size() >= TRACE_HEADER_SIZE)
+    {
+        std::memcpy(&version, bytes_.data() + sizeof(TRACE_MAGIC), sizeof(version));
+    }
+    if (bytes_.size() < TRACE_HEADER_SIZE ||
+        std::memcmp(bytes_.data(), TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        version != TRACE_VERSION)
+    {
+        throw std::runtime_error("Not a Kites address trace");
+    }
+}
+
+AddressTrace AddressTrace::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        throw std::runtime_error("Could not open address trace: " + path);
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return AddressTrace(std::move(bytes));
+}
+
+AddressTraceCursor::AddressTraceCursor(const AddressTrace &trace)
+    : position_(trace.bytes().data() + TRACE_HEADER_SIZE),
+      end_(trace.bytes().data() + trace.bytes().size())
+{
+}
+
+bool AddressTraceCursor::next(TraceRecord &record)
+{
+    if (position_ == end_)
+    {
+        return false;
+    }
+    const uint8_t tag = *position_++;
+    record.access = static_cast<TraceAccess>(tag & TAG_ACCESS_MASK);
+    record.size = static_cast<uint8_t>(1u << ((tag >> TAG_SIZE_SHIFT) & 0x3));
+
+    const bool fetch = record.access == TraceAccess::FETCH;
+    record.address = getDelta(position_, end_, previous_address_[fetch]);
+    previous_address_[fetch] = record.address;
+    if ((tag & TAG_HAS_PC) != 0)
+    {
+        previous_pc_ = getDelta(position_, end_, previous_pc_);
+    }
+    else if (fetch)
+    {
+        previous_pc_ = record.address;
+    }
+    record.pc = previous_pc_;
+    return true;
+}
+}//namespace Kites
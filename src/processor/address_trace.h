@@ -0,0 +1,117 @@
+/**
+ * @file address_trace.h
+ * @brief Compact binary recording of the memory accesses a program makes through the caches.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Kites
+{
+enum class TraceAccess : uint8_t
+{
+    LOAD,
+    STORE,
+    FETCH
+};
+
+struct TraceRecord
+{
+    uint64_t address = 0;
+    uint64_t pc = 0;   ///< instruction making the access; equal to address for a fetch
+    uint8_t size = 0;  ///< 1, 2, 4 or 8 bytes
+    TraceAccess access = TraceAccess::LOAD;
+};
+
+/**
+ * @brief Appends records to a trace file.
+ *
+ * The file is a 16 byte header followed by one variable length record per access:
+ *  - a tag byte: bits 0-1 the TraceAccess, bits 2-3 log2 of the size, bit 4 set if a pc follows
+ *  - the zigzag varint difference to the previous address of the same stream, data or fetch
+ *  - for data accesses whose pc differs from the previous record's, the zigzag varint pc difference
+ *
+ * Sequential fetches take 2 bytes and a load or store in straight-line code 2 to 4.
+ */
+class AddressTraceWriter
+{
+  public:
+    /**
+     * @brief Creates or truncates @p path. Throws std::runtime_error if it cannot be opened.
+     */
+    explicit AddressTraceWriter(const std::string &path);
+    ~AddressTraceWriter();
+
+    AddressTraceWriter(const AddressTraceWriter &) = delete;
+    AddressTraceWriter &operator=(const AddressTraceWriter &) = delete;
+
+    void append(TraceAccess access, uint64_t address, uint8_t size, uint64_t pc);
+
+    /**
+     * @brief Writes out everything appended so far and closes the file.
+     */
+    void close();
+
+    [[nodiscard]] uint64_t recordCount() const
+    {
+        return record_count_;
+    }
+
+  private:
+    void flush();
+
+    std::ofstream out_;
+    std::vector<uint8_t> buffer_;
+    uint64_t previous_address_[2] = {0, 0}; // data, fetch
+    uint64_t previous_pc_ = 0;
+    uint64_t record_count_ = 0;
+};
+
+/**
+ * @brief A whole trace held in memory, still encoded. Read it with an AddressTraceCursor; any
+ * number of cursors, on any threads, can walk the same trace.
+ */
+class AddressTrace
+{
+  public:
+    /**
+     * @brief Takes an encoded trace. Throws std::runtime_error if the header is not valid.
+     */
+    explicit AddressTrace(std::vector<uint8_t> bytes);
+
+    /**
+     * @brief Reads a trace file written by AddressTraceWriter.
+     */
+    static AddressTrace load(const std::string &path);
+
+    [[nodiscard]] const std::vector<uint8_t> &bytes() const
+    {
+        return bytes_;
+    }
+
+  private:
+    std::vector<uint8_t> bytes_;
+};
+
+class AddressTraceCursor
+{
+  public:
+    explicit AddressTraceCursor(const AddressTrace &trace);
+
+    /**
+     * @brief Decodes the next record into @p record. Returns false at the end of the trace.
+     * Throws std::runtime_error if the trace is cut off in the middle of a record.
+     */
+    bool next(TraceRecord &record);
+
+  private:
+    const uint8_t *position_;
+    const uint8_t *end_;
+    uint64_t previous_address_[2] = {0, 0};
+    uint64_t previous_pc_ = 0;
+};
+}//namespace Kites
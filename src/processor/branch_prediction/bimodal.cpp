@@ -0,0 +1,45 @@
+#include "processor/branch_prediction/bimodal.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+BimodalPredictor::BimodalPredictor(PredictorJournal &journal, unsigned int tableBits,
+                                   unsigned int counterBits)
+    : DirectionPredictor(journal), m_max(static_cast<uint8_t>((1u << counterBits) - 1)),
+      m_mask((uint64_t{1} << tableBits) - 1), m_counters(size_t{1} << tableBits)
+{
+    reset();
+}
+
+bool BimodalPredictor::predict(uint64_t pc, uint64_t, uint64_t) const
+{
+    return m_counters[pcIndex(pc) & m_mask] > m_max / 2;
+}
+
+void BimodalPredictor::update(uint64_t pc, uint64_t, uint64_t, bool taken)
+{
+    train(m_counters[pcIndex(pc) & m_mask], taken, m_max);
+}
+
+void BimodalPredictor::reset()
+{
+    // weakly not taken
+    std::fill(m_counters.begin(), m_counters.end(), static_cast<uint8_t>(m_max / 2));
+}
+
+void BimodalPredictor::saveState(std::vector<uint8_t> &state) const
+{
+    appendTable(state, m_counters);
+}
+
+void BimodalPredictor::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readTable(state, offset, m_counters);
+}
+
+std::string_view BimodalPredictor::name() const
+{
+    return m_max == 1 ? "1-bit" : "2-bit";
+}
+}//namespace Kites
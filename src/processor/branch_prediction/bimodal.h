@@ -0,0 +1,31 @@
+#pragma once
+#include "direction_predictor.h"
+
+namespace Kites
+{
+/**
+ * @brief A table of saturating counters indexed by the pc of the branch. With 1-bit counters
+ * it predicts whatever the branch did last time; 2-bit counters have to be wrong twice before
+ * they change their mind, so a loop branch mispredicts once per loop instead of twice.
+ */
+class BimodalPredictor : public DirectionPredictor
+{
+  public:
+    /**
+     * @param counterBits 1 or 2.
+     */
+    BimodalPredictor(PredictorJournal &journal, unsigned int tableBits, unsigned int counterBits);
+
+    bool predict(uint64_t pc, uint64_t target, uint64_t history) const override;
+    void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) override;
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+    std::string_view name() const override;
+
+  private:
+    uint8_t m_max;
+    uint64_t m_mask;
+    std::vector<uint8_t> m_counters;
+};
+}//namespace Kites
@@ -0,0 +1,225 @@
+#include "processor/branch_prediction/branch_prediction_unit.h"
+#include "processor/branch_prediction/bimodal.h"
+#include "processor/branch_prediction/gshare.h"
+#include "processor/branch_prediction/static_predictor.h"
+#include "processor/branch_prediction/tage.h"
+#include "processor/branch_prediction/tournament.h"
+#include "processor/checkpoint_history.h"
+
+namespace Kites
+{
+using vm_config::BranchPredictorType;
+
+namespace
+{
+constexpr uint32_t OPCODE_BRANCH = 0b1100011;
+constexpr uint32_t OPCODE_JALR = 0b1100111;
+
+// the standard link registers, ra and t0
+bool isLinkRegister(uint32_t reg)
+{
+    return reg == 1 || reg == 5;
+}
+
+std::unique_ptr<DirectionPredictor> createDirectionPredictor(
+    const vm_config::BranchPredictorConfig &config, PredictorJournal &journal)
+{
+    const auto tableBits = static_cast<unsigned int>(config.table_bits);
+    const auto historyBits = static_cast<unsigned int>(config.history_bits);
+    switch (config.type)
+    {
+    case BranchPredictorType::BTFN:
+        return std::make_unique<StaticPredictor>(journal, true);
+    case BranchPredictorType::ONE_BIT:
+        return std::make_unique<BimodalPredictor>(journal, tableBits, 1);
+    case BranchPredictorType::TWO_BIT:
+        return std::make_unique<BimodalPredictor>(journal, tableBits, 2);
+    case BranchPredictorType::GSHARE:
+        return std::make_unique<GsharePredictor>(journal, tableBits, historyBits);
+    case BranchPredictorType::TOURNAMENT:
+        return std::make_unique<TournamentPredictor>(journal, tableBits, historyBits);
+    case BranchPredictorType::TAGE:
+        return std::make_unique<TagePredictor>(journal, tableBits);
+    case BranchPredictorType::NOT_TAKEN:
+        break;
+    }
+    return std::make_unique<StaticPredictor>(journal, false);
+}
+} // namespace
+
+BranchKind branchKindOf(uint32_t instruction)
+{
+    const uint32_t opcode = instruction & 0b1111111;
+    if (opcode == OPCODE_BRANCH)
+    {
+        return BranchKind::Conditional;
+    }
+    const uint32_t rd = (instruction >> 7) & 0x1F;
+    const uint32_t rs1 = (instruction >> 15) & 0x1F;
+    if (isLinkRegister(rd))
+    {
+        return BranchKind::Call;
+    }
+    if (opcode == OPCODE_JALR && rd == 0 && isLinkRegister(rs1))
+    {
+        return BranchKind::Return;
+    }
+    return BranchKind::Jump;
+}
+
+std::string_view branchPredictorName(BranchPredictorType type)
+{
+    switch (type)
+    {
+    case BranchPredictorType::NOT_TAKEN:
+        return "not_taken";
+    case BranchPredictorType::BTFN:
+        return "btfn";
+    case BranchPredictorType::ONE_BIT:
+        return "one_bit";
+    case BranchPredictorType::TWO_BIT:
+        return "two_bit";
+    case BranchPredictorType::GSHARE:
+        return "gshare";
+    case BranchPredictorType::TOURNAMENT:
+        return "tournament";
+    case BranchPredictorType::TAGE:
+        return "tage";
+    }
+    return "unknown";
+}
+
+BranchPredictionUnit::BranchPredictionUnit() : m_targets(m_journal), m_returns(m_journal)
+{
+    configure(m_config);
+}
+
+void BranchPredictionUnit::configure(const vm_config::BranchPredictorConfig &config)
+{
+    m_config = config;
+    m_direction = createDirectionPredictor(config, m_journal);
+    m_targets.configure(config.btb_entries);
+    m_returns.configure(config.ras_entries);
+    reset();
+}
+
+std::string_view BranchPredictionUnit::name() const
+{
+    return branchPredictorName(m_config.type);
+}
+
+void BranchPredictionUnit::reset()
+{
+    m_direction->reset();
+    m_targets.reset();
+    m_returns.reset();
+    m_history = 0;
+    m_stats = BranchPredictionStats{};
+    m_journal.clear();
+}
+
+FetchPrediction BranchPredictionUnit::predict(uint64_t pc)
+{
+    FetchPrediction prediction{.next_pc = pc + 4,
+                               .history = m_history,
+                               .ras_top = m_returns.top(),
+                               .ras_depth = m_returns.depth()};
+    const BranchTargetBuffer::Entry *entry =
+        m_config.type == BranchPredictorType::NOT_TAKEN ? nullptr : m_targets.lookup(pc);
+    if (entry)
+    {
+        switch (entry->kind)
+        {
+        case BranchKind::Conditional:
+            if (m_direction->predict(pc, entry->target, m_history))
+            {
+                prediction.next_pc = entry->target;
+            }
+            break;
+        case BranchKind::Call:
+            m_returns.push(pc + 4);
+            prediction.next_pc = entry->target;
+            break;
+        case BranchKind::Return:
+            prediction.next_pc = m_returns.pop().value_or(entry->target);
+            break;
+        case BranchKind::Jump:
+            prediction.next_pc = entry->target;
+            break;
+        }
+    }
+    return prediction;
+}
+
+bool BranchPredictionUnit::resolve(uint64_t pc, uint32_t instruction,
+                                   const FetchPrediction &prediction, bool taken, uint64_t target)
+{
+    const BranchKind kind = branchKindOf(instruction);
+    const bool mispredicted = prediction.next_pc != (taken ? target : pc + 4);
+    if (kind == BranchKind::Conditional)
+    {
+        m_direction->update(pc, target, prediction.history, taken);
+        m_journal.write(m_history, (m_history << 1) | (taken ? 1 : 0));
+        m_journal.write(m_stats.conditionalCount, m_stats.conditionalCount + 1);
+        if (mispredicted)
+        {
+            m_journal.write(m_stats.conditionalMispredictions,
+                            m_stats.conditionalMispredictions + 1);
+        }
+    }
+    else
+    {
+        m_journal.write(m_stats.jumpCount, m_stats.jumpCount + 1);
+        if (mispredicted)
+        {
+            m_journal.write(m_stats.jumpMispredictions, m_stats.jumpMispredictions + 1);
+        }
+    }
+    if (m_config.type == BranchPredictorType::NOT_TAKEN)
+    {
+        return mispredicted;
+    }
+    if (taken)
+    {
+        m_targets.insert(pc, target, kind);
+    }
+    if (mispredicted)
+    {
+        // fetch may not have known this was a call or a return
+        recover(prediction);
+        if (kind == BranchKind::Call)
+        {
+            m_returns.push(pc + 4);
+        }
+        else if (kind == BranchKind::Return)
+        {
+            m_returns.pop();
+        }
+    }
+    return mispredicted;
+}
+
+void BranchPredictionUnit::recover(const FetchPrediction &prediction)
+{
+    m_returns.recover(prediction.ras_top, prediction.ras_depth);
+}
+
+void BranchPredictionUnit::saveState(std::vector<uint8_t> &state) const
+{
+    m_direction->saveState(state);
+    m_targets.saveState(state);
+    m_returns.saveState(state);
+    appendCheckpointState(state, m_history);
+    appendCheckpointState(state, m_stats);
+}
+
+void BranchPredictionUnit::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    m_direction->restoreState(state, offset);
+    m_targets.restoreState(state, offset);
+    m_returns.restoreState(state, offset);
+    readCheckpointState(state, offset, m_history);
+    readCheckpointState(state, offset, m_stats);
+    m_journal.clear();
+}
+}//namespace Kites
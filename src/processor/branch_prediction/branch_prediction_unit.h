@@ -0,0 +1,134 @@
+/**
+ * @file branch_prediction_unit.h
+ * @brief Where the fetch stage of the pipelined processors goes after each instruction.
+ */
+#pragma once
+
+#include "config/config.h"
+#include "processor/branch_prediction/branch_target_buffer.h"
+#include "processor/branch_prediction/direction_predictor.h"
+#include "processor/branch_prediction/predictor_journal.h"
+#include "processor/branch_prediction/return_address_stack.h"
+#include "processor/pipeline_registers.h"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Kites
+{
+struct BranchPredictionStats
+{
+    uint64_t conditionalCount = 0;
+    uint64_t conditionalMispredictions = 0;
+    uint64_t jumpCount = 0; // jal and jalr, calls and returns included
+    uint64_t jumpMispredictions = 0;
+
+    /**
+     * @brief Share of conditional branches fetch followed the right way, 1 with none.
+     */
+    double conditionalAccuracy() const
+    {
+        return conditionalCount == 0 ? 1.0
+                                     : 1.0 - static_cast<double>(conditionalMispredictions) /
+                                                 static_cast<double>(conditionalCount);
+    }
+
+    /**
+     * @brief Share of all control transfers fetch followed the right way, 1 with none.
+     */
+    double accuracy() const
+    {
+        const uint64_t count = conditionalCount + jumpCount;
+        return count == 0 ? 1.0
+                          : 1.0 - static_cast<double>(conditionalMispredictions +
+                                                      jumpMispredictions) /
+                                      static_cast<double>(count);
+    }
+};
+
+/**
+ * @brief The branch prediction unit the fetch stage consults for every instruction.
+ *
+ * Fetch only knows the pc, so the branch target buffer decides whether the instruction is a
+ * branch or a jump at all. On a hit a conditional branch asks the direction predictor, a return
+ * takes the top of the return address stack, and the rest go to the target the buffer holds. A
+ * call pushes its return address. Anything else, and every miss, falls through to pc + 4.
+ *
+ * The instruction resolves in EX, or in ID with early branch resolution, where it trains the
+ * predictor and the buffer, is counted, and tells the pipeline whether fetch went the wrong way.
+ * The global history is only extended at resolution.
+ *
+ * The NOT_TAKEN type keeps the buffer and the stack out of it, so fetch always falls through and
+ * every taken branch or jump is redirected, as in a pipeline without prediction.
+ */
+class BranchPredictionUnit
+{
+  public:
+    BranchPredictionUnit();
+
+    /**
+     * @brief Builds fresh tables for @p config.
+     */
+    void configure(const vm_config::BranchPredictorConfig &config);
+    const vm_config::BranchPredictorConfig &config() const
+    {
+        return m_config;
+    }
+    std::string_view name() const;
+
+    /**
+     * @brief Forgets everything learned and clears the statistics.
+     */
+    void reset();
+
+    FetchPrediction predict(uint64_t pc);
+
+    /**
+     * @brief Trains on the control transfer instruction at @p pc, which fetch followed with
+     * @p prediction. When fetch went the wrong way the return address stack is repaired too.
+     * @param target where the instruction goes when taken.
+     * @return whether fetch went the wrong way.
+     */
+    bool resolve(uint64_t pc, uint32_t instruction, const FetchPrediction &prediction, bool taken,
+                 uint64_t target);
+
+    /**
+     * @brief Puts the return address stack back to how fetch found it for @p prediction's
+     * instruction, undoing what the instructions fetched after it did.
+     */
+    void recover(const FetchPrediction &prediction);
+
+    const BranchPredictionStats &stats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * @brief The table writes since the last call, for undo, see PredictorJournal.
+     */
+    std::vector<PredictorWrite> takeWrites()
+    {
+        return m_journal.takeWrites();
+    }
+
+    void saveState(std::vector<uint8_t> &state) const;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    vm_config::BranchPredictorConfig m_config{};
+    PredictorJournal m_journal;
+    std::unique_ptr<DirectionPredictor> m_direction;
+    BranchTargetBuffer m_targets;
+    ReturnAddressStack m_returns;
+    uint64_t m_history = 0; // newest outcome in bit 0
+    BranchPredictionStats m_stats;
+};
+
+/**
+ * @brief Classifies a jal, jalr or B-type instruction.
+ */
+BranchKind branchKindOf(uint32_t instruction);
+
+std::string_view branchPredictorName(vm_config::BranchPredictorType type);
+}//namespace Kites
@@ -0,0 +1,50 @@
+#include "processor/branch_prediction/branch_target_buffer.h"
+#include "processor/branch_prediction/direction_predictor.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+void BranchTargetBuffer::configure(size_t entryCount)
+{
+    m_entries.assign(entryCount, Entry{});
+}
+
+void BranchTargetBuffer::reset()
+{
+    std::fill(m_entries.begin(), m_entries.end(), Entry{});
+}
+
+const BranchTargetBuffer::Entry *BranchTargetBuffer::lookup(uint64_t pc) const
+{
+    if (m_entries.empty())
+    {
+        return nullptr;
+    }
+    const Entry &entry = m_entries[(pc >> 2) % m_entries.size()];
+    return entry.valid && entry.pc == pc ? &entry : nullptr;
+}
+
+void BranchTargetBuffer::insert(uint64_t pc, uint64_t target, BranchKind kind)
+{
+    if (m_entries.empty())
+    {
+        return;
+    }
+    Entry &entry = m_entries[(pc >> 2) % m_entries.size()];
+    m_journal.write(entry.valid, true);
+    m_journal.write(entry.pc, pc);
+    m_journal.write(entry.target, target);
+    m_journal.write(entry.kind, kind);
+}
+
+void BranchTargetBuffer::saveState(std::vector<uint8_t> &state) const
+{
+    appendTable(state, m_entries);
+}
+
+void BranchTargetBuffer::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readTable(state, offset, m_entries);
+}
+}//namespace Kites
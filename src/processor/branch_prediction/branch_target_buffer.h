@@ -0,0 +1,55 @@
+#pragma once
+#include "predictor_journal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Kites
+{
+enum class BranchKind : uint8_t
+{
+    Conditional,
+    Jump,   // jal or jalr that neither calls nor returns
+    Call,   // jal or jalr linking into ra or t0
+    Return  // jalr x0 through ra or t0
+};
+
+/**
+ * @brief Direct mapped, fully tagged cache of the control transfers seen taken, looked up by pc
+ * in fetch before the instruction is decoded. A hit tells fetch the instruction is a branch or a
+ * jump, which kind, and where it went last time.
+ */
+class BranchTargetBuffer
+{
+  public:
+    struct Entry
+    {
+        uint64_t pc = 0;
+        uint64_t target = 0;
+        BranchKind kind = BranchKind::Conditional;
+        bool valid = false;
+    };
+
+    explicit BranchTargetBuffer(PredictorJournal &journal) : m_journal(journal)
+    {
+    }
+
+    /**
+     * @brief Resizes to @p entryCount entries and empties the buffer. With no entries every
+     * lookup misses.
+     */
+    void configure(size_t entryCount);
+    void reset();
+
+    const Entry *lookup(uint64_t pc) const;
+    void insert(uint64_t pc, uint64_t target, BranchKind kind);
+
+    void saveState(std::vector<uint8_t> &state) const;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    PredictorJournal &m_journal;
+    std::vector<Entry> m_entries;
+};
+}//namespace Kites
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "processor/branch_prediction/predictor_journal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Base class for the predictors that guess whether a conditional branch is taken.
+ *
+ * The prediction unit hands every call the global history it predicted with, newest outcome in
+ * bit 0, so a branch trains the same entries it was predicted from even if older branches
+ * resolved in between. Table writes go through the journal, see PredictorJournal.
+ */
+class DirectionPredictor
+{
+  public:
+    explicit DirectionPredictor(PredictorJournal &journal) : m_journal(journal)
+    {
+    }
+    virtual ~DirectionPredictor() = default;
+
+    /**
+     * @param target where the branch goes when taken.
+     */
+    virtual bool predict(uint64_t pc, uint64_t target, uint64_t history) const = 0;
+
+    virtual void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) = 0;
+
+    /**
+     * @brief Forgets everything learned.
+     */
+    virtual void reset() = 0;
+
+    virtual void saveState(std::vector<uint8_t> &state) const = 0;
+    virtual void restoreState(const std::vector<uint8_t> &state, size_t &offset) = 0;
+
+    virtual std::string_view name() const = 0;
+
+  protected:
+    /**
+     * @brief Moves a saturating counter in [0, max] one step towards @p taken.
+     */
+    void train(uint8_t &counter, bool taken, uint8_t max)
+    {
+        if (taken && counter < max)
+        {
+            m_journal.write(counter, static_cast<uint8_t>(counter + 1));
+        }
+        else if (!taken && counter > 0)
+        {
+            m_journal.write(counter, static_cast<uint8_t>(counter - 1));
+        }
+    }
+
+    // instructions are 4 byte aligned, so the low pc bits carry nothing
+    static uint64_t pcIndex(uint64_t pc)
+    {
+        return pc >> 2;
+    }
+
+    PredictorJournal &m_journal;
+};
+
+template <typename T> void appendTable(std::vector<uint8_t> &state, const std::vector<T> &table)
+{
+    const size_t offset = state.size();
+    state.resize(offset + table.size() * sizeof(T));
+    std::memcpy(state.data() + offset, table.data(), table.size() * sizeof(T));
+}
+
+/**
+ * @brief Reads back a table stored by appendTable into @p table, which has the same size.
+ */
+template <typename T>
+void readTable(const std::vector<uint8_t> &state, size_t &offset, std::vector<T> &table)
+{
+    std::memcpy(table.data(), state.data() + offset, table.size() * sizeof(T));
+    offset += table.size() * sizeof(T);
+}
+}//namespace Kites
@@ -0,0 +1,45 @@
+#include "processor/branch_prediction/gshare.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+GsharePredictor::GsharePredictor(PredictorJournal &journal, unsigned int tableBits,
+                                 unsigned int historyBits)
+    : DirectionPredictor(journal), m_mask((uint64_t{1} << tableBits) - 1),
+      m_historyMask(historyBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << historyBits) - 1),
+      m_counters(size_t{1} << tableBits)
+{
+    reset();
+}
+
+bool GsharePredictor::predict(uint64_t pc, uint64_t, uint64_t history) const
+{
+    return m_counters[index(pc, history)] >= 2;
+}
+
+void GsharePredictor::update(uint64_t pc, uint64_t, uint64_t history, bool taken)
+{
+    train(m_counters[index(pc, history)], taken, 3);
+}
+
+void GsharePredictor::reset()
+{
+    std::fill(m_counters.begin(), m_counters.end(), uint8_t{1});
+}
+
+void GsharePredictor::saveState(std::vector<uint8_t> &state) const
+{
+    appendTable(state, m_counters);
+}
+
+void GsharePredictor::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readTable(state, offset, m_counters);
+}
+
+std::string_view GsharePredictor::name() const
+{
+    return "gshare";
+}
+}//namespace Kites
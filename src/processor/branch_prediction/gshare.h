@@ -0,0 +1,32 @@
+#pragma once
+#include "direction_predictor.h"
+
+namespace Kites
+{
+/**
+ * @brief 2-bit counters indexed by the pc xor the global history, so one branch can use a
+ * different counter for each path that leads to it.
+ */
+class GsharePredictor : public DirectionPredictor
+{
+  public:
+    GsharePredictor(PredictorJournal &journal, unsigned int tableBits, unsigned int historyBits);
+
+    bool predict(uint64_t pc, uint64_t target, uint64_t history) const override;
+    void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) override;
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+    std::string_view name() const override;
+
+  private:
+    size_t index(uint64_t pc, uint64_t history) const
+    {
+        return (pcIndex(pc) ^ (history & m_historyMask)) & m_mask;
+    }
+
+    uint64_t m_mask;
+    uint64_t m_historyMask;
+    std::vector<uint8_t> m_counters;
+};
+}//namespace Kites
@@ -0,0 +1,89 @@
+#include "processor/branch_prediction/predictor_comparison.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Kites
+{
+namespace
+{
+class ComparisonProcessor final : public RV5StageProcessorHF
+{
+  public:
+    BranchPredictorResult run(const AssembledProgram &program,
+                              const vm_config::BranchPredictorConfig &config, uint64_t maxCycles)
+    {
+        LoadProgram(program);
+        branch_predictor_.configure(config);
+        while (!stop_requested_ && !ReplayFinished() && cycle_s_ < maxCycles)
+        {
+            Step();
+        }
+
+        BranchPredictorResult result;
+        result.config = config;
+        result.stats = branch_predictor_.stats();
+        result.cycles = cycle_s_;
+        result.instructions = instructions_retired_;
+        result.cpi = instructions_retired_ ? static_cast<double>(cycle_s_) /
+                                                 static_cast<double>(instructions_retired_)
+                                           : 0.0;
+        return result;
+    }
+};
+} // namespace
+
+std::vector<BranchPredictorResult> compareBranchPredictors(
+    const AssembledProgram &program, const std::vector<vm_config::BranchPredictorType> &types,
+    const vm_config::BranchPredictorConfig &base, uint64_t maxCycles)
+{
+    auto runWith = [&](vm_config::BranchPredictorType type)
+    {
+        vm_config::BranchPredictorConfig config = base;
+        config.type = type;
+        return ComparisonProcessor().run(program, config, maxCycles);
+    };
+
+    std::vector<BranchPredictorResult> results;
+    for (vm_config::BranchPredictorType type : types)
+    {
+        results.push_back(runWith(type));
+    }
+
+    auto baseline = std::find_if(
+        results.begin(), results.end(), [](const BranchPredictorResult &result)
+        { return result.config.type == vm_config::BranchPredictorType::NOT_TAKEN; });
+    const double baselineCpi = baseline != results.end()
+                                   ? baseline->cpi
+                                   : runWith(vm_config::BranchPredictorType::NOT_TAKEN).cpi;
+    for (BranchPredictorResult &result : results)
+    {
+        result.cpiChange = result.cpi - baselineCpi;
+    }
+    return results;
+}
+
+std::string formatPredictorTable(const std::vector<BranchPredictorResult> &results)
+{
+    std::string table = "predictor   branches mispredicted br_accuracy    jumps mispredicted "
+                        "accuracy   cycles      cpi cpi_change\n";
+    char row[160];
+    for (const BranchPredictorResult &result : results)
+    {
+        const BranchPredictionStats &stats = result.stats;
+        std::snprintf(row, sizeof(row),
+                      "%-10s %9llu %12llu %11.4f %8llu %12llu %8.4f %8llu %8.4f %+10.4f\n",
+                      std::string(branchPredictorName(result.config.type)).c_str(),
+                      static_cast<unsigned long long>(stats.conditionalCount),
+                      static_cast<unsigned long long>(stats.conditionalMispredictions),
+                      stats.conditionalAccuracy(),
+                      static_cast<unsigned long long>(stats.jumpCount),
+                      static_cast<unsigned long long>(stats.jumpMispredictions), stats.accuracy(),
+                      static_cast<unsigned long long>(result.cycles), result.cpi,
+                      result.cpiChange);
+        table += row;
+    }
+    return table;
+}
+}//namespace Kites
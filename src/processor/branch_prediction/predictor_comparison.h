@@ -0,0 +1,39 @@
+/**
+ * @file predictor_comparison.h
+ * @brief Runs one program on the five-stage pipeline under several branch predictors.
+ */
+#pragma once
+
+#include "common/assembled_program.h"
+#include "processor/branch_prediction/branch_prediction_unit.h"
+
+#include <string>
+#include <vector>
+
+namespace Kites
+{
+struct BranchPredictorResult
+{
+    vm_config::BranchPredictorConfig config;
+    BranchPredictionStats stats;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double cpi = 0.0;
+    /**
+     * @brief CPI less that of the same run without prediction, negative when the predictor helps.
+     */
+    double cpiChange = 0.0;
+};
+
+/**
+ * @brief Runs @p program to completion on the hazard detecting, forwarding pipeline once for
+ * each of @p types, with the table sizes of @p base and the memory hierarchy of the current
+ * configuration. Runs without prediction too when @p types leaves it out, for the CPI change.
+ * @param maxCycles stops a run that has not finished by then.
+ */
+std::vector<BranchPredictorResult> compareBranchPredictors(
+    const AssembledProgram &program, const std::vector<vm_config::BranchPredictorType> &types,
+    const vm_config::BranchPredictorConfig &base = {}, uint64_t maxCycles = 10'000'000);
+
+std::string formatPredictorTable(const std::vector<BranchPredictorResult> &results);
+}//namespace Kites
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief One predictor table entry or counter changed during a cycle.
+ */
+struct PredictorWrite
+{
+    void *slot = nullptr;
+    uint64_t oldValue = 0;
+    uint64_t newValue = 0;
+    uint8_t size = 0;
+};
+
+/**
+ * @brief Records every write the branch predictor makes, so a step can be undone and redone
+ * without copying the tables.
+ *
+ * The writes point into the tables, so they only stay valid until the tables are resized, which
+ * happens on reset, when the undo history is dropped too.
+ */
+class PredictorJournal
+{
+  public:
+    template <typename T> void write(T &slot, T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t));
+        if (slot == value)
+        {
+            return;
+        }
+        PredictorWrite entry{.slot = &slot, .size = sizeof(T)};
+        std::memcpy(&entry.oldValue, &slot, sizeof(T));
+        std::memcpy(&entry.newValue, &value, sizeof(T));
+        m_writes.push_back(entry);
+        slot = value;
+    }
+
+    /**
+     * @brief Hands over the writes made since the last call.
+     */
+    std::vector<PredictorWrite> takeWrites()
+    {
+        return std::exchange(m_writes, {});
+    }
+
+    void clear()
+    {
+        m_writes.clear();
+    }
+
+    static void undo(const std::vector<PredictorWrite> &writes)
+    {
+        for (auto it = writes.rbegin(); it != writes.rend(); ++it)
+        {
+            std::memcpy(it->slot, &it->oldValue, it->size);
+        }
+    }
+
+    static void redo(const std::vector<PredictorWrite> &writes)
+    {
+        for (const PredictorWrite &write : writes)
+        {
+            std::memcpy(write.slot, &write.newValue, write.size);
+        }
+    }
+
+  private:
+    std::vector<PredictorWrite> m_writes;
+};
+}//namespace Kites
@@ -0,0 +1,68 @@
+#include "processor/branch_prediction/return_address_stack.h"
+#include "processor/branch_prediction/direction_predictor.h"
+#include "processor/checkpoint_history.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Kites
+{
+void ReturnAddressStack::configure(size_t entryCount)
+{
+    m_addresses.assign(std::min<size_t>(entryCount, std::numeric_limits<uint16_t>::max()), 0);
+    m_top = 0;
+    m_depth = 0;
+}
+
+void ReturnAddressStack::reset()
+{
+    std::fill(m_addresses.begin(), m_addresses.end(), 0);
+    m_top = 0;
+    m_depth = 0;
+}
+
+void ReturnAddressStack::push(uint64_t returnAddress)
+{
+    if (m_addresses.empty())
+    {
+        return;
+    }
+    const auto size = static_cast<uint16_t>(m_addresses.size());
+    m_journal.write(m_top, static_cast<uint16_t>((m_top + 1) % size));
+    m_journal.write(m_addresses[m_top], returnAddress);
+    m_journal.write(m_depth, std::min(static_cast<uint16_t>(m_depth + 1), size));
+}
+
+std::optional<uint64_t> ReturnAddressStack::pop()
+{
+    if (m_depth == 0)
+    {
+        return std::nullopt;
+    }
+    const uint64_t returnAddress = m_addresses[m_top];
+    const auto size = static_cast<uint16_t>(m_addresses.size());
+    m_journal.write(m_top, static_cast<uint16_t>((m_top + size - 1) % size));
+    m_journal.write(m_depth, static_cast<uint16_t>(m_depth - 1));
+    return returnAddress;
+}
+
+void ReturnAddressStack::recover(uint16_t top, uint16_t depth)
+{
+    m_journal.write(m_top, top);
+    m_journal.write(m_depth, depth);
+}
+
+void ReturnAddressStack::saveState(std::vector<uint8_t> &state) const
+{
+    appendTable(state, m_addresses);
+    appendCheckpointState(state, m_top);
+    appendCheckpointState(state, m_depth);
+}
+
+void ReturnAddressStack::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readTable(state, offset, m_addresses);
+    readCheckpointState(state, offset, m_top);
+    readCheckpointState(state, offset, m_depth);
+}
+}//namespace Kites
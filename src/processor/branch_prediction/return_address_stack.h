@@ -0,0 +1,55 @@
+#pragma once
+#include "predictor_journal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Circular stack of return addresses, pushed when fetch predicts a call and popped when it
+ * predicts a return. When full the oldest address is overwritten.
+ *
+ * Fetch runs ahead of resolution, so instructions on a mispredicted path may push or pop. Each
+ * fetched instruction carries the top and depth as fetch found them, and a misprediction puts
+ * those of the mispredicted instruction back before redoing its own push or pop.
+ */
+class ReturnAddressStack
+{
+  public:
+    explicit ReturnAddressStack(PredictorJournal &journal) : m_journal(journal)
+    {
+    }
+
+    /**
+     * @brief Resizes to @p entryCount addresses and empties the stack. With no entries it
+     * never predicts.
+     */
+    void configure(size_t entryCount);
+    void reset();
+
+    void push(uint64_t returnAddress);
+    std::optional<uint64_t> pop();
+
+    uint16_t top() const
+    {
+        return m_top;
+    }
+    uint16_t depth() const
+    {
+        return m_depth;
+    }
+    void recover(uint16_t top, uint16_t depth);
+
+    void saveState(std::vector<uint8_t> &state) const;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    PredictorJournal &m_journal;
+    std::vector<uint64_t> m_addresses;
+    uint16_t m_top = 0; // slot of the newest address
+    uint16_t m_depth = 0;
+};
+}//namespace Kites
@@ -0,0 +1,30 @@
+#include "processor/branch_prediction/static_predictor.h"
+
+namespace Kites
+{
+bool StaticPredictor::predict(uint64_t pc, uint64_t target, uint64_t) const
+{
+    return m_backwardTaken && target < pc;
+}
+
+void StaticPredictor::update(uint64_t, uint64_t, uint64_t, bool)
+{
+}
+
+void StaticPredictor::reset()
+{
+}
+
+void StaticPredictor::saveState(std::vector<uint8_t> &) const
+{
+}
+
+void StaticPredictor::restoreState(const std::vector<uint8_t> &, size_t &)
+{
+}
+
+std::string_view StaticPredictor::name() const
+{
+    return m_backwardTaken ? "BTFN" : "Not taken";
+}
+}//namespace Kites
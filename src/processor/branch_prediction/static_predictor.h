@@ -0,0 +1,28 @@
+#pragma once
+#include "direction_predictor.h"
+
+namespace Kites
+{
+/**
+ * @brief Predicts from the branch alone, learning nothing: always not taken, or backward taken
+ * and forward not taken (BTFN), which gets loops right.
+ */
+class StaticPredictor : public DirectionPredictor
+{
+  public:
+    StaticPredictor(PredictorJournal &journal, bool backwardTaken)
+        : DirectionPredictor(journal), m_backwardTaken(backwardTaken)
+    {
+    }
+
+    bool predict(uint64_t pc, uint64_t target, uint64_t history) const override;
+    void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) override;
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+    std::string_view name() const override;
+
+  private:
+    bool m_backwardTaken;
+};
+}//namespace Kites
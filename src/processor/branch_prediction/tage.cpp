@@ -0,0 +1,162 @@
+#include "processor/branch_prediction/tage.h"
+#include "processor/checkpoint_history.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+namespace
+{
+// xors the newest length bits of history together in chunks of bits
+uint64_t foldHistory(uint64_t history, unsigned int length, unsigned int bits)
+{
+    if (length < 64)
+    {
+        history &= (uint64_t{1} << length) - 1;
+    }
+    uint64_t folded = 0;
+    for (; history != 0; history >>= bits)
+    {
+        folded ^= history & ((uint64_t{1} << bits) - 1);
+    }
+    return folded;
+}
+} // namespace
+
+TagePredictor::TagePredictor(PredictorJournal &journal, unsigned int tableBits)
+    : DirectionPredictor(journal), m_taggedBits(tableBits - 1),
+      m_baseMask((uint64_t{1} << tableBits) - 1), m_base(size_t{1} << tableBits)
+{
+    for (std::vector<Entry> &table : m_tagged)
+    {
+        table.resize(size_t{1} << m_taggedBits);
+    }
+    reset();
+}
+
+TagePredictor::Lookup TagePredictor::lookup(uint64_t pc, uint64_t history) const
+{
+    Lookup result;
+    const uint64_t line = pcIndex(pc);
+    const uint64_t mask = (uint64_t{1} << m_taggedBits) - 1;
+    for (size_t table = 0; table < TAGGED_TABLE_COUNT; ++table)
+    {
+        const unsigned int length = HISTORY_LENGTHS[table];
+        result.indices[table] =
+            (line ^ (line >> m_taggedBits) ^ foldHistory(history, length, m_taggedBits)) & mask;
+        result.tags[table] = static_cast<uint8_t>(line ^ foldHistory(history, length, TAG_BITS) ^
+                                                  (foldHistory(history, length, TAG_BITS - 1) << 1));
+        const Entry &entry = m_tagged[table][result.indices[table]];
+        if (entry.valid && entry.tag == result.tags[table])
+        {
+            result.alternate = result.provider;
+            result.provider = static_cast<int>(table);
+        }
+    }
+    return result;
+}
+
+bool TagePredictor::predictionOf(const Lookup &lookup, int table, uint64_t pc) const
+{
+    if (table < 0)
+    {
+        return m_base[pcIndex(pc) & m_baseMask] >= 2;
+    }
+    return m_tagged[table][lookup.indices[table]].counter >= 4;
+}
+
+bool TagePredictor::predict(uint64_t pc, uint64_t, uint64_t history) const
+{
+    const Lookup found = lookup(pc, history);
+    return predictionOf(found, found.provider, pc);
+}
+
+void TagePredictor::update(uint64_t pc, uint64_t, uint64_t history, bool taken)
+{
+    const Lookup found = lookup(pc, history);
+    const bool prediction = predictionOf(found, found.provider, pc);
+
+    if (found.provider >= 0)
+    {
+        Entry &provider = m_tagged[found.provider][found.indices[found.provider]];
+        if (prediction != predictionOf(found, found.alternate, pc))
+        {
+            train(provider.useful, prediction == taken, 3);
+        }
+        train(provider.counter, taken, 7);
+    }
+    else
+    {
+        train(m_base[pcIndex(pc) & m_baseMask], taken, 3);
+    }
+
+    if (prediction != taken)
+    {
+        // a longer history may tell this case apart
+        bool allocated = false;
+        for (size_t table = found.provider + 1; table < TAGGED_TABLE_COUNT && !allocated; ++table)
+        {
+            Entry &entry = m_tagged[table][found.indices[table]];
+            if (entry.useful == 0)
+            {
+                m_journal.write(entry.valid, uint8_t{1});
+                m_journal.write(entry.tag, found.tags[table]);
+                m_journal.write(entry.counter, static_cast<uint8_t>(taken ? 4 : 3));
+                allocated = true;
+            }
+        }
+        for (size_t table = found.provider + 1; table < TAGGED_TABLE_COUNT && !allocated; ++table)
+        {
+            Entry &entry = m_tagged[table][found.indices[table]];
+            m_journal.write(entry.useful, static_cast<uint8_t>(entry.useful - 1));
+        }
+    }
+
+    m_journal.write(m_updateCount, m_updateCount + 1);
+    if (m_updateCount % USEFUL_AGING_PERIOD == 0)
+    {
+        for (std::vector<Entry> &table : m_tagged)
+        {
+            for (Entry &entry : table)
+            {
+                m_journal.write(entry.useful, static_cast<uint8_t>(entry.useful >> 1));
+            }
+        }
+    }
+}
+
+void TagePredictor::reset()
+{
+    std::fill(m_base.begin(), m_base.end(), uint8_t{1});
+    for (std::vector<Entry> &table : m_tagged)
+    {
+        std::fill(table.begin(), table.end(), Entry{});
+    }
+    m_updateCount = 0;
+}
+
+void TagePredictor::saveState(std::vector<uint8_t> &state) const
+{
+    appendTable(state, m_base);
+    for (const std::vector<Entry> &table : m_tagged)
+    {
+        appendTable(state, table);
+    }
+    appendCheckpointState(state, m_updateCount);
+}
+
+void TagePredictor::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readTable(state, offset, m_base);
+    for (std::vector<Entry> &table : m_tagged)
+    {
+        readTable(state, offset, table);
+    }
+    readCheckpointState(state, offset, m_updateCount);
+}
+
+std::string_view TagePredictor::name() const
+{
+    return "TAGE";
+}
+}//namespace Kites
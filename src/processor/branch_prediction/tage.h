@@ -0,0 +1,65 @@
+#pragma once
+#include "direction_predictor.h"
+
+#include <array>
+
+namespace Kites
+{
+/**
+ * @brief A small TAGE: a 2-bit bimodal base table and four tagged tables indexed by the pc
+ * hashed with geometrically longer slices of the global history.
+ *
+ * The tagged table with the longest history whose tag matches provides the prediction, the base
+ * table when none does. A misprediction allocates an entry in a longer table, taking one whose
+ * useful counter is zero or else aging the candidates. A provider gains usefulness when it was
+ * right and the next shorter match would have been wrong. Useful counters are halved every
+ * USEFUL_AGING_PERIOD updates so stale entries can be replaced.
+ */
+class TagePredictor : public DirectionPredictor
+{
+  public:
+    static constexpr size_t TAGGED_TABLE_COUNT = 4;
+    static constexpr std::array<unsigned int, TAGGED_TABLE_COUNT> HISTORY_LENGTHS = {4, 10, 24,
+                                                                                     56};
+    static constexpr unsigned int TAG_BITS = 8;
+    static constexpr uint64_t USEFUL_AGING_PERIOD = 1 << 14;
+
+    /**
+     * @param tableBits log2 of the base table size, each tagged table has half as many entries.
+     */
+    TagePredictor(PredictorJournal &journal, unsigned int tableBits);
+
+    bool predict(uint64_t pc, uint64_t target, uint64_t history) const override;
+    void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) override;
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+    std::string_view name() const override;
+
+  private:
+    struct Entry
+    {
+        uint8_t valid = 0;
+        uint8_t tag = 0;
+        uint8_t counter = 0; // 3 bits, taken from 4
+        uint8_t useful = 0;  // 2 bits
+    };
+
+    struct Lookup
+    {
+        int provider = -1;  // longest matching tagged table
+        int alternate = -1; // next shorter matching tagged table
+        std::array<size_t, TAGGED_TABLE_COUNT> indices{};
+        std::array<uint8_t, TAGGED_TABLE_COUNT> tags{};
+    };
+
+    Lookup lookup(uint64_t pc, uint64_t history) const;
+    bool predictionOf(const Lookup &lookup, int table, uint64_t pc) const;
+
+    unsigned int m_taggedBits;
+    uint64_t m_baseMask;
+    std::vector<uint8_t> m_base;
+    std::array<std::vector<Entry>, TAGGED_TABLE_COUNT> m_tagged;
+    uint64_t m_updateCount = 0;
+};
+}//namespace Kites
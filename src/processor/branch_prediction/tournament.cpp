@@ -0,0 +1,60 @@
+#include "processor/branch_prediction/tournament.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+TournamentPredictor::TournamentPredictor(PredictorJournal &journal, unsigned int tableBits,
+                                         unsigned int historyBits)
+    : DirectionPredictor(journal), m_local(journal, tableBits, 2),
+      m_global(journal, tableBits, historyBits), m_mask((uint64_t{1} << tableBits) - 1),
+      m_choosers(size_t{1} << tableBits)
+{
+    reset();
+}
+
+bool TournamentPredictor::predict(uint64_t pc, uint64_t target, uint64_t history) const
+{
+    return m_choosers[pcIndex(pc) & m_mask] >= 2 ? m_global.predict(pc, target, history)
+                                                 : m_local.predict(pc, target, history);
+}
+
+void TournamentPredictor::update(uint64_t pc, uint64_t target, uint64_t history, bool taken)
+{
+    const bool local = m_local.predict(pc, target, history);
+    const bool global = m_global.predict(pc, target, history);
+    if (local != global)
+    {
+        train(m_choosers[pcIndex(pc) & m_mask], global == taken, 3);
+    }
+    m_local.update(pc, target, history, taken);
+    m_global.update(pc, target, history, taken);
+}
+
+void TournamentPredictor::reset()
+{
+    m_local.reset();
+    m_global.reset();
+    // weakly in favour of the bimodal predictor, which warms up faster
+    std::fill(m_choosers.begin(), m_choosers.end(), uint8_t{1});
+}
+
+void TournamentPredictor::saveState(std::vector<uint8_t> &state) const
+{
+    m_local.saveState(state);
+    m_global.saveState(state);
+    appendTable(state, m_choosers);
+}
+
+void TournamentPredictor::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    m_local.restoreState(state, offset);
+    m_global.restoreState(state, offset);
+    readTable(state, offset, m_choosers);
+}
+
+std::string_view TournamentPredictor::name() const
+{
+    return "Tournament";
+}
+}//namespace Kites
@@ -0,0 +1,31 @@
+#pragma once
+#include "bimodal.h"
+#include "gshare.h"
+
+namespace Kites
+{
+/**
+ * @brief A 2-bit bimodal and a gshare predictor side by side, with a table of 2-bit choosers
+ * indexed by pc that learns which of the two to trust for each branch. A chooser only moves
+ * when the two disagree.
+ */
+class TournamentPredictor : public DirectionPredictor
+{
+  public:
+    TournamentPredictor(PredictorJournal &journal, unsigned int tableBits,
+                        unsigned int historyBits);
+
+    bool predict(uint64_t pc, uint64_t target, uint64_t history) const override;
+    void update(uint64_t pc, uint64_t target, uint64_t history, bool taken) override;
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+    std::string_view name() const override;
+
+  private:
+    BimodalPredictor m_local;
+    GsharePredictor m_global;
+    uint64_t m_mask;
+    std::vector<uint8_t> m_choosers; // 2 and up pick the global predictor
+};
+}//namespace Kites
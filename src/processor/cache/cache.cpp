@@ -1,7 +1,17 @@
 #include "processor/cache/cache.h"
+#include "processor/cache/policies/bit_plru.h"
 #include "processor/cache/policies/custom_policy.h"
 #include "processor/cache/policies/fifo.h"
+#include "processor/cache/policies/lfu.h"
 #include "processor/cache/policies/lru.h"
+#include "processor/cache/policies/random.h"
+#include "processor/cache/policies/rrip.h"
+#include "processor/cache/policies/tree_plru.h"
+#include "processor/cache/prefetchers/next_line.h"
+#include "processor/cache/prefetchers/stream.h"
+#include "processor/cache/prefetchers/stride.h"
+#include <algorithm>
+#include <cstring>
 #include <span>
 
 namespace Kites
@@ -22,10 +32,40 @@ createPolicy(ReplacementPolicy policy_type, const std::string &custom_policy_scr
         return std::make_unique<FIFOReplacementPolicy>();
     case ReplacementPolicy::Custom:
         return std::make_unique<CustomReplacementPolicy>(custom_policy_script_path);
+    case ReplacementPolicy::TreePLRU:
+        return std::make_unique<TreePLRUReplacementPolicy>();
+    case ReplacementPolicy::BitPLRU:
+        return std::make_unique<BitPLRUReplacementPolicy>();
+    case ReplacementPolicy::SRRIP:
+    case ReplacementPolicy::BRRIP:
+    case ReplacementPolicy::DRRIP:
+        return std::make_unique<RRIPReplacementPolicy>(policy_type);
+    case ReplacementPolicy::LFU:
+        return std::make_unique<LFUReplacementPolicy>();
+    case ReplacementPolicy::Random:
+        return std::make_unique<RandomReplacementPolicy>();
     default:
         return std::make_unique<LRUReplacementPolicy>(); // default fallback
     }
 }
+
+std::unique_ptr<CachePrefetcher> createPrefetcher(PrefetcherType prefetcher_type, size_t degree,
+                                                  size_t distance)
+{
+    switch (prefetcher_type)
+    {
+    case PrefetcherType::NextLine:
+        return std::make_unique<NextLinePrefetcher>(degree, distance);
+    case PrefetcherType::Stride:
+        return std::make_unique<StridePrefetcher>(degree, distance);
+    case PrefetcherType::Stream:
+        return std::make_unique<StreamPrefetcher>(degree, distance);
+    default:
+        return nullptr;
+    }
+}
+
+constexpr size_t PREFETCH_QUEUE_SIZE = 16;
 }
 
 
@@ -42,12 +82,19 @@ void Cache::setupCache(size_t setCount, size_t lineSize, size_t wayCount)
     m_offsetMask      = (lineSize) - 1;
     m_setMask         = m_setCount - 1;
 
-    m_sets.clear();
     m_timestampCounter = 0;
-    m_sets.reserve(m_setCount);
-    for (size_t i = 0; i < m_setCount; ++i)
+    m_storage.resize(m_setCount, m_wayCount, m_lineSizeInBytes);
+    m_ReplacementPolicy->reset();
+    m_prefetchQueue.clear();
+    if (m_prefetcher)
+    {
+        m_prefetcher->reset();
+    }
+    m_victimViews.resize(m_wayCount);
+    if (m_observer)
     {
-        m_sets.emplace_back(m_wayCount, CacheLine(m_lineSizeInBytes));
+        m_observer = std::make_unique<CacheObserver>(m_setCount * m_wayCount);
+        m_observer->noteAllLines();
     }
 }
 
@@ -67,11 +114,20 @@ void Cache::reconfigure(CacheConfig newConfig)
     m_writePolicy       = newConfig.writePolicy;
     m_allocationPolicy  = newConfig.allocationPolicy;
     m_ReplacementPolicy = createPolicy(newConfig.replacementPolicy, m_customPolicyScriptPath);
+    setPrefetcher(newConfig.prefetcher, newConfig.prefetchDegree, newConfig.prefetchDistance);
     setupCache(newConfig.lineCount, newConfig.lineSizeInBytes, newConfig.wayCount);
     emit cacheReconfiguredSignal(newConfig);
 }
 
-const CacheLine &Cache::getCacheLine(size_t setIndex,size_t wayIndex) const
+void Cache::setPrefetcher(PrefetcherType type, size_t degree, size_t distance)
+{
+    m_prefetchDegree   = degree;
+    m_prefetchDistance = distance;
+    m_prefetcher       = createPrefetcher(type, degree, distance);
+    m_prefetchQueue.clear();
+}
+
+CacheLine Cache::getCacheLine(size_t setIndex,size_t wayIndex) const
 {
     if (setIndex >= m_setCount || wayIndex >= m_wayCount)
     {
@@ -79,7 +135,102 @@ const CacheLine &Cache::getCacheLine(size_t setIndex,size_t wayIndex) const
                                 std::to_string(setIndex) +
                                 ", wayIndex=" + std::to_string(wayIndex));
     }
-    return m_sets[setIndex][wayIndex];
+    CacheLine line(m_lineSizeInBytes);
+    line.tag        = m_storage.tag(setIndex, wayIndex);
+    line.age        = m_storage.age(setIndex, wayIndex);
+    line.insertTime = m_storage.insertTime(setIndex, wayIndex);
+    line.lastAccess = m_storage.lastAccess(setIndex, wayIndex);
+    line.frequency  = m_storage.frequency(setIndex, wayIndex);
+    line.valid      = m_storage.isValid(setIndex, wayIndex);
+    line.dirty      = m_storage.isDirty(setIndex, wayIndex);
+    const uint8_t *data = m_storage.lineData(setIndex, wayIndex);
+    std::copy(data, data + m_lineSizeInBytes, line.data.begin());
+    return line;
+}
+
+CacheLineView Cache::lineView(size_t setIndex, size_t wayIndex) const
+{
+    return {m_storage.isValid(setIndex, wayIndex),    m_storage.tag(setIndex, wayIndex),
+            m_storage.age(setIndex, wayIndex),        m_storage.frequency(setIndex, wayIndex),
+            m_storage.insertTime(setIndex, wayIndex), m_storage.lastAccess(setIndex, wayIndex),
+            m_storage.isDirty(setIndex, wayIndex)};
+}
+
+void Cache::recordAccess(uint64_t address, bool hit)
+{
+    ++(hit ? m_hitCount : m_missCount);
+    if (m_observer)
+    {
+        m_observer->noteAccess(address, hit);
+    }
+    if (m_prefetcher)
+    {
+        trainPrefetcher(address, hit);
+    }
+}
+
+void Cache::trainPrefetcher(uint64_t address, bool hit)
+{
+    const uint64_t line = address >> m_offsetBits;
+    if (!hit)
+    {
+        // the line was asked for but its turn had not come yet
+        auto queued = std::find(m_prefetchQueue.begin(), m_prefetchQueue.end(), line);
+        if (queued != m_prefetchQueue.end())
+        {
+            m_prefetchQueue.erase(queued);
+            ++m_prefetchLateCount;
+        }
+    }
+
+    m_prefetchCandidates.clear();
+    const PrefetchRequestView request{line, address, m_offsetBits, m_accessPc, hit, m_prefetchHit};
+    m_prefetchHit = false;
+    m_prefetcher->onAccess(request, m_prefetchCandidates);
+
+    const uint64_t lastLine = (vm_config::config.getMemorySize() >> m_offsetBits) - 1;
+    for (uint64_t candidate : m_prefetchCandidates)
+    {
+        if (candidate == line || candidate > lastLine ||
+            findWay(candidate & m_setMask, candidate >> m_setBits) < m_wayCount ||
+            std::find(m_prefetchQueue.begin(), m_prefetchQueue.end(), candidate) !=
+                m_prefetchQueue.end())
+        {
+            continue;
+        }
+        if (m_prefetchQueue.size() == PREFETCH_QUEUE_SIZE)
+        {
+            m_prefetchQueue.pop_front(); // too old to still be wanted
+        }
+        m_prefetchQueue.push_back(candidate);
+    }
+}
+
+void Cache::issuePrefetches()
+{
+    if (m_prefetchQueue.empty())
+    {
+        return;
+    }
+    const uint64_t line = m_prefetchQueue.front();
+    m_prefetchQueue.pop_front();
+    const size_t setIndex = line & m_setMask;
+    if (findWay(setIndex, line >> m_setBits) < m_wayCount)
+    {
+        return; // a demand access brought it in meanwhile
+    }
+    const size_t wayIndex = evictCacheLine(setIndex);
+    bringIn(line << m_offsetBits, setIndex, wayIndex);
+    m_storage.setPrefetched(setIndex, wayIndex, true);
+    ++m_prefetchIssuedCount;
+}
+
+void Cache::markLineChanged(size_t setIndex, size_t wayIndex)
+{
+    if (m_observer)
+    {
+        m_observer->noteLine(setIndex * m_wayCount + wayIndex);
+    }
 }
 
 std::span<const uint8_t> Cache::readLine(uint64_t address, size_t lineSize)
@@ -87,20 +238,21 @@ std::span<const uint8_t> Cache::readLine(uint64_t address, size_t lineSize)
     // a higher level cache will call this
     // if the line requested is not present we bring it from lower level memory devices
     assert(lineSize <= m_lineSizeInBytes && "Requested line size exceeds cache line size.");
+    if (m_prefetcher)
+    {
+        issuePrefetches();
+    }
     size_t setIndex = getSetIndex(address);
     uint64_t tag    = getTag(address);
     size_t wayIndex = findWay(setIndex, tag);
-    bool hit = false;
-    if (wayIndex >= m_wayCount)
+    bool hit = wayIndex < m_wayCount;
+    if (!hit)
     {
-        ++m_missCount;
         wayIndex = evictCacheLine(setIndex);
         bringIn(address, setIndex, wayIndex);
     }
     else 
     {
-        hit = true;
-        ++m_hitCount;
         touchWay(setIndex, wayIndex);
     }
     size_t offset = getOffset(address); // get offset for this level of cache
@@ -108,23 +260,25 @@ std::span<const uint8_t> Cache::readLine(uint64_t address, size_t lineSize)
                                        //with the address of the start of the line
                                        // and if size of this cache is larger than calling cache
                                        // address will not align
-    if(hit)emit cacheHitSignal(address);
-    else emit cacheMissSignal(address);
-    updateStats();
-    return std::span<const uint8_t>(m_sets[setIndex][wayIndex].data.data() + offset, lineSize);
+    recordAccess(address, hit);
+    return std::span<const uint8_t>(m_storage.lineData(setIndex, wayIndex) + offset, lineSize);
 }
 
 void Cache::writeLine(uint64_t address, std::span<const uint8_t> data)
 {
+    if (m_prefetcher)
+    {
+        issuePrefetches();
+    }
     size_t setIndex = getSetIndex(address);
     uint64_t tag    = getTag(address);
     size_t wayIndex = findWay(setIndex, tag);
-    bool hit = false;
-    if (wayIndex >= m_wayCount)
+    bool hit = wayIndex < m_wayCount;
+    if (!hit)
     {
-        m_missCount++;
         if(m_allocationPolicy == AllocationPolicy::NoWriteAllocate)
         {
+            recordAccess(address, hit);
             m_nextLevelMemoryRef.writeLine(address, data);
             return;
         }
@@ -136,13 +290,10 @@ void Cache::writeLine(uint64_t address, std::span<const uint8_t> data)
     }
     else
     {
-        hit = true;
-        ++m_hitCount;
         touchWay(setIndex, wayIndex);
     }
     size_t offset = getOffset(address); 
-    auto &line = m_sets[setIndex][wayIndex];
-    std::memcpy(line.data.data() + offset, data.data(), data.size());
+    std::memcpy(m_storage.lineData(setIndex, wayIndex) + offset, data.data(), data.size());
 
     if(m_writePolicy == WritePolicy::WriteThrough)
     {
@@ -150,12 +301,10 @@ void Cache::writeLine(uint64_t address, std::span<const uint8_t> data)
     }
     else if(m_writePolicy == WritePolicy::WriteBack)
     {
-        line.dirty = true;
+        m_storage.setDirty(setIndex, wayIndex, true);
     }
-    if(hit)emit cacheHitSignal(address);
-    else emit cacheMissSignal(address);
-    updateStats();
-    
+    markLineChanged(setIndex, wayIndex);
+    recordAccess(address, hit);
 }
 /**
  * @brief  Returns the way index of the cache line in the specified set that matches the given tag.
@@ -163,30 +312,25 @@ void Cache::writeLine(uint64_t address, std::span<const uint8_t> data)
  */
 size_t Cache::findWay(size_t setIndex, uint64_t tag) const
 {
-    const auto &set = m_sets[setIndex];
-    for (size_t way = 0; way < m_wayCount; ++way)
-    {
-        if (set[way].valid && set[way].tag == tag)
-        {
-            return way;
-        }
-    }
-    return m_wayCount; // not found
+    return m_storage.findWay(setIndex, tag);
 }
 
 void Cache::touchWay(size_t setIndex, size_t wayIndex)
 {
-    auto &line = m_sets[setIndex][wayIndex];
-
       // Update line age and lastAccess
-    line.lastAccess = ++m_timestampCounter;
-    line.age        = line.lastAccess;
-    line.frequency++;
+    m_storage.lastAccess(setIndex, wayIndex) = ++m_timestampCounter;
+    m_storage.age(setIndex, wayIndex)        = m_timestampCounter;
+    m_storage.frequency(setIndex, wayIndex)++;
+    if (m_storage.isPrefetched(setIndex, wayIndex))
+    {
+        m_storage.setPrefetched(setIndex, wayIndex, false);
+        ++m_prefetchUsefulCount;
+        m_prefetchHit = true;
+    }
 
     // Notify policy of access
-    CacheLineView view = {line.valid,      line.tag,        line.age,  line.frequency,
-                          line.insertTime, line.lastAccess, line.dirty};
-    CacheRequestView request = {0, setIndex, wayIndex, 0, 1, false, line.tag};
+    CacheLineView view = lineView(setIndex, wayIndex);
+    CacheRequestView request = {0, setIndex, wayIndex, 0, 1, false, view.tag};
     CacheContextView context = {m_setCount, m_wayCount, m_lineSizeInBytes, m_timestampCounter};
     m_ReplacementPolicy->onAccess(view, request, context);
 }
@@ -199,24 +343,18 @@ void Cache::touchWay(size_t setIndex, size_t wayIndex)
  */
 size_t Cache::evictCacheLine(size_t setIndex)
 {
-    auto &ways = m_sets[setIndex];
-
     // always prefer to evict an invalid line if available
-    for (size_t way = 0; way < m_wayCount; ++way)
+    size_t invalidWay = m_storage.firstInvalidWay(setIndex);
+    if (invalidWay < m_wayCount)
     {
-        if (!ways[way].valid)
-        {
-            return way;
-        }
+        return invalidWay;
     }
 
     // Build views for all valid lines in the set
-    std::vector<CacheLineView> line_views;
+    std::vector<CacheLineView> &line_views = m_victimViews;
     for (size_t way = 0; way < m_wayCount; ++way)
     {
-        const auto &line = ways[way];
-        line_views.push_back({line.valid, line.tag, line.age, line.frequency, line.insertTime,
-                              line.lastAccess, line.dirty});
+        line_views[way] = lineView(setIndex, way);
     }
 
     CacheRequestView request = {0, setIndex, 0, 0, 1, false, 0};
@@ -227,134 +365,97 @@ size_t Cache::evictCacheLine(size_t setIndex)
 
     // Notify policy of eviction and write back if dirty
     CacheLineView victim_view = line_views[victim];
+    request.wayIndex = victim;
     m_ReplacementPolicy->onEvict(victim_view, request, context);
 
-    if (ways[victim].dirty && m_writePolicy == WritePolicy::WriteBack)
+    if (m_storage.isDirty(setIndex, victim) && m_writePolicy == WritePolicy::WriteBack)
     {
         writeBack(setIndex, victim);
     }
+    if (m_storage.isPrefetched(setIndex, victim))
+    {
+        m_storage.setPrefetched(setIndex, victim, false);
+        ++m_prefetchUselessCount;
+    }
 
-    ways[victim].valid = false; // invalidate the line before bringing in new data
+    m_storage.setValid(setIndex, victim, false); // invalidate the line before bringing in new data
     return victim;
 }
 
 void Cache::writeBack(size_t setIndex, size_t wayIndex)
 {
-    CacheLine &line = m_sets[setIndex][wayIndex];
-    if (line.valid && line.dirty)
+    if (m_storage.isValid(setIndex, wayIndex) && m_storage.isDirty(setIndex, wayIndex))
     {
-        uint64_t lineStartAddress = 
-                            (line.tag << (m_setBits + m_offsetBits)) | (setIndex << m_offsetBits);
+        uint64_t lineStartAddress = (m_storage.tag(setIndex, wayIndex) << (m_setBits + m_offsetBits)) |
+                                    (setIndex << m_offsetBits);
 
-        m_nextLevelMemoryRef.writeLine(lineStartAddress, std::span<const uint8_t>(line.data));
-        line.dirty = false; 
+        m_nextLevelMemoryRef.writeLine(lineStartAddress,
+                                       std::span<const uint8_t>(m_storage.lineData(setIndex, wayIndex),
+                                                                m_lineSizeInBytes));
+        m_storage.setDirty(setIndex, wayIndex, false);
+        markLineChanged(setIndex, wayIndex);
         ++m_writeBackCount;
     }
 }
 
 void Cache::bringIn(uint64_t address, size_t setIndex, size_t wayIndex)
 {
-    CacheLine &line = m_sets[setIndex][wayIndex];
     uint64_t lineStartAddress = address & ~(m_offsetMask); // align address to block boundary
 
-    line.valid      = true;
-    line.dirty      = false;
-    line.tag        = getTag(address);
-    line.insertTime = ++m_timestampCounter;
-    line.lastAccess = line.insertTime;
-    line.age        = line.insertTime;
-    line.frequency  = 0;
+    m_storage.setValid(setIndex, wayIndex, true);
+    m_storage.setDirty(setIndex, wayIndex, false);
+    m_storage.setPrefetched(setIndex, wayIndex, false);
+    m_storage.tag(setIndex, wayIndex)        = getTag(address);
+    m_storage.insertTime(setIndex, wayIndex) = ++m_timestampCounter;
+    m_storage.lastAccess(setIndex, wayIndex) = m_timestampCounter;
+    m_storage.age(setIndex, wayIndex)        = m_timestampCounter;
+    m_storage.frequency(setIndex, wayIndex)  = 0;
 
     std::span<const uint8_t> lineFromNextLevel = m_nextLevelMemoryRef.readLine(lineStartAddress, 
                                                                                 m_lineSizeInBytes);
-    std::memcpy(line.data.data(), lineFromNextLevel.data(), m_lineSizeInBytes);
+    std::memcpy(m_storage.lineData(setIndex, wayIndex), lineFromNextLevel.data(), m_lineSizeInBytes);
 
 
     // Notify policy of insertion
-    CacheLineView view = {line.valid,      line.tag,        line.age,  line.frequency,
-                          line.insertTime, line.lastAccess, line.dirty};
+    CacheLineView view = lineView(setIndex, wayIndex);
     CacheRequestView request = {address, setIndex, wayIndex, getOffset(address),
-                                1,       false,     line.tag};
+                                1,       false,     view.tag};
     CacheContextView context = {m_setCount, m_wayCount, m_lineSizeInBytes, m_timestampCounter};
     m_ReplacementPolicy->onInsert(view, request, context);
+    markLineChanged(setIndex, wayIndex);
 }
 
-uint8_t Cache::getByteFromCache(uint64_t address)
-{
-    size_t   setIndex = getSetIndex(address);
-    uint64_t tag      = getTag(address);
-    size_t   wayIndex = findWay(setIndex, tag);
-    assert(wayIndex < m_wayCount && "getByteFromCache called on a cache line that is not present!");
-    return m_sets[setIndex][wayIndex].data[getOffset(address)];
-}
-
-void Cache::putByteInCache(uint64_t address, uint8_t value)
+/**
+ * @brief Looks up the line holding @p address once. A hit touches the line, a miss brings it in,
+ * except for a write under no-write-allocate, which leaves the cache alone and returns nullptr.
+ * A miss clears @p hit. A write marks the line dirty under write-back.
+ * @return Pointer to the byte at @p address inside the line.
+ */
+uint8_t *Cache::accessLine(uint64_t address, bool write, bool &hit)
 {
     size_t   setIndex = getSetIndex(address);
     uint64_t tag      = getTag(address);
     size_t   wayIndex = findWay(setIndex, tag);
-    CacheLine &line = m_sets[setIndex][wayIndex];
-    line.data[getOffset(address)] = value;
-
-    if (m_writePolicy == WritePolicy::WriteThrough)
+    if (wayIndex < m_wayCount)
     {
-        line.dirty = false;
+        touchWay(setIndex, wayIndex);
     }
     else
     {
-        line.dirty = true;
-    }
-}
-
-template<typename T>
-bool Cache::isHit(uint64_t address) const
-{
-    uint64_t currentAddress = address;
-    uint64_t endAddress = address + sizeof(T) - 1;
-    // we check if all the line that the data access will touch are in the cache
-    // because the data can be split across multiple cache lines
-    while(currentAddress <= endAddress)
-    {
-        size_t   setIndex = getSetIndex(currentAddress);
-        uint64_t tag      = getTag(currentAddress);
-        size_t   wayIndex = findWay(setIndex, tag);
-        if (wayIndex >= m_wayCount)
+        hit = false;
+        if (write && m_allocationPolicy == AllocationPolicy::NoWriteAllocate)
         {
-            return false;
+            return nullptr;
         }
-        currentAddress += m_lineSizeInBytes - getOffset(currentAddress); // move to the next cache line
-    }
-    return true;
-}
-
-template<typename T>
-void Cache::touchLines(uint64_t address)
-{
-    uint64_t currentAddress = address;
-    uint64_t endAddress = address + sizeof(T) - 1;
-    while(currentAddress <= endAddress)
-    {
-        size_t   setIndex = getSetIndex(currentAddress);
-        uint64_t tag      = getTag(currentAddress);
-        size_t   wayIndex = findWay(setIndex, tag);
-        touchWay(setIndex, wayIndex); // we know its a cache hit because we 
-                                      // check it before calling this function
-        currentAddress += m_lineSizeInBytes - getOffset(currentAddress);
+        wayIndex = evictCacheLine(setIndex);
+        bringIn(address, setIndex, wayIndex);
     }
-}
-
-template<typename T>
-void Cache::bringInLines(uint64_t address)
-{
-    uint64_t currentAddress = address;
-    uint64_t endAddress = address + sizeof(T) - 1;
-    while(currentAddress <= endAddress)
+    if (write)
     {
-        size_t   setIndex = getSetIndex(currentAddress);
-        size_t   wayIndex = evictCacheLine(setIndex);
-        bringIn(currentAddress, setIndex, wayIndex);
-        currentAddress += m_lineSizeInBytes - getOffset(currentAddress);
+        m_storage.setDirty(setIndex, wayIndex, m_writePolicy == WritePolicy::WriteBack);
+        markLineChanged(setIndex, wayIndex);
     }
+    return m_storage.lineData(setIndex, wayIndex) + getOffset(address);
 }
 
 template <typename T> 
@@ -365,40 +466,32 @@ T Cache::readGeneric(uint64_t address)
         throw std::out_of_range(std::string("Cache read address out of range: ") +
                                 std::to_string(address));
     }
-
-    // Multi-byte accesses can cross cache-line boundaries; handle them byte-wise.
-    // The issue here is that if we read byte wise the hits count will increase for every byte
-    // but we want it to count when all the byte are in the cache for the
-    // word/half-word/double-word access
-    bool hit = isHit<T>(address);
-    if(hit)
-    {
-        ++m_hitCount;
-        touchLines<T>(address);
-    }
-    else
+    if (m_prefetcher)
     {
-        ++m_missCount;
-        bringInLines<T>(address);
+        issuePrefetches();
     }
 
+    // An access counts as a hit only when every line it touches is in the cache
+    bool hit = true;
     T value = 0;
-    for(size_t i = 0; i < sizeof(T); ++i)
-    {
-        uint8_t byte = getByteFromCache(address + i);
-        value |= static_cast<T>(byte) << (8 * i);
-    }
-
-    if(hit)
+    if (getOffset(address) + sizeof(T) <= m_lineSizeInBytes)
     {
-        emit cacheHitSignal(address);
+        std::memcpy(&value, accessLine(address, false, hit), sizeof(T));
     }
     else
     {
-        emit cacheMissSignal(address);
+        // the access crosses a line boundary, copy it one line at a time
+        auto *bytes = reinterpret_cast<uint8_t *>(&value);
+        for (size_t done = 0; done < sizeof(T);)
+        {
+            const uint64_t current = address + done;
+            const size_t   chunk   = std::min(sizeof(T) - done, m_lineSizeInBytes - getOffset(current));
+            std::memcpy(bytes + done, accessLine(current, false, hit), chunk);
+            done += chunk;
+        }
     }
-    emit cacheLineUpdatedSignal(address);
-    updateStats();
+
+    recordAccess(address, hit);
     return value;
 }
 
@@ -410,77 +503,69 @@ void Cache::writeGeneric(uint64_t address, T value)
         throw std::out_of_range(std::string("Cache write address out of range: ") +
                                 std::to_string(address));
     }
+    if (m_prefetcher)
+    {
+        issuePrefetches();
+    }
 
-    bool hit = isHit<T>(address);
-    if(hit)
+    bool hit = true;
+    if (getOffset(address) + sizeof(T) <= m_lineSizeInBytes)
     {
-        ++m_hitCount;
-        touchLines<T>(address);
+        if (uint8_t *line = accessLine(address, true, hit))
+        {
+            std::memcpy(line, &value, sizeof(T));
+        }
     }
     else
     {
-        ++m_missCount;
-        
-        if(m_allocationPolicy == AllocationPolicy::NoWriteAllocate)
+        // the access crosses a line boundary; under no-write-allocate the lines that are
+        // present still take their part of the value so they do not go stale
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        for (size_t done = 0; done < sizeof(T);)
         {
-            if constexpr(std::is_same_v<T, uint8_t>)
+            const uint64_t current = address + done;
+            const size_t   chunk   = std::min(sizeof(T) - done, m_lineSizeInBytes - getOffset(current));
+            if (uint8_t *line = accessLine(current, true, hit))
             {
-                m_nextLevelMemoryRef.writeByte(address, static_cast<uint8_t>(value));
+                std::memcpy(line, bytes + done, chunk);
             }
-            else if constexpr(std::is_same_v<T, uint16_t>)
-            {
-                m_nextLevelMemoryRef.writeHalfWord(address, static_cast<uint16_t>(value));
-            }
-            else if constexpr(std::is_same_v<T, uint32_t>)
-            {
-                m_nextLevelMemoryRef.writeWord(address, static_cast<uint32_t>(value));
-            }
-            else if constexpr(std::is_same_v<T, uint64_t>)
-            {
-                m_nextLevelMemoryRef.writeDoubleWord(address, static_cast<uint64_t>(value));
-            }
-            return;
+            done += chunk;
         }
-        bringInLines<T>(address);
     }
 
-    for(size_t i = 0; i < sizeof(T); ++i)
+    if (!hit && m_allocationPolicy == AllocationPolicy::NoWriteAllocate)
     {
-        uint8_t byte = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
-        putByteInCache(address + i, byte);
+        recordAccess(address, hit);
+        writeToNextLevel(address, value);
+        return;
     }
-
     if(m_writePolicy == WritePolicy::WriteThrough)
     {
-        if constexpr(std::is_same_v<T, uint8_t>)
-        {
-            m_nextLevelMemoryRef.writeByte(address, static_cast<uint8_t>(value));
-        }
-        else if constexpr(std::is_same_v<T, uint16_t>)
-        {
-            m_nextLevelMemoryRef.writeHalfWord(address, static_cast<uint16_t>(value));
-        }
-        else if constexpr(std::is_same_v<T, uint32_t>)
-        {
-            m_nextLevelMemoryRef.writeWord(address, static_cast<uint32_t>(value));
-        }
-        else if constexpr(std::is_same_v<T, uint64_t>)
-        {
-            m_nextLevelMemoryRef.writeDoubleWord(address, static_cast<uint64_t>(value));
-        }
+        writeToNextLevel(address, value);
     }
 
-    if(hit)
+    recordAccess(address, hit);
+}
+
+template <typename T>
+void Cache::writeToNextLevel(uint64_t address, T value)
+{
+    if constexpr(std::is_same_v<T, uint8_t>)
     {
-        emit cacheHitSignal(address);
+        m_nextLevelMemoryRef.writeByte(address, value);
     }
-    else
+    else if constexpr(std::is_same_v<T, uint16_t>)
     {
-        emit cacheMissSignal(address);
+        m_nextLevelMemoryRef.writeHalfWord(address, value);
+    }
+    else if constexpr(std::is_same_v<T, uint32_t>)
+    {
+        m_nextLevelMemoryRef.writeWord(address, value);
+    }
+    else if constexpr(std::is_same_v<T, uint64_t>)
+    {
+        m_nextLevelMemoryRef.writeDoubleWord(address, value);
     }
-    emit cacheLineUpdatedSignal(address);
-    updateStats();
-
 }
 
 uint8_t Cache::readByte(uint64_t address)
@@ -525,23 +610,25 @@ void Cache::writeDoubleWord(uint64_t address, uint64_t value)
 
 void Cache::reset()
 {
-    for (auto &set : m_sets)
+    m_storage.clear();
+    m_ReplacementPolicy->reset();
+    if (m_observer)
     {
-        for (auto &line : set)
-        {
-            line.valid      = false;
-            line.dirty      = false;
-            line.age        = 0;
-            line.insertTime = 0;
-            line.lastAccess = 0;
-            line.frequency  = 0;
-            std::fill(std::begin(line.data), std::end(line.data), 0);
-        }
+        m_observer->noteAllLines();
     }
     m_timestampCounter = 0;
     m_hitCount = 0;
     m_missCount = 0;
     m_writeBackCount = 0;
+    m_prefetchIssuedCount = 0;
+    m_prefetchUsefulCount = 0;
+    m_prefetchUselessCount = 0;
+    m_prefetchLateCount = 0;
+    m_prefetchQueue.clear();
+    if (m_prefetcher)
+    {
+        m_prefetcher->reset();
+    }
     updateStats();
 }
 
@@ -551,7 +638,7 @@ void Cache::flush()
     {
         for (size_t wayIndex = 0; wayIndex < m_wayCount; ++wayIndex)
         {
-            if (m_sets[setIndex][wayIndex].valid && m_sets[setIndex][wayIndex].dirty)
+            if (m_storage.isValid(setIndex, wayIndex) && m_storage.isDirty(setIndex, wayIndex))
             {
                 writeBack(setIndex, wayIndex);
             }
@@ -560,18 +647,131 @@ void Cache::flush()
     reset();
 }
 
-void Cache::updateStats()
+CacheState Cache::saveState() const
+{
+    std::vector<uint8_t> policyState;
+    m_ReplacementPolicy->saveState(policyState);
+    return CacheState{
+        .config           = getConfig(),
+        .storage          = m_storage,
+        .timestampCounter = m_timestampCounter,
+        .hitCount         = m_hitCount,
+        .missCount        = m_missCount,
+        .writeBackCount   = m_writeBackCount,
+        .prefetchIssuedCount  = m_prefetchIssuedCount,
+        .prefetchUsefulCount  = m_prefetchUsefulCount,
+        .prefetchUselessCount = m_prefetchUselessCount,
+        .prefetchLateCount    = m_prefetchLateCount,
+        .policyState          = std::move(policyState)
+    };
+}
+
+void Cache::restoreState(const CacheState &state)
+{
+    const CacheConfig current = getConfig();
+    if (current.lineCount != state.config.lineCount ||
+        current.lineSizeInBytes != state.config.lineSizeInBytes ||
+        current.wayCount != state.config.wayCount || current.writePolicy != state.config.writePolicy ||
+        current.allocationPolicy != state.config.allocationPolicy ||
+        current.replacementPolicy != state.config.replacementPolicy ||
+        current.prefetcher != state.config.prefetcher ||
+        current.prefetchDegree != state.config.prefetchDegree ||
+        current.prefetchDistance != state.config.prefetchDistance)
+    {
+        // the cache was reconfigured after the state was saved; unlike reconfigure() nothing is
+        // flushed, the lines are about to be overwritten
+        m_writePolicy      = state.config.writePolicy;
+        m_allocationPolicy = state.config.allocationPolicy;
+        if (current.replacementPolicy != state.config.replacementPolicy)
+        {
+            m_ReplacementPolicy = createPolicy(state.config.replacementPolicy, m_customPolicyScriptPath);
+        }
+        setPrefetcher(state.config.prefetcher, state.config.prefetchDegree,
+                      state.config.prefetchDistance);
+        setupCache(state.config.lineCount, state.config.lineSizeInBytes, state.config.wayCount);
+        emit cacheReconfiguredSignal(state.config);
+    }
+    m_storage          = state.storage;
+    size_t policyOffset = 0;
+    m_ReplacementPolicy->reset();
+    m_ReplacementPolicy->restoreState(state.policyState, policyOffset);
+    if (m_observer)
+    {
+        m_observer->noteAllLines();
+    }
+    m_timestampCounter = state.timestampCounter;
+    m_hitCount         = state.hitCount;
+    m_missCount        = state.missCount;
+    m_writeBackCount   = state.writeBackCount;
+    m_prefetchIssuedCount  = state.prefetchIssuedCount;
+    m_prefetchUsefulCount  = state.prefetchUsefulCount;
+    m_prefetchUselessCount = state.prefetchUselessCount;
+    m_prefetchLateCount    = state.prefetchLateCount;
+    // the queue and the prefetcher's training are not saved, it relearns from here
+    m_prefetchQueue.clear();
+    if (m_prefetcher)
+    {
+        m_prefetcher->reset();
+    }
+    m_undoBuffer.clear();
+    updateStats();
+}
+
+CacheStats Cache::getStats() const
 {
     CacheStats stats;
     stats.hitCount         = m_hitCount;
     stats.missCount        = m_missCount;
     stats.writeBackCount   = m_writeBackCount;
-    stats.hitRate          = m_hitCount + m_missCount > 0 ?
-                             static_cast<double>(m_hitCount) / (m_hitCount + m_missCount): 0.0;
-    stats.cacheSizeInBytes = m_setCount * m_wayCount * m_lineSizeInBytes;
-    // For write-backs, we would need to track them in the WriteBack function
-    // stats.writeBacks = write_backs_;
-    emit cacheStatsUpdatedSignal(stats);
+    stats.hitRate          = getHitRate();
+    stats.cacheSizeInBytes = getCacheSizeInBytes();
+    stats.prefetchIssuedCount  = m_prefetchIssuedCount;
+    stats.prefetchUsefulCount  = m_prefetchUsefulCount;
+    stats.prefetchUselessCount = m_prefetchUselessCount;
+    stats.prefetchLateCount    = m_prefetchLateCount;
+    if (m_prefetchIssuedCount > 0)
+    {
+        stats.prefetchAccuracy = static_cast<double>(m_prefetchUsefulCount) / m_prefetchIssuedCount;
+    }
+    if (m_prefetchUsefulCount + m_missCount > 0)
+    {
+        stats.prefetchCoverage = static_cast<double>(m_prefetchUsefulCount) /
+                                 (m_prefetchUsefulCount + m_missCount);
+    }
+    return stats;
+}
+
+void Cache::updateStats()
+{
+    emit cacheStatsUpdatedSignal(getStats());
+}
+
+void Cache::setObserved(bool observed)
+{
+    if (!observed)
+    {
+        m_observer.reset();
+    }
+    else if (!m_observer)
+    {
+        m_observer = std::make_unique<CacheObserver>(m_setCount * m_wayCount);
+    }
+}
+
+bool Cache::isObserved() const
+{
+    return m_observer != nullptr;
+}
+
+void Cache::publishChanges(bool force)
+{
+    if (!m_observer || !m_observer->hasChanges() || (!force && !m_observer->frameElapsed()))
+    {
+        return;
+    }
+    const CacheUpdate update = m_observer->take(getStats());
+    emit cacheStatsUpdatedSignal(update.stats);
+    emit cacheChangesPublishedSignal(update);
 }
 
 void Cache::loadCustomPolicyScript(const std::string &path)
@@ -631,6 +831,10 @@ size_t Cache::getCacheSizeInBytes() const
 {
     return m_setCount * m_wayCount * m_lineSizeInBytes;
 }
+bool Cache::contains(uint64_t address) const
+{
+    return findWay(getSetIndex(address), getTag(address)) < m_wayCount;
+}
 // Address Decomposition Helper Functions
 uint64_t Cache::getTag(uint64_t address) const
 {
@@ -652,8 +856,15 @@ CacheConfig Cache::getConfig() const
         .wayCount = m_wayCount,
         .writePolicy = m_writePolicy,
         .allocationPolicy = m_allocationPolicy,
-        .replacementPolicy = m_ReplacementPolicy->type()
+        .replacementPolicy = m_ReplacementPolicy->type(),
+        .prefetcher = m_prefetcher ? m_prefetcher->type() : PrefetcherType::None,
+        .prefetchDegree = m_prefetchDegree,
+        .prefetchDistance = m_prefetchDistance
     };
 }
-}//namespace Kites
 
+const std::string &Cache::getCustomPolicyScriptPath() const
+{
+    return m_customPolicyScriptPath;
+}
+}//namespace Kites
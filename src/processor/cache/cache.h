@@ -9,8 +9,11 @@
 
 // #include "processor/memory_controller.h"
 #include "cacheconfig.h"
+#include "cache_observer.h"
+#include "cache_storage.h"
 #include "policies/cache_replacement_policy.h"
 #include "policies/custom_policy.h"
+#include "prefetchers/cache_prefetcher.h"
 #include "processor/main_memory.h"
 #include <QObject>
 #include "processor/memory_device.h"
@@ -49,6 +52,26 @@ struct CacheChange
     CacheLine newCacheLine;
 
 };
+/**
+ * @brief Everything needed to put a cache back the way it was: its configuration, its lines
+ * (including their replacement metadata), its clock and its statistics.
+ * State a custom policy script keeps on its own side is not part of it.
+ */
+struct CacheState
+{
+    CacheConfig config{};
+    CacheStorage storage{};
+    uint64_t timestampCounter{0};
+    size_t hitCount{0};
+    size_t missCount{0};
+    size_t writeBackCount{0};
+    size_t prefetchIssuedCount{0};
+    size_t prefetchUsefulCount{0};
+    size_t prefetchUselessCount{0};
+    size_t prefetchLateCount{0};
+    std::vector<uint8_t> policyState{}; // what the replacement policy keeps besides the lines
+};
+
 //default values for cache configuration
 //maybe we will move its location later on 
 namespace default_cache_config
@@ -77,6 +100,18 @@ public:
 
 
     void reconfigure(CacheConfig newConfig);
+    /**
+     * @brief Replaces the prefetcher, PrefetcherType::None removing it. Lines already prefetched
+     * stay, queued prefetches are dropped.
+     */
+    void setPrefetcher(PrefetcherType type, size_t degree, size_t distance);
+    /**
+     * @brief The instruction making the next accesses, for prefetchers that go by pc.
+     */
+    void setAccessPc(uint64_t pc)
+    {
+        m_accessPc = pc;
+    }
 
     // void BringInCache(uint64_t address);
 
@@ -97,6 +132,10 @@ public:
     void reset();
     void flush(); // write back all dirty lines to memory and and invalidate all lines in cache
 
+    // Checkpointing: restoring does not write anything back, the next level is restored separately
+    [[nodiscard]] CacheState saveState() const;
+    void restoreState(const CacheState &state);
+
     // Statistics
     [[nodiscard]]size_t getHitCount()  const;
     [[nodiscard]]size_t getMissCount() const;
@@ -107,15 +146,34 @@ public:
     [[nodiscard]]size_t getLineSizeInBytes() const;
     [[nodiscard]]size_t getCacheSizeInBytes() const;
 
+    /**
+     * @brief Whether the line holding @p address is cached. Counts no access and changes nothing.
+     */
+    [[nodiscard]] bool contains(uint64_t address) const;
+
     // Address Decomposition Helper Functions
     [[nodiscard]]uint64_t getTag(uint64_t address) const;
     [[nodiscard]]size_t getSetIndex(uint64_t address) const;
     [[nodiscard]]size_t getOffset(uint64_t address) const;
 
     CacheConfig getConfig() const;
+    // script the Custom policy runs, empty if none was loaded
+    [[nodiscard]] const std::string &getCustomPolicyScriptPath() const;
+    [[nodiscard]] CacheStats getStats() const;
     void updateStats();
 
-    const CacheLine &getCacheLine(size_t setIndex, size_t wayIndex) const;
+    // Observation for views. Accesses never emit signals: an observed cache collects the lines
+    // it changes and publishChanges() sends them as one cacheChangesPublishedSignal.
+    void setObserved(bool observed);
+    [[nodiscard]] bool isObserved() const;
+    /**
+     * @brief Publishes what changed since the last call, if anything did. Unless @p force is
+     * set, does nothing until a frame has passed since the last publish.
+     */
+    void publishChanges(bool force = true);
+
+    // a copy assembled from the cache storage, for display
+    CacheLine getCacheLine(size_t setIndex, size_t wayIndex) const;
 public slots:
     void loadCustomPolicyScript(const std::string &path);
 
@@ -128,19 +186,22 @@ private:
     size_t evictCacheLine(size_t setIndex);
     void writeBack(size_t setIndex, size_t wayIndex);
     void bringIn(uint64_t address, size_t setIndex, size_t wayIndex);
+    CacheLineView lineView(size_t setIndex, size_t wayIndex) const;
+    void recordAccess(uint64_t address, bool hit);
+    void trainPrefetcher(uint64_t address, bool hit);
+    void issuePrefetches();
+    void markLineChanged(size_t setIndex, size_t wayIndex);
     // These functions are used to read and write
-    uint8_t getByteFromCache(uint64_t address);  
-    void putByteInCache(uint64_t address, uint8_t value);
-    template <typename T> bool isHit(uint64_t address) const;
-    template <typename T> void touchLines(uint64_t address);
-    template <typename T> void bringInLines(uint64_t address);
+    uint8_t *accessLine(uint64_t address, bool write, bool &hit);
     template <typename T> T readGeneric(uint64_t address);
     template <typename T> void writeGeneric(uint64_t address, T value);
+    template <typename T> void writeToNextLevel(uint64_t address, T value);
 
     // Data Members
     MemoryDevice& m_nextLevelMemoryRef; //either memory or next level cache
     
-    std::vector<std::vector<CacheLine>> m_sets; // each set contains wayCount cache lines
+    CacheStorage m_storage;                     // tags, flags, policy metadata and data of all lines
+    std::vector<CacheLineView> m_victimViews;   // reused by evictCacheLine
     uint64_t m_timestampCounter {0};           // cache-wide clock for replacement metadata
 
     size_t m_wayCount{0};
@@ -151,6 +212,16 @@ private:
     std::unique_ptr<CacheReplacementPolicy> m_ReplacementPolicy;
     std::string m_customPolicyScriptPath;
 
+    // Prefetching. Candidates wait in the queue and are filled one per demand access, before it
+    // is looked up, as if the next level had been free in between.
+    std::unique_ptr<CachePrefetcher> m_prefetcher; // null when prefetching is off
+    size_t m_prefetchDegree{1};
+    size_t m_prefetchDistance{1};
+    std::deque<uint64_t> m_prefetchQueue;          // line numbers, oldest first
+    std::vector<uint64_t> m_prefetchCandidates;    // reused by trainPrefetcher
+    uint64_t m_accessPc{0};
+    bool m_prefetchHit{false};                     // the access being recorded used a prefetched line
+
     // precomputed bit masks for tag, index and offset
     size_t m_offsetBits{0};
     size_t m_setBits{0};
@@ -161,15 +232,17 @@ private:
     size_t m_hitCount  {0};
     size_t m_missCount {0};
     size_t m_writeBackCount {0}; 
+    size_t m_prefetchIssuedCount {0};
+    size_t m_prefetchUsefulCount {0};
+    size_t m_prefetchUselessCount {0};
+    size_t m_prefetchLateCount {0};
+    std::unique_ptr<CacheObserver> m_observer; // null unless a view is attached
     // common setup function 
     void setupCache(size_t cache_size, size_t lineSizeInBytes,size_t wayCount); 
     //TODO get this buffer size from config
     UndoBuffer<CacheChange> m_undoBuffer{100};
 signals:
-    //TODO : Maybe we can combine hit and miss into one signal with a bool parameter
-    void cacheMissSignal(uint64_t address);
-    void cacheHitSignal(uint64_t address);
-    void cacheLineUpdatedSignal(uint64_t address);
+    void cacheChangesPublishedSignal(const CacheUpdate &update);
     void cacheReconfiguredSignal(CacheConfig newConfig);
     void cacheStatsUpdatedSignal(CacheStats newStats);
     void customPolicyScriptLoadedSignal(bool success, const std::string &errorMessage = "");
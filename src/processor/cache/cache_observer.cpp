@@ -0,0 +1,40 @@
+#include "processor/cache/cache_observer.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+CacheObserver::CacheObserver(size_t lineCount) : m_marked(lineCount, 0)
+{
+}
+
+bool CacheObserver::frameElapsed() const
+{
+    return std::chrono::steady_clock::now() - m_lastTake >= FRAME_INTERVAL;
+}
+
+CacheUpdate CacheObserver::take(const CacheStats &stats)
+{
+    CacheUpdate update;
+    update.allLinesChanged = m_allChanged;
+    update.hasAccess       = m_hasAccess;
+    update.lastAddress     = m_lastAddress;
+    update.lastAccessHit   = m_lastAccessHit;
+    update.stats           = stats;
+
+    for (size_t line : m_changed)
+    {
+        m_marked[line] = 0;
+    }
+    if (!m_allChanged)
+    {
+        std::sort(m_changed.begin(), m_changed.end());
+        update.changedLines = std::move(m_changed);
+    }
+    m_changed.clear();
+    m_allChanged = false;
+    m_hasAccess  = false;
+    m_lastTake   = std::chrono::steady_clock::now();
+    return update;
+}
+}//namespace Kites
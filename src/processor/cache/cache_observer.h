@@ -0,0 +1,83 @@
+#pragma once
+
+#include "cacheconfig.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Everything about a cache that changed since the previous update was published.
+ */
+struct CacheUpdate
+{
+    std::vector<size_t> changedLines{}; ///< set * wayCount + way of each changed line, ascending
+    bool allLinesChanged{false};        ///< reset, flush or restore: changedLines is left empty
+    bool hasAccess{false};              ///< lastAddress and lastAccessHit are meaningful
+    uint64_t lastAddress{0};            ///< address of the most recent access
+    bool lastAccessHit{false};
+    CacheStats stats{};
+};
+
+/**
+ * @brief Collects what a cache changes between two UI updates, so they can be published as one.
+ *
+ * A cache without an observer only counts hits and misses. Once observed, it marks every line
+ * whose contents or flags change and remembers the last access; publishing hands the marks over
+ * as a CacheUpdate and starts collecting again.
+ */
+class CacheObserver
+{
+  public:
+    /// Continuous runs publish at most once per frame of a 60 Hz display
+    static constexpr std::chrono::milliseconds FRAME_INTERVAL{16};
+
+    explicit CacheObserver(size_t lineCount);
+
+    void noteLine(size_t line)
+    {
+        if (!m_marked[line])
+        {
+            m_marked[line] = 1;
+            m_changed.push_back(line);
+        }
+    }
+    void noteAllLines()
+    {
+        m_allChanged = true;
+    }
+    void noteAccess(uint64_t address, bool hit)
+    {
+        m_hasAccess     = true;
+        m_lastAddress   = address;
+        m_lastAccessHit = hit;
+    }
+
+    [[nodiscard]] bool hasChanges() const
+    {
+        return m_hasAccess || m_allChanged || !m_changed.empty();
+    }
+
+    /**
+     * @brief True if a frame has passed since the last take().
+     */
+    [[nodiscard]] bool frameElapsed() const;
+
+    /**
+     * @brief Returns what changed, with @p stats attached, and starts collecting afresh.
+     */
+    CacheUpdate take(const CacheStats &stats);
+
+  private:
+    std::vector<uint8_t> m_marked; // one entry per line, set while the line is in m_changed
+    std::vector<size_t> m_changed;
+    bool m_allChanged{false};
+    bool m_hasAccess{false};
+    uint64_t m_lastAddress{0};
+    bool m_lastAccessHit{false};
+    std::chrono::steady_clock::time_point m_lastTake{};
+};
+}//namespace Kites
@@ -0,0 +1,51 @@
+#include "processor/cache/cache_storage.h"
+
+namespace Kites
+{
+void CacheStorage::resize(size_t setCount, size_t wayCount, size_t lineSize)
+{
+    m_wayCount  = wayCount;
+    m_lineSize  = lineSize;
+    m_maskWords = (wayCount + 63) / 64;
+
+    const size_t lines = setCount * wayCount;
+    m_tags.assign(lines, 0);
+    m_validBits.assign(setCount * m_maskWords, 0);
+    m_dirtyBits.assign(setCount * m_maskWords, 0);
+    m_prefetchedBits.assign(setCount * m_maskWords, 0);
+    m_age.assign(lines, 0);
+    m_insertTime.assign(lines, 0);
+    m_lastAccess.assign(lines, 0);
+    m_frequency.assign(lines, 0);
+    m_data.assign(lines * lineSize, 0);
+}
+
+void CacheStorage::clear()
+{
+    std::fill(m_tags.begin(), m_tags.end(), 0);
+    std::fill(m_validBits.begin(), m_validBits.end(), 0);
+    std::fill(m_dirtyBits.begin(), m_dirtyBits.end(), 0);
+    std::fill(m_prefetchedBits.begin(), m_prefetchedBits.end(), 0);
+    std::fill(m_age.begin(), m_age.end(), 0);
+    std::fill(m_insertTime.begin(), m_insertTime.end(), 0);
+    std::fill(m_lastAccess.begin(), m_lastAccess.end(), 0);
+    std::fill(m_frequency.begin(), m_frequency.end(), 0);
+    std::fill(m_data.begin(), m_data.end(), 0);
+}
+
+size_t CacheStorage::firstInvalidWay(size_t setIndex) const
+{
+    for (size_t word = 0; word < m_maskWords; ++word)
+    {
+        const size_t first = word * 64;
+        const size_t count = std::min<size_t>(64, m_wayCount - first);
+        const uint64_t inUse = count == 64 ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+        const uint64_t invalid = ~m_validBits[setIndex * m_maskWords + word] & inUse;
+        if (invalid != 0)
+        {
+            return first + static_cast<size_t>(std::countr_zero(invalid));
+        }
+    }
+    return m_wayCount;
+}
+}//namespace Kites
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace Kites
+{
+/**
+ * @brief Compares @p count (at most 64) consecutive tags against @p tag.
+ * @return A mask with bit i set if tags[i] == tag.
+ *
+ * Uses the widest vector compare the build targets: 8 tags at a time with AVX-512, 4 with AVX2,
+ * 2 with SSE2 or NEON, so a 16-way set takes 2 to 8 compares and no branch per way.
+ */
+inline uint64_t matchTags(const uint64_t *tags, size_t count, uint64_t tag)
+{
+    uint64_t mask = 0;
+    size_t i = 0;
+#if defined(__AVX512F__)
+    const __m512i needle = _mm512_set1_epi64(static_cast<long long>(tag));
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m512i row = _mm512_loadu_si512(tags + i);
+        mask |= static_cast<uint64_t>(_mm512_cmpeq_epi64_mask(row, needle)) << i;
+    }
+#elif defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(tag));
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags + i));
+        const __m256i equal = _mm256_cmpeq_epi64(row, needle);
+        mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(equal))) << i;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i needle = _mm_set1_epi64x(static_cast<long long>(tag));
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags + i));
+        // SSE2 has no 64-bit compare: a tag matches when both of its 32-bit halves do
+        const __m128i halves = _mm_cmpeq_epi32(row, needle);
+        const __m128i equal = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        mask |= static_cast<uint64_t>(_mm_movemask_pd(_mm_castsi128_pd(equal))) << i;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint64x2_t needle = vdupq_n_u64(tag);
+    for (; i + 2 <= count; i += 2)
+    {
+        const uint64x2_t equal = vceqq_u64(vld1q_u64(tags + i), needle);
+        const uint64_t lanes = (vgetq_lane_u64(equal, 0) & 1) | ((vgetq_lane_u64(equal, 1) & 1) << 1);
+        mask |= lanes << i;
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        mask |= static_cast<uint64_t>(tags[i] == tag) << i;
+    }
+    return mask;
+}
+
+/**
+ * @brief Line storage of a cache, laid out as structure of arrays.
+ *
+ * Every per-line field is its own array indexed by set * wayCount + way, so the tags of a set
+ * are contiguous and can be compared with matchTags. Valid, dirty and prefetched flags are
+ * bitmasks, one 64-bit word per 64 ways of a set, and the line data of the whole cache is a
+ * single slab.
+ */
+class CacheStorage
+{
+  public:
+    /**
+     * @brief Reallocates for a new geometry. Every line ends up invalid and zeroed.
+     */
+    void resize(size_t setCount, size_t wayCount, size_t lineSize);
+
+    /**
+     * @brief Invalidates every line and zeroes its metadata and data.
+     */
+    void clear();
+
+    /**
+     * @brief Way holding @p tag in the set, or wayCount() if none does.
+     */
+    [[nodiscard]] size_t findWay(size_t setIndex, uint64_t tag) const
+    {
+        for (size_t word = 0; word < m_maskWords; ++word)
+        {
+            const size_t first = word * 64;
+            const size_t count = std::min<size_t>(64, m_wayCount - first);
+            const uint64_t hits = matchTags(&m_tags[slot(setIndex, first)], count, tag) &
+                                  m_validBits[setIndex * m_maskWords + word];
+            if (hits != 0)
+            {
+                return first + static_cast<size_t>(std::countr_zero(hits));
+            }
+        }
+        return m_wayCount;
+    }
+
+    /**
+     * @brief First invalid way of the set, or wayCount() if the set is full.
+     */
+    [[nodiscard]] size_t firstInvalidWay(size_t setIndex) const;
+
+    [[nodiscard]] size_t wayCount() const
+    {
+        return m_wayCount;
+    }
+    [[nodiscard]] size_t lineSize() const
+    {
+        return m_lineSize;
+    }
+
+    [[nodiscard]] bool isValid(size_t setIndex, size_t wayIndex) const
+    {
+        return testBit(m_validBits, setIndex, wayIndex);
+    }
+    [[nodiscard]] bool isDirty(size_t setIndex, size_t wayIndex) const
+    {
+        return testBit(m_dirtyBits, setIndex, wayIndex);
+    }
+    /**
+     * @brief Set on lines a prefetch brought in until a demand access first uses them.
+     */
+    [[nodiscard]] bool isPrefetched(size_t setIndex, size_t wayIndex) const
+    {
+        return testBit(m_prefetchedBits, setIndex, wayIndex);
+    }
+    void setValid(size_t setIndex, size_t wayIndex, bool value)
+    {
+        assignBit(m_validBits, setIndex, wayIndex, value);
+    }
+    void setDirty(size_t setIndex, size_t wayIndex, bool value)
+    {
+        assignBit(m_dirtyBits, setIndex, wayIndex, value);
+    }
+    void setPrefetched(size_t setIndex, size_t wayIndex, bool value)
+    {
+        assignBit(m_prefetchedBits, setIndex, wayIndex, value);
+    }
+
+    [[nodiscard]] uint64_t &tag(size_t setIndex, size_t wayIndex)
+    {
+        return m_tags[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t tag(size_t setIndex, size_t wayIndex) const
+    {
+        return m_tags[slot(setIndex, wayIndex)];
+    }
+
+    // Replacement policy metadata
+    [[nodiscard]] uint64_t &age(size_t setIndex, size_t wayIndex)
+    {
+        return m_age[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t age(size_t setIndex, size_t wayIndex) const
+    {
+        return m_age[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t &insertTime(size_t setIndex, size_t wayIndex)
+    {
+        return m_insertTime[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t insertTime(size_t setIndex, size_t wayIndex) const
+    {
+        return m_insertTime[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t &lastAccess(size_t setIndex, size_t wayIndex)
+    {
+        return m_lastAccess[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t lastAccess(size_t setIndex, size_t wayIndex) const
+    {
+        return m_lastAccess[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t &frequency(size_t setIndex, size_t wayIndex)
+    {
+        return m_frequency[slot(setIndex, wayIndex)];
+    }
+    [[nodiscard]] uint64_t frequency(size_t setIndex, size_t wayIndex) const
+    {
+        return m_frequency[slot(setIndex, wayIndex)];
+    }
+
+    [[nodiscard]] uint8_t *lineData(size_t setIndex, size_t wayIndex)
+    {
+        return m_data.data() + slot(setIndex, wayIndex) * m_lineSize;
+    }
+    [[nodiscard]] const uint8_t *lineData(size_t setIndex, size_t wayIndex) const
+    {
+        return m_data.data() + slot(setIndex, wayIndex) * m_lineSize;
+    }
+
+  private:
+    [[nodiscard]] size_t slot(size_t setIndex, size_t wayIndex) const
+    {
+        return setIndex * m_wayCount + wayIndex;
+    }
+    [[nodiscard]] bool testBit(const std::vector<uint64_t> &bits, size_t setIndex,
+                               size_t wayIndex) const
+    {
+        return (bits[setIndex * m_maskWords + wayIndex / 64] >> (wayIndex % 64)) & 1;
+    }
+    void assignBit(std::vector<uint64_t> &bits, size_t setIndex, size_t wayIndex, bool value)
+    {
+        uint64_t &word = bits[setIndex * m_maskWords + wayIndex / 64];
+        const uint64_t bit = uint64_t{1} << (wayIndex % 64);
+        word = value ? word | bit : word & ~bit;
+    }
+
+    size_t m_wayCount{0};
+    size_t m_lineSize{0};
+    size_t m_maskWords{0}; // 64-bit words of flag bits per set
+
+    std::vector<uint64_t> m_tags;
+    std::vector<uint64_t> m_validBits;
+    std::vector<uint64_t> m_dirtyBits;
+    std::vector<uint64_t> m_prefetchedBits;
+    std::vector<uint64_t> m_age;
+    std::vector<uint64_t> m_insertTime;
+    std::vector<uint64_t> m_lastAccess;
+    std::vector<uint64_t> m_frequency;
+    std::vector<uint8_t> m_data; // line (set, way) starts at (set * wayCount + way) * lineSize
+};
+}//namespace Kites
@@ -0,0 +1,233 @@
+#include "processor/cache/cache_sweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Kites
+{
+namespace
+{
+CacheConfig &levelConfig(CacheHierarchyConfig &hierarchy, CacheLevel level)
+{
+    switch (level)
+    {
+    case CacheLevel::INSTRUCTION:
+        return hierarchy.instruction;
+    case CacheLevel::L2:
+        return hierarchy.l2;
+    default:
+        return hierarchy.l1;
+    }
+}
+
+double missRateOf(const CacheStats &stats)
+{
+    const size_t accesses = stats.hitCount + stats.missCount;
+    return accesses == 0 ? 0.0 : static_cast<double>(stats.missCount) / accesses;
+}
+
+CacheSweepResult evaluate(const AddressTrace &trace, const CacheHierarchyConfig &point,
+                          CacheLevel level, const CacheLatencies &latencies)
+{
+    const TraceReplayResult replay = replayTrace(trace, point);
+    CacheSweepResult result;
+    result.hierarchy = point;
+    result.config = levelConfig(result.hierarchy, level);
+    switch (level)
+    {
+    case CacheLevel::INSTRUCTION:
+        result.stats = replay.instruction;
+        break;
+    case CacheLevel::L2:
+        result.stats = replay.l2;
+        break;
+    default:
+        result.stats = replay.l1;
+        break;
+    }
+    result.missRate = missRateOf(result.stats);
+
+    const CacheStats &first = level == CacheLevel::INSTRUCTION ? replay.instruction : replay.l1;
+    const double l2Time = latencies.l2Hit + missRateOf(replay.l2) * latencies.memory;
+    result.amat = latencies.l1Hit + missRateOf(first) * l2Time;
+    return result;
+}
+
+const char *writePolicyName(WritePolicy policy)
+{
+    return policy == WritePolicy::WriteBack ? "WB" : "WT";
+}
+
+const char *allocationPolicyName(AllocationPolicy policy)
+{
+    return policy == AllocationPolicy::WriteAllocate ? "WA" : "NWA";
+}
+
+const char *prefetcherName(PrefetcherType prefetcher)
+{
+    switch (prefetcher)
+    {
+    case PrefetcherType::NextLine:
+        return "next";
+    case PrefetcherType::Stride:
+        return "stride";
+    case PrefetcherType::Stream:
+        return "stream";
+    default:
+        return "none";
+    }
+}
+
+const char *replacementPolicyName(ReplacementPolicy policy)
+{
+    switch (policy)
+    {
+    case ReplacementPolicy::LRU:
+        return "LRU";
+    case ReplacementPolicy::FIFO:
+        return "FIFO";
+    case ReplacementPolicy::Custom:
+        return "Custom";
+    case ReplacementPolicy::TreePLRU:
+        return "TreePLRU";
+    case ReplacementPolicy::BitPLRU:
+        return "BitPLRU";
+    case ReplacementPolicy::SRRIP:
+        return "SRRIP";
+    case ReplacementPolicy::BRRIP:
+        return "BRRIP";
+    case ReplacementPolicy::DRRIP:
+        return "DRRIP";
+    case ReplacementPolicy::LFU:
+        return "LFU";
+    case ReplacementPolicy::Random:
+        return "Random";
+    }
+    return "?";
+}
+}
+
+std::vector<CacheHierarchyConfig> enumerateSweep(const CacheSweepSpace &space,
+                                                 const CacheHierarchyConfig &base)
+{
+    auto allPowersOfTwo = [](const std::vector<size_t> &values)
+    {
+        return std::all_of(values.begin(), values.end(),
+                           [](size_t value) { return std::has_single_bit(value); });
+    };
+    if (!allPowersOfTwo(space.setCounts) || !allPowersOfTwo(space.lineSizes))
+    {
+        throw std::invalid_argument("Cache sweep set counts and line sizes must be powers of two");
+    }
+
+    const size_t count = space.setCounts.size() * space.wayCounts.size() *
+                         space.lineSizes.size() * space.writePolicies.size() *
+                         space.allocationPolicies.size() * space.replacementPolicies.size() *
+                         space.prefetchers.size();
+    std::vector<CacheHierarchyConfig> points(count, base);
+    for (size_t i = 0; i < count; ++i)
+    {
+        // read i as a mixed radix number, the prefetcher being the fastest digit
+        size_t rest = i;
+        auto pick = [&rest](const auto &values)
+        {
+            const auto &value = values[rest % values.size()];
+            rest /= values.size();
+            return value;
+        };
+        CacheConfig config{};
+        config.prefetcher        = pick(space.prefetchers);
+        config.prefetchDegree    = space.prefetchDegree;
+        config.prefetchDistance  = space.prefetchDistance;
+        config.replacementPolicy = pick(space.replacementPolicies);
+        config.allocationPolicy  = pick(space.allocationPolicies);
+        config.writePolicy       = pick(space.writePolicies);
+        config.lineSizeInBytes   = pick(space.lineSizes);
+        config.wayCount          = pick(space.wayCounts);
+        config.lineCount         = pick(space.setCounts);
+        levelConfig(points[i], space.level) = config;
+    }
+    return points;
+}
+
+std::vector<CacheSweepResult> runCacheSweep(const AddressTrace &trace,
+                                            const std::vector<CacheHierarchyConfig> &points,
+                                            CacheLevel level, const CacheLatencies &latencies,
+                                            unsigned int threadCount)
+{
+    std::vector<CacheSweepResult> results(points.size());
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, points.size()));
+
+    // points differ a lot in cost, so threads take the next one as they finish instead of
+    // splitting the list up front
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < points.size(); i = next++)
+        {
+            try
+            {
+                results[i] = evaluate(trace, points[i], level, latencies);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure)
+                {
+                    failure = std::current_exception();
+                }
+                next = points.size();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < threadCount; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    return results;
+}
+
+std::string formatSweepTable(const std::vector<CacheSweepResult> &results)
+{
+    std::string table = "sets ways line write alloc repl     prefetch   hit_rate miss_rate write_backs "
+                        "pf_accuracy     amat\n";
+    char row[160];
+    for (const CacheSweepResult &result : results)
+    {
+        const CacheConfig &config = result.config;
+        std::snprintf(row, sizeof(row),
+                      "%4zu %4zu %4zu %5s %5s %8s %8s %10.4f %9.4f %11zu %11.4f %8.3f\n",
+                      config.lineCount, config.wayCount, config.lineSizeInBytes,
+                      writePolicyName(config.writePolicy),
+                      allocationPolicyName(config.allocationPolicy),
+                      replacementPolicyName(config.replacementPolicy),
+                      prefetcherName(config.prefetcher), result.stats.hitRate, result.missRate,
+                      result.stats.writeBackCount, result.stats.prefetchAccuracy, result.amat);
+        table += row;
+    }
+    return table;
+}
+}//namespace Kites
@@ -0,0 +1,86 @@
+/**
+ * @file cache_sweep.h
+ * @brief Evaluates many cache configurations against one address trace in parallel.
+ */
+#pragma once
+
+#include "processor/cache/trace_replay.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Kites
+{
+enum class CacheLevel
+{
+    L1 = 0,
+    INSTRUCTION,
+    L2
+};
+
+/**
+ * @brief The values to try for one cache of the hierarchy; every combination becomes one point.
+ * Set counts and line sizes must be powers of two.
+ */
+struct CacheSweepSpace
+{
+    CacheLevel level = CacheLevel::L1;
+    std::vector<size_t> setCounts;
+    std::vector<size_t> wayCounts;
+    std::vector<size_t> lineSizes;
+    std::vector<WritePolicy> writePolicies{WritePolicy::WriteBack};
+    std::vector<AllocationPolicy> allocationPolicies{AllocationPolicy::WriteAllocate};
+    std::vector<ReplacementPolicy> replacementPolicies{ReplacementPolicy::LRU};
+    std::vector<PrefetcherType> prefetchers{PrefetcherType::None};
+    size_t prefetchDegree = 1;
+    size_t prefetchDistance = 1;
+};
+
+/**
+ * @brief Access times, in cycles, used for the average memory access time.
+ */
+struct CacheLatencies
+{
+    double l1Hit = 1.0;
+    double l2Hit = 10.0;
+    double memory = 100.0;
+};
+
+struct CacheSweepResult
+{
+    CacheHierarchyConfig hierarchy;
+    CacheConfig config; ///< the swept cache, as it appears in hierarchy
+    CacheStats stats;   ///< of the swept cache
+    double missRate = 0.0;
+    /**
+     * @brief Average memory access time in cycles of the path through the swept cache: fetches
+     * for the instruction cache, loads and stores otherwise.
+     */
+    double amat = 0.0;
+};
+
+/**
+ * @brief Every combination of @p space applied to @p base, in the order of the nested loops sets,
+ * ways, line size, write, allocation and replacement policy, prefetcher. Throws std::invalid_argument if a
+ * set count or line size is not a power of two.
+ */
+std::vector<CacheHierarchyConfig> enumerateSweep(const CacheSweepSpace &space,
+                                                 const CacheHierarchyConfig &base);
+
+/**
+ * @brief Replays @p trace through every point on @p threadCount threads, zero meaning one per
+ * core. Each thread builds its own caches and only reads the trace, so points run independently.
+ * Results are in the order of @p points whatever the thread count.
+ */
+std::vector<CacheSweepResult> runCacheSweep(const AddressTrace &trace,
+                                            const std::vector<CacheHierarchyConfig> &points,
+                                            CacheLevel level, const CacheLatencies &latencies = {},
+                                            unsigned int threadCount = 0);
+
+/**
+ * @brief One line per result with the swept configuration, hit rate, miss rate, write backs,
+ * prefetch accuracy and AMAT, under a header line.
+ */
+std::string formatSweepTable(const std::vector<CacheSweepResult> &results);
+}//namespace Kites
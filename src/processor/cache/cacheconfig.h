@@ -20,7 +20,22 @@ enum class ReplacementPolicy
 {
     LRU = 0,
     FIFO,
-    Custom
+    Custom,
+    TreePLRU, // binary tree of ways-1 bits per set
+    BitPLRU,  // one MRU bit per way
+    SRRIP,    // 2-bit re-reference prediction, inserted at long
+    BRRIP,    // as SRRIP, but mostly inserted at distant
+    DRRIP,    // set dueling picks SRRIP or BRRIP insertion
+    LFU,
+    Random
+};
+
+enum class PrefetcherType
+{
+    None = 0,
+    NextLine,
+    Stride, // PC indexed reference prediction table
+    Stream
 };
 
 struct CacheConfig
@@ -31,6 +46,9 @@ struct CacheConfig
     WritePolicy writePolicy;
     AllocationPolicy allocationPolicy;
     ReplacementPolicy replacementPolicy;
+    PrefetcherType prefetcher = PrefetcherType::None;
+    size_t prefetchDegree     = 1; // lines requested per trigger
+    size_t prefetchDistance   = 1; // how many lines (or strides) ahead the first request is
 };
 
 struct CacheStats
@@ -40,6 +58,16 @@ struct CacheStats
     size_t writeBackCount   = 0;
     double hitRate          = 0.0;
     size_t cacheSizeInBytes = 0;
+
+    // a prefetch is issued once its line is actually filled; it is useful if a demand access
+    // hits it, useless if it is evicted untouched, and late if a demand access misses on its line
+    // while it still waits in the prefetch queue
+    size_t prefetchIssuedCount  = 0;
+    size_t prefetchUsefulCount  = 0;
+    size_t prefetchUselessCount = 0;
+    size_t prefetchLateCount    = 0;
+    double prefetchAccuracy     = 0.0; // useful / issued
+    double prefetchCoverage     = 0.0; // useful / (useful + misses), the misses prefetching removed
 };
 
 }//namespace Kites
@@ -47,4 +75,5 @@ struct CacheStats
 //for making the enums usable in Qt's combo box
 Q_DECLARE_METATYPE(Kites::WritePolicy)
 Q_DECLARE_METATYPE(Kites::AllocationPolicy)
-Q_DECLARE_METATYPE(Kites::ReplacementPolicy)
\ No newline at end of file
+Q_DECLARE_METATYPE(Kites::ReplacementPolicy)
+Q_DECLARE_METATYPE(Kites::PrefetcherType)
\ No newline at end of file
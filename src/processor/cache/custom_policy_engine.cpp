@@ -1,5 +1,6 @@
 #include "processor/cache/custom_policy_engine.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <string_view>
 
@@ -13,19 +14,45 @@ extern "C"
 
 }
 
-// we want hasfuction to be visible only within this file, so we put it in an anonymous namespace
-//  same as defining it static, but this is the more modern way to do it in C++
 namespace
 {
-bool hasFunction(lua_State *state, const char *name)
+constexpr std::array<const char *, static_cast<size_t>(CustomPolicyHook::Count)> HOOK_NAMES = {
+    "chooseVictim", "onAccess", "onInsert", "onEvict"};
+
+// the string at the top of the stack, or a compile error naming @p field
+std::string readString(lua_State *state, const std::string &field)
+{
+    if (lua_type(state, -1) != LUA_TSTRING)
+    {
+        throw PolicyCompileError("policy." + field + " must be a string, not " +
+                                 luaL_typename(state, -1));
+    }
+    return lua_tostring(state, -1);
+}
+
+// a string or a list of strings at the top of the stack
+std::vector<std::string> readStringList(lua_State *state, const std::string &field)
+{
+    if (!lua_istable(state, -1))
+    {
+        return {readString(state, field)};
+    }
+    std::vector<std::string> strings;
+    const lua_Integer count = static_cast<lua_Integer>(lua_rawlen(state, -1));
+    for (lua_Integer i = 1; i <= count; ++i)
+    {
+        lua_rawgeti(state, -1, i);
+        strings.push_back(readString(state, field + "[" + std::to_string(i) + "]"));
+        lua_pop(state, 1);
+    }
+    return strings;
+}
+
+// a fresh table kept alive in the registry
+int newTableRef(lua_State *state)
 {
-    // gets the fuction and then pushes it on the state
-    lua_getglobal(state, name);
-    // we check if the topmost value is a fuction
-    const bool isFunction = lua_isfunction(state, -1);
-    // pop the function (or non function)
-    lua_pop(state, 1);
-    return isFunction;
+    lua_newtable(state);
+    return luaL_ref(state, LUA_REGISTRYINDEX);
 }
 } // namespace
 
@@ -37,6 +64,10 @@ CustomPolicyEngine::CustomPolicyEngine() : m_state_(luaL_newstate())
     }
 
     luaL_openlibs(m_state_);
+    m_hook_refs_.fill(LUA_NOREF);
+    m_lines_ref_   = newTableRef(m_state_);
+    m_request_ref_ = newTableRef(m_state_);
+    m_context_ref_ = newTableRef(m_state_);
 }
 
 CustomPolicyEngine::~CustomPolicyEngine()
@@ -63,124 +94,318 @@ void CustomPolicyEngine::loadCustomPolicyScript(const std::string &path)
                                  "': " + message);
     }
 
+    resolveHooks(path);
     m_script_path_ = path;
 }
 
+void CustomPolicyEngine::resolveHooks(const std::string &path)
+{
+    std::array<bool, static_cast<size_t>(CustomPolicyHook::Count)> wanted{};
+    lua_getglobal(m_state_, "hooks");
+    if (lua_isnil(m_state_, -1))
+    {
+        wanted.fill(true); // no declaration, call whatever is defined
+    }
+    else if (lua_istable(m_state_, -1))
+    {
+        const lua_Integer count = static_cast<lua_Integer>(lua_rawlen(m_state_, -1));
+        for (lua_Integer i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(m_state_, -1, i);
+            const char *name = lua_type(m_state_, -1) == LUA_TSTRING ? lua_tostring(m_state_, -1)
+                                                                     : nullptr;
+            const auto found = name ? std::find_if(HOOK_NAMES.begin(), HOOK_NAMES.end(),
+                                                   [name](const char *hookName)
+                                                   { return std::string_view(hookName) == name; })
+                                    : HOOK_NAMES.end();
+            if (found == HOOK_NAMES.end())
+            {
+                const std::string entry = name ? name : luaL_typename(m_state_, -1);
+                lua_pop(m_state_, 2);
+                throw std::runtime_error("Custom policy script '" + path +
+                                         "' lists unknown hook '" + entry + "' in hooks");
+            }
+            wanted[static_cast<size_t>(found - HOOK_NAMES.begin())] = true;
+            lua_pop(m_state_, 1);
+        }
+        // a victim is always needed, listing it is optional
+        wanted[static_cast<size_t>(CustomPolicyHook::ChooseVictim)] = true;
+    }
+    else
+    {
+        lua_pop(m_state_, 1);
+        throw std::runtime_error("Custom policy script '" + path +
+                                 "': hooks must be a list of function names");
+    }
+    lua_pop(m_state_, 1);
+
+    for (size_t hook = 0; hook < m_hook_refs_.size(); ++hook)
+    {
+        luaL_unref(m_state_, LUA_REGISTRYINDEX, m_hook_refs_[hook]);
+        m_hook_refs_[hook] = LUA_NOREF;
+        if (!wanted[hook])
+        {
+            continue;
+        }
+        lua_getglobal(m_state_, HOOK_NAMES[hook]);
+        if (lua_isfunction(m_state_, -1))
+        {
+            m_hook_refs_[hook] = luaL_ref(m_state_, LUA_REGISTRYINDEX);
+        }
+        else
+        {
+            lua_pop(m_state_, 1);
+        }
+    }
+}
+
 bool CustomPolicyEngine::hasScript() const
 {
     return !m_script_path_.empty();
 }
 
+bool CustomPolicyEngine::hasHook(CustomPolicyHook hook) const
+{
+    return m_hook_refs_[static_cast<size_t>(hook)] != LUA_NOREF;
+}
+
+std::optional<PolicyDescription> CustomPolicyEngine::readPolicyDescription() const
+{
+    const int top = lua_gettop(m_state_);
+    lua_getglobal(m_state_, "policy");
+    if (lua_isnil(m_state_, -1))
+    {
+        lua_settop(m_state_, top);
+        return std::nullopt;
+    }
+
+    PolicyDescription description;
+    try
+    {
+        if (!lua_istable(m_state_, -1))
+        {
+            throw PolicyCompileError("policy must be a table");
+        }
+        lua_pushnil(m_state_);
+        while (lua_next(m_state_, -2) != 0)
+        {
+            // key at -2, value at -1; a table key or a function value is not a policy field
+            const std::string key = lua_type(m_state_, -2) == LUA_TSTRING
+                                        ? lua_tostring(m_state_, -2)
+                                        : std::string(luaL_typename(m_state_, -2));
+            if (key == "counters")
+            {
+                description.counters = readStringList(m_state_, key);
+            }
+            else if (key == "victim")
+            {
+                description.victim = readStringList(m_state_, key);
+            }
+            else if (key == "onAccess")
+            {
+                description.onAccess = readString(m_state_, key);
+            }
+            else if (key == "onInsert")
+            {
+                description.onInsert = readString(m_state_, key);
+            }
+            else if (key == "onEvict")
+            {
+                description.onEvict = readString(m_state_, key);
+            }
+            else
+            {
+                throw PolicyCompileError("policy." + key + " is not supported");
+            }
+            lua_pop(m_state_, 1);
+        }
+    }
+    catch (const PolicyCompileError &)
+    {
+        lua_settop(m_state_, top);
+        throw;
+    }
+    lua_settop(m_state_, top);
+    return description;
+}
+
 size_t CustomPolicyEngine::callChooseVictim(std::span<const CacheLineView> cacheLines,
                                             const CacheRequestView &request,
                                             const CacheContextView &context)
 {
-    return callChooseVictimFunction("chooseVictim", cacheLines, request, context, true);
+    const char *functionName = HOOK_NAMES[static_cast<size_t>(CustomPolicyHook::ChooseVictim)];
+    if (!hasHook(CustomPolicyHook::ChooseVictim))
+    {
+        throw std::runtime_error(std::string("Custom policy script does not define function '") +
+                                 functionName + "'");
+    }
+    if (cacheLines.empty())
+    {
+        throw std::runtime_error(std::string("Custom policy function '") + functionName +
+                                 "' was called with no cache lines");
+    }
+
+    callHook(CustomPolicyHook::ChooseVictim, cacheLines, request, context, 1);
+
+    if (!lua_isinteger(m_state_, -1))
+    {
+        lua_pop(m_state_, 1);
+        throw std::runtime_error(std::string("Custom policy function '") + functionName +
+                                 "' must return an integer victim index");
+    }
+
+    const lua_Integer returnedIndex = lua_tointeger(m_state_, -1);
+    lua_pop(m_state_, 1);
+
+    if (returnedIndex < 0)
+    {
+        throw std::runtime_error(std::string("Custom policy function '") + functionName +
+                                 "' returned a negative victim index");
+    }
+
+    if (returnedIndex > static_cast<lua_Integer>(cacheLines.size()))
+    {
+        throw std::runtime_error(std::string("Custom policy function '") + functionName +
+                                 "' returned an out-of-range victim index");
+    }
+
+    if (returnedIndex == 0)
+    {
+        return 0;
+    }
+
+    return static_cast<size_t>(returnedIndex - 1);
 }
 
 void CustomPolicyEngine::callOnAccess(std::span<const CacheLineView> cacheLines,
                                       const CacheRequestView &request,
                                       const CacheContextView &context)
 {
-    callOptionalVoidFunction("onAccess", cacheLines, request, context);
+    if (hasHook(CustomPolicyHook::OnAccess))
+    {
+        callHook(CustomPolicyHook::OnAccess, cacheLines, request, context, 0);
+    }
 }
 
 void CustomPolicyEngine::callOnInsert(std::span<const CacheLineView> cacheLines,
                                       const CacheRequestView &request,
                                       const CacheContextView &context)
 {
-    callOptionalVoidFunction("onInsert", cacheLines, request, context);
+    if (hasHook(CustomPolicyHook::OnInsert))
+    {
+        callHook(CustomPolicyHook::OnInsert, cacheLines, request, context, 0);
+    }
 }
 
 void CustomPolicyEngine::callOnEvict(std::span<const CacheLineView> cacheLines,
                                      const CacheRequestView &request,
                                      const CacheContextView &context)
 {
-    callOptionalVoidFunction("onEvict", cacheLines, request, context);
+    if (hasHook(CustomPolicyHook::OnEvict))
+    {
+        callHook(CustomPolicyHook::OnEvict, cacheLines, request, context, 0);
+    }
 }
 
-void CustomPolicyEngine::pushLineTable(lua_State *state, const CacheLineView &line, size_t index)
+void CustomPolicyEngine::pushLinesTable(std::span<const CacheLineView> cacheLines)
 {
-    lua_newtable(state);
+    lua_rawgeti(m_state_, LUA_REGISTRYINDEX, m_lines_ref_);
+    const int lines = lua_gettop(m_state_);
 
-    lua_pushinteger(state, static_cast<lua_Integer>(index));
-    lua_setfield(state, -2, "index");
+    for (size_t i = 0; i < cacheLines.size(); ++i)
+    {
+        if (i == m_line_refs_.size())
+        {
+            // a line table always sits at the same index, so that field never changes
+            lua_newtable(m_state_);
+            lua_pushinteger(m_state_, static_cast<lua_Integer>(i));
+            lua_setfield(m_state_, -2, "index");
+            m_line_refs_.push_back(luaL_ref(m_state_, LUA_REGISTRYINDEX));
+        }
+        lua_rawgeti(m_state_, LUA_REGISTRYINDEX, m_line_refs_[i]);
+        const CacheLineView &line = cacheLines[i];
 
-    lua_pushboolean(state, line.valid);
-    lua_setfield(state, -2, "valid");
+        lua_pushboolean(m_state_, line.valid);
+        lua_setfield(m_state_, -2, "valid");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(line.tag));
-    lua_setfield(state, -2, "tag");
+        lua_pushinteger(m_state_, static_cast<lua_Integer>(line.tag));
+        lua_setfield(m_state_, -2, "tag");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(line.age));
-    lua_setfield(state, -2, "age");
+        lua_pushinteger(m_state_, static_cast<lua_Integer>(line.age));
+        lua_setfield(m_state_, -2, "age");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(line.frequency));
-    lua_setfield(state, -2, "frequency");
+        lua_pushinteger(m_state_, static_cast<lua_Integer>(line.frequency));
+        lua_setfield(m_state_, -2, "frequency");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(line.insertTime));
-    lua_setfield(state, -2, "insertTime");
+        lua_pushinteger(m_state_, static_cast<lua_Integer>(line.insertTime));
+        lua_setfield(m_state_, -2, "insertTime");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(line.lastAccess));
-    lua_setfield(state, -2, "lastAccess");
+        lua_pushinteger(m_state_, static_cast<lua_Integer>(line.lastAccess));
+        lua_setfield(m_state_, -2, "lastAccess");
 
-    lua_pushboolean(state, line.dirty);
-    lua_setfield(state, -2, "dirty");
-}
+        lua_pushboolean(m_state_, line.dirty);
+        lua_setfield(m_state_, -2, "dirty");
 
-void CustomPolicyEngine::pushLinesTable(lua_State *state, std::span<const CacheLineView> cacheLines)
-{
-    lua_newtable(state);
-
-    for (size_t i = 0; i < cacheLines.size(); ++i)
+        if (i >= m_lines_length_)
+        {
+            // using i + 1 since Lua tables are 1 indexed
+            lua_rawseti(m_state_, lines, static_cast<lua_Integer>(i + 1));
+        }
+        else
+        {
+            lua_pop(m_state_, 1); // already in place from an earlier call
+        }
+    }
+    // a shorter span than last time, e.g. a single line for the hooks after a whole set
+    for (size_t i = cacheLines.size(); i < m_lines_length_; ++i)
     {
-        pushLineTable(state, cacheLines[i], i);
-        // using i + 1 since Lua tables are 1 indexed
-        lua_seti(state, -2, static_cast<lua_Integer>(i + 1));
+        lua_pushnil(m_state_);
+        lua_rawseti(m_state_, lines, static_cast<lua_Integer>(i + 1));
     }
+    m_lines_length_ = cacheLines.size();
 }
 
-void CustomPolicyEngine::pushRequestTable(lua_State *state, const CacheRequestView &request)
+void CustomPolicyEngine::pushRequestTable(const CacheRequestView &request)
 {
-    lua_newtable(state);
+    lua_rawgeti(m_state_, LUA_REGISTRYINDEX, m_request_ref_);
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.address));
-    lua_setfield(state, -2, "address");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.address));
+    lua_setfield(m_state_, -2, "address");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.setIndex));
-    lua_setfield(state, -2, "setIndex");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.setIndex));
+    lua_setfield(m_state_, -2, "setIndex");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.wayIndex));
-    lua_setfield(state, -2, "wayIndex");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.wayIndex));
+    lua_setfield(m_state_, -2, "wayIndex");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.offset));
-    lua_setfield(state, -2, "offset");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.offset));
+    lua_setfield(m_state_, -2, "offset");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.accessSize));
-    lua_setfield(state, -2, "accessSize");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.accessSize));
+    lua_setfield(m_state_, -2, "accessSize");
 
-    lua_pushboolean(state, request.isWrite);
-    lua_setfield(state, -2, "isWrite");
+    lua_pushboolean(m_state_, request.isWrite);
+    lua_setfield(m_state_, -2, "isWrite");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(request.tag));
-    lua_setfield(state, -2, "tag");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(request.tag));
+    lua_setfield(m_state_, -2, "tag");
 }
 
-void CustomPolicyEngine::pushContextTable(lua_State *state, const CacheContextView &context)
+void CustomPolicyEngine::pushContextTable(const CacheContextView &context)
 {
-    lua_newtable(state);
+    lua_rawgeti(m_state_, LUA_REGISTRYINDEX, m_context_ref_);
 
-    lua_pushinteger(state, static_cast<lua_Integer>(context.setCount));
-    lua_setfield(state, -2, "setCount");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(context.setCount));
+    lua_setfield(m_state_, -2, "setCount");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(context.wayCount));
-    lua_setfield(state, -2, "wayCount");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(context.wayCount));
+    lua_setfield(m_state_, -2, "wayCount");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(context.blockSize));
-    lua_setfield(state, -2, "blockSize");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(context.blockSize));
+    lua_setfield(m_state_, -2, "blockSize");
 
-    lua_pushinteger(state, static_cast<lua_Integer>(context.tick));
-    lua_setfield(state, -2, "tick");
+    lua_pushinteger(m_state_, static_cast<lua_Integer>(context.tick));
+    lua_setfield(m_state_, -2, "tick");
 }
 
 std::string CustomPolicyEngine::readLuaError(lua_State *state)
@@ -189,104 +414,25 @@ std::string CustomPolicyEngine::readLuaError(lua_State *state)
     return message ? std::string(message) : std::string("unknown Lua error");
 }
 
-size_t CustomPolicyEngine::callChooseVictimFunction(const char *functionName,
-                                                    std::span<const CacheLineView> cacheLines,
-                                                    const CacheRequestView &request,
-                                                    const CacheContextView &context, bool required)
+void CustomPolicyEngine::callHook(CustomPolicyHook hook, std::span<const CacheLineView> cacheLines,
+                                  const CacheRequestView &request,
+                                  const CacheContextView &context, int results)
 {
-    if (!m_state_)
-    {
-        throw std::runtime_error("Lua state is not initialized");
-    }
+    lua_rawgeti(m_state_, LUA_REGISTRYINDEX, m_hook_refs_[static_cast<size_t>(hook)]);
 
-    if (!hasFunction(m_state_, functionName))
-    {
-        if (required)
-        {
-            throw std::runtime_error(
-                std::string("Custom policy script does not define function '") + functionName +
-                "'");
-        }
-        return 0;
-    }
-
-    // hasFunction only validates existence; push the callback to call it with pcall.
-    lua_getglobal(m_state_, functionName);
-
-    pushLinesTable(m_state_, cacheLines);
-    pushRequestTable(m_state_, request);
-    pushContextTable(m_state_, context);
+    pushLinesTable(cacheLines);
+    pushRequestTable(request);
+    pushContextTable(context);
 
     // lua_pcall (protected call) will call the function
     // at the top of the stack
     // the args are no of args,no of return values and error function (0 means no error function)
-    if (lua_pcall(m_state_, 3, 1, 0) != LUA_OK)
-    {
-        std::string message = readLuaError(m_state_);
-        lua_pop(m_state_, 1);
-        throw std::runtime_error(std::string("Custom policy script function '") + functionName +
-                                 "' failed: " + message);
-    }
-
-    if (!lua_isinteger(m_state_, -1))
-    {
-        lua_pop(m_state_, 1);
-        throw std::runtime_error(std::string("Custom policy function '") + functionName +
-                                 "' must return an integer victim index");
-    }
-
-    const lua_Integer returnedIndex = lua_tointeger(m_state_, -1);
-    lua_pop(m_state_, 1);
-
-    if (returnedIndex < 0)
-    {
-        throw std::runtime_error(std::string("Custom policy function '") + functionName +
-                                 "' returned a negative victim index");
-    }
-
-    if (cacheLines.empty())
-    {
-        throw std::runtime_error(std::string("Custom policy function '") + functionName +
-                                 "' was called with no cache lines");
-    }
-
-    if (returnedIndex > static_cast<lua_Integer>(cacheLines.size()))
-    {
-        throw std::runtime_error(std::string("Custom policy function '") + functionName +
-                                 "' returned an out-of-range victim index");
-    }
-
-    if (returnedIndex == 0)
-    {
-        return 0;
-    }
-
-    return static_cast<size_t>(returnedIndex - 1);
-}
-
-void CustomPolicyEngine::callOptionalVoidFunction(const char *functionName,
-                                                  std::span<const CacheLineView> cacheLines,
-                                                  const CacheRequestView &request,
-                                                  const CacheContextView &context)
-{
-    if (!m_state_ || !hasFunction(m_state_, functionName))
-    {
-        return;
-    }
-
-    // hasFunction pops the probed value, so push the function again for pcall.
-    lua_getglobal(m_state_, functionName);
-
-    pushLinesTable(m_state_, cacheLines);
-    pushRequestTable(m_state_, request);
-    pushContextTable(m_state_, context);
-
-    if (lua_pcall(m_state_, 3, 0, 0) != LUA_OK)
+    if (lua_pcall(m_state_, 3, results, 0) != LUA_OK)
     {
         std::string message = readLuaError(m_state_);
         lua_pop(m_state_, 1);
-        throw std::runtime_error(std::string("Custom policy script function '") + functionName +
-                                 "' failed: " + message);
+        throw std::runtime_error(std::string("Custom policy script function '") +
+                                 HOOK_NAMES[static_cast<size_t>(hook)] + "' failed: " + message);
     }
 }
 }//namespace Kites
\ No newline at end of file
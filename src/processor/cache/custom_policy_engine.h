@@ -1,10 +1,14 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <optional>
 #include <span>
 #include <string>
+#include <vector>
 
 #include "processor/cache/policies/cache_replacement_policy.h"
+#include "processor/cache/policy_compiler.h"
 
 namespace Kites
 {
@@ -13,6 +17,27 @@ namespace Kites
 // providing interface to call lua functiona and pass cache state to the lua script
 struct lua_State;
 
+/**
+ * @brief The functions a custom policy script can define. A script may list the ones it wants
+ * called in a global `hooks` table; the others are then skipped even if defined.
+ */
+enum class CustomPolicyHook
+{
+    ChooseVictim = 0,
+    OnAccess,
+    OnInsert,
+    OnEvict,
+    Count
+};
+
+/**
+ * @brief Runs a Lua replacement policy.
+ *
+ * The hook functions are looked up once per script load and kept as registry references. The
+ * lines, request and cache tables handed to them are allocated once and overwritten in place on
+ * every call, so a call allocates nothing on the Lua heap. Scripts must treat them as read-only
+ * and keep their own state in their own tables.
+ */
 class CustomPolicyEngine
 {
   public:
@@ -38,25 +63,43 @@ class CustomPolicyEngine
 
     bool hasScript() const;
 
+    /**
+     * @brief Whether the loaded script defines @p hook and, if it declares its hooks, lists it.
+     */
+    bool hasHook(CustomPolicyHook hook) const;
+
+    /**
+     * @brief Reads the loaded script's `policy` table, if it has one.
+     * @throws PolicyCompileError if the table holds anything but the fields of a
+     * PolicyDescription, as strings or lists of strings.
+     */
+    std::optional<PolicyDescription> readPolicyDescription() const;
+
   private:
     lua_State *m_state_ = nullptr;
     std::string m_script_path_;
 
-    // These push functions convert the cache state into Lua tables and push them onto the Lua stack
-    // for the custom policy functions to consume
-    static void pushLineTable(lua_State *state, const CacheLineView &line, size_t index);
-    static void pushLinesTable(lua_State *state, std::span<const CacheLineView> cacheLines);
-    static void pushRequestTable(lua_State *state, const CacheRequestView &request);
-    static void pushContextTable(lua_State *state, const CacheContextView &context);
+    // registry references, LUA_NOREF for hooks that are not called
+    std::array<int, static_cast<size_t>(CustomPolicyHook::Count)> m_hook_refs_;
+    int m_lines_ref_;
+    int m_request_ref_;
+    int m_context_ref_;
+    std::vector<int> m_line_refs_; // one table per way, reused by every call
+    size_t m_lines_length_ = 0;    // entries currently set in the lines table
+
+    // Looks the hooks up after the script at @p path ran, honouring its hooks table
+    void resolveHooks(const std::string &path);
+
+    // These push functions write the cache state into the persistent tables and push those onto
+    // the Lua stack for the custom policy functions to consume
+    void pushLinesTable(std::span<const CacheLineView> cacheLines);
+    void pushRequestTable(const CacheRequestView &request);
+    void pushContextTable(const CacheContextView &context);
 
     static std::string readLuaError(lua_State *state);
 
-    size_t callChooseVictimFunction(const char *functionName,
-                                    std::span<const CacheLineView> cacheLines,
-                                    const CacheRequestView &request,
-                                    const CacheContextView &context, bool required);
-    void callOptionalVoidFunction(const char *functionName,
-                                  std::span<const CacheLineView> cacheLines,
-                                  const CacheRequestView &request, const CacheContextView &context);
+    // Pushes the hook and its three arguments, then calls it
+    void callHook(CustomPolicyHook hook, std::span<const CacheLineView> cacheLines,
+                  const CacheRequestView &request, const CacheContextView &context, int results);
 };
 }//namespace Kites
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "processor/cache/policies/bit_plru.h"
+
+namespace Kites
+{
+std::string_view BitPLRUReplacementPolicy::name() const
+{
+    return "Bit-PLRU";
+}
+
+ReplacementPolicy BitPLRUReplacementPolicy::type() const
+{
+    return ReplacementPolicy::BitPLRU;
+}
+
+void BitPLRUReplacementPolicy::fit(const CacheContextView &context)
+{
+    m_mruBits.fit(context.setCount, context.wayCount, 1);
+}
+
+void BitPLRUReplacementPolicy::touch(size_t setIndex, size_t wayIndex)
+{
+    m_mruBits.set(setIndex, wayIndex, 1);
+    for (size_t way = 0; way < m_mruBits.fieldsPerSet(); ++way)
+    {
+        if (!m_mruBits.get(setIndex, way))
+        {
+            return;
+        }
+    }
+    // every bit is set, start a new round with only the latest way marked
+    for (size_t way = 0; way < m_mruBits.fieldsPerSet(); ++way)
+    {
+        m_mruBits.set(setIndex, way, way == wayIndex);
+    }
+}
+
+size_t BitPLRUReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                              const CacheRequestView &request,
+                                              const CacheContextView &context)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+    }
+    fit(context);
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!m_mruBits.get(request.setIndex, i))
+        {
+            return i;
+        }
+    }
+    return 0; // only a single way set has all bits set
+}
+
+void BitPLRUReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                                        const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    touch(request.setIndex, request.wayIndex);
+}
+
+void BitPLRUReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                                        const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    touch(request.setIndex, request.wayIndex);
+}
+
+void BitPLRUReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                                       const CacheContextView &context)
+{
+    // the insert that follows marks the way
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void BitPLRUReplacementPolicy::reset()
+{
+    m_mruBits.clear();
+}
+
+void BitPLRUReplacementPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    m_mruBits.saveState(state);
+}
+
+void BitPLRUReplacementPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    m_mruBits.restoreState(state, offset);
+}
+}//namespace Kites
@@ -0,0 +1,44 @@
+#pragma once
+#include "cache_replacement_policy.h"
+#include "packed_set_state.h"
+
+namespace Kites
+{
+/**
+ * @brief Bit pseudo-LRU, also known as MRU bits. Each way has one bit set when it is used; once
+ * every way of a set has its bit set all but the latest are cleared. The victim is the first way
+ * whose bit is clear.
+ */
+class BitPLRUReplacementPolicy : public CacheReplacementPolicy
+{
+  public:
+    BitPLRUReplacementPolicy() = default;
+    ~BitPLRUReplacementPolicy() = default;
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context) override;
+
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context) override;
+
+    std::string_view name() const override;
+
+    ReplacementPolicy type() const override;
+
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+
+  private:
+    void fit(const CacheContextView &context);
+    void touch(size_t setIndex, size_t wayIndex);
+
+    PackedSetState m_mruBits;
+};
+}//namespace Kites
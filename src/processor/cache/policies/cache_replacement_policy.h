@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <span>
 #include <string_view>
+#include <vector>
 
 namespace Kites
 {
@@ -88,5 +89,31 @@ class CacheReplacementPolicy
     virtual std::string_view name() const = 0;
 
     virtual ReplacementPolicy type() const = 0;
+
+    /**
+     * @brief Forgets the policy's own state, e.g. when the cache is reset. Policies that decide
+     * from the line views alone keep none.
+     */
+    virtual void reset()
+    {
+    }
+
+    /**
+     * @brief Appends the policy's own state to @p state, so a cache restored from a checkpoint
+     * picks the same victims.
+     */
+    virtual void saveState(std::vector<uint8_t> &state) const
+    {
+        (void)state;
+    }
+
+    /**
+     * @brief Reads back what saveState stored, advancing @p offset past it.
+     */
+    virtual void restoreState(const std::vector<uint8_t> &state, size_t &offset)
+    {
+        (void)state;
+        (void)offset;
+    }
 };
 }//namespace Kites
\ No newline at end of file
@@ -29,12 +29,47 @@ void CustomReplacementPolicy::loadScript(const std::string &scriptPath)
     }
 
     m_engine_->loadCustomPolicyScript(scriptPath);
+
+    // a policy table that compiles runs natively, anything else falls back to the Lua hooks
+    m_compiled_.reset();
+    m_compile_error_.clear();
+    try
+    {
+        if (std::optional<PolicyDescription> description = m_engine_->readPolicyDescription())
+        {
+            m_compiled_ = std::make_unique<CompiledPolicy>(CompiledPolicy::compile(*description));
+        }
+    }
+    catch (const PolicyCompileError &e)
+    {
+        if (!m_engine_->hasHook(CustomPolicyHook::ChooseVictim))
+        {
+            throw std::runtime_error("Custom policy script '" + scriptPath +
+                                     "' has a policy table that cannot be compiled (" + e.what() +
+                                     ") and no chooseVictim function to fall back on");
+        }
+        m_compile_error_ = e.what();
+    }
+}
+
+bool CustomReplacementPolicy::isCompiled() const
+{
+    return m_compiled_ != nullptr;
+}
+
+std::string CustomReplacementPolicy::getCompileError() const
+{
+    return m_compile_error_;
 }
 
 size_t CustomReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
                                              const CacheRequestView &request,
                                              const CacheContextView &context)
 {
+    if (m_compiled_)
+    {
+        return m_compiled_->chooseVictim(lines, request, context);
+    }
     if (!m_engine_ || !m_engine_->hasScript())
     {
         throw std::runtime_error(
@@ -47,7 +82,13 @@ size_t CustomReplacementPolicy::chooseVictim(std::span<const CacheLineView> line
 void CustomReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
                                        const CacheContextView &context)
 {
-    if (!m_engine_ || !m_engine_->hasScript())
+    if (m_compiled_)
+    {
+        m_compiled_->onAccess(line, request, context);
+        return;
+    }
+    // hooks the script does not define or declare cost nothing
+    if (!m_engine_ || !m_engine_->hasHook(CustomPolicyHook::OnAccess))
     {
         return;
     }
@@ -58,7 +99,12 @@ void CustomReplacementPolicy::onAccess(const CacheLineView &line, const CacheReq
 void CustomReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
                                        const CacheContextView &context)
 {
-    if (!m_engine_ || !m_engine_->hasScript())
+    if (m_compiled_)
+    {
+        m_compiled_->onInsert(line, request, context);
+        return;
+    }
+    if (!m_engine_ || !m_engine_->hasHook(CustomPolicyHook::OnInsert))
     {
         return;
     }
@@ -69,7 +115,12 @@ void CustomReplacementPolicy::onInsert(const CacheLineView &line, const CacheReq
 void CustomReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
                                       const CacheContextView &context)
 {
-    if (!m_engine_ || !m_engine_->hasScript())
+    if (m_compiled_)
+    {
+        m_compiled_->onEvict(line, request, context);
+        return;
+    }
+    if (!m_engine_ || !m_engine_->hasHook(CustomPolicyHook::OnEvict))
     {
         return;
     }
@@ -87,6 +138,31 @@ ReplacementPolicy CustomReplacementPolicy::type() const
     return ReplacementPolicy::Custom;
 }
 
+void CustomReplacementPolicy::reset()
+{
+    if (m_compiled_)
+    {
+        m_compiled_->reset();
+    }
+}
+
+void CustomReplacementPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    // a Lua policy's tables live in the interpreter and are not saved
+    if (m_compiled_)
+    {
+        m_compiled_->saveState(state);
+    }
+}
+
+void CustomReplacementPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    if (m_compiled_ && offset < state.size())
+    {
+        m_compiled_->restoreState(state, offset);
+    }
+}
+
 std::string CustomReplacementPolicy::getScriptPath() const
 {
     return custom_policy_script_path_;
@@ -8,7 +8,13 @@
 namespace Kites
 {
 class CustomPolicyEngine;
+class CompiledPolicy;
 
+/**
+ * @brief A replacement policy loaded from a Lua script. A script with a `policy` table (see
+ * PolicyDescription) is compiled and run natively; otherwise, or if the table uses something the
+ * compiler does not support, its Lua hook functions are called.
+ */
 class CustomReplacementPolicy : public CacheReplacementPolicy
 {
   public:
@@ -35,12 +41,28 @@ class CustomReplacementPolicy : public CacheReplacementPolicy
 
     ReplacementPolicy type() const override;
 
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+
     void loadScript(const std::string &scriptPath);
 
     std::string getScriptPath() const;
 
+    /**
+     * @brief Whether the script's policy table was compiled, so no Lua runs per access.
+     */
+    bool isCompiled() const;
+
+    /**
+     * @brief Why the policy table could not be compiled, empty if it was or there is none.
+     */
+    std::string getCompileError() const;
+
   private:
     std::unique_ptr<CustomPolicyEngine> m_engine_;
+    std::unique_ptr<CompiledPolicy> m_compiled_;
+    std::string m_compile_error_;
     std::string custom_policy_script_path_;
 };
 }//namespace Kites
\ No newline at end of file
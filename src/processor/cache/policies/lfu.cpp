@@ -0,0 +1,64 @@
+#include "processor/cache/policies/lfu.h"
+
+namespace Kites
+{
+std::string_view LFUReplacementPolicy::name() const
+{
+    return "LFU";
+}
+
+ReplacementPolicy LFUReplacementPolicy::type() const
+{
+    return ReplacementPolicy::LFU;
+}
+
+size_t LFUReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                          const CacheRequestView &request,
+                                          const CacheContextView &context)
+{
+    (void)request;
+    (void)context;
+    size_t victim_index = 0;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+        const CacheLineView &victim = lines[victim_index];
+        if (lines[i].frequency < victim.frequency ||
+            (lines[i].frequency == victim.frequency && lines[i].lastAccess < victim.lastAccess))
+        {
+            victim_index = i;
+        }
+    }
+    return victim_index;
+}
+
+void LFUReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                                    const CacheContextView &context)
+{
+    // No internal state to update, the cache counts the hits in the frequency field
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void LFUReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                                    const CacheContextView &context)
+{
+    // No internal state to update, the cache clears the frequency of a new line
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void LFUReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                                   const CacheContextView &context)
+{
+    // No internal state to update on evict
+    (void)line;
+    (void)request;
+    (void)context;
+}
+}//namespace Kites
@@ -0,0 +1,32 @@
+#pragma once
+#include "cache_replacement_policy.h"
+
+namespace Kites
+{
+/**
+ * @brief Least frequently used. Evicts the line with the fewest hits since it was brought in,
+ * the least recently used of them on a tie. The hit counts live in the cache metadata.
+ */
+class LFUReplacementPolicy : public CacheReplacementPolicy
+{
+  public:
+    LFUReplacementPolicy() = default;
+    ~LFUReplacementPolicy() = default;
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context) override;
+
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context) override;
+
+    std::string_view name() const override;
+
+    ReplacementPolicy type() const override;
+};
+}//namespace Kites
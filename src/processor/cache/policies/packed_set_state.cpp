@@ -0,0 +1,52 @@
+#include "processor/cache/policies/packed_set_state.h"
+#include "processor/checkpoint_history.h"
+#include <algorithm>
+
+namespace Kites
+{
+void PackedSetState::fit(size_t setCount, size_t fieldsPerSet, unsigned int bitsPerField)
+{
+    if (setCount == m_setCount && fieldsPerSet == m_fieldsPerSet && bitsPerField == m_bitsPerField)
+    {
+        return;
+    }
+    reshape(setCount, fieldsPerSet, bitsPerField);
+}
+
+void PackedSetState::reshape(size_t setCount, size_t fieldsPerSet, unsigned int bitsPerField)
+{
+    m_setCount     = setCount;
+    m_fieldsPerSet = fieldsPerSet;
+    m_bitsPerField = bitsPerField;
+    m_fieldMask    = static_cast<uint8_t>((1u << bitsPerField) - 1);
+    m_bytesPerSet  = (fieldsPerSet * bitsPerField + 7) / 8;
+    m_bytes.assign(m_setCount * m_bytesPerSet, 0);
+}
+
+void PackedSetState::clear()
+{
+    std::fill(m_bytes.begin(), m_bytes.end(), 0);
+}
+
+void PackedSetState::saveState(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, static_cast<uint64_t>(m_setCount));
+    appendCheckpointState(state, static_cast<uint64_t>(m_fieldsPerSet));
+    appendCheckpointState(state, m_bitsPerField);
+    state.insert(state.end(), m_bytes.begin(), m_bytes.end());
+}
+
+void PackedSetState::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    uint64_t setCount = 0;
+    uint64_t fieldsPerSet = 0;
+    unsigned int bitsPerField = 1;
+    readCheckpointState(state, offset, setCount);
+    readCheckpointState(state, offset, fieldsPerSet);
+    readCheckpointState(state, offset, bitsPerField);
+    reshape(setCount, fieldsPerSet, bitsPerField);
+    std::copy_n(state.begin() + static_cast<std::ptrdiff_t>(offset), m_bytes.size(),
+                m_bytes.begin());
+    offset += m_bytes.size();
+}
+}//namespace Kites
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Small per-set replacement state packed into bytes, e.g. one PLRU bit or a 2-bit RRPV
+ * per way.
+ *
+ * Every set holds the same number of fields of 1, 2, 4 or 8 bits and starts on a byte of its
+ * own, so a field never straddles two bytes. All fields start out as zero.
+ */
+class PackedSetState
+{
+  public:
+    PackedSetState() = default;
+
+    /**
+     * @brief Resizes to @p setCount sets of @p fieldsPerSet fields and zeroes every field. Does
+     * nothing if the shape is unchanged, so a policy can call it on every hook.
+     */
+    void fit(size_t setCount, size_t fieldsPerSet, unsigned int bitsPerField);
+
+    /**
+     * @brief Zeroes every field, keeping the shape.
+     */
+    void clear();
+
+    uint8_t get(size_t setIndex, size_t field) const
+    {
+        const size_t bit = field * m_bitsPerField;
+        return (m_bytes[setIndex * m_bytesPerSet + bit / 8] >> (bit % 8)) & m_fieldMask;
+    }
+
+    void set(size_t setIndex, size_t field, uint8_t value)
+    {
+        const size_t bit = field * m_bitsPerField;
+        uint8_t &byte = m_bytes[setIndex * m_bytesPerSet + bit / 8];
+        byte = static_cast<uint8_t>((byte & ~(m_fieldMask << (bit % 8))) |
+                                    ((value & m_fieldMask) << (bit % 8)));
+    }
+
+    size_t setCount() const
+    {
+        return m_setCount;
+    }
+
+    size_t fieldsPerSet() const
+    {
+        return m_fieldsPerSet;
+    }
+
+    size_t sizeInBytes() const
+    {
+        return m_bytes.size();
+    }
+
+    void saveState(std::vector<uint8_t> &state) const;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    void reshape(size_t setCount, size_t fieldsPerSet, unsigned int bitsPerField);
+
+    size_t m_setCount = 0;
+    size_t m_fieldsPerSet = 0;
+    unsigned int m_bitsPerField = 1;
+    uint8_t m_fieldMask = 1;
+    size_t m_bytesPerSet = 0;
+    std::vector<uint8_t> m_bytes;
+};
+}//namespace Kites
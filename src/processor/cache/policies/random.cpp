@@ -0,0 +1,83 @@
+#include "processor/cache/policies/random.h"
+#include "processor/checkpoint_history.h"
+
+namespace Kites
+{
+RandomReplacementPolicy::RandomReplacementPolicy(uint64_t seed)
+    : m_seed(seed != 0 ? seed : DEFAULT_SEED), m_state(m_seed) // xorshift never leaves 0
+{
+}
+
+std::string_view RandomReplacementPolicy::name() const
+{
+    return "Random";
+}
+
+ReplacementPolicy RandomReplacementPolicy::type() const
+{
+    return ReplacementPolicy::Random;
+}
+
+uint64_t RandomReplacementPolicy::next()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 7;
+    m_state ^= m_state << 17;
+    return m_state;
+}
+
+size_t RandomReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                             const CacheRequestView &request,
+                                             const CacheContextView &context)
+{
+    (void)request;
+    (void)context;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+    }
+    return lines.empty() ? 0 : next() % lines.size();
+}
+
+void RandomReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                                       const CacheContextView &context)
+{
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void RandomReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                                       const CacheContextView &context)
+{
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void RandomReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                                      const CacheContextView &context)
+{
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void RandomReplacementPolicy::reset()
+{
+    m_state = m_seed;
+}
+
+void RandomReplacementPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, m_state);
+}
+
+void RandomReplacementPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readCheckpointState(state, offset, m_state);
+}
+}//namespace Kites
@@ -0,0 +1,44 @@
+#pragma once
+#include "cache_replacement_policy.h"
+
+namespace Kites
+{
+/**
+ * @brief Evicts a pseudo-random way. The generator is a seeded xorshift64, so a run with the
+ * same seed evicts the same lines, and reset() starts the sequence over.
+ */
+class RandomReplacementPolicy : public CacheReplacementPolicy
+{
+  public:
+    static constexpr uint64_t DEFAULT_SEED = 0x9E3779B97F4A7C15ULL;
+
+    explicit RandomReplacementPolicy(uint64_t seed = DEFAULT_SEED);
+    ~RandomReplacementPolicy() = default;
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context) override;
+
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context) override;
+
+    std::string_view name() const override;
+
+    ReplacementPolicy type() const override;
+
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+
+  private:
+    uint64_t next();
+
+    uint64_t m_seed;
+    uint64_t m_state;
+};
+}//namespace Kites
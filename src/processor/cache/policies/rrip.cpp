@@ -0,0 +1,178 @@
+#include "processor/cache/policies/rrip.h"
+#include "processor/checkpoint_history.h"
+#include <algorithm>
+
+namespace Kites
+{
+RRIPReplacementPolicy::RRIPReplacementPolicy(ReplacementPolicy variant) : m_variant(variant)
+{
+}
+
+std::string_view RRIPReplacementPolicy::name() const
+{
+    switch (m_variant)
+    {
+    case ReplacementPolicy::BRRIP:
+        return "BRRIP";
+    case ReplacementPolicy::DRRIP:
+        return "DRRIP";
+    default:
+        return "SRRIP";
+    }
+}
+
+ReplacementPolicy RRIPReplacementPolicy::type() const
+{
+    return m_variant;
+}
+
+void RRIPReplacementPolicy::fit(const CacheContextView &context)
+{
+    m_rrpv.fit(context.setCount, context.wayCount, 2);
+}
+
+RRIPReplacementPolicy::DuelRole RRIPReplacementPolicy::duelRole(size_t setIndex,
+                                                                size_t setCount) const
+{
+    // one set of each kind in every group of period sets, spread over the whole cache
+    const size_t period = std::max<size_t>(setCount / DUEL_LEADER_SETS, 4);
+    if (setIndex % period == 0)
+    {
+        return DuelRole::SRRIPLeader;
+    }
+    if (setIndex % period == period / 2)
+    {
+        return DuelRole::BRRIPLeader;
+    }
+    return DuelRole::Follower;
+}
+
+bool RRIPReplacementPolicy::insertsBimodal(size_t setIndex, size_t setCount) const
+{
+    switch (m_variant)
+    {
+    case ReplacementPolicy::BRRIP:
+        return true;
+    case ReplacementPolicy::DRRIP:
+        switch (duelRole(setIndex, setCount))
+        {
+        case DuelRole::SRRIPLeader:
+            return false;
+        case DuelRole::BRRIPLeader:
+            return true;
+        default:
+            // a high selector means the SRRIP leaders miss more
+            return m_psel > PSEL_MAX / 2;
+        }
+    default:
+        return false;
+    }
+}
+
+size_t RRIPReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                           const CacheRequestView &request,
+                                           const CacheContextView &context)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+    }
+    fit(context);
+
+    // ageing the set until some way reaches MAX_RRPV is a single step: add what the oldest
+    // way is short of it to every way
+    uint8_t oldest = 0;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        oldest = std::max(oldest, m_rrpv.get(request.setIndex, i));
+    }
+    const uint8_t shortfall = MAX_RRPV - oldest;
+    size_t victim = 0;
+    bool found = false;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        const uint8_t rrpv = m_rrpv.get(request.setIndex, i) + shortfall;
+        m_rrpv.set(request.setIndex, i, rrpv);
+        if (rrpv == MAX_RRPV && !found)
+        {
+            victim = i;
+            found = true;
+        }
+    }
+    return victim;
+}
+
+void RRIPReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                                     const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    m_rrpv.set(request.setIndex, request.wayIndex, 0);
+}
+
+void RRIPReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                                     const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    if (m_variant == ReplacementPolicy::DRRIP)
+    {
+        // every insert follows a miss, charge it to the leader side it happened on
+        switch (duelRole(request.setIndex, context.setCount))
+        {
+        case DuelRole::SRRIPLeader:
+            m_psel = std::min<uint16_t>(m_psel + 1, PSEL_MAX);
+            break;
+        case DuelRole::BRRIPLeader:
+            m_psel = m_psel > 0 ? m_psel - 1 : 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    uint8_t rrpv = MAX_RRPV - 1;
+    if (insertsBimodal(request.setIndex, context.setCount))
+    {
+        m_bimodalCounter = (m_bimodalCounter + 1) % BRRIP_LONG_INTERVAL;
+        if (m_bimodalCounter != 0)
+        {
+            rrpv = MAX_RRPV;
+        }
+    }
+    m_rrpv.set(request.setIndex, request.wayIndex, rrpv);
+}
+
+void RRIPReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                                    const CacheContextView &context)
+{
+    // the insert that follows sets the way's RRPV
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void RRIPReplacementPolicy::reset()
+{
+    m_rrpv.clear();
+    m_psel = (PSEL_MAX + 1) / 2;
+    m_bimodalCounter = 0;
+}
+
+void RRIPReplacementPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    m_rrpv.saveState(state);
+    appendCheckpointState(state, m_psel);
+    appendCheckpointState(state, m_bimodalCounter);
+}
+
+void RRIPReplacementPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    m_rrpv.restoreState(state, offset);
+    readCheckpointState(state, offset, m_psel);
+    readCheckpointState(state, offset, m_bimodalCounter);
+}
+}//namespace Kites
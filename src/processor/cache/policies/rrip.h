@@ -0,0 +1,76 @@
+#pragma once
+#include "cache_replacement_policy.h"
+#include "packed_set_state.h"
+
+namespace Kites
+{
+/**
+ * @brief Re-reference interval prediction (Jaleel et al., ISCA 2010) with 2-bit RRPVs.
+ *
+ * Every way holds a re-reference prediction value, 0 meaning reused soon and 3 reused in the
+ * distant future. A hit sets it to 0 and the victim is a way at 3, after ageing the whole set
+ * until one is. The variants only differ in where a new line starts:
+ *  - SRRIP inserts at 2, so a scan is gone before it can push out lines that are reused.
+ *  - BRRIP inserts at 3 and only every 32nd line at 2, which keeps part of a working set larger
+ *    than the cache instead of thrashing all of it.
+ *  - DRRIP duels the two: a few leader sets always use one of them, a saturating counter
+ *    tracks which leaders miss less and all other sets follow the winner.
+ */
+class RRIPReplacementPolicy : public CacheReplacementPolicy
+{
+  public:
+    static constexpr uint8_t MAX_RRPV = 3;
+    static constexpr uint32_t BRRIP_LONG_INTERVAL = 32; // one in this many BRRIP inserts is long
+    static constexpr uint16_t PSEL_MAX = 1023;           // 10-bit policy selector
+    static constexpr size_t DUEL_LEADER_SETS = 32;       // leader sets per side, at most
+
+    /**
+     * @param variant ReplacementPolicy::SRRIP, BRRIP or DRRIP
+     */
+    explicit RRIPReplacementPolicy(ReplacementPolicy variant);
+    ~RRIPReplacementPolicy() = default;
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context) override;
+
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context) override;
+
+    std::string_view name() const override;
+
+    ReplacementPolicy type() const override;
+
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+
+    uint16_t getPolicySelector() const
+    {
+        return m_psel;
+    }
+
+  private:
+    enum class DuelRole
+    {
+        SRRIPLeader,
+        BRRIPLeader,
+        Follower
+    };
+
+    void fit(const CacheContextView &context);
+    DuelRole duelRole(size_t setIndex, size_t setCount) const;
+    // whether a line inserted into @p setIndex starts as BRRIP would insert it
+    bool insertsBimodal(size_t setIndex, size_t setCount) const;
+
+    ReplacementPolicy m_variant;
+    PackedSetState m_rrpv;
+    uint16_t m_psel = (PSEL_MAX + 1) / 2;
+    uint32_t m_bimodalCounter = 0;
+};
+}//namespace Kites
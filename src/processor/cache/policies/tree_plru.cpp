@@ -0,0 +1,118 @@
+#include "processor/cache/policies/tree_plru.h"
+#include <algorithm>
+#include <bit>
+
+namespace Kites
+{
+std::string_view TreePLRUReplacementPolicy::name() const
+{
+    return "Tree-PLRU";
+}
+
+ReplacementPolicy TreePLRUReplacementPolicy::type() const
+{
+    return ReplacementPolicy::TreePLRU;
+}
+
+void TreePLRUReplacementPolicy::fit(const CacheContextView &context)
+{
+    // a full tree over the next power of two, heap ordered: node n has children 2n+1 and 2n+2
+    const size_t leaves = std::bit_ceil(std::max<size_t>(context.wayCount, 1));
+    m_nodes.fit(context.setCount, std::max<size_t>(leaves - 1, 1), 1);
+}
+
+void TreePLRUReplacementPolicy::touch(size_t setIndex, size_t wayIndex, size_t wayCount)
+{
+    size_t node = 0;
+    size_t low = 0;
+    size_t span = std::bit_ceil(std::max<size_t>(wayCount, 1));
+    while (span > 1)
+    {
+        span /= 2;
+        if (wayIndex < low + span)
+        {
+            m_nodes.set(setIndex, node, 1); // the right half is now older
+            node = 2 * node + 1;
+        }
+        else
+        {
+            m_nodes.set(setIndex, node, 0);
+            low += span;
+            node = 2 * node + 2;
+        }
+    }
+}
+
+size_t TreePLRUReplacementPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                               const CacheRequestView &request,
+                                               const CacheContextView &context)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+    }
+    fit(context);
+
+    size_t node = 0;
+    size_t low = 0;
+    size_t span = std::bit_ceil(std::max<size_t>(lines.size(), 1));
+    while (span > 1)
+    {
+        span /= 2;
+        // the right half may hold no ways at all when the way count is not a power of two
+        if (m_nodes.get(request.setIndex, node) && low + span < lines.size())
+        {
+            low += span;
+            node = 2 * node + 2;
+        }
+        else
+        {
+            node = 2 * node + 1;
+        }
+    }
+    return low;
+}
+
+void TreePLRUReplacementPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                                         const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    touch(request.setIndex, request.wayIndex, context.wayCount);
+}
+
+void TreePLRUReplacementPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                                         const CacheContextView &context)
+{
+    (void)line;
+    fit(context);
+    touch(request.setIndex, request.wayIndex, context.wayCount);
+}
+
+void TreePLRUReplacementPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                                        const CacheContextView &context)
+{
+    // the insert that follows repoints the tree
+    (void)line;
+    (void)request;
+    (void)context;
+}
+
+void TreePLRUReplacementPolicy::reset()
+{
+    m_nodes.clear();
+}
+
+void TreePLRUReplacementPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    m_nodes.saveState(state);
+}
+
+void TreePLRUReplacementPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    m_nodes.restoreState(state, offset);
+}
+}//namespace Kites
@@ -0,0 +1,45 @@
+#pragma once
+#include "cache_replacement_policy.h"
+#include "packed_set_state.h"
+
+namespace Kites
+{
+/**
+ * @brief Tree pseudo-LRU. Each set keeps a binary tree over its ways, one bit per inner node
+ * pointing towards the less recently used half, so ways-1 bits per set instead of full LRU
+ * order. Way counts that are not a power of two leave the missing leaves unused.
+ */
+class TreePLRUReplacementPolicy : public CacheReplacementPolicy
+{
+  public:
+    TreePLRUReplacementPolicy() = default;
+    ~TreePLRUReplacementPolicy() = default;
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context) override;
+
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context) override;
+
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context) override;
+
+    std::string_view name() const override;
+
+    ReplacementPolicy type() const override;
+
+    void reset() override;
+    void saveState(std::vector<uint8_t> &state) const override;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset) override;
+
+  private:
+    void fit(const CacheContextView &context);
+    // points every node on the path to @p wayIndex away from it
+    void touch(size_t setIndex, size_t wayIndex, size_t wayCount);
+
+    PackedSetState m_nodes;
+};
+}//namespace Kites
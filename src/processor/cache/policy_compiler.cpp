@@ -0,0 +1,565 @@
+#include "processor/cache/policy_compiler.h"
+#include "processor/checkpoint_history.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+
+namespace Kites
+{
+namespace
+{
+struct NamedField
+{
+    std::string_view name;
+    CompiledPolicy::Op op;
+};
+
+constexpr std::array<NamedField, 11> FIELDS = {{{"valid", CompiledPolicy::Op::Valid},
+                                                {"dirty", CompiledPolicy::Op::Dirty},
+                                                {"tag", CompiledPolicy::Op::Tag},
+                                                {"age", CompiledPolicy::Op::Age},
+                                                {"frequency", CompiledPolicy::Op::Frequency},
+                                                {"insertTime", CompiledPolicy::Op::InsertTime},
+                                                {"lastAccess", CompiledPolicy::Op::LastAccess},
+                                                {"way", CompiledPolicy::Op::Way},
+                                                {"set", CompiledPolicy::Op::Set},
+                                                {"tick", CompiledPolicy::Op::Tick},
+                                                {"isWrite", CompiledPolicy::Op::IsWrite}}};
+
+/**
+ * @brief Recursive descent over one rule string, emitting postfix instructions.
+ */
+class RuleParser
+{
+  public:
+    RuleParser(std::string_view text, const std::vector<std::string> &counters)
+        : m_text(text), m_counters(counters)
+    {
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return m_position == m_text.size();
+    }
+
+    bool accept(char symbol)
+    {
+        skipSpace();
+        if (m_position < m_text.size() && m_text[m_position] == symbol)
+        {
+            ++m_position;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char symbol)
+    {
+        if (!accept(symbol))
+        {
+            fail(std::string("expected '") + symbol + "'");
+        }
+    }
+
+    std::string_view identifier()
+    {
+        skipSpace();
+        const size_t start = m_position;
+        while (m_position < m_text.size() &&
+               (std::isalnum(static_cast<unsigned char>(m_text[m_position])) ||
+                m_text[m_position] == '_'))
+        {
+            ++m_position;
+        }
+        if (start == m_position || std::isdigit(static_cast<unsigned char>(m_text[start])))
+        {
+            m_position = start;
+            fail("expected a name");
+        }
+        return m_text.substr(start, m_position - start);
+    }
+
+    size_t counterIndex(std::string_view name) const
+    {
+        const auto found = std::find(m_counters.begin(), m_counters.end(), name);
+        return found == m_counters.end() ? m_counters.size()
+                                         : static_cast<size_t>(found - m_counters.begin());
+    }
+
+    // expression := term (('+' | '-') term)*
+    void expression(std::vector<CompiledPolicy::Instruction> &out)
+    {
+        term(out);
+        while (true)
+        {
+            if (accept('+'))
+            {
+                term(out);
+                out.push_back({CompiledPolicy::Op::Add});
+            }
+            else if (accept('-'))
+            {
+                term(out);
+                out.push_back({CompiledPolicy::Op::Sub});
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw PolicyCompileError(message + " at column " + std::to_string(m_position + 1) +
+                                 " of \"" + std::string(m_text) + "\"");
+    }
+
+  private:
+    void skipSpace()
+    {
+        while (m_position < m_text.size() &&
+               std::isspace(static_cast<unsigned char>(m_text[m_position])))
+        {
+            ++m_position;
+        }
+    }
+
+    // term := factor (('*' | '/' | '%') factor)*
+    void term(std::vector<CompiledPolicy::Instruction> &out)
+    {
+        factor(out);
+        while (true)
+        {
+            CompiledPolicy::Op op;
+            if (accept('*'))
+            {
+                op = CompiledPolicy::Op::Mul;
+            }
+            else if (accept('/'))
+            {
+                op = CompiledPolicy::Op::Div;
+            }
+            else if (accept('%'))
+            {
+                op = CompiledPolicy::Op::Mod;
+            }
+            else
+            {
+                return;
+            }
+            factor(out);
+            out.push_back({op});
+        }
+    }
+
+    // factor := integer | name | '-' factor | '(' expression ')' | (min | max) '(' e ',' e ')'
+    void factor(std::vector<CompiledPolicy::Instruction> &out)
+    {
+        if (++m_nesting > MAX_NESTING)
+        {
+            fail("expression too deeply nested");
+        }
+        factorBody(out);
+        --m_nesting;
+    }
+
+    void factorBody(std::vector<CompiledPolicy::Instruction> &out)
+    {
+        skipSpace();
+        if (m_position < m_text.size() && std::isdigit(static_cast<unsigned char>(m_text[m_position])))
+        {
+            int64_t value = 0;
+            while (m_position < m_text.size() &&
+                   std::isdigit(static_cast<unsigned char>(m_text[m_position])))
+            {
+                if (value > (INT64_MAX - 9) / 10)
+                {
+                    fail("constant too large");
+                }
+                value = value * 10 + (m_text[m_position++] - '0');
+            }
+            out.push_back({CompiledPolicy::Op::Const, value});
+            return;
+        }
+        if (accept('-'))
+        {
+            out.push_back({CompiledPolicy::Op::Const, 0});
+            factor(out);
+            out.push_back({CompiledPolicy::Op::Sub});
+            return;
+        }
+        if (accept('('))
+        {
+            expression(out);
+            expect(')');
+            return;
+        }
+
+        const std::string_view name = identifier();
+        if (name == "min" || name == "max")
+        {
+            expect('(');
+            expression(out);
+            expect(',');
+            expression(out);
+            expect(')');
+            out.push_back({name == "min" ? CompiledPolicy::Op::Min : CompiledPolicy::Op::Max});
+            return;
+        }
+        const size_t counter = counterIndex(name);
+        if (counter < m_counters.size())
+        {
+            out.push_back({CompiledPolicy::Op::Counter, static_cast<int64_t>(counter)});
+            return;
+        }
+        for (const NamedField &field : FIELDS)
+        {
+            if (field.name == name)
+            {
+                out.push_back({field.op});
+                return;
+            }
+        }
+        fail("unknown name '" + std::string(name) + "'");
+    }
+
+    static constexpr size_t MAX_NESTING = 64; // bounds the recursion on hostile input
+
+    std::string_view m_text;
+    const std::vector<std::string> &m_counters;
+    size_t m_position = 0;
+    size_t m_nesting = 0;
+};
+
+void checkStackDepth(const std::vector<CompiledPolicy::Instruction> &expression,
+                     std::string_view source)
+{
+    size_t depth = 0;
+    for (const CompiledPolicy::Instruction &instruction : expression)
+    {
+        if (instruction.op >= CompiledPolicy::Op::Add)
+        {
+            --depth; // pops two, pushes one
+        }
+        else if (++depth > CompiledPolicy::MAX_STACK_DEPTH)
+        {
+            throw PolicyCompileError("expression too deeply nested: \"" + std::string(source) +
+                                     "\"");
+        }
+    }
+}
+
+} // namespace
+
+CompiledPolicy CompiledPolicy::compile(const PolicyDescription &description)
+{
+    CompiledPolicy policy;
+    for (const std::string &name : description.counters)
+    {
+        static const std::vector<std::string> noCounters;
+        RuleParser check(name, noCounters);
+        if (check.identifier() != name || !check.atEnd())
+        {
+            throw PolicyCompileError("bad counter name \"" + name + "\"");
+        }
+        if (std::find(policy.m_counterNames.begin(), policy.m_counterNames.end(), name) !=
+                policy.m_counterNames.end() ||
+            name == "min" || name == "max" ||
+            std::any_of(FIELDS.begin(), FIELDS.end(),
+                        [&name](const NamedField &field) { return field.name == name; }))
+        {
+            throw PolicyCompileError("counter name \"" + name + "\" is taken");
+        }
+        policy.m_counterNames.push_back(name);
+    }
+
+    // statement := counter '=' expression, separated by ';'
+    auto compileRule = [&policy](const std::string &source, std::vector<Assignment> &rule)
+    {
+        RuleParser parser(source, policy.m_counterNames);
+        while (!parser.atEnd())
+        {
+            if (parser.accept(';'))
+            {
+                continue;
+            }
+            const std::string_view target = parser.identifier();
+            Assignment assignment{parser.counterIndex(target), {}};
+            if (assignment.counter == policy.m_counterNames.size())
+            {
+                parser.fail("only counters can be assigned, not '" + std::string(target) + "'");
+            }
+            parser.expect('=');
+            parser.expression(assignment.expression);
+            checkStackDepth(assignment.expression, source);
+            rule.push_back(std::move(assignment));
+            if (!parser.atEnd())
+            {
+                parser.expect(';');
+            }
+        }
+    };
+    compileRule(description.onAccess, policy.m_onAccess);
+    compileRule(description.onInsert, policy.m_onInsert);
+    compileRule(description.onEvict, policy.m_onEvict);
+
+    // rule := ('min' | 'max') expression
+    for (const std::string &source : description.victim)
+    {
+        RuleParser parser(source, policy.m_counterNames);
+        const std::string_view direction = parser.identifier();
+        if (direction != "min" && direction != "max")
+        {
+            parser.fail("a victim rule starts with min or max");
+        }
+        VictimRule rule{direction == "max", {}};
+        parser.expression(rule.key);
+        if (!parser.atEnd())
+        {
+            parser.fail("unexpected text");
+        }
+        checkStackDepth(rule.key, source);
+        policy.m_victim.push_back(std::move(rule));
+    }
+    if (policy.m_victim.empty())
+    {
+        throw PolicyCompileError("the policy has no victim rule");
+    }
+    return policy;
+}
+
+int64_t CompiledPolicy::evaluate(const std::vector<Instruction> &expression,
+                                 const CacheLineView &line, size_t wayIndex,
+                                 const CacheRequestView &request, const CacheContextView &context,
+                                 const int64_t *counters) const
+{
+    std::array<int64_t, MAX_STACK_DEPTH> stack;
+    size_t top = 0;
+    for (const Instruction &instruction : expression)
+    {
+        int64_t value = 0;
+        switch (instruction.op)
+        {
+        case Op::Const:
+            value = instruction.operand;
+            break;
+        case Op::Counter:
+            value = counters[instruction.operand];
+            break;
+        case Op::Valid:
+            value = line.valid;
+            break;
+        case Op::Dirty:
+            value = line.dirty;
+            break;
+        case Op::Tag:
+            value = static_cast<int64_t>(line.tag);
+            break;
+        case Op::Age:
+            value = static_cast<int64_t>(line.age);
+            break;
+        case Op::Frequency:
+            value = static_cast<int64_t>(line.frequency);
+            break;
+        case Op::InsertTime:
+            value = static_cast<int64_t>(line.insertTime);
+            break;
+        case Op::LastAccess:
+            value = static_cast<int64_t>(line.lastAccess);
+            break;
+        case Op::Way:
+            value = static_cast<int64_t>(wayIndex);
+            break;
+        case Op::Set:
+            value = static_cast<int64_t>(request.setIndex);
+            break;
+        case Op::Tick:
+            value = static_cast<int64_t>(context.tick);
+            break;
+        case Op::IsWrite:
+            value = request.isWrite;
+            break;
+        default:
+        {
+            // binary operators, wrapping like unsigned arithmetic instead of overflowing
+            const int64_t right = stack[--top];
+            const int64_t left = stack[--top];
+            const auto ul = static_cast<uint64_t>(left);
+            const auto ur = static_cast<uint64_t>(right);
+            switch (instruction.op)
+            {
+            case Op::Add:
+                value = static_cast<int64_t>(ul + ur);
+                break;
+            case Op::Sub:
+                value = static_cast<int64_t>(ul - ur);
+                break;
+            case Op::Mul:
+                value = static_cast<int64_t>(ul * ur);
+                break;
+            case Op::Div:
+                value = right == 0 || (left == INT64_MIN && right == -1) ? 0 : left / right;
+                break;
+            case Op::Mod:
+                value = right == 0 || (left == INT64_MIN && right == -1) ? 0 : left % right;
+                break;
+            case Op::Min:
+                value = std::min(left, right);
+                break;
+            default:
+                value = std::max(left, right);
+                break;
+            }
+        }
+        }
+        stack[top++] = value;
+    }
+    return stack[0];
+}
+
+void CompiledPolicy::fit(const CacheContextView &context)
+{
+    if (context.setCount != m_setCount || context.wayCount != m_wayCount)
+    {
+        m_setCount = context.setCount;
+        m_wayCount = context.wayCount;
+        m_counters.assign(m_setCount * m_wayCount * m_counterNames.size(), 0);
+    }
+}
+
+void CompiledPolicy::run(const std::vector<Assignment> &rule, const CacheLineView &line,
+                         const CacheRequestView &request, const CacheContextView &context)
+{
+    if (rule.empty())
+    {
+        return;
+    }
+    fit(context);
+    int64_t *counters = m_counters.data() +
+                        (request.setIndex * m_wayCount + request.wayIndex) * m_counterNames.size();
+    for (const Assignment &assignment : rule)
+    {
+        counters[assignment.counter] =
+            evaluate(assignment.expression, line, request.wayIndex, request, context, counters);
+    }
+}
+
+size_t CompiledPolicy::chooseVictim(std::span<const CacheLineView> lines,
+                                    const CacheRequestView &request,
+                                    const CacheContextView &context)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (!lines[i].valid)
+        {
+            return i;
+        }
+    }
+    fit(context);
+
+    const size_t ruleCount = m_victim.size();
+    m_victimKeys.resize(lines.size() * ruleCount);
+    const int64_t *setCounters =
+        m_counters.data() + request.setIndex * m_wayCount * m_counterNames.size();
+    for (size_t way = 0; way < lines.size(); ++way)
+    {
+        for (size_t rule = 0; rule < ruleCount; ++rule)
+        {
+            m_victimKeys[way * ruleCount + rule] =
+                evaluate(m_victim[rule].key, lines[way], way, request, context,
+                         setCounters + way * m_counterNames.size());
+        }
+    }
+
+    size_t victim = 0;
+    for (size_t way = 1; way < lines.size(); ++way)
+    {
+        for (size_t rule = 0; rule < ruleCount; ++rule)
+        {
+            const int64_t candidate = m_victimKeys[way * ruleCount + rule];
+            const int64_t best = m_victimKeys[victim * ruleCount + rule];
+            if (candidate != best)
+            {
+                if ((candidate > best) == m_victim[rule].maximize)
+                {
+                    victim = way;
+                }
+                break;
+            }
+        }
+    }
+    return victim;
+}
+
+void CompiledPolicy::onAccess(const CacheLineView &line, const CacheRequestView &request,
+                              const CacheContextView &context)
+{
+    run(m_onAccess, line, request, context);
+}
+
+void CompiledPolicy::onInsert(const CacheLineView &line, const CacheRequestView &request,
+                              const CacheContextView &context)
+{
+    fit(context);
+    // a new line starts from zero whatever its way held before
+    int64_t *counters = m_counters.data() +
+                        (request.setIndex * m_wayCount + request.wayIndex) * m_counterNames.size();
+    std::fill_n(counters, m_counterNames.size(), 0);
+    run(m_onInsert, line, request, context);
+}
+
+void CompiledPolicy::onEvict(const CacheLineView &line, const CacheRequestView &request,
+                             const CacheContextView &context)
+{
+    run(m_onEvict, line, request, context);
+}
+
+int64_t CompiledPolicy::counter(size_t setIndex, size_t wayIndex, size_t counter) const
+{
+    const size_t index = (setIndex * m_wayCount + wayIndex) * m_counterNames.size() + counter;
+    return index < m_counters.size() ? m_counters[index] : 0;
+}
+
+void CompiledPolicy::reset()
+{
+    std::fill(m_counters.begin(), m_counters.end(), 0);
+}
+
+void CompiledPolicy::saveState(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, static_cast<uint64_t>(m_setCount));
+    appendCheckpointState(state, static_cast<uint64_t>(m_wayCount));
+    appendCheckpointState(state, static_cast<uint64_t>(m_counterNames.size()));
+    const size_t offset = state.size();
+    state.resize(offset + m_counters.size() * sizeof(int64_t));
+    std::memcpy(state.data() + offset, m_counters.data(), m_counters.size() * sizeof(int64_t));
+}
+
+void CompiledPolicy::restoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    uint64_t setCount = 0;
+    uint64_t wayCount = 0;
+    uint64_t counterCount = 0;
+    readCheckpointState(state, offset, setCount);
+    readCheckpointState(state, offset, wayCount);
+    readCheckpointState(state, offset, counterCount);
+    if (counterCount != m_counterNames.size() ||
+        state.size() - offset < setCount * wayCount * counterCount * sizeof(int64_t))
+    {
+        // saved by another policy description, e.g. before a different script was loaded
+        m_setCount = 0;
+        m_wayCount = 0;
+        m_counters.clear();
+        return;
+    }
+    m_setCount = setCount;
+    m_wayCount = wayCount;
+    m_counters.resize(m_setCount * m_wayCount * m_counterNames.size());
+    std::memcpy(m_counters.data(), state.data() + offset, m_counters.size() * sizeof(int64_t));
+    offset += m_counters.size() * sizeof(int64_t);
+}
+}//namespace Kites
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "processor/cache/policies/cache_replacement_policy.h"
+
+namespace Kites
+{
+/**
+ * @brief A replacement policy written as a `policy` table in a custom policy script instead of
+ * Lua functions:
+ *
+ * @code
+ * policy = {
+ *     counters = { "hits" },                     -- per-line integers, 0 when the line comes in
+ *     onInsert = "hits = 0",
+ *     onAccess = "hits = min(hits + 1, 15)",
+ *     onEvict  = "",
+ *     victim   = { "min hits", "min lastAccess" } -- later rules break ties, then the lowest way
+ * }
+ * @endcode
+ *
+ * Update rules are `counter = expression` statements separated by `;`. Expressions use integer
+ * constants, the counters, the line fields valid, dirty, tag, age, frequency, insertTime and
+ * lastAccess, way, set, tick and isWrite, the operators + - * / % with parentheses, and min(a, b)
+ * and max(a, b). Division or remainder by zero gives 0.
+ */
+struct PolicyDescription
+{
+    std::vector<std::string> counters{};
+    std::string onAccess{}; // hooks left out do nothing
+    std::string onInsert{};
+    std::string onEvict{};
+    std::vector<std::string> victim{};
+};
+
+/**
+ * @brief Thrown for anything a policy description cannot be compiled from. The script is then
+ * run by the Lua engine instead, if it defines chooseVictim.
+ */
+class PolicyCompileError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief A policy description compiled into flat postfix operation tables, evaluated natively on
+ * every hook. Keeps the per-line counters of every set.
+ */
+class CompiledPolicy
+{
+  public:
+    enum class Op : uint8_t
+    {
+        Const,
+        Counter,
+        Valid,
+        Dirty,
+        Tag,
+        Age,
+        Frequency,
+        InsertTime,
+        LastAccess,
+        Way,
+        Set,
+        Tick,
+        IsWrite,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Mod,
+        Min,
+        Max
+    };
+
+    struct Instruction
+    {
+        Op op;
+        int64_t operand = 0; // the constant, or the counter index
+    };
+
+    // enough for any expression a person writes, checked when compiling
+    static constexpr size_t MAX_STACK_DEPTH = 32;
+
+    /**
+     * @throws PolicyCompileError if the description uses anything outside the language.
+     */
+    static CompiledPolicy compile(const PolicyDescription &description);
+
+    size_t chooseVictim(std::span<const CacheLineView> lines, const CacheRequestView &request,
+                        const CacheContextView &context);
+    void onAccess(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context);
+    void onInsert(const CacheLineView &line, const CacheRequestView &request,
+                  const CacheContextView &context);
+    void onEvict(const CacheLineView &line, const CacheRequestView &request,
+                 const CacheContextView &context);
+
+    size_t counterCount() const
+    {
+        return m_counterNames.size();
+    }
+    /**
+     * @brief Counter @p counter of the line in @p wayIndex of @p setIndex, 0 if never set.
+     */
+    int64_t counter(size_t setIndex, size_t wayIndex, size_t counter) const;
+
+    void reset();
+    void saveState(std::vector<uint8_t> &state) const;
+    void restoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    struct Assignment
+    {
+        size_t counter;
+        std::vector<Instruction> expression;
+    };
+
+    struct VictimRule
+    {
+        bool maximize;
+        std::vector<Instruction> key;
+    };
+
+    void fit(const CacheContextView &context);
+    void run(const std::vector<Assignment> &rule, const CacheLineView &line,
+             const CacheRequestView &request, const CacheContextView &context);
+    int64_t evaluate(const std::vector<Instruction> &expression, const CacheLineView &line,
+                     size_t wayIndex, const CacheRequestView &request,
+                     const CacheContextView &context, const int64_t *counters) const;
+
+    std::vector<std::string> m_counterNames;
+    std::vector<Assignment> m_onAccess;
+    std::vector<Assignment> m_onInsert;
+    std::vector<Assignment> m_onEvict;
+    std::vector<VictimRule> m_victim;
+
+    size_t m_setCount = 0;
+    size_t m_wayCount = 0;
+    std::vector<int64_t> m_counters; // set major, then way, then counter
+    std::vector<int64_t> m_victimKeys; // scratch, one key per way
+};
+}//namespace Kites
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "processor/cache/cacheconfig.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief A demand access as a prefetcher sees it. Addresses are in lines, that is the byte
+ * address shifted right by the line offset bits.
+ */
+struct PrefetchRequestView
+{
+    uint64_t line = 0;
+    uint64_t address = 0;
+    size_t offsetBits = 0;  // line = address >> offsetBits
+    uint64_t pc = 0;        // instruction making the access, 0 if unknown
+    bool hit = false;
+    bool prefetchHit = false; // the first demand hit on a line a prefetch brought in
+};
+
+/**
+ * @brief Base class for hardware prefetchers.
+ *
+ * A prefetcher watches the demand accesses of one cache and proposes lines to bring in. The
+ * cache filters out lines it already holds and queues the rest, so a prefetcher only keeps its
+ * own training state.
+ */
+class CachePrefetcher
+{
+  public:
+    CachePrefetcher(size_t degree, size_t distance) : m_degree(degree), m_distance(distance)
+    {
+    }
+    virtual ~CachePrefetcher() = default;
+
+    /**
+     * @brief Trains on @p request and appends the lines worth prefetching to @p lines.
+     */
+    virtual void onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines) = 0;
+
+    /**
+     * @brief Forgets everything learned, e.g. when the cache is reset.
+     */
+    virtual void reset() = 0;
+
+    virtual std::string_view name() const = 0;
+
+    virtual PrefetcherType type() const = 0;
+
+  protected:
+    size_t m_degree;
+    size_t m_distance;
+};
+}//namespace Kites
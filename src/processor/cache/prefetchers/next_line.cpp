@@ -0,0 +1,31 @@
+#include "processor/cache/prefetchers/next_line.h"
+
+namespace Kites
+{
+void NextLinePrefetcher::onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines)
+{
+    if (request.hit && !request.prefetchHit)
+    {
+        return;
+    }
+    for (size_t i = 0; i < m_degree; ++i)
+    {
+        lines.push_back(request.line + m_distance + i);
+    }
+}
+
+void NextLinePrefetcher::reset()
+{
+    // stateless
+}
+
+std::string_view NextLinePrefetcher::name() const
+{
+    return "Next line";
+}
+
+PrefetcherType NextLinePrefetcher::type() const
+{
+    return PrefetcherType::NextLine;
+}
+}//namespace Kites
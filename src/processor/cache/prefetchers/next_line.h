@@ -0,0 +1,20 @@
+#pragma once
+#include "cache_prefetcher.h"
+
+namespace Kites
+{
+/**
+ * @brief Tagged next-line prefetching: a miss, or the first hit on a prefetched line, asks for
+ * the degree lines starting distance lines further on.
+ */
+class NextLinePrefetcher : public CachePrefetcher
+{
+  public:
+    using CachePrefetcher::CachePrefetcher;
+
+    void onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines) override;
+    void reset() override;
+    std::string_view name() const override;
+    PrefetcherType type() const override;
+};
+}//namespace Kites
@@ -0,0 +1,66 @@
+#include "processor/cache/prefetchers/stream.h"
+
+namespace Kites
+{
+void StreamPrefetcher::onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines)
+{
+    if (request.hit && !request.prefetchHit)
+    {
+        return;
+    }
+    ++m_clock;
+
+    Stream *match = nullptr;
+    Stream *oldest = &m_streams[0];
+    for (Stream &stream : m_streams)
+    {
+        const uint64_t gap = request.line > stream.lastLine ? request.line - stream.lastLine
+                                                            : stream.lastLine - request.line;
+        if (stream.valid && gap <= TRAINING_WINDOW)
+        {
+            match = &stream;
+            break;
+        }
+        if (!stream.valid || stream.lastUse < oldest->lastUse)
+        {
+            oldest = &stream;
+        }
+    }
+    if (match == nullptr)
+    {
+        *oldest = Stream{.valid = true, .lastLine = request.line, .direction = 0, .lastUse = m_clock};
+        return;
+    }
+
+    match->lastUse = m_clock;
+    if (request.line == match->lastLine)
+    {
+        return;
+    }
+    // the first step away from where a stream started sets its direction, and a step the
+    // other way turns it round
+    match->direction = request.line > match->lastLine ? 1 : -1;
+    match->lastLine = request.line;
+    for (size_t i = 0; i < m_degree; ++i)
+    {
+        const int64_t ahead = match->direction * static_cast<int64_t>(m_distance + i);
+        lines.push_back(request.line + static_cast<uint64_t>(ahead));
+    }
+}
+
+void StreamPrefetcher::reset()
+{
+    m_streams.fill(Stream{});
+    m_clock = 0;
+}
+
+std::string_view StreamPrefetcher::name() const
+{
+    return "Stream";
+}
+
+PrefetcherType StreamPrefetcher::type() const
+{
+    return PrefetcherType::Stream;
+}
+}//namespace Kites
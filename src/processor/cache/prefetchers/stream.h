@@ -0,0 +1,39 @@
+#pragma once
+#include "cache_prefetcher.h"
+
+#include <array>
+
+namespace Kites
+{
+/**
+ * @brief Follows up to STREAM_COUNT sequential streams, ascending or descending. A miss close to
+ * a tracked stream's last line trains it, and a trained stream asks for the degree lines
+ * starting distance lines ahead in its direction each time a miss or the first hit on a
+ * prefetched line moves it on. Misses near no stream start a new one in place of the least
+ * recently used.
+ */
+class StreamPrefetcher : public CachePrefetcher
+{
+  public:
+    static constexpr size_t STREAM_COUNT = 8;
+    static constexpr uint64_t TRAINING_WINDOW = 16; // lines either side of a stream's last line
+
+    using CachePrefetcher::CachePrefetcher;
+
+    void onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines) override;
+    void reset() override;
+    std::string_view name() const override;
+    PrefetcherType type() const override;
+
+  private:
+    struct Stream
+    {
+        bool valid = false;
+        uint64_t lastLine = 0;
+        int direction = 0; // 0 until trained
+        uint64_t lastUse = 0;
+    };
+    std::array<Stream, STREAM_COUNT> m_streams{};
+    uint64_t m_clock{0};
+};
+}//namespace Kites
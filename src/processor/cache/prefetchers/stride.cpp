@@ -0,0 +1,65 @@
+#include "processor/cache/prefetchers/stride.h"
+
+namespace Kites
+{
+void StridePrefetcher::onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines)
+{
+    // instructions are 4 byte aligned, so the low pc bits carry nothing
+    Entry &entry = m_table[(request.pc >> 2) % TABLE_SIZE];
+    if (!entry.valid || entry.pc != request.pc)
+    {
+        entry = Entry{.valid = true, .pc = request.pc, .lastAddress = request.address};
+        return;
+    }
+
+    const int64_t stride = static_cast<int64_t>(request.address - entry.lastAddress);
+    entry.lastAddress = request.address;
+    if (stride == entry.stride)
+    {
+        if (entry.confidence < 3)
+        {
+            ++entry.confidence;
+        }
+    }
+    else if (entry.confidence > 0)
+    {
+        --entry.confidence;
+    }
+    else
+    {
+        entry.stride = stride;
+    }
+
+    if (entry.confidence < 2 || entry.stride == 0)
+    {
+        return;
+    }
+    // short strides put several targets in one line, which only needs asking for once
+    uint64_t previous = request.line;
+    for (size_t i = 0; i < m_degree; ++i)
+    {
+        const int64_t ahead = entry.stride * static_cast<int64_t>(m_distance + i);
+        const uint64_t line = (request.address + static_cast<uint64_t>(ahead)) >> request.offsetBits;
+        if (line != previous)
+        {
+            lines.push_back(line);
+            previous = line;
+        }
+    }
+}
+
+void StridePrefetcher::reset()
+{
+    m_table.fill(Entry{});
+}
+
+std::string_view StridePrefetcher::name() const
+{
+    return "Stride";
+}
+
+PrefetcherType StridePrefetcher::type() const
+{
+    return PrefetcherType::Stride;
+}
+}//namespace Kites
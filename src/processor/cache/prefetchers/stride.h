@@ -0,0 +1,37 @@
+#pragma once
+#include "cache_prefetcher.h"
+
+#include <array>
+
+namespace Kites
+{
+/**
+ * @brief Reference prediction table: one entry per load or store instruction, indexed by its
+ * pc, remembering the last address and stride it used. Once the same stride has been seen
+ * twice in a row the entry is steady and asks for the degree strides starting distance strides
+ * ahead of the current address.
+ */
+class StridePrefetcher : public CachePrefetcher
+{
+  public:
+    static constexpr size_t TABLE_SIZE = 64;
+
+    using CachePrefetcher::CachePrefetcher;
+
+    void onAccess(const PrefetchRequestView &request, std::vector<uint64_t> &lines) override;
+    void reset() override;
+    std::string_view name() const override;
+    PrefetcherType type() const override;
+
+  private:
+    struct Entry
+    {
+        bool valid = false;
+        uint64_t pc = 0;
+        uint64_t lastAddress = 0;
+        int64_t stride = 0;
+        uint8_t confidence = 0; // saturating, 0..3; steady from 2
+    };
+    std::array<Entry, TABLE_SIZE> m_table{};
+};
+}//namespace Kites
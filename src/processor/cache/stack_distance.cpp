@@ -0,0 +1,254 @@
+#include "processor/cache/stack_distance.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace Kites
+{
+namespace
+{
+constexpr uint32_t MIN_TIME_CAPACITY = 1u << 16;
+
+uint64_t sumBelow(const std::vector<uint64_t> &histogram, size_t limit)
+{
+    const size_t end = std::min(limit, histogram.size());
+    return std::accumulate(histogram.begin(), histogram.begin() + static_cast<ptrdiff_t>(end),
+                           uint64_t{0});
+}
+}
+
+StackDistanceAnalyzer::StackDistanceAnalyzer(size_t lineSizeInBytes, size_t maxSetBits,
+                                             size_t maxWays)
+    : m_lineSizeInBytes(lineSizeInBytes), m_offsetBits(std::countr_zero(lineSizeInBytes)),
+      m_maxSetBits(maxSetBits), m_maxWays(maxWays)
+{
+    if (!std::has_single_bit(lineSizeInBytes) || maxWays == 0)
+    {
+        throw std::invalid_argument("Stack distance analysis needs a power of two line size and at least one way");
+    }
+    m_tree.assign(MIN_TIME_CAPACITY + 1, 0);
+    m_setStacks.resize(maxSetBits + 1);
+    for (size_t bits = 1; bits <= maxSetBits; ++bits)
+    {
+        const size_t setCount = size_t{1} << bits;
+        m_setStacks[bits].lines.assign(setCount * maxWays, 0);
+        m_setStacks[bits].depth.assign(setCount, 0);
+        m_setStacks[bits].histogram.assign(maxWays, 0);
+    }
+}
+
+void StackDistanceAnalyzer::access(uint64_t address, size_t size)
+{
+    const uint64_t first = address >> m_offsetBits;
+    const uint64_t last = (address + std::max<size_t>(size, 1) - 1) >> m_offsetBits;
+    for (uint64_t line = first; line <= last; ++line)
+    {
+        accessLine(line);
+    }
+}
+
+void StackDistanceAnalyzer::accessLine(uint64_t line)
+{
+    ++m_accessCount;
+    accessFullyAssociative(line);
+    accessSets(line);
+}
+
+void StackDistanceAnalyzer::accessFullyAssociative(uint64_t line)
+{
+    if (m_time + 1 >= m_tree.size())
+    {
+        compactTimes();
+    }
+    const uint32_t now = ++m_time;
+    const size_t capacity = m_tree.size() - 1;
+    auto mark = [&](uint32_t time, uint32_t delta)
+    {
+        for (size_t i = time; i <= capacity; i += i & (~i + 1))
+        {
+            m_tree[i] += delta;
+        }
+    };
+
+    auto found = m_lastTime.find(line);
+    if (found == m_lastTime.end())
+    {
+        m_lastTime.emplace(line, now);
+        mark(now, 1);
+        return;
+    }
+
+    // every live mark is at or before the previous access or after it, so the lines used since
+    // are the live lines less those marked up to and including it
+    uint64_t upToPrevious = 0;
+    for (size_t i = found->second; i > 0; i -= i & (~i + 1))
+    {
+        upToPrevious += m_tree[i];
+    }
+    const size_t distance = m_lastTime.size() - upToPrevious;
+    if (distance >= m_fullHistogram.size())
+    {
+        m_fullHistogram.resize(std::max(distance + 1, m_fullHistogram.size() * 2), 0);
+    }
+    ++m_fullHistogram[distance];
+
+    mark(found->second, ~uint32_t{0}); // unsigned wrap-around subtracts one
+    found->second = now;
+    mark(now, 1);
+}
+
+void StackDistanceAnalyzer::compactTimes()
+{
+    // renumber the live marks 1..n in the same order, leaving room to grow
+    std::vector<uint32_t *> times;
+    times.reserve(m_lastTime.size());
+    for (auto &entry : m_lastTime)
+    {
+        times.push_back(&entry.second);
+    }
+    std::sort(times.begin(), times.end(), [](const uint32_t *a, const uint32_t *b) { return *a < *b; });
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        *times[i] = static_cast<uint32_t>(i + 1);
+    }
+
+    const size_t capacity = std::max<size_t>(MIN_TIME_CAPACITY, 2 * (times.size() + 1));
+    m_tree.assign(capacity + 1, 0);
+    std::fill(m_tree.begin() + 1, m_tree.begin() + static_cast<ptrdiff_t>(times.size()) + 1, 1u);
+    for (size_t i = 1; i <= capacity; ++i)
+    {
+        const size_t parent = i + (i & (~i + 1));
+        if (parent <= capacity)
+        {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+    m_time = static_cast<uint32_t>(times.size());
+}
+
+void StackDistanceAnalyzer::accessSets(uint64_t line)
+{
+    for (size_t bits = 1; bits <= m_maxSetBits; ++bits)
+    {
+        SetStacks &stacks = m_setStacks[bits];
+        const size_t set = line & ((size_t{1} << bits) - 1);
+        uint64_t *stack = stacks.lines.data() + set * m_maxWays;
+        uint32_t &depth = stacks.depth[set];
+
+        size_t position = 0;
+        while (position < depth && stack[position] != line)
+        {
+            ++position;
+        }
+        if (position < depth)
+        {
+            ++stacks.histogram[position];
+        }
+        else if (depth < m_maxWays)
+        {
+            ++depth;
+        }
+        else
+        {
+            position = m_maxWays - 1; // the least recent line falls off the stack
+        }
+        std::memmove(stack + 1, stack, position * sizeof(uint64_t));
+        stack[0] = line;
+    }
+}
+
+size_t StackDistanceAnalyzer::getLineSizeInBytes() const
+{
+    return m_lineSizeInBytes;
+}
+
+uint64_t StackDistanceAnalyzer::getAccessCount() const
+{
+    return m_accessCount;
+}
+
+uint64_t StackDistanceAnalyzer::getColdMissCount() const
+{
+    return m_lastTime.size();
+}
+
+uint64_t StackDistanceAnalyzer::hitCount(size_t setCount, size_t wayCount) const
+{
+    if (setCount == 1)
+    {
+        return sumBelow(m_fullHistogram, wayCount);
+    }
+    const size_t bits = std::countr_zero(setCount);
+    if (!std::has_single_bit(setCount) || bits > m_maxSetBits || wayCount > m_maxWays)
+    {
+        throw std::out_of_range("Stack distances were not kept for " + std::to_string(setCount) +
+                                " sets of " + std::to_string(wayCount) + " ways");
+    }
+    return sumBelow(m_setStacks[bits].histogram, wayCount);
+}
+
+MissRatioPoint StackDistanceAnalyzer::makePoint(size_t setCount, size_t wayCount) const
+{
+    MissRatioPoint point;
+    point.setCount = setCount;
+    point.wayCount = wayCount;
+    point.capacityInBytes = setCount * wayCount * m_lineSizeInBytes;
+    point.hitCount = hitCount(setCount, wayCount);
+    point.missCount = m_accessCount - point.hitCount;
+    point.missRate = m_accessCount == 0 ? 0.0 : static_cast<double>(point.missCount) / m_accessCount;
+    return point;
+}
+
+std::vector<MissRatioPoint> StackDistanceAnalyzer::fullyAssociativeCurve() const
+{
+    std::vector<MissRatioPoint> curve;
+    const size_t largest = std::bit_ceil(std::max<size_t>(m_lastTime.size(), 1));
+    for (size_t lines = 1; lines <= largest; lines *= 2)
+    {
+        curve.push_back(makePoint(1, lines));
+    }
+    return curve;
+}
+
+std::vector<MissRatioPoint> StackDistanceAnalyzer::setAssociativeCurve(size_t wayCount) const
+{
+    std::vector<MissRatioPoint> curve;
+    for (size_t bits = 0; bits <= m_maxSetBits; ++bits)
+    {
+        curve.push_back(makePoint(size_t{1} << bits, wayCount));
+    }
+    return curve;
+}
+
+std::vector<StackDistanceAnalyzer> analyzeStackDistances(const AddressTrace &trace,
+                                                         TraceStream stream,
+                                                         const std::vector<size_t> &lineSizes,
+                                                         size_t maxSetBits, size_t maxWays)
+{
+    std::vector<StackDistanceAnalyzer> analyzers;
+    analyzers.reserve(lineSizes.size());
+    for (size_t lineSize : lineSizes)
+    {
+        analyzers.emplace_back(lineSize, maxSetBits, maxWays);
+    }
+
+    AddressTraceCursor cursor(trace);
+    TraceRecord record;
+    while (cursor.next(record))
+    {
+        const bool fetch = record.access == TraceAccess::FETCH;
+        if (stream == TraceStream::ALL || fetch == (stream == TraceStream::INSTRUCTION))
+        {
+            for (StackDistanceAnalyzer &analyzer : analyzers)
+            {
+                analyzer.access(record.address, record.size);
+            }
+        }
+    }
+    return analyzers;
+}
+}//namespace Kites
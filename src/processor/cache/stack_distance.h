@@ -0,0 +1,124 @@
+/**
+ * @file stack_distance.h
+ * @brief Single pass LRU stack distance (Mattson) analysis of an access stream.
+ */
+#pragma once
+
+#include "processor/address_trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Which records of a trace an analysis looks at.
+ */
+enum class TraceStream
+{
+    DATA = 0,    ///< loads and stores, what the l1 data cache sees
+    INSTRUCTION, ///< fetches, what the instruction cache sees
+    ALL
+};
+
+struct MissRatioPoint
+{
+    size_t setCount = 0;
+    size_t wayCount = 0;
+    size_t capacityInBytes = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    double missRate = 0.0;
+};
+
+/**
+ * @brief Records the LRU stack distance of every line access for one line size, from which the
+ * hits of any LRU cache with that line size follow without simulating it.
+ *
+ * Fully associative distances are exact and unbounded. Set associative ones are kept for every
+ * power of two set count up to 2^maxSetBits, and up to maxWays deep, which is as far as
+ * hitCount() can answer for them. The model is a write allocate cache, where a store is just
+ * another access; under no write allocate real caches hit a little less often.
+ */
+class StackDistanceAnalyzer
+{
+  public:
+    static constexpr size_t DEFAULT_MAX_SET_BITS = 12;
+    static constexpr size_t DEFAULT_MAX_WAYS = 64;
+
+    explicit StackDistanceAnalyzer(size_t lineSizeInBytes,
+                                   size_t maxSetBits = DEFAULT_MAX_SET_BITS,
+                                   size_t maxWays = DEFAULT_MAX_WAYS);
+
+    /**
+     * @brief Accesses every line that [address, address + size) touches. Counts are per line
+     * access, so an access straddling two lines counts twice where Cache counts it once.
+     */
+    void access(uint64_t address, size_t size);
+
+    [[nodiscard]] size_t getLineSizeInBytes() const;
+    [[nodiscard]] uint64_t getAccessCount() const;
+    /**
+     * @brief Accesses to a line never seen before, which miss in every cache.
+     */
+    [[nodiscard]] uint64_t getColdMissCount() const;
+
+    /**
+     * @brief Hits of an LRU cache with @p setCount sets of @p wayCount ways over the accesses so
+     * far. Throws std::out_of_range if @p setCount is not a power of two up to 2^maxSetBits, or
+     * if it is above one and @p wayCount is above maxWays.
+     */
+    [[nodiscard]] uint64_t hitCount(size_t setCount, size_t wayCount) const;
+
+    /**
+     * @brief Fully associative caches of 1, 2, 4 ... lines, up to one holding every line seen.
+     */
+    [[nodiscard]] std::vector<MissRatioPoint> fullyAssociativeCurve() const;
+    /**
+     * @brief Caches of @p wayCount ways and 1, 2, 4 ... 2^maxSetBits sets.
+     */
+    [[nodiscard]] std::vector<MissRatioPoint> setAssociativeCurve(size_t wayCount) const;
+
+  private:
+    void accessLine(uint64_t line);
+    void accessFullyAssociative(uint64_t line);
+    void accessSets(uint64_t line);
+    void compactTimes();
+    MissRatioPoint makePoint(size_t setCount, size_t wayCount) const;
+
+    size_t m_lineSizeInBytes;
+    size_t m_offsetBits;
+    size_t m_maxSetBits;
+    size_t m_maxWays;
+    uint64_t m_accessCount{0};
+
+    // fully associative: a Fenwick tree over access times with a mark at each line's last
+    // access, so the distinct lines used since a line's previous access is a prefix sum
+    std::unordered_map<uint64_t, uint32_t> m_lastTime;
+    std::vector<uint32_t> m_tree;
+    uint32_t m_time{0};
+    std::vector<uint64_t> m_fullHistogram;
+
+    // set associative, one entry per set bit count 1..maxSetBits: every set's LRU stack of up
+    // to maxWays lines, most recent first, and the histogram of distances found in them
+    struct SetStacks
+    {
+        std::vector<uint64_t> lines;
+        std::vector<uint32_t> depth;
+        std::vector<uint64_t> histogram;
+    };
+    std::vector<SetStacks> m_setStacks;
+};
+
+/**
+ * @brief Runs one analyzer per line size over the records of @p trace in @p stream, in a single
+ * pass over the trace.
+ */
+std::vector<StackDistanceAnalyzer>
+analyzeStackDistances(const AddressTrace &trace, TraceStream stream,
+                      const std::vector<size_t> &lineSizes,
+                      size_t maxSetBits = StackDistanceAnalyzer::DEFAULT_MAX_SET_BITS,
+                      size_t maxWays = StackDistanceAnalyzer::DEFAULT_MAX_WAYS);
+}//namespace Kites
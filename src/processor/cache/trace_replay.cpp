@@ -0,0 +1,111 @@
+#include "processor/cache/trace_replay.h"
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+namespace Kites
+{
+namespace
+{
+std::unique_ptr<Cache> buildCache(MemoryDevice &nextLevel, const CacheConfig &config,
+                                  const std::string &customPolicyScriptPath)
+{
+    auto cache = std::make_unique<Cache>(nextLevel, config.lineCount, config.lineSizeInBytes,
+                                         config.wayCount, config.writePolicy,
+                                         config.allocationPolicy, config.replacementPolicy);
+    if (config.replacementPolicy == ReplacementPolicy::Custom)
+    {
+        cache->loadCustomPolicyScript(customPolicyScriptPath);
+    }
+    cache->setPrefetcher(config.prefetcher, config.prefetchDegree, config.prefetchDistance);
+    return cache;
+}
+
+void replayData(Cache &cache, const TraceRecord &record)
+{
+    if (record.access == TraceAccess::STORE)
+    {
+        switch (record.size)
+        {
+        case 1:
+            cache.writeByte(record.address, 0);
+            break;
+        case 2:
+            cache.writeHalfWord(record.address, 0);
+            break;
+        case 4:
+            cache.writeWord(record.address, 0);
+            break;
+        default:
+            cache.writeDoubleWord(record.address, 0);
+            break;
+        }
+        return;
+    }
+    switch (record.size)
+    {
+    case 1:
+        (void)cache.readByte(record.address);
+        break;
+    case 2:
+        (void)cache.readHalfWord(record.address);
+        break;
+    case 4:
+        (void)cache.readWord(record.address);
+        break;
+    default:
+        (void)cache.readDoubleWord(record.address);
+        break;
+    }
+}
+}
+
+TraceReplayResult replayTrace(const AddressTrace &trace, const CacheHierarchyConfig &config)
+{
+    if (config.l1.lineSizeInBytes > config.l2.lineSizeInBytes ||
+        config.instruction.lineSizeInBytes > config.l2.lineSizeInBytes)
+    {
+        throw std::invalid_argument("L1 and instruction cache lines cannot be longer than L2 lines");
+    }
+
+    MainMemory memory;
+    auto l2 = buildCache(memory, config.l2, config.customPolicyScriptPath);
+    auto l1 = buildCache(*l2, config.l1, config.customPolicyScriptPath);
+    auto instruction = buildCache(*l2, config.instruction, config.customPolicyScriptPath);
+
+    TraceReplayResult result;
+    const auto start = std::chrono::steady_clock::now();
+    AddressTraceCursor cursor(trace);
+    TraceRecord record;
+    uint64_t pc = 0;
+    while (cursor.next(record))
+    {
+        if (record.pc != pc)
+        {
+            pc = record.pc;
+            l1->setAccessPc(pc);
+            instruction->setAccessPc(pc);
+            l2->setAccessPc(pc);
+        }
+        if (record.access == TraceAccess::FETCH)
+        {
+            (void)instruction->readWord(record.address);
+        }
+        else
+        {
+            replayData(*l1, record);
+        }
+        ++result.accesses;
+    }
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.l1 = l1->getStats();
+    result.instruction = instruction->getStats();
+    result.l2 = l2->getStats();
+    return result;
+}
+}//namespace Kites
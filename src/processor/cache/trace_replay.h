@@ -0,0 +1,45 @@
+/**
+ * @file trace_replay.h
+ * @brief Runs a recorded address trace through a cache hierarchy without the processor.
+ */
+#pragma once
+
+#include "processor/address_trace.h"
+#include "processor/cache/cacheconfig.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Kites
+{
+/**
+ * @brief The same shape as MemoryController: the l1 data cache and the instruction cache both
+ * miss into the l2, which misses into main memory.
+ */
+struct CacheHierarchyConfig
+{
+    CacheConfig l1;
+    CacheConfig instruction;
+    CacheConfig l2;
+    std::string customPolicyScriptPath{}; ///< used by every cache whose policy is Custom
+};
+
+struct TraceReplayResult
+{
+    uint64_t accesses = 0;
+    CacheStats l1;
+    CacheStats instruction;
+    CacheStats l2;
+    double seconds = 0.0; ///< wall time of the replay itself, not counting setup
+};
+
+/**
+ * @brief Replays @p trace through fresh caches built from @p config and returns their statistics.
+ *
+ * Only addresses are recorded, so stores write zeros; hits, misses and write backs come out the
+ * same as on the caches the trace was recorded from, provided those started out empty. Nothing is
+ * shared between calls, so several replays of one trace can run on different threads. Throws
+ * std::invalid_argument if an l1 line is longer than an l2 line.
+ */
+TraceReplayResult replayTrace(const AddressTrace &trace, const CacheHierarchyConfig &config);
+}//namespace Kites
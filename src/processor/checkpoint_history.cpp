@@ -0,0 +1,103 @@
+/**
+ * @file checkpoint_history.cpp
+ * @brief Storage, thinning and memory reconstruction of CheckpointHistory.
+ */
+
+#include "processor/checkpoint_history.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+CheckpointHistory::CheckpointHistory(uint64_t interval, size_t maxCount)
+{
+    configure(interval, maxCount);
+}
+
+void CheckpointHistory::configure(uint64_t interval, size_t maxCount)
+{
+    m_baseInterval = std::max<uint64_t>(interval, 1);
+    // the oldest and the newest checkpoint always survive thinning
+    m_maxCount = std::max<size_t>(maxCount, 2);
+    clear();
+}
+
+void CheckpointHistory::clear()
+{
+    m_checkpoints.clear();
+    m_interval = m_baseInterval;
+}
+
+void CheckpointHistory::add(ProcessorCheckpoint checkpoint)
+{
+    m_checkpoints.push_back(std::move(checkpoint));
+    if (m_checkpoints.size() > m_maxCount)
+    {
+        thin();
+    }
+}
+
+void CheckpointHistory::thin()
+{
+    std::vector<ProcessorCheckpoint> kept;
+    kept.reserve(m_checkpoints.size() / 2 + 1);
+    for (size_t i = 0; i < m_checkpoints.size(); ++i)
+    {
+        ProcessorCheckpoint &checkpoint = m_checkpoints[i];
+        const bool last = i + 1 == m_checkpoints.size();
+        if (i % 2 == 1 && !last)
+        {
+            // the successor holds newer copies of any block both have
+            ProcessorCheckpoint &successor = m_checkpoints[i + 1];
+            for (auto &[block_index, block] : checkpoint.memory_blocks)
+            {
+                successor.memory_blocks.try_emplace(block_index, std::move(block));
+            }
+            continue;
+        }
+        kept.push_back(std::move(checkpoint));
+    }
+    m_checkpoints = std::move(kept);
+    m_interval *= 2;
+}
+
+void CheckpointHistory::truncate(uint64_t cycle, std::vector<uint64_t> &droppedBlocks)
+{
+    auto first = std::lower_bound(m_checkpoints.begin(), m_checkpoints.end(), cycle,
+                                  [](const ProcessorCheckpoint &checkpoint, uint64_t value)
+                                  { return checkpoint.cycle < value; });
+    for (auto it = first; it != m_checkpoints.end(); ++it)
+    {
+        for (const auto &[block_index, block] : it->memory_blocks)
+        {
+            droppedBlocks.push_back(block_index);
+        }
+    }
+    m_checkpoints.erase(first, m_checkpoints.end());
+}
+
+size_t CheckpointHistory::indexAtOrBefore(uint64_t cycle) const
+{
+    auto it = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), cycle,
+                               [](uint64_t value, const ProcessorCheckpoint &checkpoint)
+                               { return value < checkpoint.cycle; });
+    if (it == m_checkpoints.begin())
+    {
+        return size();
+    }
+    return static_cast<size_t>(it - m_checkpoints.begin()) - 1;
+}
+
+std::unordered_map<uint64_t, MemoryBlock> CheckpointHistory::memoryAt(size_t index) const
+{
+    std::unordered_map<uint64_t, MemoryBlock> blocks = m_checkpoints[index].memory_blocks;
+    for (size_t i = index; i-- > 0;)
+    {
+        for (const auto &[block_index, block] : m_checkpoints[i].memory_blocks)
+        {
+            blocks.try_emplace(block_index, block);
+        }
+    }
+    return blocks;
+}
+}//namespace Kites
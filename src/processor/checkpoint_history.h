@@ -0,0 +1,149 @@
+/**
+ * @file checkpoint_history.h
+ * @brief Periodic full-state checkpoints used to travel back in execution by replaying forward.
+ */
+#pragma once
+
+#include "processor/cache/cache.h"
+#include "processor/memory_block.h"
+#include "processor/registers.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief The state of a processor at the start of one cycle.
+ *
+ * Main memory is stored as a delta: only the blocks written since the previous checkpoint. The
+ * memory image at a checkpoint is the union of its blocks and those of every earlier checkpoint,
+ * newest copy first.
+ */
+struct ProcessorCheckpoint
+{
+    uint64_t cycle{}; ///< cycle_s_ when the checkpoint was taken
+    uint64_t program_counter{};
+    uint64_t last_executed_pc{};
+    uint32_t current_instruction{};
+    unsigned int instructions_retired{};
+    unsigned int stall_cycles{};
+    unsigned int memory_stall_cycles{};
+    unsigned int functional_unit_stall_cycles{};
+    unsigned int branch_mispredictions{};
+    size_t input_position{}; ///< stdin lines consumed so far
+    RegisterFile::State registers{};
+    std::unordered_map<uint64_t, MemoryBlock> memory_blocks{};
+    std::array<CacheState, 3> caches{}; ///< l1, instruction, l2
+    std::vector<uint8_t> processor_state{}; ///< pipeline registers and the like
+};
+
+/**
+ * @brief Appends a trivially copyable value to ProcessorCheckpoint::processor_state.
+ */
+template <typename T> void appendCheckpointState(std::vector<uint8_t> &state, const T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    const size_t offset = state.size();
+    state.resize(offset + sizeof(T));
+    std::memcpy(state.data() + offset, &value, sizeof(T));
+}
+
+/**
+ * @brief Reads back a value stored by appendCheckpointState, advancing @p offset past it.
+ */
+template <typename T>
+void readCheckpointState(const std::vector<uint8_t> &state, size_t &offset, T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::memcpy(&value, state.data() + offset, sizeof(T));
+    offset += sizeof(T);
+}
+
+/**
+ * @brief Checkpoints taken every interval cycles, bounded in number.
+ *
+ * When the count limit is exceeded every other checkpoint is dropped, folding its memory blocks
+ * into its successor, and the interval doubles. The oldest checkpoint is never dropped, so any
+ * cycle since it can still be reached, at the cost of replaying at most one interval.
+ */
+class CheckpointHistory
+{
+  public:
+    CheckpointHistory(uint64_t interval, size_t maxCount);
+
+    /**
+     * @brief Changes the interval and the count limit. Everything recorded so far is dropped.
+     */
+    void configure(uint64_t interval, size_t maxCount);
+    void clear();
+
+    /**
+     * @brief True if a checkpoint should be taken before executing @p cycle.
+     */
+    [[nodiscard]] bool due(uint64_t cycle) const
+    {
+        return m_checkpoints.empty() || cycle >= nextCycle();
+    }
+    [[nodiscard]] uint64_t nextCycle() const
+    {
+        return m_checkpoints.empty() ? 0 : m_checkpoints.back().cycle + m_interval;
+    }
+
+    /**
+     * @brief Appends a checkpoint taken after every one already held.
+     */
+    void add(ProcessorCheckpoint checkpoint);
+
+    /**
+     * @brief Drops every checkpoint taken at or after @p cycle.
+     * @param droppedBlocks receives the memory blocks those checkpoints held, which the next
+     * checkpoint must cover again since it will be appended after an older one.
+     */
+    void truncate(uint64_t cycle, std::vector<uint64_t> &droppedBlocks);
+
+    /**
+     * @brief Index of the newest checkpoint taken at or before @p cycle, or size() if none.
+     */
+    [[nodiscard]] size_t indexAtOrBefore(uint64_t cycle) const;
+    [[nodiscard]] const ProcessorCheckpoint &at(size_t index) const
+    {
+        return m_checkpoints[index];
+    }
+    /**
+     * @brief Rebuilds the full memory image as of checkpoint @p index.
+     */
+    [[nodiscard]] std::unordered_map<uint64_t, MemoryBlock> memoryAt(size_t index) const;
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_checkpoints.size();
+    }
+    [[nodiscard]] bool empty() const
+    {
+        return m_checkpoints.empty();
+    }
+    [[nodiscard]] uint64_t interval() const
+    {
+        return m_interval;
+    }
+    [[nodiscard]] size_t maxCount() const
+    {
+        return m_maxCount;
+    }
+
+  private:
+    void thin();
+
+    std::vector<ProcessorCheckpoint> m_checkpoints; // oldest first, cycles strictly increasing
+    uint64_t m_baseInterval{1};
+    uint64_t m_interval{1}; // doubles every time the checkpoints are thinned out
+    size_t m_maxCount{2};
+};
+}//namespace Kites
@@ -8,6 +8,7 @@
 #include "common/globals.h"
 
 #include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
@@ -16,6 +17,7 @@
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace Kites
@@ -26,13 +28,16 @@ uint8_t MainMemory::read(uint64_t address)
     {
         throw std::out_of_range("Memory address out of range: " + std::to_string(address));
     }
-    uint64_t block_index = getBlockIndex(address);
-    uint64_t offset = getBlockOffset(address);
-    if (!isBlockPresent(block_index))
+    if (const MemoryWindow *window = findWindow(address, 1))
+    {
+        return *window->at(address);
+    }
+    const Page *page = findPage(address >> MEMORY_PAGE_SHIFT);
+    if (page == nullptr)
     {
         return 0;
     }
-    return blocks_[block_index].data[offset];
+    return page->data[address & MEMORY_PAGE_MASK];
 }
 
 void MainMemory::write(uint64_t address, uint8_t value)
@@ -42,38 +47,158 @@ void MainMemory::write(uint64_t address, uint8_t value)
         throw std::out_of_range(std::string("Memory address out of range: ") +
                                 std::to_string(address));
     }
-    uint64_t block_index = getBlockIndex(address);
-    uint64_t offset = getBlockOffset(address);
-    ensureBlockExists(block_index);
-    blocks_[block_index].data[offset] = value;
+    if (MemoryWindow *window = findWindow(address, 1))
+    {
+        window->prepareWrite(address, 1, snapshot_);
+        *window->at(address) = value;
+        return;
+    }
+    Page &page = touchPage(address >> MEMORY_PAGE_SHIFT);
+    prepareWrite(page);
+    page.data[address & MEMORY_PAGE_MASK] = value;
+}
+
+void MainMemory::reset()
+{
+    clear();
+    snapshot_.discard();
+    mapWindows();
+}
+
+void MainMemory::mapWindows()
+{
+    windows_ = {};
+    const vm_config::VmConfig &config = vm_config::config;
+    if (config.getMemoryBackend() != vm_config::MemoryBackend::MAPPED)
+    {
+        return;
+    }
+    const uint64_t text_start = config.getTextSectionStart();
+    const uint64_t data_start = config.getDataSectionStart();
+    const uint64_t stack_size = config.getStackWindowSize();
+    // most accesses go to data and the stack, so they are looked up first
+    const std::array<std::pair<uint64_t, uint64_t>, 3> layout = {{
+        {data_start, config.getDataWindowSize()},
+        {0 - stack_size, stack_size},
+        {text_start, data_start > text_start ? data_start - text_start : 0},
+    }};
+    for (size_t i = 0; i < layout.size(); ++i)
+    {
+        const auto [base, size] = layout[i];
+        const bool overlaps = std::any_of(windows_.begin(), windows_.begin() + i,
+                                          [base, size](const MemoryWindow &window)
+                                          { return window.overlaps(base, size); });
+        if (!overlaps)
+        {
+            windows_[i] = MemoryWindow(base, size);
+        }
+    }
+}
+
+void MainMemory::clear()
+{
+    for (MemoryWindow &window : windows_)
+    {
+        window.clear();
+    }
+    page_directory_.clear();
+    arena_.clear();
+    page_count_ = 0;
+    last_page_number_ = UINT64_MAX;
+    last_page_ = nullptr;
 }
 
-uint64_t MainMemory::getBlockIndex(uint64_t address) const
+const uint8_t *MainMemory::readablePage(uint64_t page_number)
 {
-    return address / block_size_;
+    const uint64_t address = page_number << MEMORY_PAGE_SHIFT;
+    if (const MemoryWindow *window = findWindow(address, MEMORY_PAGE_SIZE))
+    {
+        return window->at(address);
+    }
+    const Page *page = findPage(page_number);
+    return page != nullptr ? page->data.data() : nullptr;
 }
 
-uint64_t MainMemory::getBlockOffset(uint64_t address) const
+uint8_t *MainMemory::writablePage(uint64_t page_number)
 {
-    return address % block_size_;
+    const uint64_t address = page_number << MEMORY_PAGE_SHIFT;
+    if (MemoryWindow *window = findWindow(address, MEMORY_PAGE_SIZE))
+    {
+        window->prepareWrite(address, MEMORY_PAGE_SIZE, snapshot_);
+        return window->at(address);
+    }
+    Page &page = touchPage(page_number);
+    prepareWrite(page);
+    return page.data.data();
 }
 
-bool MainMemory::isBlockPresent(uint64_t block_index) const
+void MainMemory::notePageWrite(Page &page)
 {
-    return blocks_.find(block_index) != blocks_.end();
+    if ((page.flags & PAGE_SNAPSHOT_DIRTY) == 0)
+    {
+        snapshot_.preserve(page.number, page.data.data());
+    }
+    page.flags = PAGE_ALL_DIRTY;
 }
 
-void MainMemory::ensureBlockExists(uint64_t block_index)
+MainMemory::Page *MainMemory::lookupPage(uint64_t page_number)
 {
-    if (blocks_.find(block_index) == blocks_.end())
+    auto it = page_directory_.find(page_number >> PAGE_TABLE_BITS);
+    if (it == page_directory_.end())
+    {
+        return nullptr;
+    }
+    Page *page = (*it->second)[page_number & (PAGE_TABLE_SIZE - 1)];
+    if (page != nullptr)
     {
-        blocks_.emplace(block_index, MemoryBlock());
+        last_page_number_ = page_number;
+        last_page_ = page;
     }
+    return page;
+}
+
+MainMemory::Page &MainMemory::allocatePage(uint64_t page_number)
+{
+    if (page_count_ == arena_.size() * PAGES_PER_CHUNK)
+    {
+        arena_.push_back(std::make_unique<Page[]>(PAGES_PER_CHUNK));
+    }
+    Page &page = allocatedPage(page_count_++);
+    page.number = page_number;
+    page.flags = 0;
+
+    std::unique_ptr<PageTable> &table = page_directory_[page_number >> PAGE_TABLE_BITS];
+    if (!table)
+    {
+        table = std::make_unique<PageTable>();
+        table->fill(nullptr);
+    }
+    (*table)[page_number & (PAGE_TABLE_SIZE - 1)] = &page;
+    last_page_number_ = page_number;
+    last_page_ = &page;
+    return page;
 }
 
 template <typename T> T MainMemory::readGeneric(uint64_t address)
 {
+    static_assert(std::endian::native == std::endian::little,
+                  "guest memory is little-endian and is copied as is");
     T value = 0;
+    if (const MemoryWindow *window = findWindow(address, sizeof(T)))
+    {
+        std::memcpy(&value, window->at(address), sizeof(T));
+        return value;
+    }
+    const uint64_t offset = address & MEMORY_PAGE_MASK;
+    if (offset + sizeof(T) <= MEMORY_PAGE_SIZE)
+    {
+        const Page *page = findPage(address >> MEMORY_PAGE_SHIFT);
+        if (page != nullptr)
+        {
+            std::memcpy(&value, page->data.data() + offset, sizeof(T));
+        }
+        return value;
+    }
     for (size_t i = 0; i < sizeof(T); ++i)
     {
         value |= static_cast<T>(read(address + i)) << (8 * i);
@@ -88,10 +213,35 @@ std::span<const uint8_t> MainMemory::readLine(uint64_t address, size_t lineSize)
         throw std::out_of_range(std::string("Memory address out of range: ") +
                                 std::to_string(address));
     }
-    uint64_t block_index = getBlockIndex(address);
-    uint64_t offset = getBlockOffset(address);
-    ensureBlockExists(block_index);
-    return std::span<const uint8_t>(blocks_[block_index].data.data() + offset, lineSize);
+    if (const MemoryWindow *window = findWindow(address, lineSize))
+    {
+        return std::span<const uint8_t>(window->at(address), lineSize);
+    }
+    const uint64_t offset = address & MEMORY_PAGE_MASK;
+    if (offset + lineSize <= MEMORY_PAGE_SIZE)
+    {
+        const Page *page = findPage(address >> MEMORY_PAGE_SHIFT);
+        if (page != nullptr)
+        {
+            return std::span<const uint8_t>(page->data.data() + offset, lineSize);
+        }
+    }
+
+    // an absent page or a line spanning several pages: assemble a copy
+    line_buffer_.assign(lineSize, 0);
+    size_t done = 0;
+    while (done < lineSize)
+    {
+        const uint64_t current = address + done;
+        const uint64_t page_offset = current & MEMORY_PAGE_MASK;
+        const size_t chunk = std::min<size_t>(lineSize - done, MEMORY_PAGE_SIZE - page_offset);
+        if (const uint8_t *page = readablePage(current >> MEMORY_PAGE_SHIFT))
+        {
+            std::memcpy(line_buffer_.data() + done, page + page_offset, chunk);
+        }
+        done += chunk;
+    }
+    return std::span<const uint8_t>(line_buffer_.data(), lineSize);
 }
 
 void MainMemory::writeLine(uint64_t address, std::span<const uint8_t> data)
@@ -101,14 +251,40 @@ void MainMemory::writeLine(uint64_t address, std::span<const uint8_t> data)
         throw std::out_of_range(std::string("Memory address out of range: ") +
                                 std::to_string(address));
     }
-    uint64_t block_index = getBlockIndex(address);
-    uint64_t offset = getBlockOffset(address);
-    ensureBlockExists(block_index);
-    std::copy(data.begin(), data.end(), blocks_[block_index].data.begin() + offset);
+    if (MemoryWindow *window = findWindow(address, data.size()))
+    {
+        window->prepareWrite(address, data.size(), snapshot_);
+        std::memcpy(window->at(address), data.data(), data.size());
+        return;
+    }
+    size_t done = 0;
+    while (done < data.size())
+    {
+        const uint64_t current = address + done;
+        const uint64_t page_offset = current & MEMORY_PAGE_MASK;
+        const size_t chunk = std::min<size_t>(data.size() - done, MEMORY_PAGE_SIZE - page_offset);
+        uint8_t *page = writablePage(current >> MEMORY_PAGE_SHIFT);
+        std::memcpy(page + page_offset, data.data() + done, chunk);
+        done += chunk;
+    }
 }
 
 template <typename T> void MainMemory::writeGeneric(uint64_t address, T value)
 {
+    if (MemoryWindow *window = findWindow(address, sizeof(T)))
+    {
+        window->prepareWrite(address, sizeof(T), snapshot_);
+        std::memcpy(window->at(address), &value, sizeof(T));
+        return;
+    }
+    const uint64_t offset = address & MEMORY_PAGE_MASK;
+    if (offset + sizeof(T) <= MEMORY_PAGE_SIZE)
+    {
+        Page &page = touchPage(address >> MEMORY_PAGE_SHIFT);
+        prepareWrite(page);
+        std::memcpy(page.data.data() + offset, &value, sizeof(T));
+        return;
+    }
     for (size_t i = 0; i < sizeof(T); ++i)
     {
         write(address + i, static_cast<uint8_t>(value >> (8 * i)));
@@ -163,11 +339,7 @@ float MainMemory::readFloat(uint64_t address)
                                 std::to_string(address));
         ;
     }
-    uint32_t value = 0;
-    for (size_t i = 0; i < sizeof(float); ++i)
-    {
-        value |= static_cast<uint32_t>(read(address + i)) << (8 * i);
-    }
+    uint32_t value = readGeneric<uint32_t>(address);
     float result;
     std::memcpy(&result, &value, sizeof(float));
     return result;
@@ -180,11 +352,7 @@ double MainMemory::readDouble(uint64_t address)
         throw std::out_of_range(std::string("Memory address out of range: ") +
                                 std::to_string(address));
     }
-    uint64_t value = 0;
-    for (size_t i = 0; i < sizeof(double); ++i)
-    {
-        value |= static_cast<uint64_t>(read(address + i)) << (8 * i);
-    }
+    uint64_t value = readGeneric<uint64_t>(address);
     double result;
     std::memcpy(&result, &value, sizeof(double));
     return result;
@@ -239,10 +407,7 @@ void MainMemory::writeFloat(uint64_t address, float value)
     }
     uint32_t value_bits;
     std::memcpy(&value_bits, &value, sizeof(float));
-    for (size_t i = 0; i < sizeof(float); ++i)
-    {
-        write(address + i, static_cast<uint8_t>((value_bits >> (8 * i)) & 0xFF));
-    }
+    writeGeneric<uint32_t>(address, value_bits);
 }
 
 void MainMemory::writeDouble(uint64_t address, double value)
@@ -254,10 +419,7 @@ void MainMemory::writeDouble(uint64_t address, double value)
     }
     uint64_t value_bits;
     std::memcpy(&value_bits, &value, sizeof(double));
-    for (size_t i = 0; i < sizeof(double); ++i)
-    {
-        write(address + i, static_cast<uint8_t>((value_bits >> (8 * i)) & 0xFF));
-    }
+    writeGeneric<uint64_t>(address, value_bits);
 }
 
 void MainMemory::printMemory(const uint64_t address, unsigned int rows)
@@ -372,16 +534,142 @@ void MainMemory::printMemoryUsage() const
 {
     std::cout << "Memory Usage Report:\n";
     std::cout << "---------------------\n";
-    std::cout << "Block Count: " << blocks_.size() << "\n";
-    for (const auto &[block_index, block] : blocks_)
+    for (const MemoryWindow &window : windows_)
     {
-        size_t used_bytes = std::count_if(block.data.begin(), block.data.end(),
+        if (window.mapped())
+        {
+            std::cout << "Window 0x" << std::hex << window.base() << std::dec << ": "
+                      << window.writtenPageCount() << " / "
+                      << (window.size() >> MEMORY_PAGE_SHIFT) << " pages written\n";
+        }
+    }
+    std::cout << "Page Count: " << page_count_ << "\n";
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        const Page &page = allocatedPage(i);
+        size_t used_bytes = std::count_if(page.data.begin(), page.data.end(),
                                           [](uint8_t byte) { return byte != 0; });
         if (used_bytes > 0)
         {
-            std::cout << "Block " << block_index << ": " << used_bytes << " / " << block_size_
-                      << " bytes used\n";
+            std::cout << "Page " << page.number << ": " << used_bytes << " / "
+                      << MEMORY_PAGE_SIZE << " bytes used\n";
+        }
+    }
+}
+
+void MainMemory::collectDirtyBlocks(std::unordered_map<uint64_t, MemoryBlock> &out)
+{
+    for (MemoryWindow &window : windows_)
+    {
+        window.collectDirtyPages(out);
+    }
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        Page &page = allocatedPage(i);
+        if ((page.flags & PAGE_CHECKPOINT_DIRTY) != 0)
+        {
+            page.flags &= ~PAGE_CHECKPOINT_DIRTY;
+            MemoryBlock &block = out[page.number];
+            std::memcpy(block.data.data(), page.data.data(), MEMORY_PAGE_SIZE);
+        }
+    }
+}
+
+void MainMemory::markBlockDirty(uint64_t block_index)
+{
+    for (MemoryWindow &window : windows_)
+    {
+        if (window.markPageDirty(block_index))
+        {
+            return;
         }
     }
+    if (Page *page = findPage(block_index))
+    {
+        page->flags |= PAGE_CHECKPOINT_DIRTY;
+    }
+}
+
+void MainMemory::markAllBlocksDirty()
+{
+    for (MemoryWindow &window : windows_)
+    {
+        window.markAllPagesDirty();
+    }
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        allocatedPage(i).flags |= PAGE_CHECKPOINT_DIRTY;
+    }
+}
+
+void MainMemory::restoreBlocks(const std::unordered_map<uint64_t, MemoryBlock> &blocks)
+{
+    // everything goes through the write path, so an active snapshot preserves what is replaced
+    std::vector<uint64_t> present;
+    for (const MemoryWindow &window : windows_)
+    {
+        std::vector<uint64_t> pages = window.writtenPages();
+        present.insert(present.end(), pages.begin(), pages.end());
+    }
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        present.push_back(allocatedPage(i).number);
+    }
+    for (uint64_t page_number : present)
+    {
+        if (blocks.find(page_number) == blocks.end())
+        {
+            std::memset(writablePage(page_number), 0, MEMORY_PAGE_SIZE);
+        }
+    }
+    for (const auto &[block_index, block] : blocks)
+    {
+        std::memcpy(writablePage(block_index), block.data.data(), MEMORY_PAGE_SIZE);
+    }
+
+    for (MemoryWindow &window : windows_)
+    {
+        window.clearPageFlag(PAGE_CHECKPOINT_DIRTY);
+    }
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        allocatedPage(i).flags &= ~PAGE_CHECKPOINT_DIRTY;
+    }
+}
+
+void MainMemory::takeSnapshot()
+{
+    snapshot_.take();
+    for (MemoryWindow &window : windows_)
+    {
+        window.clearPageFlag(PAGE_SNAPSHOT_DIRTY);
+    }
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        allocatedPage(i).flags &= ~PAGE_SNAPSHOT_DIRTY;
+    }
+}
+
+void MainMemory::restoreSnapshot()
+{
+    for (uint64_t page_number : snapshot_.modifiedPages())
+    {
+        const MemoryBlock &original = snapshot_.original(page_number);
+        const uint64_t address = page_number << MEMORY_PAGE_SHIFT;
+        if (MemoryWindow *window = findWindow(address, MEMORY_PAGE_SIZE))
+        {
+            window->revertPage(page_number, original);
+            continue;
+        }
+        Page &page = touchPage(page_number);
+        std::memcpy(page.data.data(), original.data.data(), MEMORY_PAGE_SIZE);
+        page.flags = PAGE_WRITTEN | PAGE_CHECKPOINT_DIRTY;
+    }
+    snapshot_.restored();
+}
+
+void MainMemory::discardSnapshot()
+{
+    snapshot_.discard();
 }
 }//namespace Kites
@@ -10,8 +10,13 @@
 #include "config/config.h"
 #include "memory_block.h"
 #include "memory_device.h"
+#include "memory_snapshot.h"
+#include "memory_window.h"
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -19,46 +24,137 @@
 namespace Kites
 {
 /**
- * @brief Represents a memory management system with dynamic memory block allocation.
+ * @brief Represents a memory management system with on-demand page allocation.
+ *
+ * Memory is split into 4 KB pages, allocated zero-filled the first time they are written and
+ * found through a two-level page table: a sparse directory of page tables, each a flat array of
+ * page pointers. The most recently used page is cached, so runs of accesses to one page never
+ * touch the table. Pages that were never written read as zero and take no space.
+ *
+ * With the MAPPED backend the text, data and stack windows of the address space are each
+ * backed by one lazily populated host mapping instead, where an access is a bounds check and a
+ * pointer add. The page table then only holds the pages outside those windows.
  */
 
 class MainMemory : public MemoryDevice
 {
 private:
-    std::unordered_map<uint64_t, MemoryBlock>
-        blocks_;              ///< A map storing memory blocks, indexed by block index.
-    unsigned int block_size_; ///< The size of each memory block in bytes.
+    struct Page
+    {
+        std::array<uint8_t, MEMORY_PAGE_SIZE> data; ///< Page contents.
+        uint64_t number;                            ///< Address of the page >> MEMORY_PAGE_SHIFT.
+        uint8_t flags;                              ///< PAGE_ flags, see memory_block.h.
+    };
+
+    static constexpr unsigned int PAGE_TABLE_BITS = 12; ///< One page table maps 16 MB.
+    static constexpr size_t PAGE_TABLE_SIZE = size_t{1} << PAGE_TABLE_BITS;
+    static constexpr size_t PAGES_PER_CHUNK = 64; ///< Pages allocated from the arena at once.
+
+    using PageTable = std::array<Page *, PAGE_TABLE_SIZE>;
+
+    std::unordered_map<uint64_t, std::unique_ptr<PageTable>>
+        page_directory_; ///< Page tables, indexed by page number >> PAGE_TABLE_BITS.
+    std::vector<std::unique_ptr<Page[]>> arena_; ///< Page storage, PAGES_PER_CHUNK pages a chunk.
+    size_t page_count_ = 0;                      ///< Pages handed out from the arena.
+    uint64_t last_page_number_ = UINT64_MAX;     ///< Page number cached in last_page_.
+    Page *last_page_ = nullptr;                  ///< The most recently used present page.
+    std::vector<uint8_t> line_buffer_; ///< Lines spanning pages or over absent pages.
+    std::array<MemoryWindow, 3> windows_; ///< Data, stack and text windows; unmapped if unused.
+    MemorySnapshot snapshot_;             ///< Pages as they were when the snapshot was taken.
     uint64_t memory_size_ = vm_config::config.getMemorySize(); ///< The total memory size in bytes.
 
     /**
-     * @brief Gets the block index for a given memory address.
-     * @param address The memory address.
-     * @return The block index corresponding to the address.
+     * @brief Finds the window holding all of [address, address + length), if any.
+     */
+    MemoryWindow *findWindow(uint64_t address, size_t length)
+    {
+        for (MemoryWindow &window : windows_)
+        {
+            if (window.contains(address, length))
+            {
+                return &window;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Maps the windows configured in vm_config, dropping any previous ones.
+     */
+    void mapWindows();
+
+    /**
+     * @brief Zeroes all memory, keeping the windows mapped.
      */
-    uint64_t getBlockIndex(uint64_t address) const;
+    void clear();
 
     /**
-     * @brief Gets the offset within a block for a given memory address.
-     * @param address The memory address.
-     * @return The offset within the block corresponding to the address.
+     * @brief Contents of a page wherever it is stored, or nullptr if it was never written.
      */
-    uint64_t getBlockOffset(uint64_t address) const;
+    const uint8_t *readablePage(uint64_t page_number);
 
     /**
-     * @brief Checks if a memory block is present at the specified index.
-     * @param block_index The index of the block to check.
-     * @return True if the block is present, false otherwise.
+     * @brief Contents of a page wherever it is stored, prepared for writing.
      */
-    bool isBlockPresent(uint64_t block_index) const;
+    uint8_t *writablePage(uint64_t page_number);
 
     /**
-     * @brief Ensures that a memory block exists at the specified index, if not then adds it.
-     * @param block_index The index of the block to check or create.
+     * @brief Finds the page with the given number in the page table.
+     * @return The page, or nullptr if it was never written.
      */
-    void ensureBlockExists(uint64_t block_index);
+    Page *findPage(uint64_t page_number)
+    {
+        if (page_number == last_page_number_)
+        {
+            return last_page_;
+        }
+        return lookupPage(page_number);
+    }
+
+    /**
+     * @brief Finds the page with the given number, allocating it if it does not exist yet.
+     */
+    Page &touchPage(uint64_t page_number)
+    {
+        Page *page = findPage(page_number);
+        return page != nullptr ? *page : allocatePage(page_number);
+    }
+
+    /**
+     * @brief Records a write to a page of the table. Must be called before the write.
+     */
+    void prepareWrite(Page &page)
+    {
+        if (page.flags != PAGE_ALL_DIRTY)
+        {
+            notePageWrite(page);
+        }
+    }
+    void notePageWrite(Page &page);
+
+    /**
+     * @brief Page table walk behind findPage. Caches the page found as the last page.
+     */
+    Page *lookupPage(uint64_t page_number);
+
+    /**
+     * @brief Takes a zero-filled page from the arena and maps it at @p page_number.
+     */
+    Page &allocatePage(uint64_t page_number);
+
+    /**
+     * @brief The @p i th page taken from the arena.
+     */
+    Page &allocatedPage(size_t i) const
+    {
+        return arena_[i / PAGES_PER_CHUNK][i % PAGES_PER_CHUNK];
+    }
 
     /**
      * @brief Generic function to read data of type T from the memory.
+     *
+     * Accesses within one page are a single copy, accesses that straddle two pages are
+     * assembled byte by byte.
      * @tparam T The type of data to read.
      * @param address The memory address to read from.
      * @return The value read from the specified memory address.
@@ -77,7 +173,8 @@ private:
      * @brief Function to read cache Line 
      * @param address The memory address to read from.
      * @param lineSize The size of the line to read.
-     * @return A span of bytes representing the data read from the specified memory address.
+     * @return A span of bytes representing the data read from the specified memory address,
+     * valid until the next call.
      */
     std::span<const uint8_t> readLine(uint64_t address, size_t lineSize) override;
     /**
@@ -93,17 +190,18 @@ private:
      */
     MainMemory()
     {
-        block_size_ = vm_config::config.getMemoryBlockSize();
+        mapWindows();
     }
     /**
      * @brief Destroys the Memory object.
      */
     ~MainMemory() = default;
 
-    void reset()
-    {
-        blocks_.clear();
-    }
+    /**
+     * @brief Zeroes all memory, drops the snapshot and remaps the windows from the current
+     * vm_config.
+     */
+    void reset();
 
     /**
      * @brief Reads a single byte from the given memory address.
@@ -190,6 +288,47 @@ private:
     void getMemoryPoint(std::string address);
 
     void printMemoryUsage() const;
+
+    /**
+     * @brief Copies every block written since the last collection into @p out, replacing any
+     * older copy of the same block there, and marks those blocks clean.
+     */
+    void collectDirtyBlocks(std::unordered_map<uint64_t, MemoryBlock> &out);
+
+    /**
+     * @brief Marks a block dirty so the next collection copies it. Absent blocks are ignored.
+     */
+    void markBlockDirty(uint64_t block_index);
+
+    /**
+     * @brief Marks every present block dirty.
+     */
+    void markAllBlocksDirty();
+
+    /**
+     * @brief Replaces the whole memory with @p blocks. Blocks not listed read as zero again.
+     * Every block is clean afterwards.
+     */
+    void restoreBlocks(const std::unordered_map<uint64_t, MemoryBlock> &blocks);
+
+    /**
+     * @brief Snapshots the current contents. Costs nothing up front: each page is copied the
+     * first time it is written afterwards. Replaces any earlier snapshot.
+     */
+    void takeSnapshot();
+
+    /**
+     * @brief Puts back every page written since the snapshot was taken or last restored.
+     * The snapshot stays in place and can be restored again.
+     */
+    void restoreSnapshot();
+
+    void discardSnapshot();
+
+    [[nodiscard]] bool hasSnapshot() const
+    {
+        return snapshot_.active();
+    }
 };
 }//namespace Kites
 #endif // MAIN_MEMORY_H
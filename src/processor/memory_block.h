@@ -1,24 +1,34 @@
 #pragma once
-#include "config/config.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace Kites
 {
+constexpr unsigned int MEMORY_PAGE_SHIFT = 12;
+constexpr size_t MEMORY_PAGE_SIZE = size_t{1} << MEMORY_PAGE_SHIFT; ///< 4 KB main memory pages
+constexpr uint64_t MEMORY_PAGE_MASK = MEMORY_PAGE_SIZE - 1;
+
+// Per-page write tracking. Every write sets all three, so only the first write to a page after
+// one of them was cleared takes the slow path.
+constexpr uint8_t PAGE_WRITTEN = 1;          ///< written since memory was last emptied
+constexpr uint8_t PAGE_CHECKPOINT_DIRTY = 2; ///< written since the last checkpoint collection
+constexpr uint8_t PAGE_SNAPSHOT_DIRTY = 4;   ///< written since the snapshot was taken or restored
+constexpr uint8_t PAGE_ALL_DIRTY = PAGE_WRITTEN | PAGE_CHECKPOINT_DIRTY | PAGE_SNAPSHOT_DIRTY;
+
 /**
- * @brief Represents a memory block containing 1 KB of memory.
+ * @brief A copy of one main memory page, indexed elsewhere by its page number.
  */
 struct MemoryBlock
 {
     std::vector<uint8_t> data; ///< A vector representing the memory block data.
-    unsigned int block_size =
-        vm_config::config.getMemoryBlockSize(); ///< The size of the memory block in bytes.
 
     /**
-     * @brief Constructs a MemoryBlock with a size of 1 KB initialized to 0.
+     * @brief Constructs a MemoryBlock of one page initialized to 0.
      */
     MemoryBlock()
     {
-        data.resize(block_size, 0);
+        data.resize(MEMORY_PAGE_SIZE, 0);
     }
 };
-}//namespace Kites
\ No newline at end of file
+}//namespace Kites
@@ -13,54 +13,175 @@ instruction_cache_(static_cast<MemoryDevice&>(l2_cache_)) // casting needed here
 
 void MemoryController::reset()
 {
-    memory_.reset();
+    if (memory_.hasSnapshot())
+    {
+        memory_.restoreSnapshot();
+    }
+    else
+    {
+        memory_.reset();
+    }
     l1_cache_.reset();
     l2_cache_.reset();
     instruction_cache_.reset();
+    configureTiming();
     emit memoryResetSignal(); // this will notify views to reset themselves
 }
 
+void MemoryController::takeSnapshot()
+{
+    memory_.takeSnapshot();
+}
+
+void MemoryController::restoreSnapshot()
+{
+    memory_.restoreSnapshot();
+    emit memoryResetSignal();
+}
+
+void MemoryController::discardSnapshot()
+{
+    memory_.discardSnapshot();
+}
+
+bool MemoryController::hasSnapshot() const
+{
+    return memory_.hasSnapshot();
+}
+
+void MemoryController::flushCaches()
+{
+    // l1 and the instruction cache write back into l2, so l2 goes last
+    l1_cache_.flush();
+    instruction_cache_.flush();
+    l2_cache_.flush();
+}
+
+void MemoryController::publishCacheChanges(bool force)
+{
+    l1_cache_.publishChanges(force);
+    instruction_cache_.publishChanges(force);
+    l2_cache_.publishChanges(force);
+}
+
+void MemoryController::configureTiming()
+{
+    timing_.configure(vm_config::config.getMemoryTiming());
+}
+
+uint64_t MemoryController::timeAccess(TimedAccess kind, uint64_t address, uint64_t cycle)
+{
+    if (!timing_.enabled())
+    {
+        return 0;
+    }
+    const Cache &first = kind == TimedAccess::FETCH ? instruction_cache_ : l1_cache_;
+    MemoryLevel level = MemoryLevel::L1;
+    if (!first.contains(address))
+    {
+        level = l2_cache_.contains(address) ? MemoryLevel::L2 : MemoryLevel::MEMORY;
+    }
+    return timing_.access(kind, address / first.getLineSizeInBytes(), level, cycle,
+                          l2_cache_.getLineSizeInBytes());
+}
+
+void MemoryController::startTrace(const std::string &path)
+{
+    stopTrace();
+    trace_writer_ = std::make_unique<AddressTraceWriter>(path);
+}
+
+uint64_t MemoryController::stopTrace()
+{
+    if (!trace_writer_)
+    {
+        return 0;
+    }
+    trace_writer_->close();
+    const uint64_t records = trace_writer_->recordCount();
+    trace_writer_.reset();
+    return records;
+}
+
+void MemoryController::collectDirtyMemoryBlocks(std::unordered_map<uint64_t, MemoryBlock> &out)
+{
+    memory_.collectDirtyBlocks(out);
+}
+
+void MemoryController::markMemoryBlockDirty(uint64_t block_index)
+{
+    memory_.markBlockDirty(block_index);
+}
+
+void MemoryController::markAllMemoryDirty()
+{
+    memory_.markAllBlocksDirty();
+}
+
+std::array<CacheState, 3> MemoryController::saveCacheStates() const
+{
+    return {l1_cache_.saveState(), instruction_cache_.saveState(), l2_cache_.saveState()};
+}
+
+void MemoryController::restoreState(const std::unordered_map<uint64_t, MemoryBlock> &blocks,
+                                    const std::array<CacheState, 3> &caches)
+{
+    memory_.restoreBlocks(blocks);
+    l1_cache_.restoreState(caches[0]);
+    instruction_cache_.restoreState(caches[1]);
+    l2_cache_.restoreState(caches[2]);
+    emit memoryResetSignal();
+}
+
 void MemoryController::writeByte(uint64_t address, uint8_t value)
 {
+    traceAccess(TraceAccess::STORE, address, 1);
     l1_cache_.writeByte(address, value);
     emit memoryUpdated(address);
 }
 
 void MemoryController::writeHalfWord(uint64_t address, uint16_t value)
 {
+    traceAccess(TraceAccess::STORE, address, 2);
     l1_cache_.writeHalfWord(address, value);
     emit memoryUpdated(address);
 }
 
 void MemoryController::writeWord(uint64_t address, uint32_t value)
 {
+    traceAccess(TraceAccess::STORE, address, 4);
     l1_cache_.writeWord(address, value);
     emit memoryUpdated(address);
 }
 
 void MemoryController::writeDoubleWord(uint64_t address, uint64_t value)
 {
+    traceAccess(TraceAccess::STORE, address, 8);
     l1_cache_.writeDoubleWord(address, value);
     emit memoryUpdated(address);
 }
 
 uint8_t MemoryController::readByte(uint64_t address)
 {
+    traceAccess(TraceAccess::LOAD, address, 1);
     return l1_cache_.readByte(address);
 }
 
 uint16_t MemoryController::readHalfWord(uint64_t address)
 {
+    traceAccess(TraceAccess::LOAD, address, 2);
     return l1_cache_.readHalfWord(address);
 }
 
 uint32_t MemoryController::readWord(uint64_t address)
 {
+    traceAccess(TraceAccess::LOAD, address, 4);
     return l1_cache_.readWord(address);
 }
 
 uint64_t MemoryController::readDoubleWord(uint64_t address)
 {
+    traceAccess(TraceAccess::LOAD, address, 8);
     return l1_cache_.readDoubleWord(address);
 }
 
@@ -89,6 +210,8 @@ uint64_t MemoryController::readDoubleWord_d(uint64_t address)
 // function to read from instruction cache
 uint32_t MemoryController::readInstruction(uint64_t address)
 {
+    setAccessPc(address);
+    traceAccess(TraceAccess::FETCH, address, 4);
     return instruction_cache_.readWord(address);
 }
 
@@ -114,6 +237,27 @@ void MemoryController::writeDoubleWord_d(uint64_t address, uint64_t value)
     emit memoryUpdated(address);
 }
 
+void MemoryController::writeByteQuiet_d(uint64_t address, uint8_t value)
+{
+    memory_.writeByte(address, value);
+}
+void MemoryController::writeHalfWordQuiet_d(uint64_t address, uint16_t value)
+{
+    memory_.writeHalfWord(address, value);
+}
+void MemoryController::writeWordQuiet_d(uint64_t address, uint32_t value)
+{
+    memory_.writeWord(address, value);
+}
+void MemoryController::writeDoubleWordQuiet_d(uint64_t address, uint64_t value)
+{
+    memory_.writeDoubleWord(address, value);
+}
+void MemoryController::notifyMemoryChanged()
+{
+    emit memoryResetSignal();
+}
+
 void MemoryController::printMemory(const uint64_t address, unsigned int rows)
 {
     memory_.printMemory(address, rows);
@@ -9,9 +9,14 @@
 
 #include "config/config.h"
 #include "cache/cache.h"
+#include "address_trace.h"
 #include "main_memory.h"
+#include "memory_timing.h"
 #include <QObject>
+#include <array>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
@@ -29,11 +34,40 @@ class MemoryController : public QObject
     Cache l1_cache_;          ///< The cache object for faster memory access. 
     Cache instruction_cache_; ///< The cache object for instructions.
 
+    std::unique_ptr<AddressTraceWriter> trace_writer_; ///< Set while an address trace is recorded.
+    uint64_t access_pc_ = 0;                           ///< Instruction the next data access belongs to.
+    MemoryTimingModel timing_;                         ///< Cycle counts for the pipelined processors.
+
+    void traceAccess(TraceAccess access, uint64_t address, uint8_t size)
+    {
+        if (trace_writer_)
+        {
+            trace_writer_->append(access, address, size, access_pc_);
+        }
+    }
+
   public:
     MemoryController();
 
+    /**
+     * @brief Empties the caches and puts main memory back to its snapshot, or empties it too if
+     * there is none.
+     */
     void reset();
 
+    // --- Snapshots of the loaded program, see processor/memory_snapshot.h ---
+    /**
+     * @brief Snapshots main memory as it is now, typically right after a program was loaded.
+     */
+    void takeSnapshot();
+    /**
+     * @brief Puts main memory back to the snapshot, copying only the pages written since it was
+     * taken or last restored. Caches are left alone.
+     */
+    void restoreSnapshot();
+    void discardSnapshot();
+    [[nodiscard]] bool hasSnapshot() const;
+
     void writeByte(uint64_t address, uint8_t value);
     void writeHalfWord(uint64_t address, uint16_t value);
 
@@ -57,6 +91,94 @@ class MemoryController : public QObject
     void writeHalfWord_d(uint64_t address, uint16_t value);
     void writeWord_d(uint64_t address, uint32_t value);
     void writeDoubleWord_d(uint64_t address, uint64_t value);
+    // Same as the _d writes without the memoryUpdated signal, for runs that write memory faster
+    // than a view could keep up with. Call notifyMemoryChanged() once they are done.
+    void writeByteQuiet_d(uint64_t address, uint8_t value);
+    void writeHalfWordQuiet_d(uint64_t address, uint16_t value);
+    void writeWordQuiet_d(uint64_t address, uint32_t value);
+    void writeDoubleWordQuiet_d(uint64_t address, uint64_t value);
+    /**
+     * @brief Tells views to reload all of memory, after writes that did not signal each change.
+     */
+    void notifyMemoryChanged();
+
+    /**
+     * @brief Writes back every dirty line and invalidates all caches, leaving main memory
+     * authoritative. Used by backends that access main memory directly.
+     */
+    void flushCaches();
+
+    /**
+     * @brief Has every observed cache publish its pending changes, see Cache::publishChanges.
+     */
+    void publishCacheChanges(bool force = true);
+
+    // --- Address traces, see processor/address_trace.h ---
+    /**
+     * @brief Starts recording every access that goes through the caches to @p path, replacing any
+     * trace already being recorded. Accesses that bypass the caches are not recorded.
+     */
+    void startTrace(const std::string &path);
+    /**
+     * @brief Finishes the trace being recorded. Returns the number of accesses in it.
+     */
+    uint64_t stopTrace();
+    [[nodiscard]] bool isTracing() const
+    {
+        return trace_writer_ != nullptr;
+    }
+    /**
+     * @brief Tells the trace and the caches' prefetchers which instruction the following data
+     * accesses belong to. Fetches set it themselves, so only pipelines that fetch ahead of the
+     * memory stage need to call this.
+     */
+    void setAccessPc(uint64_t pc)
+    {
+        access_pc_ = pc;
+        l1_cache_.setAccessPc(pc);
+        l2_cache_.setAccessPc(pc);
+        instruction_cache_.setAccessPc(pc);
+    }
+
+    // --- Timing, see processor/memory_timing.h ---
+    /**
+     * @brief Takes the latencies from the VM configuration and forgets outstanding misses. Also
+     * done by reset().
+     */
+    void configureTiming();
+    [[nodiscard]] bool isTimingEnabled() const
+    {
+        return timing_.enabled();
+    }
+    /**
+     * @brief Returns how many cycles beyond the first an access to @p address issued in
+     * @p cycle takes, 0 with timing off. Call it before making the access, since it goes by
+     * what the caches hold.
+     */
+    uint64_t timeAccess(TimedAccess kind, uint64_t address, uint64_t cycle);
+    [[nodiscard]] const MemoryTimingModel::State &saveTimingState() const
+    {
+        return timing_.saveState();
+    }
+    void restoreTimingState(const MemoryTimingModel::State &state)
+    {
+        timing_.restoreState(state);
+    }
+
+    // --- Checkpointing, see processor/checkpoint_history.h ---
+    void collectDirtyMemoryBlocks(std::unordered_map<uint64_t, MemoryBlock> &out);
+    void markMemoryBlockDirty(uint64_t block_index);
+    void markAllMemoryDirty();
+    /**
+     * @brief Saves the l1, instruction and l2 caches, in that order.
+     */
+    [[nodiscard]] std::array<CacheState, 3> saveCacheStates() const;
+    /**
+     * @brief Puts main memory and all three caches back to a saved state, without any write back
+     * in between. Views are told to reload as if memory had been reset.
+     */
+    void restoreState(const std::unordered_map<uint64_t, MemoryBlock> &blocks,
+                      const std::array<CacheState, 3> &caches);
 
     void printMemory(const uint64_t address, unsigned int rows);
    
@@ -0,0 +1,39 @@
+/**
+ * @file memory_snapshot.cpp
+ * @brief Page preservation of MemorySnapshot.
+ */
+
+#include "processor/memory_snapshot.h"
+
+#include <cstring>
+
+namespace Kites
+{
+void MemorySnapshot::take()
+{
+    original_pages_.clear();
+    modified_pages_.clear();
+    active_ = true;
+}
+
+void MemorySnapshot::discard()
+{
+    original_pages_.clear();
+    modified_pages_.clear();
+    active_ = false;
+}
+
+void MemorySnapshot::preserve(uint64_t page_number, const uint8_t *data)
+{
+    if (!active_)
+    {
+        return;
+    }
+    modified_pages_.push_back(page_number);
+    auto [it, inserted] = original_pages_.try_emplace(page_number);
+    if (inserted && data != nullptr)
+    {
+        std::memcpy(it->second.data.data(), data, MEMORY_PAGE_SIZE);
+    }
+}
+}//namespace Kites
@@ -0,0 +1,72 @@
+/**
+ * @file memory_snapshot.h
+ * @brief Copy-on-write snapshot of main memory pages.
+ */
+#pragma once
+
+#include "processor/memory_block.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Keeps the contents main memory had when the snapshot was taken.
+ *
+ * Nothing is copied up front. Main memory hands each page to preserve() just before the first
+ * write to it since the snapshot was taken or last restored, so the snapshot holds exactly the
+ * pages that changed, and restoring it only copies those back. Pages keep their preserved copy
+ * across restores, so rerunning the same program copies each page once in total.
+ */
+class MemorySnapshot
+{
+  public:
+    [[nodiscard]] bool active() const
+    {
+        return active_;
+    }
+
+    /**
+     * @brief Starts a new snapshot of the current contents, dropping any previous one.
+     */
+    void take();
+    void discard();
+
+    /**
+     * @brief Records a page about to be written for the first time since the snapshot.
+     * @param data the page as it is now, or nullptr if it was never written.
+     */
+    void preserve(uint64_t page_number, const uint8_t *data);
+
+    /**
+     * @brief Pages written since the snapshot was taken or last restored.
+     */
+    [[nodiscard]] const std::vector<uint64_t> &modifiedPages() const
+    {
+        return modified_pages_;
+    }
+
+    /**
+     * @brief The snapshot contents of a page in modifiedPages().
+     */
+    [[nodiscard]] const MemoryBlock &original(uint64_t page_number) const
+    {
+        return original_pages_.at(page_number);
+    }
+
+    /**
+     * @brief Called once every modified page was copied back.
+     */
+    void restored()
+    {
+        modified_pages_.clear();
+    }
+
+  private:
+    bool active_ = false;
+    std::unordered_map<uint64_t, MemoryBlock> original_pages_;
+    std::vector<uint64_t> modified_pages_;
+};
+}//namespace Kites
@@ -0,0 +1,76 @@
+#include "processor/memory_timing.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+void MemoryTimingModel::configure(const vm_config::MemoryTimingConfig &config)
+{
+    config_ = config;
+    reset();
+}
+
+void MemoryTimingModel::reset()
+{
+    state_ = State{};
+}
+
+uint64_t MemoryTimingModel::access(TimedAccess kind, uint64_t line, MemoryLevel level,
+                                   uint64_t cycle, uint64_t line_size)
+{
+    const uint64_t hit_latency = std::max<uint64_t>(
+        1, kind == TimedAccess::FETCH ? config_.instruction_hit_latency : config_.l1_hit_latency);
+    const size_t mshr_count = std::clamp<uint64_t>(config_.mshr_count, 1, MAX_MSHRS);
+
+    // the line was missed on recently and has not arrived yet, so the lookup found it in name only
+    for (size_t i = 0; i < mshr_count; ++i)
+    {
+        const Mshr &mshr = state_.mshrs[i];
+        if (mshr.valid && mshr.line == line && mshr.ready_cycle > cycle)
+        {
+            if (kind == TimedAccess::STORE)
+            {
+                return hit_latency - 1;
+            }
+            return std::max(hit_latency, mshr.ready_cycle - cycle) - 1;
+        }
+    }
+    if (level == MemoryLevel::L1)
+    {
+        return hit_latency - 1;
+    }
+
+    // a free MSHR, or else the one that frees up first
+    Mshr *slot = &state_.mshrs[0];
+    for (size_t i = 0; i < mshr_count; ++i)
+    {
+        Mshr &mshr = state_.mshrs[i];
+        if (!mshr.valid || mshr.ready_cycle <= cycle)
+        {
+            slot = &mshr;
+            break;
+        }
+        if (mshr.ready_cycle < slot->ready_cycle)
+        {
+            slot = &mshr;
+        }
+    }
+    const uint64_t start = slot->valid ? std::max(cycle, slot->ready_cycle) : cycle;
+
+    uint64_t ready = start + hit_latency + config_.l2_hit_latency;
+    if (level == MemoryLevel::MEMORY)
+    {
+        const uint64_t bandwidth = std::max<uint64_t>(1, config_.memory_bandwidth);
+        const uint64_t transfer = (line_size + bandwidth - 1) / bandwidth;
+        ready = std::max(ready + config_.memory_latency, state_.bus_free_cycle) + transfer;
+        state_.bus_free_cycle = ready;
+    }
+    *slot = Mshr{.line = line, .ready_cycle = ready, .valid = true};
+
+    if (kind == TimedAccess::STORE)
+    {
+        return start - cycle + hit_latency - 1;
+    }
+    return ready - cycle - 1;
+}
+}//namespace Kites
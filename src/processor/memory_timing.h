@@ -0,0 +1,101 @@
+/**
+ * @file memory_timing.h
+ * @brief Cycle counts for accesses to the cache hierarchy, for the pipelined processors.
+ */
+#pragma once
+
+#include "config/config.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Kites
+{
+enum class TimedAccess : uint8_t
+{
+    LOAD,
+    STORE,
+    FETCH
+};
+
+/**
+ * @brief Where the line an access needs was found.
+ */
+enum class MemoryLevel : uint8_t
+{
+    L1, // the l1 data cache or the instruction cache, whichever the access goes to
+    L2,
+    MEMORY
+};
+
+/**
+ * @brief Turns each access into the cycles it keeps its pipeline stage busy.
+ *
+ * The caches stay functional and fill at once; this only keeps the clock. A first level hit
+ * takes its hit latency. A miss takes one of the MSHRs shared by the l1 and instruction caches
+ * until its line arrives: after the l2 latency for an l2 hit, or after the memory latency plus
+ * the time the line spends on the memory bus, which moves one line at a time at the configured
+ * bandwidth. When every MSHR is busy a miss waits for the first to free up, and an access to a
+ * line that is still on its way waits for it.
+ *
+ * Loads and fetches wait for their data. Stores wait only for an MSHR and the lookup, the rest
+ * of a store miss overlaps with what follows. Write backs are not charged.
+ */
+class MemoryTimingModel
+{
+  public:
+    static constexpr size_t MAX_MSHRS = 16;
+
+    struct Mshr
+    {
+        uint64_t line = 0;       // first level line number
+        uint64_t ready_cycle = 0; // cycle the line arrives, free from then on
+        bool valid = false;
+    };
+
+    /**
+     * @brief Everything that carries over from one access to the next, for checkpoints and undo.
+     */
+    struct State
+    {
+        std::array<Mshr, MAX_MSHRS> mshrs{};
+        uint64_t bus_free_cycle = 0;
+    };
+
+    void configure(const vm_config::MemoryTimingConfig &config);
+    [[nodiscard]] const vm_config::MemoryTimingConfig &config() const
+    {
+        return config_;
+    }
+    [[nodiscard]] bool enabled() const
+    {
+        return config_.enabled;
+    }
+
+    /**
+     * @brief Forgets outstanding misses.
+     */
+    void reset();
+
+    /**
+     * @brief Times an access issued in @p cycle to first level line @p line, found in @p level.
+     * @param line_size bytes moved over the memory bus on a miss to memory.
+     * @return the cycles the access takes beyond the one its stage always spends.
+     */
+    uint64_t access(TimedAccess kind, uint64_t line, MemoryLevel level, uint64_t cycle,
+                    uint64_t line_size);
+
+    [[nodiscard]] const State &saveState() const
+    {
+        return state_;
+    }
+    void restoreState(const State &state)
+    {
+        state_ = state;
+    }
+
+  private:
+    vm_config::MemoryTimingConfig config_{};
+    State state_{};
+};
+}//namespace Kites
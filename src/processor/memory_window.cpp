@@ -0,0 +1,192 @@
+/**
+ * @file memory_window.cpp
+ * @brief Host mapping and page bookkeeping of MemoryWindow.
+ */
+
+#include "processor/memory_window.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define KITES_HAS_MMAP 1
+#endif
+
+namespace Kites
+{
+namespace
+{
+#ifdef KITES_HAS_MMAP
+void *mapZeroPages(void *hint, size_t size, int extra_flags)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | extra_flags;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void *data = mmap(hint, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return data == MAP_FAILED ? nullptr : data;
+}
+#endif
+} // namespace
+
+MemoryWindow::MemoryWindow(uint64_t base, uint64_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    base_ = base & ~MEMORY_PAGE_MASK;
+    // a window may end exactly at the top of the address space, where base + size wraps to 0
+    const uint64_t length = (base + size - base_ + MEMORY_PAGE_MASK) & ~MEMORY_PAGE_MASK;
+#ifdef KITES_HAS_MMAP
+    data_ = static_cast<uint8_t *>(mapZeroPages(nullptr, static_cast<size_t>(length), 0));
+#endif
+    if (data_ != nullptr)
+    {
+        size_ = length;
+        page_flags_.assign(size_ >> MEMORY_PAGE_SHIFT, 0);
+    }
+}
+
+MemoryWindow::~MemoryWindow()
+{
+    unmap();
+}
+
+MemoryWindow::MemoryWindow(MemoryWindow &&other) noexcept
+    : base_(other.base_), size_(std::exchange(other.size_, 0)),
+      data_(std::exchange(other.data_, nullptr)), page_flags_(std::move(other.page_flags_))
+{
+}
+
+MemoryWindow &MemoryWindow::operator=(MemoryWindow &&other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        base_ = other.base_;
+        size_ = std::exchange(other.size_, 0);
+        data_ = std::exchange(other.data_, nullptr);
+        page_flags_ = std::move(other.page_flags_);
+    }
+    return *this;
+}
+
+void MemoryWindow::unmap()
+{
+#ifdef KITES_HAS_MMAP
+    if (data_ != nullptr)
+    {
+        munmap(data_, static_cast<size_t>(size_));
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    page_flags_.clear();
+}
+
+void MemoryWindow::clear()
+{
+    if (writtenPageCount() == 0)
+    {
+        return;
+    }
+#ifdef KITES_HAS_MMAP
+    // mapping fresh pages over the old ones zeroes them on every platform, unlike madvise
+    if (mapZeroPages(data_, static_cast<size_t>(size_), MAP_FIXED) == nullptr)
+    {
+        std::memset(data_, 0, static_cast<size_t>(size_));
+    }
+#endif
+    std::fill(page_flags_.begin(), page_flags_.end(), 0);
+}
+
+void MemoryWindow::notePageWrite(size_t index, MemorySnapshot &snapshot)
+{
+    uint8_t &flags = page_flags_[index];
+    if ((flags & PAGE_SNAPSHOT_DIRTY) == 0)
+    {
+        // a page never written is still the kernel's zero page, no need to fault it in
+        const uint8_t *data = (flags & PAGE_WRITTEN) != 0 ? data_ + (index << MEMORY_PAGE_SHIFT)
+                                                          : nullptr;
+        snapshot.preserve((base_ >> MEMORY_PAGE_SHIFT) + index, data);
+    }
+    flags = PAGE_ALL_DIRTY;
+}
+
+void MemoryWindow::collectDirtyPages(std::unordered_map<uint64_t, MemoryBlock> &out)
+{
+    const uint64_t first_page = base_ >> MEMORY_PAGE_SHIFT;
+    for (size_t i = 0; i < page_flags_.size(); ++i)
+    {
+        if ((page_flags_[i] & PAGE_CHECKPOINT_DIRTY) != 0)
+        {
+            page_flags_[i] &= ~PAGE_CHECKPOINT_DIRTY;
+            MemoryBlock &block = out[first_page + i];
+            std::memcpy(block.data.data(), data_ + (i << MEMORY_PAGE_SHIFT), MEMORY_PAGE_SIZE);
+        }
+    }
+}
+
+bool MemoryWindow::markPageDirty(uint64_t page_number)
+{
+    const uint64_t index = page_number - (base_ >> MEMORY_PAGE_SHIFT);
+    if (index >= page_flags_.size())
+    {
+        return false;
+    }
+    if ((page_flags_[index] & PAGE_WRITTEN) != 0)
+    {
+        page_flags_[index] |= PAGE_CHECKPOINT_DIRTY;
+    }
+    return true;
+}
+
+void MemoryWindow::markAllPagesDirty()
+{
+    for (uint8_t &flags : page_flags_)
+    {
+        if ((flags & PAGE_WRITTEN) != 0)
+        {
+            flags |= PAGE_CHECKPOINT_DIRTY;
+        }
+    }
+}
+
+void MemoryWindow::clearPageFlag(uint8_t flag)
+{
+    for (uint8_t &flags : page_flags_)
+    {
+        flags &= ~flag;
+    }
+}
+
+void MemoryWindow::revertPage(uint64_t page_number, const MemoryBlock &block)
+{
+    const uint64_t index = page_number - (base_ >> MEMORY_PAGE_SHIFT);
+    std::memcpy(data_ + (index << MEMORY_PAGE_SHIFT), block.data.data(), MEMORY_PAGE_SIZE);
+    page_flags_[index] = PAGE_WRITTEN | PAGE_CHECKPOINT_DIRTY;
+}
+
+std::vector<uint64_t> MemoryWindow::writtenPages() const
+{
+    std::vector<uint64_t> pages;
+    for (size_t i = 0; i < page_flags_.size(); ++i)
+    {
+        if ((page_flags_[i] & PAGE_WRITTEN) != 0)
+        {
+            pages.push_back((base_ >> MEMORY_PAGE_SHIFT) + i);
+        }
+    }
+    return pages;
+}
+
+size_t MemoryWindow::writtenPageCount() const
+{
+    return static_cast<size_t>(std::count_if(page_flags_.begin(), page_flags_.end(),
+                                             [](uint8_t flags)
+                                             { return (flags & PAGE_WRITTEN) != 0; }));
+}
+}//namespace Kites
@@ -0,0 +1,142 @@
+/**
+ * @file memory_window.h
+ * @brief A contiguous range of guest memory backed by a lazily populated host mapping.
+ */
+#pragma once
+
+#include "processor/memory_block.h"
+#include "processor/memory_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Guest addresses [base, base + size) mapped onto one reserved host region.
+ *
+ * The region is reserved with mmap(MAP_NORESERVE), so the kernel only provides memory for the
+ * pages actually touched and untouched pages read as zero. Where no such mapping is available
+ * the window stays unmapped, contains() is always false and the caller falls back to its own
+ * storage.
+ */
+class MemoryWindow
+{
+  public:
+    MemoryWindow() = default;
+    /**
+     * @brief Reserves the window. @p base and @p size are widened to whole pages.
+     */
+    MemoryWindow(uint64_t base, uint64_t size);
+    ~MemoryWindow();
+
+    MemoryWindow(MemoryWindow &&other) noexcept;
+    MemoryWindow &operator=(MemoryWindow &&other) noexcept;
+    MemoryWindow(const MemoryWindow &) = delete;
+    MemoryWindow &operator=(const MemoryWindow &) = delete;
+
+    [[nodiscard]] bool mapped() const
+    {
+        return data_ != nullptr;
+    }
+    [[nodiscard]] uint64_t base() const
+    {
+        return base_;
+    }
+    [[nodiscard]] uint64_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief True if all of [address, address + length) lies in the window.
+     */
+    [[nodiscard]] bool contains(uint64_t address, size_t length) const
+    {
+        const uint64_t offset = address - base_;
+        return offset < size_ && size_ - offset >= length;
+    }
+    [[nodiscard]] bool overlaps(uint64_t base, uint64_t size) const
+    {
+        if (size_ == 0 || size == 0)
+        {
+            return false;
+        }
+        return base - base_ < size_ || base_ - base < size;
+    }
+
+    /**
+     * @brief Host address of guest @p address, which must be inside the window.
+     */
+    [[nodiscard]] uint8_t *at(uint64_t address) const
+    {
+        return data_ + (address - base_);
+    }
+
+    /**
+     * @brief Records a write of @p length bytes at @p address. Must be called before the write,
+     * so @p snapshot can preserve the pages it is about to change.
+     */
+    void prepareWrite(uint64_t address, size_t length, MemorySnapshot &snapshot)
+    {
+        const uint64_t offset = address - base_;
+        const size_t last = (offset + length - 1) >> MEMORY_PAGE_SHIFT;
+        for (size_t index = offset >> MEMORY_PAGE_SHIFT; index <= last; ++index)
+        {
+            if (page_flags_[index] != PAGE_ALL_DIRTY)
+            {
+                notePageWrite(index, snapshot);
+            }
+        }
+    }
+
+    /**
+     * @brief Drops the contents of every page, returning their memory to the system.
+     */
+    void clear();
+
+    /**
+     * @brief Copies every page written since the last collection into @p out, keyed by page
+     * number, and marks those pages clean.
+     */
+    void collectDirtyPages(std::unordered_map<uint64_t, MemoryBlock> &out);
+
+    /**
+     * @brief Marks a page dirty if it was ever written. Returns false if it is not in the window.
+     */
+    bool markPageDirty(uint64_t page_number);
+
+    void markAllPagesDirty();
+
+    /**
+     * @brief Clears @p flag, one of the PAGE_ flags, on every page.
+     */
+    void clearPageFlag(uint8_t flag);
+
+    /**
+     * @brief Puts the snapshot copy of a page, which must be in the window, back in place.
+     */
+    void revertPage(uint64_t page_number, const MemoryBlock &block);
+
+    /**
+     * @brief Numbers of the pages written since the window was last cleared.
+     */
+    [[nodiscard]] std::vector<uint64_t> writtenPages() const;
+
+    /**
+     * @brief Number of pages written since the window was last cleared.
+     */
+    [[nodiscard]] size_t writtenPageCount() const;
+
+  private:
+    void notePageWrite(size_t index, MemorySnapshot &snapshot);
+    void unmap();
+
+    uint64_t base_ = 0;
+    uint64_t size_ = 0;
+    uint8_t *data_ = nullptr;
+    std::vector<uint8_t> page_flags_; // PAGE_ flags, one entry per page of the window
+};
+}//namespace Kites
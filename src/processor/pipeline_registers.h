@@ -12,17 +12,28 @@
 #include "processor/processor_constants.h"
 namespace Kites
 {
+// --- What fetch predicted about an instruction, checked when the instruction resolves ---
+struct FetchPrediction
+{
+    uint64_t next_pc {INVALID_PC};  // where fetch went after this instruction
+    uint64_t history {0};           // global branch history the direction was predicted from
+    uint16_t ras_top {0};           // return address stack before this instruction's push or pop
+    uint16_t ras_depth {0};
+};
+
 // --- Data passed from Fetch (IF) to Decode (ID) ---
 struct IF_ID_Register
 {
     uint32_t instruction {NOP};  // A NOP instruction (addi x0, x0, 0)
     uint64_t pc {INVALID_PC};
+    FetchPrediction prediction {};
 
     void reset()
     {
         // Resetting injects a NOP, used for flushing the pipeline.
         instruction = NOP;
         pc          = INVALID_PC;
+        prediction  = FetchPrediction{};
     }
 
     void insertNop()
@@ -70,6 +81,8 @@ struct ID_EX_Register
 
     uint8_t alu_op {0};      // Hint for the ALU Control Unit
 
+    FetchPrediction prediction {};
+
     void reset()
     {
           // Resetting injects a "bubble"
@@ -80,6 +93,7 @@ struct ID_EX_Register
         instruction = NOP;
         reg_write   = freg_write = mem_to_reg = mem_read = mem_write = branch = alu_src = false;
         alu_op      = 0;
+        prediction  = FetchPrediction{};
     }
 };
 
@@ -104,6 +118,8 @@ struct EX_MEM_Register
     bool     branch_taken      {false};
     bool     prev_branch_taken {false};  // we'll use this for hightlighting purposes
     uint64_t branch_target_pc  {0};
+    bool     branch_mispredicted {false};  // fetch went the wrong way, MEM redirects it
+    FetchPrediction prediction {};
 
     // Control signals passed through from the previous stage
     bool reg_write       {false};  // GPR Write enable
@@ -114,7 +130,7 @@ struct EX_MEM_Register
     bool mem_read        {false};  // for highlighting purposes
     bool mem_write       {false};
 
-    bool prev_mem_read  {false};  // Previous mem_read signal (for highlighting purposes)
+    bool prev_mem_read  {false};  // Previous mem_read signal (highlighting, early branch hazards)
     bool prev_mem_write {false};  // Previous mem_write signal (for highlighting purposes)
 
     void reset()
@@ -135,6 +151,8 @@ struct EX_MEM_Register
         branch_taken      = false;
         prev_branch_taken = false;
         branch_target_pc  = 0;
+        branch_mispredicted = false;
+        prediction          = FetchPrediction{};
 
         reg_write       = false;
         prev_reg_write  = false;
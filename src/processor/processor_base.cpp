@@ -7,6 +7,9 @@
 #include "processor/processor_base.h"
 #include "common/globals.h"
 #include "config/config.h"
+#include "processor/branch_prediction/branch_prediction_unit.h"
+#include "processor/rv5s/rv5s_issue_stats.h"
+#include "utils/utils.h"
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
@@ -18,6 +21,29 @@
 
 namespace Kites
 {
+namespace
+{
+/**
+ * @brief Mutes std::cout while past cycles are re-executed, so their output is not repeated.
+ */
+class ReplayOutputGuard
+{
+  public:
+    ReplayOutputGuard() : buffer_(std::cout.rdbuf(nullptr))
+    {
+    }
+    ~ReplayOutputGuard()
+    {
+        std::cout.rdbuf(buffer_);
+    }
+    ReplayOutputGuard(const ReplayOutputGuard &) = delete;
+    ReplayOutputGuard &operator=(const ReplayOutputGuard &) = delete;
+
+  private:
+    std::streambuf *buffer_;
+};
+} // namespace
+
 ProcessorBase::ProcessorBase()
 {
 }
@@ -39,6 +65,10 @@ void ProcessorBase::RequestResume()
     pause_requested_ = false;
     pause_wait_condition_.wakeAll();
 }
+void ProcessorBase::FastRun()
+{
+    Run();
+}
 bool ProcessorBase::IsStopRequested() const
 {
     return stop_requested_;
@@ -51,15 +81,41 @@ void ProcessorBase::ClearStop()
 
 void ProcessorBase::LoadProgram(const AssembledProgram &program)
 {
+    ClearCheckpoints();
+    const uint64_t data_address = vm_config::config.getDataSectionStart();
+    const bool same_image = memory_controller_.hasSnapshot() &&
+                            snapshot_data_address_ == data_address &&
+                            program.text_buffer == program_.text_buffer &&
+                            program.data_buffer == program_.data_buffer;
     program_ = program;
+    program_size_ = program.text_buffer.size() * 4;
+    AddBreakpoint(program_size_, false); // address
+
+    if (same_image)
+    {
+        memory_controller_.restoreSnapshot();
+    }
+    else
+    {
+        // a reset put back the previous program's image, which must not leak into this one
+        memory_controller_.discardSnapshot();
+        memory_controller_.reset();
+        WriteProgramImage(program);
+        memory_controller_.takeSnapshot();
+        snapshot_data_address_ = data_address;
+    }
+
+    DumpState(globals::vm_state_dump_file_path);
+}
+
+void ProcessorBase::WriteProgramImage(const AssembledProgram &program)
+{
     unsigned int counter = 0;
     for (const auto &instruction : program.text_buffer)
     {
         memory_controller_.writeWord_d(counter, instruction);
         counter += 4;
     }
-    program_size_ = counter;
-    AddBreakpoint(program_size_, false); // address
 
     unsigned int data_counter = 0;
     uint64_t base_data_address = vm_config::config.getDataSectionStart();
@@ -136,8 +192,6 @@ void ProcessorBase::LoadProgram(const AssembledProgram &program)
             },
             data);
     }
-
-    DumpState(globals::vm_state_dump_file_path);
 }
 
 uint64_t ProcessorBase::GetProgramCounter() const
@@ -165,6 +219,7 @@ int32_t ProcessorBase::ImmGenerator(uint32_t instruction)
     {
     /*** I-TYPE (Load, alu Immediate, JALR, FPU Loads) ***/
     case 0b0010011: // alu Immediate (ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI)
+    case 0b0011011: // alu Immediate Word (ADDIW, SLLIW, SRLIW, SRAIW)
     case 0b0000011: // Load (LB, LH, LW, LD, LBU, LHU, LWU)
     case 0b1100111: // JALR
     case 0b0001111: // FENCE
@@ -237,6 +292,7 @@ void ProcessorBase::SetBreakpoints(const std::vector<uint64_t> &breakpoints)
     {
         breakpoints_.emplace_back(program_.line_number_instruction_number_mapping[bp] * 4);
     }
+    breakpoints_changed_ = true;
 }
 
 void ProcessorBase::AddBreakpoint(uint64_t val, bool is_line)
@@ -274,6 +330,7 @@ void ProcessorBase::AddBreakpoint(uint64_t val, bool is_line)
         }
         breakpoints_.emplace_back(val);
     }
+    breakpoints_changed_ = true;
 
     DumpState(globals::vm_state_dump_file_path);
 }
@@ -315,6 +372,7 @@ void ProcessorBase::RemoveBreakpoint(uint64_t val, bool is_line)
         breakpoints_.erase(std::remove(breakpoints_.begin(), breakpoints_.end(), val),
                            breakpoints_.end());
     }
+    breakpoints_changed_ = true;
     DumpState(globals::vm_state_dump_file_path);
 }
 
@@ -360,7 +418,29 @@ void ProcessorBase::DumpState(const std::filesystem::path &filename)
     file << "    \"cpi\": " << cpi_ << ",\n";
     file << "    \"ipc\": " << ipc_ << ",\n";
     file << "    \"stall_cycles\": " << stall_cycles_ << ",\n";
+    file << "    \"memory_stall_cycles\": " << memory_stall_cycles_ << ",\n";
+    file << "    \"functional_unit_stall_cycles\": " << functional_unit_stall_cycles_ << ",\n";
     file << "    \"branch_mispredictions\": " << branch_mispredictions_ << ",\n";
+    if (const BranchPredictionUnit *predictor = GetBranchPredictor())
+    {
+        file << "    \"branch_predictor\": \"" << predictor->name() << "\",\n";
+        file << "    \"branch_prediction_accuracy\": " << predictor->stats().accuracy() << ",\n";
+    }
+    if (const IssueStats *issue = GetIssueStats())
+    {
+        // cycles issuing none, one and two instructions
+        file << "    \"issue_width_histogram\": ["
+             << cycle_s_ - issue->singleIssueCycles - issue->dualIssueCycles << ", "
+             << issue->singleIssueCycles << ", " << issue->dualIssueCycles << "],\n";
+        file << "    \"single_issue_reasons\": {";
+        for (size_t i = 0; i < static_cast<size_t>(SingleIssueReason::COUNT); ++i)
+        {
+            file << (i == 0 ? "" : ", ") << "\""
+                 << singleIssueReasonName(static_cast<SingleIssueReason>(i))
+                 << "\": " << issue->singleIssueReasons[i];
+        }
+        file << "},\n";
+    }
     file << "    \"breakpoints\": [";
     for (size_t i = 1; i < breakpoints_.size(); ++i)
     {
@@ -380,5 +460,208 @@ void ProcessorBase::DumpState(const std::filesystem::path &filename)
 void ProcessorBase::ModifyRegister(const std::string &reg_name, uint64_t value)
 {
     registers_.ModifyRegister(reg_name, value);
+    InvalidateCheckpoints();
+}
+
+std::string ProcessorBase::ConsumeInput()
+{
+    if (input_position_ < input_log_.size())
+    {
+        return input_log_[input_position_++];
+    }
+
+    std::cout << "VM_STDIN_START" << std::endl;
+    output_status_ = "VM_STDIN_START";
+    std::unique_lock<std::mutex> lock(input_mutex_);
+    input_cv_.wait(lock, [this]() { return !input_queue_.empty(); });
+    output_status_ = "VM_STDIN_END";
+    std::cout << "VM_STDIN_END" << std::endl;
+
+    std::string input = input_queue_.front();
+    input_queue_.pop();
+    input_log_.push_back(input);
+    ++input_position_;
+    return input;
+}
+
+void ProcessorBase::CaptureCheckpoint()
+{
+    ProcessorCheckpoint checkpoint;
+    checkpoint.cycle                 = cycle_s_;
+    checkpoint.program_counter       = program_counter_;
+    checkpoint.last_executed_pc      = last_executed_pc_;
+    checkpoint.current_instruction   = current_instruction_;
+    checkpoint.instructions_retired  = instructions_retired_;
+    checkpoint.stall_cycles          = stall_cycles_;
+    checkpoint.memory_stall_cycles   = memory_stall_cycles_;
+    checkpoint.functional_unit_stall_cycles = functional_unit_stall_cycles_;
+    checkpoint.branch_mispredictions = branch_mispredictions_;
+    checkpoint.input_position        = input_position_;
+    checkpoint.registers             = registers_.SaveState();
+    memory_controller_.collectDirtyMemoryBlocks(checkpoint.memory_blocks);
+    checkpoint.caches = memory_controller_.saveCacheStates();
+    SaveCheckpointState(checkpoint.processor_state);
+    checkpoints_.add(std::move(checkpoint));
+}
+
+void ProcessorBase::ClearCheckpoints()
+{
+    // picks up configuration changes made since the last program was loaded
+    checkpoints_.configure(vm_config::config.getCheckpointInterval(),
+                           vm_config::config.getCheckpointMaxCount());
+    input_log_.clear();
+    input_position_ = 0;
+    // the first checkpoint has to hold the whole memory image
+    memory_controller_.markAllMemoryDirty();
+}
+
+void ProcessorBase::InvalidateCheckpoints()
+{
+    if (checkpoints_.empty())
+    {
+        return;
+    }
+    std::vector<uint64_t> dropped_blocks;
+    checkpoints_.truncate(cycle_s_, dropped_blocks);
+    // the replacement is appended after an older checkpoint, so it must also cover every block
+    // the dropped ones held
+    for (uint64_t block_index : dropped_blocks)
+    {
+        memory_controller_.markMemoryBlockDirty(block_index);
+    }
+    input_log_.resize(input_position_);
+    CaptureCheckpoint();
+}
+
+void ProcessorBase::RestoreCheckpoint(size_t index)
+{
+    const ProcessorCheckpoint &checkpoint = checkpoints_.at(index);
+    memory_controller_.restoreState(checkpoints_.memoryAt(index), checkpoint.caches);
+    registers_.RestoreState(checkpoint.registers);
+    program_counter_       = checkpoint.program_counter;
+    last_executed_pc_      = checkpoint.last_executed_pc;
+    current_instruction_   = checkpoint.current_instruction;
+    cycle_s_               = static_cast<unsigned int>(checkpoint.cycle);
+    instructions_retired_  = checkpoint.instructions_retired;
+    stall_cycles_          = checkpoint.stall_cycles;
+    memory_stall_cycles_   = checkpoint.memory_stall_cycles;
+    functional_unit_stall_cycles_ = checkpoint.functional_unit_stall_cycles;
+    branch_mispredictions_ = checkpoint.branch_mispredictions;
+    input_position_        = checkpoint.input_position;
+    size_t offset = 0;
+    LoadCheckpointState(checkpoint.processor_state, offset);
+}
+
+bool ProcessorBase::TravelToCycle(uint64_t cycle)
+{
+    const size_t index = checkpoints_.indexAtOrBefore(cycle);
+    if (index == checkpoints_.size())
+    {
+        return false;
+    }
+    // running on from where we are beats restoring when the target is ahead of us anyway
+    if (cycle_s_ > cycle || cycle_s_ < checkpoints_.at(index).cycle)
+    {
+        RestoreCheckpoint(index);
+    }
+    ReplayOutputGuard guard;
+    while (cycle_s_ < cycle && !ReplayFinished())
+    {
+        ReplayCycle();
+    }
+    return true;
+}
+
+void ProcessorBase::ReverseStep()
+{
+    if (cycle_s_ == 0 || !TravelToCycle(cycle_s_ - 1))
+    {
+        std::cout << "VM_NO_MORE_UNDO" << std::endl;
+        output_status_ = "VM_NO_MORE_UNDO";
+        return;
+    }
+    std::cout << "VM_REVERSE_STEP_COMPLETED" << std::endl;
+    output_status_ = "VM_REVERSE_STEP_COMPLETED";
+    PublishTravelState();
+}
+
+void ProcessorBase::ReverseContinue()
+{
+    const uint64_t origin = cycle_s_;
+    size_t index = origin == 0 ? checkpoints_.size() : checkpoints_.indexAtOrBefore(origin - 1);
+    if (index == checkpoints_.size())
+    {
+        std::cout << "VM_NO_MORE_UNDO" << std::endl;
+        output_status_ = "VM_NO_MORE_UNDO";
+        return;
+    }
+
+    // scan one checkpoint interval at a time, newest first, for the last cycle that started at a
+    // breakpoint
+    uint64_t segment_end = origin;
+    std::optional<uint64_t> hit;
+    for (;;)
+    {
+        RestoreCheckpoint(index);
+        {
+            ReplayOutputGuard guard;
+            while (cycle_s_ < segment_end && !ReplayFinished())
+            {
+                if (CheckBreakpoint(program_counter_))
+                {
+                    hit = cycle_s_;
+                }
+                ReplayCycle();
+            }
+        }
+        if (hit || index == 0)
+        {
+            break;
+        }
+        segment_end = checkpoints_.at(index).cycle;
+        --index;
+    }
+
+    TravelToCycle(hit.value_or(checkpoints_.at(0).cycle));
+    if (hit)
+    {
+        std::cout << "VM_BREAKPOINT_HIT " << program_counter_ << std::endl;
+        output_status_ = "VM_BREAKPOINT_HIT";
+    }
+    else
+    {
+        std::cout << "VM_REVERSE_START_REACHED" << std::endl;
+        output_status_ = "VM_REVERSE_START_REACHED";
+    }
+    PublishTravelState();
+}
+
+void ProcessorBase::GoToCycle(uint64_t cycle)
+{
+    if (!TravelToCycle(cycle))
+    {
+        std::cout << "VM_NO_MORE_UNDO" << std::endl;
+        output_status_ = "VM_NO_MORE_UNDO";
+        return;
+    }
+    // the program may have ended before reaching the cycle
+    output_status_ = cycle_s_ == cycle ? "VM_GOTO_CYCLE_COMPLETED" : "VM_PROGRAM_END";
+    std::cout << output_status_ << std::endl;
+    PublishTravelState();
+}
+
+void ProcessorBase::PublishTravelState()
+{
+    // resuming from here must not stop at the breakpoint we may have just travelled to
+    last_breakpoint_pc_ = program_counter_;
+    cpi_ = instructions_retired_
+               ? static_cast<double>(cycle_s_) / static_cast<double>(instructions_retired_)
+               : 0.0;
+    ipc_ = cycle_s_ ? static_cast<double>(instructions_retired_) / static_cast<double>(cycle_s_)
+                    : 0.0;
+    setProcessorState();
+    emit processorClockedSignal(processor_state_);
+    DumpRegisters(globals::registers_dump_file_path, registers_);
+    DumpState(globals::vm_state_dump_file_path);
 }
 }//namespace Kites
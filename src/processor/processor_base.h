@@ -9,6 +9,7 @@
 #include "alu.h"
 #include "common/assembled_program.h"
 #include "memory_controller.h"
+#include "processor/checkpoint_history.h"
 #include "processor/processor_state.h"
 #include "processor/registers.h"
 #include "ui/processor_tab/circuit_scene.h"
@@ -33,6 +34,8 @@
 
 namespace Kites
 {
+class BranchPredictionUnit;
+struct IssueStats;
 
 enum SyscallCode
 {
@@ -70,6 +73,10 @@ struct StepDelta
     unsigned int new_instructions_retired{};
     unsigned int old_stall_cycles{};
     unsigned int new_stall_cycles{};
+    unsigned int old_memory_stall_cycles{};
+    unsigned int new_memory_stall_cycles{};
+    unsigned int old_functional_unit_stall_cycles{};
+    unsigned int new_functional_unit_stall_cycles{};
     unsigned int old_branch_mispredictions{};
     unsigned int new_branch_mispredictions{};
     std::vector<RegisterChange> register_changes{};
@@ -89,6 +96,9 @@ class ProcessorBase : public QObject
     AssembledProgram program_;
     std::atomic<bool> stop_requested_ {false};
     std::atomic<bool> pause_requested_ {false};
+    // set whenever the breakpoint list changes, so a run that split its translations at the old
+    // breakpoints knows to redo them
+    std::atomic<bool> breakpoints_changed_ {false};
 
     QMutex pause_mutex_;
     QWaitCondition pause_wait_condition_;
@@ -113,6 +123,8 @@ class ProcessorBase : public QObject
     double cpi_{};
     double ipc_{};
     unsigned int stall_cycles_{};
+    unsigned int memory_stall_cycles_{}; // cycles spent waiting on the memory hierarchy
+    unsigned int functional_unit_stall_cycles_{}; // cycles EX waited on a multi-cycle unit
     unsigned int branch_mispredictions_{};
 
     std::string output_status_;
@@ -130,7 +142,17 @@ class ProcessorBase : public QObject
 
     std::unique_ptr<CircuitScene> circuit_scene_; // Circuit scene for visualization
     UndoBuffer<StepDelta> m_undoBuffer{100};
-    void LoadProgram(const AssembledProgram &program);
+
+    CheckpointHistory checkpoints_{vm_config::config.getCheckpointInterval(),
+                                   vm_config::config.getCheckpointMaxCount()};
+    std::vector<std::string> input_log_; // every stdin line consumed, replayed when re-executing
+    size_t input_position_ = 0;          // next entry of input_log_ to hand out
+
+    /**
+     * @brief Loads a program into memory. Reloading the program already loaded only puts back
+     * the memory pages its last run changed, from the snapshot taken on the first load.
+     */
+    virtual void LoadProgram(const AssembledProgram &program);
     uint64_t program_size_ = 0;
 
     uint64_t GetProgramCounter() const;
@@ -157,6 +179,12 @@ class ProcessorBase : public QObject
     void PrintString(uint64_t address);
 
     virtual void Run()      = 0;
+    /**
+     * @brief Runs the program headless: no per-step dumps, prints, signals or
+     * wire lists. State is only materialized when the run stops.
+     * Processors without a dedicated fast path fall back to Run().
+     */
+    virtual void FastRun();
     virtual void DebugRun() = 0;
     virtual void Step()     = 0;
     virtual void Undo()     = 0;
@@ -164,13 +192,110 @@ class ProcessorBase : public QObject
     virtual void Reset()    = 0;
     void DumpState(const std::filesystem::path &filename);
 
+    /**
+     * @brief The branch predictor fetch consults, or nullptr if the processor has none.
+     */
+    virtual const BranchPredictionUnit *GetBranchPredictor() const
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief How many instructions went on to EX together each cycle, or nullptr if the
+     * processor issues one at a time.
+     */
+    virtual const IssueStats *GetIssueStats() const
+    {
+        return nullptr;
+    }
+
     void ModifyRegister(const std::string &reg_name, uint64_t value);
+
+    // --- Time travel: checkpoint and replay ---
+
+    /**
+     * @brief Takes a checkpoint if one is due. Called at the start of every cycle.
+     */
+    void MaybeCheckpoint()
+    {
+        if (checkpoints_.due(cycle_s_))
+        {
+            CaptureCheckpoint();
+        }
+    }
+    void CaptureCheckpoint();
+    /**
+     * @brief Drops all checkpoints and the input log, for a new program or a reset.
+     */
+    void ClearCheckpoints();
+    /**
+     * @brief Forgets checkpoints and logged input from the current cycle on and checkpoints the
+     * current state instead. Needed whenever state is edited by hand, since replaying would
+     * not reproduce the edit.
+     */
+    void InvalidateCheckpoints();
+    /**
+     * @brief Restores the nearest checkpoint at or before @p cycle and silently re-executes up
+     * to it. Stops early if the program ends first.
+     * @return false if no checkpoint covers @p cycle.
+     */
+    bool TravelToCycle(uint64_t cycle);
+    void ReverseStep();
+    /**
+     * @brief Travels back to the most recent earlier cycle that started at a breakpoint, or to
+     * the first cycle if there is none.
+     */
+    void ReverseContinue();
+    void GoToCycle(uint64_t cycle);
+
+    /**
+     * @brief Hands out the next stdin line: from the log when re-executing past cycles,
+     * otherwise waits for PushInput and logs it.
+     */
+    std::string ConsumeInput();
+
     void PushInput(const std::string &input)
     {
         std::lock_guard<std::mutex> lock(input_mutex_);
         input_queue_.push(input);
         input_cv_.notify_one();
     }
+
+  protected:
+    /**
+     * @brief Executes one cycle while travelling. Must behave exactly like Step() apart from
+     * output, and take due checkpoints.
+     */
+    virtual void ReplayCycle()
+    {
+        Step();
+    }
+    [[nodiscard]] virtual bool ReplayFinished() const
+    {
+        return program_counter_ >= program_size_;
+    }
+    /**
+     * @brief Appends processor specific state, such as pipeline registers, to a checkpoint.
+     */
+    virtual void SaveCheckpointState([[maybe_unused]] std::vector<uint8_t> &state) const
+    {
+    }
+    /**
+     * @brief Reads back what SaveCheckpointState stored and drops anything derived from the
+     * state being replaced, such as undo history or translated code.
+     */
+    virtual void LoadCheckpointState([[maybe_unused]] const std::vector<uint8_t> &state,
+                                     [[maybe_unused]] size_t &offset)
+    {
+    }
+
+  private:
+    void RestoreCheckpoint(size_t index);
+    void PublishTravelState();
+    void WriteProgramImage(const AssembledProgram &program);
+
+    uint64_t snapshot_data_address_ = 0; // data section start the memory snapshot was loaded at
+
   signals:
     // vm state will have all the info like pc,cycles, control signals
     void processorClockedSignal(const ProcessorState &processorState);
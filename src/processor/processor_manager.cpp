@@ -9,11 +9,13 @@
  */
 
 #include "processor/processor_factory.h"
+#include "processor/rv5s/rv5s_processor_dual_issue.h"
 #include "processor/rv5s/rv5s_processor_h_f.h"
 #include "processor/rv5s/rv5s_processor_h_nf.h"
 #include "processor/rv5s/rv5s_processor_nh_f.h"
 #include "processor/rv5s/rv5s_processor_nh_nf.h"
 #include "processor/rvss/rvss_processor.h"
+#include "processor/rvss/rvss_threaded_processor.h"
 #include "processor/processor_manager.h"
 #include "common/globals.h"
 #include "common/assembled_program.h"
@@ -32,6 +34,8 @@ ProcessorManager::ProcessorManager(QObject *parent, ProcessorType vmType) : QObj
     ProcessorFactory::RegisterVM<RV5StageProcessorHNF>(ProcessorType::RV5Stage_H_NF);
     ProcessorFactory::RegisterVM<RV5StageProcessorNHF>(ProcessorType::RV5Stage_NH_F);
     ProcessorFactory::RegisterVM<RV5StageProcessorHF>(ProcessorType::RV5Stage_H_F);
+    ProcessorFactory::RegisterVM<RVSSThreadedProcessor>(ProcessorType::RVSS_Threaded);
+    ProcessorFactory::RegisterVM<RV5StageProcessorDualIssue>(ProcessorType::RV5Stage_Dual_Issue);
     m_currentProcessorType = vmType;
     m_currentProcessor = ProcessorFactory::createVM(vmType);
     connect(m_currentProcessor.get(), &ProcessorBase::processorClockedSignal, this,
@@ -93,6 +97,7 @@ void ProcessorManager::loadProgram(const std::string &sourceText)
 void ProcessorManager::runSlot()
 {
     run();
+    m_currentProcessor->memory_controller_.publishCacheChanges();
     emit runFinishedSignal();
 }
 
@@ -101,7 +106,8 @@ void ProcessorManager::processorClockedSlot(const ProcessorState &processorState
     //first we get all the necesary info from the prcossor and then update the related
     //gui widgets
     updateEditorHighlight(processorState.programCounters);
-
+    // a continuous run clocks far more often than the cache views can repaint
+    m_currentProcessor->memory_controller_.publishCacheChanges(false);
 }
 
 
@@ -126,7 +132,8 @@ void ProcessorManager::updateEditorHighlight(const std::vector<uint64_t>& progra
 
     static const std::array<std::string, 5> pcToStageLable = {"IF","ID", "EX", "MEM", "WB"};
 
-    if(m_currentProcessorType == ProcessorType::RVSS)
+    if(m_currentProcessorType == ProcessorType::RVSS ||
+       m_currentProcessorType == ProcessorType::RVSS_Threaded)
     {
         auto programCounter = programCounters[0];
         const auto instructionNumber = static_cast<unsigned int>(programCounter / 4);
@@ -183,7 +190,14 @@ void ProcessorManager::run()
 {
     try
     {
-        m_currentProcessor->Run();
+        if (m_fastRunEnabled)
+        {
+            m_currentProcessor->FastRun();
+        }
+        else
+        {
+            m_currentProcessor->Run();
+        }
     }
     catch (const std::exception &e)
     {
@@ -201,6 +215,7 @@ void ProcessorManager::step()
     {
         emit runErrorSignal(QString::fromStdString(e.what()), resolveCurrentSourceLine());
     }
+    m_currentProcessor->memory_controller_.publishCacheChanges();
 }
 
 void ProcessorManager::debugRun()
@@ -230,12 +245,34 @@ void ProcessorManager::redo()
 {
     m_currentProcessor->Redo();
 }
+void ProcessorManager::reverseStep()
+{
+    m_currentProcessor->ReverseStep();
+}
+void ProcessorManager::reverseContinue()
+{
+    m_currentProcessor->ReverseContinue();
+}
+void ProcessorManager::goToCycle(uint64_t cycle)
+{
+    m_currentProcessor->GoToCycle(cycle);
+}
 void ProcessorManager::setStepDelay(unsigned int delay)
 {
     m_stepDelayMs = delay;
     m_currentProcessor->step_delay_ = delay;
 }
 
+void ProcessorManager::setFastRun(bool enabled)
+{
+    m_fastRunEnabled = enabled;
+}
+
+bool ProcessorManager::isFastRunEnabled() const
+{
+    return m_fastRunEnabled;
+}
+
 void ProcessorManager::setBreakpoints(const std::vector<uint64_t> &breakpoints)
 {
     m_currentProcessor->SetBreakpoints(breakpoints);
@@ -290,11 +327,26 @@ unsigned int ProcessorManager::getBranchMispredictions() const
     return m_currentProcessor->branch_mispredictions_;
 }
 
+const BranchPredictionUnit *ProcessorManager::getBranchPredictor() const
+{
+    return m_currentProcessor->GetBranchPredictor();
+}
+
 unsigned int ProcessorManager::getStallCycles() const
 {
     return m_currentProcessor->stall_cycles_;
 }
 
+unsigned int ProcessorManager::getMemoryStallCycles() const
+{
+    return m_currentProcessor->memory_stall_cycles_;
+}
+
+unsigned int ProcessorManager::getFunctionalUnitStallCycles() const
+{
+    return m_currentProcessor->functional_unit_stall_cycles_;
+}
+
 unsigned int ProcessorManager::getCycles() const
 {
     return m_currentProcessor->cycle_s_;
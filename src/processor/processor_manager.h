@@ -46,8 +46,18 @@ public:
     void resume();
     void undo();
     void redo();
+    // time travel, unbounded by the undo history: replays from the nearest checkpoint
+    void reverseStep();
+    void reverseContinue();
+    void goToCycle(uint64_t cycle);
 
     void setStepDelay(unsigned int delay);
+    /**
+     * @brief When enabled, run() executes headless without per-step dumps,
+     * prints or signals; state is only published when the run stops.
+     */
+    void setFastRun(bool enabled);
+    bool isFastRunEnabled() const;
 
     void setBreakpoints(const std::vector<uint64_t> &breakpoints);
 
@@ -63,7 +73,11 @@ public:
     float getCPI() const;
     float getIPC() const;
     unsigned int getBranchMispredictions() const;
+    // nullptr for processors that do not predict branches
+    const BranchPredictionUnit *getBranchPredictor() const;
     unsigned int getStallCycles() const;
+    unsigned int getMemoryStallCycles() const;
+    unsigned int getFunctionalUnitStallCycles() const;
     unsigned int getCycles() const;
     unsigned int getInstructionsRetired() const;
 private:
@@ -78,6 +92,7 @@ private:
     Profiler m_profiler{};
     // we need this as when we chage vm we need preserve the step delay
     unsigned int m_stepDelayMs{1000};
+    bool m_fastRunEnabled{false};
 public slots:
     void runSlot();
     void processorClockedSlot(const ProcessorState &processorState);
@@ -10,6 +10,8 @@ enum class ProcessorType
     RV5Stage_H_NF,
     RV5Stage_NH_F,
     RV5Stage_H_F,
+    RVSS_Threaded,
+    RV5Stage_Dual_Issue,
 
     ProcessorTypeCount
 };
@@ -108,6 +108,33 @@ void RegisterFile::ModifyRegister(const std::string &reg_name, uint64_t value)
     }
 }
 
+RegisterFile::State RegisterFile::SaveState() const
+{
+    State state;
+    state.gpr = gpr_;
+    state.fpr = fpr_;
+    for (size_t i = 0; i < NUM_CSR; ++i)
+    {
+        if (csr_[i] != 0)
+        {
+            state.csr.emplace_back(static_cast<uint16_t>(i), csr_[i]);
+        }
+    }
+    return state;
+}
+
+void RegisterFile::RestoreState(const State &state)
+{
+    gpr_ = state.gpr;
+    fpr_ = state.fpr;
+    csr_.fill(0);
+    for (const auto &[index, value] : state.csr)
+    {
+        csr_[index] = value;
+    }
+    emit registerResetSignal();
+}
+
 const std::unordered_set<std::string> valid_general_purpose_registers = {
     "x0",   "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",  "x8",  "x9",  "x10",
     "x11",  "x12", "x13", "x14", "x15", "x16", "x17", "x18", "x19", "x20", "x21",
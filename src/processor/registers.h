@@ -46,6 +46,16 @@ class RegisterFile : public QObject
         CSR             ///< Control and Status Register (CSR).
     };
 
+    /**
+     * @brief Register values saved for a checkpoint. CSRs are kept sparse, most of them are zero.
+     */
+    struct State
+    {
+        std::array<uint64_t, NUM_GPR> gpr{};
+        std::array<uint64_t, NUM_FPR> fpr{};
+        std::vector<std::pair<uint16_t, uint64_t>> csr{};
+    };
+
     explicit RegisterFile(QObject *parent = nullptr);
     virtual ~RegisterFile() = default;
 
@@ -97,6 +107,12 @@ class RegisterFile : public QObject
 
     void ModifyRegister(const std::string &reg_name, uint64_t value);
 
+    [[nodiscard]] State SaveState() const;
+    /**
+     * @brief Overwrites every register with @p state. Views are told to reload, as on a reset.
+     */
+    void RestoreState(const State &state);
+
   signals:
     void updateRegister(size_t regIndex, uint64_t value);
     void updateFRegister(size_t regIndex, uint64_t value);
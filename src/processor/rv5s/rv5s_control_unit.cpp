@@ -94,8 +94,8 @@ void RV5SControlUnit::SetControlSignals(uint32_t instruction)
         break;
     case 0b1000011: // FMADD
     case 0b1000111: // FMSUB
-    case 0b1001011: // FNMADD
-    case 0b1001111: // FNMSUB
+    case 0b1001011: // FNMSUB
+    case 0b1001111: // FNMADD
         reg_write_ = true;
         alu_op_ = 4; // ALUOp code '4' for FMA-type decode
         break;
@@ -271,6 +271,14 @@ alu::AluOp RV5SControlUnit::GetAluSignal(uint32_t instruction, bool ALUOp)
             if (funct5 == 0)
                 return alu::AluOp::FSQRT_D;
             break;
+        case 0b0100000: // FCVT.S.D
+            if (funct5 == 0b00001)
+                return alu::AluOp::FCVT_S_D;
+            break;
+        case 0b0100001: // FCVT.D.S
+            if (funct5 == 0b00000)
+                return alu::AluOp::FCVT_D_S;
+            break;
         case 0b0010000: // FSGNJ.S, FSGNJN.S, FSGNJX.S
             if (funct3 == 0b000)
                 return alu::AluOp::FSGNJ_S;
@@ -382,9 +390,9 @@ alu::AluOp RV5SControlUnit::GetAluSignal(uint32_t instruction, bool ALUOp)
         case 0b1000111:
             return (funct2 == 0b00) ? alu::AluOp::FMSUB_S : alu::AluOp::FMSUB_D;
         case 0b1001011:
-            return (funct2 == 0b00) ? alu::AluOp::FNMADD_S : alu::AluOp::FNMADD_D;
-        case 0b1001111:
             return (funct2 == 0b00) ? alu::AluOp::FNMSUB_S : alu::AluOp::FNMSUB_D;
+        case 0b1001111:
+            return (funct2 == 0b00) ? alu::AluOp::FNMADD_S : alu::AluOp::FNMADD_D;
         }
         break;
     }
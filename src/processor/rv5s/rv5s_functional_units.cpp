@@ -0,0 +1,244 @@
+/**
+ * @file rv5s_functional_units.cpp
+ * @brief Multi-cycle functional units of the 5-stage pipelines.
+ */
+#include "processor/rv5s/rv5s_functional_units.h"
+#include "processor/checkpoint_history.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+FpOperands fp_operands(uint32_t instruction)
+{
+    FpOperands operands;
+    const uint8_t opcode = instruction & 0b1111111;
+    const uint8_t funct3 = (instruction >> 12) & 0b111;
+    const uint8_t funct7 = (instruction >> 25) & 0b1111111;
+
+    switch (opcode)
+    {
+    case 0b0000111: // FLW, FLD
+        operands.is_fp = funct3 == 0b010 || funct3 == 0b011;
+        operands.is_double = funct3 == 0b011;
+        operands.reads_gpr_rs1 = true;
+        operands.writes_fpr = true;
+        break;
+    case 0b0100111: // FSW, FSD
+        operands.is_fp = funct3 == 0b010 || funct3 == 0b011;
+        operands.is_double = funct3 == 0b011;
+        operands.reads_gpr_rs1 = true;
+        operands.reads_frs2 = true;
+        break;
+    case 0b1000011: // FMADD
+    case 0b1000111: // FMSUB
+    case 0b1001011: // FNMSUB
+    case 0b1001111: // FNMADD
+        operands.is_fp = true;
+        operands.is_double = ((instruction >> 25) & 0b11) == 0b01;
+        operands.reads_frs1 = operands.reads_frs2 = operands.reads_frs3 = true;
+        operands.writes_fpr = true;
+        break;
+    case 0b1010011: // OP-FP
+        operands.is_fp = true;
+        // fcvt.s.d reads a double, fcvt.d.s is a D instruction anyway
+        operands.is_double = (funct7 & 0b1) || funct7 == 0b0100000;
+        switch (funct7 >> 2)
+        {
+        case 0b01011: // FSQRT
+        case 0b01000: // FCVT.S.D, FCVT.D.S
+            operands.reads_frs1 = true;
+            operands.writes_fpr = true;
+            break;
+        case 0b10100: // FEQ, FLT, FLE
+            operands.reads_frs1 = operands.reads_frs2 = true;
+            operands.writes_gpr = true;
+            break;
+        case 0b11000: // FCVT.W.S, FCVT.L.D, ...
+        case 0b11100: // FMV.X.W, FMV.X.D, FCLASS
+            operands.reads_frs1 = true;
+            operands.writes_gpr = true;
+            break;
+        case 0b11010: // FCVT.S.W, FCVT.D.L, ...
+        case 0b11110: // FMV.W.X, FMV.D.X
+            operands.reads_gpr_rs1 = true;
+            operands.writes_fpr = true;
+            break;
+        default: // FADD, FSUB, FMUL, FDIV, FSGNJ, FMIN, FMAX
+            operands.reads_frs1 = operands.reads_frs2 = true;
+            operands.writes_fpr = true;
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+    return operands;
+}
+
+FunctionalUnit functional_unit(uint32_t instruction)
+{
+    const uint8_t opcode = instruction & 0b1111111;
+    if ((opcode == 0b0110011 || opcode == 0b0111011) && ((instruction >> 25) & 0b1111111) == 1)
+    {
+        // mul, mulh, mulhsu and mulhu have funct3 below 100, the divides and remainders above
+        return ((instruction >> 12) & 0b100) ? FunctionalUnit::INT_DIV : FunctionalUnit::INT_MUL;
+    }
+    if (opcode == 0b1000011 || opcode == 0b1000111 || opcode == 0b1001011 ||
+        opcode == 0b1001111)
+    {
+        return FunctionalUnit::FP_FMA;
+    }
+    if (opcode != 0b1010011)
+    {
+        return FunctionalUnit::ALU;
+    }
+    switch ((instruction >> 27) & 0b11111)
+    {
+    case 0b00000: // FADD
+    case 0b00001: // FSUB
+    case 0b01000: // FCVT.S.D, FCVT.D.S
+    case 0b11000: // FCVT to integer
+    case 0b11010: // FCVT from integer
+        return FunctionalUnit::FP_ADD;
+    case 0b00010:
+        return FunctionalUnit::FP_MUL;
+    case 0b00011:
+        return FunctionalUnit::FP_DIV;
+    case 0b01011:
+        return FunctionalUnit::FP_SQRT;
+    default: // sign injection, min and max, compares, fclass and moves
+        return FunctionalUnit::ALU;
+    }
+}
+
+void RV5SFunctionalUnits::Configure(const vm_config::FunctionalUnitConfig &config)
+{
+    auto at_least_one = [](uint64_t latency)
+    { return static_cast<unsigned int>(std::max<uint64_t>(latency, 1)); };
+
+    latencies_[static_cast<size_t>(FunctionalUnit::ALU)] = 1;
+    latencies_[static_cast<size_t>(FunctionalUnit::FP_ADD)] = at_least_one(config.fp_add_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::FP_MUL)] = at_least_one(config.fp_mul_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::FP_FMA)] = at_least_one(config.fp_fma_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::FP_DIV)] = at_least_one(config.fp_div_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::FP_SQRT)] =
+        at_least_one(config.fp_sqrt_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::INT_MUL)] =
+        at_least_one(config.int_mul_latency);
+    latencies_[static_cast<size_t>(FunctionalUnit::INT_DIV)] =
+        at_least_one(config.int_div_latency);
+    int_mul_pipelined_ = config.int_mul_pipelined;
+    int_div_pipelined_ = config.int_div_pipelined;
+    Reset();
+}
+
+void RV5SFunctionalUnits::Reset()
+{
+    in_flight_.clear();
+}
+
+unsigned int RV5SFunctionalUnits::LatencyOf(FunctionalUnit unit) const
+{
+    return latencies_[static_cast<size_t>(unit)];
+}
+
+bool RV5SFunctionalUnits::IsBusy(FunctionalUnit unit) const
+{
+    // fdiv and fsqrt share the floating point divider
+    auto same_unit = [unit](FunctionalUnit other)
+    {
+        auto divider = [](FunctionalUnit u)
+        { return u == FunctionalUnit::FP_DIV || u == FunctionalUnit::FP_SQRT; };
+        return other == unit || (divider(other) && divider(unit));
+    };
+
+    bool pipelined;
+    switch (unit)
+    {
+    case FunctionalUnit::FP_DIV:
+    case FunctionalUnit::FP_SQRT:
+        pipelined = false;
+        break;
+    case FunctionalUnit::INT_MUL:
+        pipelined = int_mul_pipelined_;
+        break;
+    case FunctionalUnit::INT_DIV:
+        pipelined = int_div_pipelined_;
+        break;
+    default:
+        pipelined = true;
+        break;
+    }
+    if (pipelined)
+    {
+        return false;
+    }
+    // the unit holds on to its result until EX/MEM has taken it
+    return std::any_of(in_flight_.begin(), in_flight_.end(),
+                       [&](const InFlight &op) { return same_unit(op.unit); });
+}
+
+void RV5SFunctionalUnits::Issue(FunctionalUnit unit, const EX_MEM_Register &result)
+{
+    in_flight_.push_back({result, LatencyOf(unit) - 1, unit});
+}
+
+void RV5SFunctionalUnits::Tick()
+{
+    for (InFlight &op : in_flight_)
+    {
+        if (op.remaining > 0)
+        {
+            --op.remaining;
+        }
+    }
+}
+
+bool RV5SFunctionalUnits::HasFinished() const
+{
+    return std::any_of(in_flight_.begin(), in_flight_.end(),
+                       [](const InFlight &op) { return op.remaining == 0; });
+}
+
+EX_MEM_Register RV5SFunctionalUnits::TakeFinished()
+{
+    auto finished = std::find_if(in_flight_.begin(), in_flight_.end(),
+                                 [](const InFlight &op) { return op.remaining == 0; });
+    EX_MEM_Register result = finished->result;
+    in_flight_.erase(finished);
+    return result;
+}
+
+bool RV5SFunctionalUnits::WritesGpr(uint8_t rd) const
+{
+    return rd != 0 && std::any_of(in_flight_.begin(), in_flight_.end(), [rd](const InFlight &op)
+                                  { return op.result.reg_write && op.result.rd == rd; });
+}
+
+bool RV5SFunctionalUnits::WritesFpr(uint8_t frd) const
+{
+    return std::any_of(in_flight_.begin(), in_flight_.end(), [frd](const InFlight &op)
+                       { return op.result.freg_write && op.result.frd == frd; });
+}
+
+void RV5SFunctionalUnits::SaveState(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, in_flight_.size());
+    for (const InFlight &op : in_flight_)
+    {
+        appendCheckpointState(state, op);
+    }
+}
+
+void RV5SFunctionalUnits::RestoreState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    size_t count = 0;
+    readCheckpointState(state, offset, count);
+    in_flight_.resize(count);
+    for (InFlight &op : in_flight_)
+    {
+        readCheckpointState(state, offset, op);
+    }
+}
+}//namespace Kites
@@ -0,0 +1,111 @@
+/**
+ * @file rv5s_functional_units.h
+ * @brief The multi-cycle functional units of the 5-stage pipelines, which keep an instruction
+ * in EX for longer than a cycle.
+ *
+ * An instruction whose unit takes more than a cycle leaves EX for the unit, and EX/MEM gets a
+ * bubble. Instructions behind it go on through EX while it is computed, and it takes its place
+ * in EX/MEM again once the unit is done, holding up whatever is in ID/EX for that cycle unless
+ * that is leaving for a unit too. The pipelined units take a new instruction every cycle, the
+ * others only once they are free again.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "config/config.h"
+#include "processor/pipeline_registers.h"
+
+namespace Kites
+{
+enum class FunctionalUnit : uint8_t
+{
+    ALU,     // everything taking a single cycle
+    FP_ADD,  // fadd, fsub and the conversions
+    FP_MUL,
+    FP_FMA,  // fmadd, fmsub, fnmadd and fnmsub
+    FP_DIV,  // fdiv, sharing the divider with fsqrt
+    FP_SQRT,
+    INT_MUL, // the M extension's multiplies
+    INT_DIV, // and divides and remainders
+    COUNT
+};
+
+/**
+ * @brief Which registers an F or D instruction reads and writes. They name GPRs and FPRs with
+ * the same fields, so the pipeline and the hazard unit cannot tell from the encoding alone.
+ */
+struct FpOperands
+{
+    bool is_fp         = false; // loads, stores and computation of the F and D extensions
+    bool is_double     = false; // computed in double precision, fcvt.s.d included
+    bool reads_gpr_rs1 = false; // base address, or the integer converted or moved
+    bool reads_frs1    = false;
+    bool reads_frs2    = false; // store data for fsw and fsd
+    bool reads_frs3    = false;
+    bool writes_gpr    = false; // compares, fclass and conversions and moves to integer
+    bool writes_fpr    = false;
+};
+
+/**
+ * @brief Sorts out the operands of @p instruction, with is_fp false for anything outside F and D.
+ */
+FpOperands fp_operands(uint32_t instruction);
+
+/**
+ * @brief The unit @p instruction is computed in.
+ */
+FunctionalUnit functional_unit(uint32_t instruction);
+
+class RV5SFunctionalUnits
+{
+  public:
+    void Configure(const vm_config::FunctionalUnitConfig &config);
+    // drops whatever is in flight
+    void Reset();
+
+    [[nodiscard]] unsigned int LatencyOf(FunctionalUnit unit) const;
+    /**
+     * @brief Whether @p unit cannot take an instruction this cycle, only ever a unit that is
+     * not pipelined while it still holds one.
+     */
+    [[nodiscard]] bool IsBusy(FunctionalUnit unit) const;
+
+    /**
+     * @brief Starts computing the instruction EX has just latched into @p result, done after
+     * LatencyOf(unit) - 1 more cycles.
+     */
+    void Issue(FunctionalUnit unit, const EX_MEM_Register &result);
+    // a cycle has passed, called before EX
+    void Tick();
+    [[nodiscard]] bool HasFinished() const;
+    // the oldest finished instruction, for EX/MEM
+    EX_MEM_Register TakeFinished();
+
+    // whether an instruction in flight writes the register, which nothing can read yet
+    [[nodiscard]] bool WritesGpr(uint8_t rd) const;
+    [[nodiscard]] bool WritesFpr(uint8_t frd) const;
+    [[nodiscard]] bool Empty() const
+    {
+        return in_flight_.empty();
+    }
+
+    void SaveState(std::vector<uint8_t> &state) const;
+    void RestoreState(const std::vector<uint8_t> &state, size_t &offset);
+
+  private:
+    struct InFlight
+    {
+        EX_MEM_Register result;
+        unsigned int remaining;
+        FunctionalUnit unit;
+    };
+
+    unsigned int latencies_[static_cast<size_t>(FunctionalUnit::COUNT)] = {1, 1, 1, 1,
+                                                                           1, 1, 1, 1};
+    bool int_mul_pipelined_ = true;
+    bool int_div_pipelined_ = false;
+    std::vector<InFlight> in_flight_; // oldest first
+};
+}//namespace Kites
@@ -12,14 +12,11 @@
 
 
 #include "processor/pipeline_registers.h"
+#include "processor/rv5s/rv5s_functional_units.h"
+#include "processor/rv5s/rv5s_hdu.h"
 
 namespace Kites
 {
-// Define stall count constants
-constexpr int STALL_NONE = 0;
-constexpr int STALL_ONE_CYCLE = 1;
-constexpr int STALL_TWO_CYCLES = 2;
-
 /**
  * @brief Checks for data hazards and returns the number of stalls required.
  * @param if_id_reg The register holding the instruction in the IF/ID stage (the dependent
@@ -27,10 +24,13 @@ constexpr int STALL_TWO_CYCLES = 2;
  * @param id_ex_reg The register holding the instruction in the ID/EX stage (the source
  * instruction).
  * @param is_forwarding_enabled Flag to switch between 'Forwarding ON' and 'No Forwarding' modes.
+ * @param resolves_in_decode Flag for branches and jalr comparing their operands in ID.
+ * @param functional_units The multi-cycle functional units, if any.
  * @return The number of cycles the pipeline should stall (0, 1, or 2).
  */
 int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_ex_reg,
-                      const EX_MEM_Register &ex_mem_reg, bool is_forwarding_enabled)
+                      const EX_MEM_Register &ex_mem_reg, bool is_forwarding_enabled,
+                      bool resolves_in_decode, const RV5SFunctionalUnits *functional_units)
 {
     // --- 1. Extract Source Register Indices from IF/ID Instruction (Dependent) ---
     uint32_t instruction = if_id_reg.instruction;
@@ -44,32 +44,62 @@ int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_
     uint8_t if_id_frs1 = (instruction >> 15) & 0x1F;
     uint8_t if_id_frs2 = (instruction >> 20) & 0x1F;
     uint8_t if_id_frs3 = (instruction >> 27) & 0x1F; // For FMA (R4 format)
+    uint8_t if_id_rd = (instruction >> 7) & 0x1F;
+    uint8_t opcode = instruction & 0b1111111;
+
+    // Which of those the dependent instruction really reads: FP instructions read GPR rs1 at
+    // most, and an FPR only where their format has one
+    const FpOperands fp = fp_operands(instruction);
+    auto reads_gpr = [&](uint8_t rd)
+    {
+        if (rd == 0)
+            return false;
+        if (fp.is_fp)
+            return fp.reads_gpr_rs1 && rd == if_id_rs1;
+        return rd == if_id_rs1 || rd == if_id_rs2;
+    };
+    auto reads_fpr = [&](uint8_t frd)
+    {
+        return (fp.reads_frs1 && frd == if_id_frs1) || (fp.reads_frs2 && frd == if_id_frs2) ||
+               (fp.reads_frs3 && frd == if_id_frs3);
+    };
+
+    // --- Results still in a multi-cycle functional unit ---
+    // They can't be forwarded before they are back in EX/MEM, and a write to the same register
+    // must not overtake them.
+    if (functional_units)
+    {
+        bool writes_gpr = fp.is_fp ? fp.writes_gpr : opcode != 0b0100011 && opcode != 0b1100011;
+        bool gpr_pending = (reads_gpr(if_id_rs1) && functional_units->WritesGpr(if_id_rs1)) ||
+                           (reads_gpr(if_id_rs2) && functional_units->WritesGpr(if_id_rs2)) ||
+                           (writes_gpr && functional_units->WritesGpr(if_id_rd));
+        bool fpr_pending = (fp.reads_frs1 && functional_units->WritesFpr(if_id_frs1)) ||
+                           (fp.reads_frs2 && functional_units->WritesFpr(if_id_frs2)) ||
+                           (fp.reads_frs3 && functional_units->WritesFpr(if_id_frs3)) ||
+                           (fp.writes_fpr && functional_units->WritesFpr(if_id_rd));
+        if (gpr_pending || fpr_pending)
+        {
+            return STALL_ONE_CYCLE;
+        }
+    }
 
     // --- 2. Check for GPR Hazard (Source writes GPR, Dependent reads GPR) ---
     // Two-cycle hazard: current EX/MEM instruction writes a GPR the IF/ID instruction reads
-    bool gpr_hazard_two_cycle = (ex_mem_reg.reg_write && (ex_mem_reg.rd != 0)) &&
-                                (ex_mem_reg.rd == if_id_rs1 || ex_mem_reg.rd == if_id_rs2);
+    bool gpr_hazard_two_cycle = ex_mem_reg.reg_write && reads_gpr(ex_mem_reg.rd);
 
     // One-cycle hazard: previous EX/MEM instruction (now further down) writes a GPR the IF/ID
     // instruction reads
-    bool gpr_hazard_one_cycle =
-        (ex_mem_reg.prev_reg_write && (ex_mem_reg.prev_rd != 0)) &&
-        (ex_mem_reg.prev_rd == if_id_rs1 || ex_mem_reg.prev_rd == if_id_rs2);
+    bool gpr_hazard_one_cycle = ex_mem_reg.prev_reg_write && reads_gpr(ex_mem_reg.prev_rd);
 
     bool gpr_hazard = gpr_hazard_one_cycle || gpr_hazard_two_cycle;
 
     // --- 3. Check for FPR Hazard (Source writes FPR, Dependent reads FPR) ---
     // Note: FPR f0 is NOT hardwired to zero (unlike GPR x0), so no frd != 0 check needed.
     // Two-cycle hazard: current EX/MEM instruction writes an FPR the IF/ID instruction reads
-    bool fpr_hazard_two_cycle =
-        (ex_mem_reg.freg_write) && (ex_mem_reg.frd == if_id_frs1 || ex_mem_reg.frd == if_id_frs2 ||
-                                    ex_mem_reg.frd == if_id_frs3);
+    bool fpr_hazard_two_cycle = ex_mem_reg.freg_write && reads_fpr(ex_mem_reg.frd);
 
     // One-cycle hazard: previous EX/MEM instruction writes an FPR the IF/ID instruction reads
-    bool fpr_hazard_one_cycle =
-        (ex_mem_reg.prev_freg_write) &&
-        (ex_mem_reg.prev_frd == if_id_frs1 || ex_mem_reg.prev_frd == if_id_frs2 ||
-         ex_mem_reg.prev_frd == if_id_frs3);
+    bool fpr_hazard_one_cycle = ex_mem_reg.prev_freg_write && reads_fpr(ex_mem_reg.prev_frd);
 
     bool fpr_hazard = fpr_hazard_one_cycle || fpr_hazard_two_cycle;
 
@@ -79,6 +109,28 @@ int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_
     bool any_hazard_one_cycle = gpr_hazard_one_cycle || fpr_hazard_one_cycle;
     bool any_hazard = gpr_hazard || fpr_hazard;
 
+    // --- 5. Early Branch Resolution (Forwarding ON) ---
+    // A branch or jalr resolved in ID needs its operands a cycle sooner than EX would. Only the
+    // ALU result two instructions ahead, now latched for MEM, can be forwarded into decode, so
+    // wait out a result still being computed in EX and a load still reading memory. Without
+    // forwarding decode already waits for the register file, which covers this too.
+    bool is_branch = opcode == 0b1100011;
+    bool is_jalr = opcode == 0b1100111;
+    if (is_forwarding_enabled && resolves_in_decode && (is_branch || is_jalr))
+    {
+        auto reads = [&](uint8_t rd)
+        { return rd != 0 && (rd == if_id_rs1 || (is_branch && rd == if_id_rs2)); };
+
+        if (ex_mem_reg.reg_write && reads(ex_mem_reg.rd))
+        {
+            return ex_mem_reg.mem_read ? STALL_TWO_CYCLES : STALL_ONE_CYCLE;
+        }
+        if (ex_mem_reg.prev_reg_write && ex_mem_reg.prev_mem_read && reads(ex_mem_reg.prev_rd))
+        {
+            return STALL_ONE_CYCLE;
+        }
+    }
+
     if (is_forwarding_enabled)
     {
         // --- Forwarding ON: Detects Load-Use only (1 Stall) ---
@@ -87,12 +139,9 @@ int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_
         if (id_ex_reg.mem_read)
         {
             // Check if the load destination matches any source of the dependent instruction
-            bool gpr_load_use = (id_ex_reg.reg_write && id_ex_reg.rd != 0) &&
-                                (id_ex_reg.rd == if_id_rs1 || id_ex_reg.rd == if_id_rs2);
+            bool gpr_load_use = id_ex_reg.reg_write && reads_gpr(id_ex_reg.rd);
 
-            bool fpr_load_use = (id_ex_reg.freg_write) &&
-                                (id_ex_reg.frd == if_id_frs1 || id_ex_reg.frd == if_id_frs2 ||
-                                 id_ex_reg.frd == if_id_frs3);
+            bool fpr_load_use = id_ex_reg.freg_write && reads_fpr(id_ex_reg.frd);
 
             if (gpr_load_use || fpr_load_use)
             {
@@ -118,4 +167,126 @@ int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_
 
     return STALL_NONE;
 }
-}//namespace Kites
\ No newline at end of file
+namespace
+{
+// The registers an instruction reads and writes, with the formats without rs1 or rs2 telling
+// apart what check_data_hazard conservatively takes for a source
+struct RegisterUse
+{
+    uint8_t reads_gpr[2] = {0, 0}; // x0 for none
+    bool reads_fpr[3] = {false, false, false};
+    uint8_t writes_gpr = 0;
+    bool writes_fpr = false;
+};
+
+RegisterUse register_use(uint32_t instruction)
+{
+    RegisterUse use;
+    const uint8_t opcode = instruction & 0b1111111;
+    const uint8_t rs1 = (instruction >> 15) & 0x1F;
+    const uint8_t rs2 = (instruction >> 20) & 0x1F;
+    const uint8_t rd = (instruction >> 7) & 0x1F;
+
+    const FpOperands fp = fp_operands(instruction);
+    if (fp.is_fp)
+    {
+        use.reads_gpr[0] = fp.reads_gpr_rs1 ? rs1 : 0;
+        use.reads_fpr[0] = fp.reads_frs1;
+        use.reads_fpr[1] = fp.reads_frs2;
+        use.reads_fpr[2] = fp.reads_frs3;
+        use.writes_gpr = fp.writes_gpr ? rd : 0;
+        use.writes_fpr = fp.writes_fpr;
+        return use;
+    }
+
+    switch (opcode)
+    {
+    case 0b0110011: // R-Type
+    case 0b0111011: // R-Type, word sized
+        use.reads_gpr[0] = rs1;
+        use.reads_gpr[1] = rs2;
+        use.writes_gpr = rd;
+        break;
+    case 0b0100011: // Store
+    case 0b1100011: // Branch
+        use.reads_gpr[0] = rs1;
+        use.reads_gpr[1] = rs2;
+        break;
+    case 0b0110111: // LUI
+    case 0b0010111: // AUIPC
+    case 0b1101111: // JAL
+        use.writes_gpr = rd;
+        break;
+    default: // I-Type, loads, JALR and CSR accesses
+        use.reads_gpr[0] = rs1;
+        use.writes_gpr = rd;
+        break;
+    }
+    return use;
+}
+
+bool is_memory_access(uint32_t instruction)
+{
+    const uint8_t opcode = instruction & 0b1111111;
+    return opcode == 0b0000011 || opcode == 0b0100011 || opcode == 0b0000111 ||
+           opcode == 0b0100111;
+}
+
+bool ends_issue_group(uint32_t instruction)
+{
+    const uint8_t opcode = instruction & 0b1111111;
+    return opcode == 0b1100011 || opcode == 0b1101111 || opcode == 0b1100111 ||
+           opcode == 0b1110011;
+}
+} // namespace
+
+std::optional<SingleIssueReason> check_pairing(const IF_ID_Register &older,
+                                               const IF_ID_Register &younger)
+{
+    if (older.instruction == NOP || younger.instruction == NOP)
+    {
+        return std::nullopt;
+    }
+
+    // Fetch went on past the branch or jump the way it was predicted, which EX only confirms
+    // later, so whatever follows waits for the next cycle
+    if (ends_issue_group(older.instruction))
+    {
+        return SingleIssueReason::CONTROL;
+    }
+    if (is_memory_access(older.instruction) && is_memory_access(younger.instruction))
+    {
+        return SingleIssueReason::MEMORY_PORT;
+    }
+
+    // Nothing forwards from one lane to the other within EX, and the older result may still
+    // be in a multi-cycle unit when the younger one's would be written
+    const RegisterUse first = register_use(older.instruction);
+    const RegisterUse second = register_use(younger.instruction);
+    const uint8_t frd = (older.instruction >> 7) & 0x1F;
+    const uint8_t frs[3] = {static_cast<uint8_t>((younger.instruction >> 15) & 0x1F),
+                            static_cast<uint8_t>((younger.instruction >> 20) & 0x1F),
+                            static_cast<uint8_t>((younger.instruction >> 27) & 0x1F)};
+    if (first.writes_gpr != 0 &&
+        (second.reads_gpr[0] == first.writes_gpr || second.reads_gpr[1] == first.writes_gpr ||
+         second.writes_gpr == first.writes_gpr))
+    {
+        return SingleIssueReason::DEPENDENCY;
+    }
+    if (first.writes_fpr)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (second.reads_fpr[i] && frs[i] == frd)
+            {
+                return SingleIssueReason::DEPENDENCY;
+            }
+        }
+        if (second.writes_fpr && ((younger.instruction >> 7) & 0x1F) == frd)
+        {
+            return SingleIssueReason::DEPENDENCY;
+        }
+    }
+    return std::nullopt;
+}
+}//namespace Kites
@@ -7,8 +7,11 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 // Assuming the path to pipeline_registers.h is correct relative to the HDU file
 #include "processor/pipeline_registers.h"
+#include "processor/rv5s/rv5s_functional_units.h"
+#include "processor/rv5s/rv5s_issue_stats.h"
 
 namespace Kites
 {
@@ -26,8 +29,27 @@ constexpr int STALL_TWO_CYCLES = 2;
  * @param is_forwarding_enabled Flag to determine the stall logic:
  * - true: Only stall for the Load-Use hazard (STALL_ONE_CYCLE).
  * - false: Stall for ALL dependencies (STALL_TWO_CYCLES).
+ * @param resolves_in_decode Whether branches and jalr compare their operands in ID, see
+ * RV5StageVM_Base::resolve_in_decode. With forwarding they then also wait for an ALU result
+ * still in EX (STALL_ONE_CYCLE) and for a load one (STALL_TWO_CYCLES) or two
+ * (STALL_ONE_CYCLE) instructions ahead.
+ * @param functional_units The multi-cycle units, if any. Nothing can be forwarded out of them
+ * and a result still in one can land after a later write to the same register, so both wait
+ * until it is back in EX/MEM (STALL_ONE_CYCLE, checked again every cycle).
  * @return The number of cycles the pipeline must stall (0, 1, or 2).
  */
 int check_data_hazard(const IF_ID_Register &if_id_reg, const ID_EX_Register &id_ex_reg,
-                      const EX_MEM_Register &ex_mem_reg, bool is_forwarding_enabled);
+                      const EX_MEM_Register &ex_mem_reg, bool is_forwarding_enabled,
+                      bool resolves_in_decode,
+                      const RV5SFunctionalUnits *functional_units = nullptr);
+
+/**
+ * @brief Checks whether the two instructions fetched together on the dual-issue pipeline can
+ * also issue together. Hazards against instructions further ahead are check_data_hazard's.
+ * @param older The IF/ID register of the instruction first in program order.
+ * @param younger The IF/ID register of the one right behind it.
+ * @return why only @p older issues this cycle, or nothing when both can.
+ */
+std::optional<SingleIssueReason> check_pairing(const IF_ID_Register &older,
+                                               const IF_ID_Register &younger);
 }//namespace Kites
\ No newline at end of file
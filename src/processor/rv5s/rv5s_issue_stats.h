@@ -0,0 +1,54 @@
+/**
+ * @file rv5s_issue_stats.h
+ * @brief How many instructions the dual-issue pipeline issued each cycle, and why it issued
+ * only one when it did.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace Kites
+{
+enum class SingleIssueReason : uint8_t
+{
+    FETCH,       // only one instruction was there to issue
+    DEPENDENCY,  // the younger reads or writes a register the older writes
+    MEMORY_PORT, // both load or store, and there is one data memory port
+    CONTROL,     // the older is a branch, jump or system instruction, which ends the pair
+    HAZARD,      // the younger waits on a load or a functional unit further ahead
+    COUNT
+};
+
+inline std::string_view singleIssueReasonName(SingleIssueReason reason)
+{
+    switch (reason)
+    {
+    case SingleIssueReason::FETCH:
+        return "fetch";
+    case SingleIssueReason::DEPENDENCY:
+        return "dependency";
+    case SingleIssueReason::MEMORY_PORT:
+        return "memory_port";
+    case SingleIssueReason::CONTROL:
+        return "control";
+    case SingleIssueReason::HAZARD:
+        return "hazard";
+    default:
+        return "unknown";
+    }
+}
+
+struct IssueStats
+{
+    // every other cycle issued nothing, memory stalls included
+    uint64_t dualIssueCycles = 0;
+    uint64_t singleIssueCycles = 0;
+    uint64_t singleIssueReasons[static_cast<size_t>(SingleIssueReason::COUNT)] = {};
+
+    uint64_t reasonCount(SingleIssueReason reason) const
+    {
+        return singleIssueReasons[static_cast<size_t>(reason)];
+    }
+};
+}//namespace Kites
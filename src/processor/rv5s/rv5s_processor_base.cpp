@@ -1,6 +1,8 @@
 #include "common/debug_colors.h"
 #include "common/instructions.h"
 #include "processor/rv5s/rv5s_processor_base.h"
+#include "config/config.h"
+#include <algorithm>
 #include <thread>
 
 namespace Kites
@@ -91,11 +93,16 @@ void RV5StageVM_Base::Reset()
     instructions_retired_ = 0;
     cycle_s_              = 0;
     stall_cycles_         = 0;
+    memory_stall_cycles_  = 0;
+    memory_stall_remaining_ = 0;
+    functional_unit_stall_cycles_ = 0;
     last_breakpoint_pc_.reset(); // Clear breakpoint tracking on reset
 
     registers_.Reset();
     memory_controller_.reset();
     control_unit_.Reset();
+    branch_predictor_.configure(vm_config::config.getBranchPredictor());
+    functional_units_.Configure(vm_config::config.getFunctionalUnits());
 
     if_id_reg_.reset();
     id_ex_reg_.reset();
@@ -105,6 +112,44 @@ void RV5StageVM_Base::Reset()
     undo_stack_ = std::stack<RV5StageStepDelta>();
     redo_stack_ = std::stack<RV5StageStepDelta>();
     processor_state_.reset();
+    ClearCheckpoints();
+}
+
+bool RV5StageVM_Base::ReplayFinished() const
+{
+    return program_counter_ >= program_size_ && is_pipeline_drained();
+}
+
+void RV5StageVM_Base::SaveCheckpointState(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, if_id_reg_);
+    appendCheckpointState(state, id_ex_reg_);
+    appendCheckpointState(state, ex_mem_reg_);
+    appendCheckpointState(state, mem_wb_reg_);
+    appendCheckpointState(state, memory_stall_remaining_);
+    appendCheckpointState(state, memory_controller_.saveTimingState());
+    branch_predictor_.saveState(state);
+    functional_units_.SaveState(state);
+    save_pipeline_state(state);
+}
+
+void RV5StageVM_Base::LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    readCheckpointState(state, offset, if_id_reg_);
+    readCheckpointState(state, offset, id_ex_reg_);
+    readCheckpointState(state, offset, ex_mem_reg_);
+    readCheckpointState(state, offset, mem_wb_reg_);
+    readCheckpointState(state, offset, memory_stall_remaining_);
+    MemoryTimingModel::State timing;
+    readCheckpointState(state, offset, timing);
+    memory_controller_.restoreTimingState(timing);
+    branch_predictor_.restoreState(state, offset);
+    functional_units_.RestoreState(state, offset);
+    restore_pipeline_state(state, offset);
+    // the undo history describes the state being replaced
+    current_delta_ = RV5StageStepDelta{};
+    undo_stack_ = std::stack<RV5StageStepDelta>();
+    redo_stack_ = std::stack<RV5StageStepDelta>();
 }
 
 void RV5StageVM_Base::begin_step_delta()
@@ -113,8 +158,14 @@ void RV5StageVM_Base::begin_step_delta()
     current_delta_.old_pc                    = program_counter_;
     current_delta_.old_cycle                 = cycle_s_;
     current_delta_.old_stall_cycles          = stall_cycles_;
+    current_delta_.old_memory_stall_cycles   = memory_stall_cycles_;
+    current_delta_.old_memory_stall_remaining = memory_stall_remaining_;
+    current_delta_.old_functional_unit_stall_cycles = functional_unit_stall_cycles_;
+    current_delta_.old_functional_units      = functional_units_;
+    current_delta_.old_memory_timing         = memory_controller_.saveTimingState();
     current_delta_.old_instructions_retired  = instructions_retired_;
     current_delta_.old_branch_mispredictions = branch_mispredictions_;
+    save_pipeline_state(current_delta_.old_pipeline_state);
 
     current_delta_.pipeline_register_change.old_if_id_reg  = if_id_reg_;
     current_delta_.pipeline_register_change.old_id_ex_reg  = id_ex_reg_;
@@ -127,13 +178,20 @@ void RV5StageVM_Base::finalize_step_delta()
     current_delta_.new_pc                    = program_counter_;
     current_delta_.new_cycle                 = cycle_s_;
     current_delta_.new_stall_cycles          = stall_cycles_;
+    current_delta_.new_memory_stall_cycles   = memory_stall_cycles_;
+    current_delta_.new_memory_stall_remaining = memory_stall_remaining_;
+    current_delta_.new_functional_unit_stall_cycles = functional_unit_stall_cycles_;
+    current_delta_.new_functional_units      = functional_units_;
+    current_delta_.new_memory_timing         = memory_controller_.saveTimingState();
     current_delta_.new_instructions_retired  = instructions_retired_;
     current_delta_.new_branch_mispredictions = branch_mispredictions_;
+    save_pipeline_state(current_delta_.new_pipeline_state);
 
     current_delta_.pipeline_register_change.new_if_id_reg  = if_id_reg_;
     current_delta_.pipeline_register_change.new_id_ex_reg  = id_ex_reg_;
     current_delta_.pipeline_register_change.new_ex_mem_reg = ex_mem_reg_;
     current_delta_.pipeline_register_change.new_mem_wb_reg = mem_wb_reg_;
+    current_delta_.branch_predictor_writes = branch_predictor_.takeWrites();
 
     undo_stack_.push(current_delta_);
     while (!redo_stack_.empty())
@@ -142,6 +200,160 @@ void RV5StageVM_Base::finalize_step_delta()
     }
 }
 
+bool RV5StageVM_Base::hold_for_memory()
+{
+    if (memory_stall_remaining_ == 0)
+    {
+        return false;
+    }
+    begin_step_delta();
+    --memory_stall_remaining_;
+    ++memory_stall_cycles_;
+    ++cycle_s_;
+    finalize_step_delta();
+    return true;
+}
+
+void RV5StageVM_Base::stall_for_memory(uint64_t extra_cycles)
+{
+    memory_stall_remaining_ =
+        std::max(memory_stall_remaining_, static_cast<unsigned int>(extra_cycles));
+}
+
+uint32_t RV5StageVM_Base::fetch_instruction(uint64_t pc)
+{
+    if (memory_controller_.isTimingEnabled())
+    {
+        stall_for_memory(memory_controller_.timeAccess(TimedAccess::FETCH, pc, cycle_s_));
+    }
+    return memory_controller_.readInstruction(pc);
+}
+
+void RV5StageVM_Base::fetch_and_predict()
+{
+    if (program_counter_ >= program_size_)
+    {
+        // past the end of the program, fetch bubbles while the pipeline drains
+        if_id_reg_.reset();
+        if_id_reg_.prediction.next_pc = program_counter_ + 4;
+        return;
+    }
+    if_id_reg_.instruction = fetch_instruction(program_counter_);
+    if_id_reg_.pc = program_counter_;
+    if_id_reg_.prediction = branch_predictor_.predict(program_counter_);
+}
+
+void RV5StageVM_Base::resolve_branch(bool taken)
+{
+    ex_mem_reg_.branch_taken = taken;
+    if (taken)
+    {
+        ex_mem_reg_.branch_target_pc = id_ex_reg_.pc + id_ex_reg_.imm;
+    }
+    ex_mem_reg_.prediction = id_ex_reg_.prediction;
+    if (early_branch_resolution_)
+    {
+        return; // decode has trained the predictor and redirected fetch already
+    }
+    ex_mem_reg_.branch_mispredicted =
+        branch_predictor_.resolve(id_ex_reg_.pc, id_ex_reg_.instruction, id_ex_reg_.prediction,
+                                  taken, id_ex_reg_.pc + id_ex_reg_.imm);
+}
+
+bool RV5StageVM_Base::resolve_jump(uint64_t target)
+{
+    ex_mem_reg_.branch_taken = true;
+    // the link address, which a predicted call's first instructions may need forwarded
+    ex_mem_reg_.alu_result = id_ex_reg_.pc + 4;
+    if (early_branch_resolution_)
+    {
+        return false;
+    }
+    if (!branch_predictor_.resolve(id_ex_reg_.pc, id_ex_reg_.instruction, id_ex_reg_.prediction,
+                                   true, target))
+    {
+        return false;
+    }
+    // the instruction behind the jump was fetched from the wrong place
+    program_counter_ = target;
+    if_id_reg_.reset();
+    return true;
+}
+
+bool RV5StageVM_Base::resolve_in_decode(bool forwarding)
+{
+    const uint32_t instruction = id_ex_reg_.instruction;
+    const uint8_t opcode = instruction & 0b1111111;
+    if (opcode != 0b1100011 && opcode != 0b1101111 && opcode != 0b1100111)
+    {
+        return false;
+    }
+
+    uint64_t rs1_value = id_ex_reg_.reg1_data;
+    uint64_t rs2_value = id_ex_reg_.reg2_data;
+    if (forwarding && mem_wb_reg_.reg_write && mem_wb_reg_.rd != 0)
+    {
+        if (mem_wb_reg_.rd == id_ex_reg_.rs1)
+        {
+            rs1_value = mem_wb_reg_.alu_result;
+        }
+        if (mem_wb_reg_.rd == id_ex_reg_.rs2)
+        {
+            rs2_value = mem_wb_reg_.alu_result;
+        }
+    }
+
+    bool taken = true;
+    uint64_t target = id_ex_reg_.pc + id_ex_reg_.imm;
+    if (opcode == 0b1100011)
+    {
+        const auto signed_rs1 = static_cast<int64_t>(rs1_value);
+        const auto signed_rs2 = static_cast<int64_t>(rs2_value);
+        switch ((instruction >> 12) & 0b111)
+        {
+        case 0b000:
+            taken = rs1_value == rs2_value;
+            break; // BEQ
+        case 0b001:
+            taken = rs1_value != rs2_value;
+            break; // BNE
+        case 0b100:
+            taken = signed_rs1 < signed_rs2;
+            break; // BLT
+        case 0b101:
+            taken = signed_rs1 >= signed_rs2;
+            break; // BGE
+        case 0b110:
+            taken = rs1_value < rs2_value;
+            break; // BLTU
+        case 0b111:
+            taken = rs1_value >= rs2_value;
+            break; // BGEU
+        default:
+            taken = false;
+            break;
+        }
+    }
+    else if (opcode == 0b1100111)
+    {
+        target = (rs1_value + id_ex_reg_.imm) & ~1ULL; // JALR
+    }
+
+    if (!branch_predictor_.resolve(id_ex_reg_.pc, instruction, id_ex_reg_.prediction, taken,
+                                   target))
+    {
+        return false;
+    }
+    // the comparator settles too late for this cycle's fetch, which becomes a bubble
+    if_id_reg_.reset();
+    if_id_reg_.prediction.next_pc = taken ? target : id_ex_reg_.pc + 4;
+    if (opcode == 0b1100011)
+    {
+        branch_mispredictions_++;
+    }
+    return true;
+}
+
 void RV5StageVM_Base::setProcessorState()
 {
     // processor_state_.programCounters[toIndex(PipelineStage::IF)]  = program_counter_;
@@ -161,6 +373,7 @@ void RV5StageVM_Base::pipeline_decode()
         // Pass through fields as needed
         id_ex_reg_.pc          = if_id_reg_.pc;
         id_ex_reg_.instruction = instruction;
+        id_ex_reg_.prediction  = if_id_reg_.prediction;
         id_ex_reg_.imm         = 0;
         id_ex_reg_.rs1         = id_ex_reg_.rs2 = id_ex_reg_.rd = 0;
         id_ex_reg_.reg1_data   = 0;
@@ -189,6 +402,7 @@ void RV5StageVM_Base::pipeline_decode()
     // Latch data for the ID/EX register
     id_ex_reg_.pc = if_id_reg_.pc;
     id_ex_reg_.instruction = instruction;
+    id_ex_reg_.prediction = if_id_reg_.prediction;
     id_ex_reg_.imm = ImmGenerator(instruction);
 
     // Extract register numbers
@@ -196,9 +410,13 @@ void RV5StageVM_Base::pipeline_decode()
     id_ex_reg_.rs2 = (instruction >> 20) & 0x1F;
     id_ex_reg_.rd = (instruction >> 7) & 0x1F;
 
+    // For FP loads, stores and integer-to-float conversions / moves rs1 is a GPR source too
+    id_ex_reg_.reg1_data = registers_.ReadGpr(id_ex_reg_.rs1);
+    id_ex_reg_.reg2_data = registers_.ReadGpr(id_ex_reg_.rs2);
+
     // Extract FP register indices for F/D instructions
-    if (instruction_set::isFInstruction(instruction) ||
-        instruction_set::isDInstruction(instruction))
+    const FpOperands fp = fp_operands(instruction);
+    if (fp.is_fp)
     {
         id_ex_reg_.frs1 = (instruction >> 15) & 0x1F;
         id_ex_reg_.frs2 = (instruction >> 20) & 0x1F;
@@ -208,21 +426,15 @@ void RV5StageVM_Base::pipeline_decode()
         id_ex_reg_.freg1_data = registers_.ReadFpr(id_ex_reg_.frs1);
         id_ex_reg_.freg2_data = registers_.ReadFpr(id_ex_reg_.frs2);
         id_ex_reg_.freg3_data = registers_.ReadFpr(id_ex_reg_.frs3);
-
-
-        // For load instructions, rs1 is a GPR base address.
-        // For integer-to-float conversions / moves, rs1 is also a GPR source.
     }
     else
     {
-        id_ex_reg_.reg1_data = registers_.ReadGpr(id_ex_reg_.rs1);
-        id_ex_reg_.reg2_data = registers_.ReadGpr(id_ex_reg_.rs2);
+        id_ex_reg_.frs1 = id_ex_reg_.frs2 = id_ex_reg_.frs3 = id_ex_reg_.frd = 0;
     }
 
-    // Pass all control signals to the next stage
-    id_ex_reg_.reg_write  = control_unit_.GetRegWrite();
-    id_ex_reg_.freg_write = instruction_set::isFInstruction(instruction) ||
-                            instruction_set::isDInstruction(instruction);
+    // Pass all control signals to the next stage. An FP instruction writes either register file.
+    id_ex_reg_.reg_write  = fp.is_fp ? fp.writes_gpr : control_unit_.GetRegWrite();
+    id_ex_reg_.freg_write = fp.writes_fpr;
     id_ex_reg_.branch     = control_unit_.GetBranch();
     id_ex_reg_.alu_src    = control_unit_.GetAluSrc();
     id_ex_reg_.mem_read   = control_unit_.GetMemRead();
@@ -354,6 +566,8 @@ void RV5StageVM_Base::register_write_back(const uint64_t &write_data)
     {
     case 0b0110011: // R-Type
     case 0b0010011: // I-Type
+    case 0b0111011: // R-Type word
+    case 0b0011011: // I-Type word
     case 0b0010111:
     { // AUIPC
         registers_.WriteGpr(mem_wb_reg_.rd, write_data);
@@ -386,13 +600,15 @@ void RV5StageVM_Base::pipeline_memory()
 {
 
     // --- B-Type Conditional Branch Resolution (3-Cycle Penalty) ---
-    if (ex_mem_reg_.branch_taken && (ex_mem_reg_.instruction & 0b1111111) == 0b1100011)
+    if (ex_mem_reg_.branch_mispredicted && (ex_mem_reg_.instruction & 0b1111111) == 0b1100011)
     {
         // B-Type misprediction confirmed in MEM stage. Hardware flushes the pipeline.
 
-        program_counter_ = ex_mem_reg_.branch_target_pc;
+        program_counter_ = ex_mem_reg_.branch_taken ? ex_mem_reg_.branch_target_pc
+                                                    : ex_mem_reg_.pc + 4;
         if_id_reg_.reset();
         id_ex_reg_.reset();
+        branch_predictor_.recover(ex_mem_reg_.prediction);
         branch_mispredictions_++;
     }
 
@@ -425,15 +641,23 @@ void RV5StageVM_Base::pipeline_memory()
     bool is_D_Instruction = instruction_set::isDInstruction(mem_wb_reg_.instruction);
 
     // Memory Access
+    // fetch has moved on by now, so name the instruction this access belongs to for the trace
+    // and the prefetchers
+    memory_controller_.setAccessPc(ex_mem_reg_.pc);
+    if (memory_controller_.isTimingEnabled() && (ex_mem_reg_.mem_read || ex_mem_reg_.mem_write))
+    {
+        // timed before the access, which changes what the caches hold
+        stall_for_memory(memory_controller_.timeAccess(
+            ex_mem_reg_.mem_read ? TimedAccess::LOAD : TimedAccess::STORE, ex_mem_reg_.alu_result,
+            cycle_s_));
+    }
     if (ex_mem_reg_.mem_read)
     {
         // Load instruction: Result available at end of this stage (Load-Use still needs 1 NOP
         // stall)
         if (is_F_Instruction)
-        { // FLW
-
-            mem_wb_reg_.memory_data =
-                static_cast<int32_t>(memory_controller_.readWord(ex_mem_reg_.alu_result));
+        { // FLW, zero extended like the results of the single precision ALU
+            mem_wb_reg_.memory_data = memory_controller_.readWord(ex_mem_reg_.alu_result);
             mem_wb_reg_.f_memory_data = mem_wb_reg_.memory_data;
         }
         else if (is_D_Instruction)
@@ -535,7 +759,29 @@ void RV5StageVM_Base::pipeline_memory()
 
 void RV5StageVM_Base::pipeline_writeback()
 {
-    // --- FP Writeback Delegation ---
+    // Stores and branches retire too, only a nop can't be told from a bubble
+    if (mem_wb_reg_.instruction != NOP)
+    {
+        instructions_retired_++;
+    }
+
+    // --- FPR Writeback, f0 is an ordinary register unlike x0 ---
+    if (mem_wb_reg_.freg_write)
+    {
+        uint64_t write_data =
+            mem_wb_reg_.mem_to_reg ? mem_wb_reg_.f_memory_data : mem_wb_reg_.f_alu_result;
+
+        // Record state for Undo/Redo
+        uint64_t old_value = registers_.ReadFpr(mem_wb_reg_.frd);
+        if (old_value != write_data)
+        {
+            current_delta_.register_changes.push_back({mem_wb_reg_.frd,
+                                                       2, // FPR type
+                                                       old_value, write_data});
+        }
+        registers_.WriteFpr(mem_wb_reg_.frd, write_data);
+        return;
+    }
 
     if (mem_wb_reg_.reg_write && mem_wb_reg_.rd != 0)
     {
@@ -551,17 +797,10 @@ void RV5StageVM_Base::pipeline_writeback()
                                                        old_value, write_data});
         }
 
-        /**TODO i think this is counting wrong so look into this */
-        instructions_retired_++; // Instruction successfully retired
-
-        if (instruction_set::isFInstruction(mem_wb_reg_.instruction))
-        {
-            pipeline_writeback_float();
-            return;
-        }
-        else if (instruction_set::isDInstruction(mem_wb_reg_.instruction))
+        // compares, fclass and conversions and moves to integer
+        if (fp_operands(mem_wb_reg_.instruction).is_fp)
         {
-            pipeline_writeback_double();
+            registers_.WriteGpr(mem_wb_reg_.rd, write_data);
             return;
         }
 
@@ -569,6 +808,8 @@ void RV5StageVM_Base::pipeline_writeback()
         {
         case 0b0110011: // R-Type
         case 0b0010011: // I-Type
+        case 0b0111011: // R-Type word
+        case 0b0011011: // I-Type word
         case 0b0010111:
         { // AUIPC
             registers_.WriteGpr(mem_wb_reg_.rd, write_data);
@@ -596,169 +837,165 @@ void RV5StageVM_Base::pipeline_writeback()
     }
 }
 
-void RV5StageVM_Base::pipeline_writeback_float()
+bool RV5StageVM_Base::execute_stage()
 {
-    // yes i just copy pasted this from rvss
-    uint64_t current_instruction_ = mem_wb_reg_.instruction;
-    uint8_t opcode = current_instruction_ & 0b1111111;
-    uint8_t funct7 = (current_instruction_ >> 25) & 0b1111111;
-    uint8_t rd = (current_instruction_ >> 7) & 0b11111;
-
-    uint64_t old_reg = 0;
-    unsigned int reg_index = rd;
-    unsigned int reg_type = 2; // 0 for GPR, 1 for CSR, 2 for FPR
-    uint64_t new_reg = 0;
-
-    // write to GPR
-    if (funct7 == 0b1010000 || funct7 == 0b1100000 || funct7 == 0b1110000)
-    { // f(eq|lt|le).s, fcvt.(w|wu|l|lu).s
-        old_reg = registers_.ReadGpr(rd);
-        registers_.WriteGpr(rd, mem_wb_reg_.alu_result);
-        new_reg = mem_wb_reg_.alu_result;
-        reg_type = 0; // GPR
+    functional_units_.Tick();
+    const bool held = execute_through_units(false);
+    if (held)
+    {
+        functional_unit_stall_cycles_++;
     }
-    // write to FPR
-    else if (opcode == 0b0000111)
+    return held;
+}
+
+bool RV5StageVM_Base::execute_through_units(bool hold)
+{
+    const bool id_ex_valid = id_ex_reg_.instruction != NOP;
+    const FunctionalUnit unit = functional_unit(id_ex_reg_.instruction);
+    const bool multi_cycle = id_ex_valid && functional_units_.LatencyOf(unit) > 1;
+    // the divider only takes a new instruction the cycle after its result has left
+    const bool unit_busy = functional_units_.IsBusy(unit);
+    const bool finished = functional_units_.HasFinished();
+
+    bool held = false;
+    if (hold || unit_busy || (finished && !multi_cycle))
     {
-        old_reg = registers_.ReadFpr(rd);
-        registers_.WriteFpr(rd, mem_wb_reg_.memory_data);
-        new_reg = mem_wb_reg_.memory_data;
-        reg_type = 2; // FPR
+        // a finished result takes the EX/MEM slot, ID/EX goes through EX next cycle instead
+        latch_ex_mem(finished ? functional_units_.TakeFinished() : EX_MEM_Register{});
+        held = id_ex_valid;
     }
     else
     {
-        old_reg = registers_.ReadFpr(rd);
-        registers_.WriteFpr(rd, mem_wb_reg_.alu_result);
-        new_reg = mem_wb_reg_.alu_result;
-        reg_type = 2; // FPR
+        const EX_MEM_Register before = ex_mem_reg_;
+        pipeline_execute();
+        if (multi_cycle)
+        {
+            // the instruction carries on in its unit, leaving its EX/MEM slot to a finished
+            // result if there is one
+            functional_units_.Issue(unit, ex_mem_reg_);
+            ex_mem_reg_ = before;
+            latch_ex_mem(finished ? functional_units_.TakeFinished() : EX_MEM_Register{});
+        }
     }
 
-    if (old_reg != new_reg)
+    if (held)
     {
-        current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
+        // Writeback may have written an operand decode read too early, and which is no longer
+        // anywhere forwarding looks by the time the instruction gets through EX. The register
+        // file holds everything older than what can still be forwarded, so read it again.
+        id_ex_reg_.reg1_data = registers_.ReadGpr(id_ex_reg_.rs1);
+        id_ex_reg_.reg2_data = registers_.ReadGpr(id_ex_reg_.rs2);
+        if (fp_operands(id_ex_reg_.instruction).is_fp)
+        {
+            id_ex_reg_.freg1_data = registers_.ReadFpr(id_ex_reg_.frs1);
+            id_ex_reg_.freg2_data = registers_.ReadFpr(id_ex_reg_.frs2);
+            id_ex_reg_.freg3_data = registers_.ReadFpr(id_ex_reg_.frs3);
+        }
     }
+    return held;
 }
 
-void RV5StageVM_Base::pipeline_writeback_double()
+void RV5StageVM_Base::latch_ex_mem(EX_MEM_Register next)
 {
-    uint64_t current_instruction_ = mem_wb_reg_.instruction;
-    uint8_t opcode = current_instruction_ & 0b1111111;
-    uint8_t funct7 = (current_instruction_ >> 25) & 0b1111111;
-    uint8_t rd = (current_instruction_ >> 7) & 0b11111;
-
-    uint64_t old_reg = 0;
-    unsigned int reg_index = rd;
-    unsigned int reg_type = 2; // 0 for GPR, 1 for CSR, 2 for FPR
-    uint64_t new_reg = 0;
+    next.prev_reg_write    = ex_mem_reg_.reg_write;
+    next.prev_rd           = ex_mem_reg_.rd;
+    next.prev_freg_write   = ex_mem_reg_.freg_write;
+    next.prev_frd          = ex_mem_reg_.frd;
+    next.prev_mem_read     = ex_mem_reg_.mem_read;
+    next.prev_mem_write    = ex_mem_reg_.mem_write;
+    next.prev_branch_taken = ex_mem_reg_.branch_taken;
+    ex_mem_reg_ = next;
+}
 
-    // write to GPR
-    if (funct7 == 0b1010001 || funct7 == 0b1100001 || funct7 == 0b1110001)
-    { // f(eq|lt|le).d, fcvt.(w|wu|l|lu).d
-        old_reg = registers_.ReadGpr(rd);
-        registers_.WriteGpr(rd, mem_wb_reg_.alu_result);
-        new_reg = mem_wb_reg_.alu_result;
-        reg_type = 0; // GPR
-    }
-    // write to FPR
-    else if (opcode == 0b0000111)
+uint64_t RV5StageVM_Base::forward_gpr(uint8_t reg, uint64_t value) const
+{
+    if (reg == 0)
     {
-        old_reg = registers_.ReadFpr(rd);
-        registers_.WriteFpr(rd, mem_wb_reg_.memory_data);
-        new_reg = mem_wb_reg_.memory_data;
-        reg_type = 2; // FPR
+        return value;
     }
-    else
+    if (ex_mem_reg_.reg_write && ex_mem_reg_.rd == reg)
     {
-        old_reg = registers_.ReadFpr(rd);
-        registers_.WriteFpr(rd, mem_wb_reg_.alu_result);
-        new_reg = mem_wb_reg_.alu_result;
-        reg_type = 2; // FPR
+        return ex_mem_reg_.alu_result;
     }
-
-    if (old_reg != new_reg)
+    if (mem_wb_reg_.prev_reg_write && mem_wb_reg_.prev_rd == reg)
     {
-        current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
+        return mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_memory_data
+                                           : mem_wb_reg_.prev_alu_result;
     }
+    return value;
 }
 
-uint64_t RV5StageVM_Base::execute_float()
+uint64_t RV5StageVM_Base::forward_fpr(uint8_t reg, uint64_t value) const
 {
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
+    if (ex_mem_reg_.freg_write && ex_mem_reg_.frd == reg)
     {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
+        return ex_mem_reg_.f_alu_result;
     }
-
-    if (id_ex_reg_.alu_src)
+    if (mem_wb_reg_.prev_freg_write && mem_wb_reg_.prev_frd == reg)
     {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
+        return mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
+                                           : mem_wb_reg_.prev_f_alu_result;
     }
-
-    alu::AluOp aluOperation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::fpexecute(aluOperation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-    return alu_result;
+    return value;
 }
 
-uint64_t RV5StageVM_Base::execute_double()
+uint64_t RV5StageVM_Base::execute_fp(bool forwarding)
 {
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
+    const uint32_t instruction = id_ex_reg_.instruction;
+    const FpOperands operands = fp_operands(instruction);
+
+    uint64_t rs1_value = id_ex_reg_.reg1_data;
+    uint64_t frs1_value = id_ex_reg_.freg1_data;
+    uint64_t frs2_value = id_ex_reg_.freg2_data;
+    uint64_t frs3_value = id_ex_reg_.freg3_data;
+    if (forwarding)
+    {
+        rs1_value = forward_gpr(id_ex_reg_.rs1, rs1_value);
+        frs1_value = forward_fpr(id_ex_reg_.frs1, frs1_value);
+        frs2_value = forward_fpr(id_ex_reg_.frs2, frs2_value);
+        frs3_value = forward_fpr(id_ex_reg_.frs3, frs3_value);
+    }
+    // Store data for fsw and fsd
+    ex_mem_reg_.freg2_data = frs2_value;
 
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
+    const uint8_t opcode = instruction & 0b1111111;
+    if (opcode == 0b0000111 || opcode == 0b0100111)
+    {
+        // two casts are necessary here the inner one extends the sign
+        return rs1_value + static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
+    }
 
+    uint8_t rm = (instruction >> 12) & 0b111;
     if (rm == 0b111)
     {
         rm = registers_.ReadCsr(0x002);
     }
 
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
+    const uint64_t reg1_value = operands.reads_gpr_rs1 ? rs1_value : frs1_value;
+    uint8_t fcsr_status = 0;
+    uint64_t alu_result = 0;
+    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
+    if (operands.is_double)
     {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
+        std::tie(alu_result, fcsr_status) =
+            alu::Alu::dfpexecute(alu_operation, reg1_value, frs2_value, frs3_value, rm);
     }
-
-    if (id_ex_reg_.alu_src)
+    else
     {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
+        std::tie(alu_result, fcsr_status) =
+            alu::Alu::fpexecute(alu_operation, reg1_value, frs2_value, frs3_value, rm);
     }
 
-    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::dfpexecute(alu_operation, reg1_value, reg2_value, reg3_value, rm);
-
     registers_.WriteCsr(0x003, fcsr_status);
     return alu_result;
 }
 
 bool RV5StageVM_Base::is_pipeline_drained() const
 {
+    if (memory_stall_remaining_ > 0)
+        return false;
+    if (!functional_units_.Empty())
+        return false;
     // IF/ID and ID/EX registers directly store the instruction word.
     if (if_id_reg_.instruction != NOP)
         return false;
@@ -822,7 +1059,15 @@ void RV5StageVM_Base::Undo()
     cycle_s_ = last.old_cycle;
     instructions_retired_ = last.old_instructions_retired;
     stall_cycles_ = last.old_stall_cycles;
+    memory_stall_cycles_ = last.old_memory_stall_cycles;
+    memory_stall_remaining_ = last.old_memory_stall_remaining;
+    functional_unit_stall_cycles_ = last.old_functional_unit_stall_cycles;
+    functional_units_ = last.old_functional_units;
+    memory_controller_.restoreTimingState(last.old_memory_timing);
     branch_mispredictions_ = last.old_branch_mispredictions;
+    PredictorJournal::undo(last.branch_predictor_writes);
+    size_t offset = 0;
+    restore_pipeline_state(last.old_pipeline_state, offset);
 
     if_id_reg_ = last.pipeline_register_change.old_if_id_reg;
     id_ex_reg_ = last.pipeline_register_change.old_id_ex_reg;
@@ -882,7 +1127,15 @@ void RV5StageVM_Base::Redo()
     cycle_s_ = next.new_cycle;
     instructions_retired_ = next.new_instructions_retired;
     stall_cycles_ = next.new_stall_cycles;
+    memory_stall_cycles_ = next.new_memory_stall_cycles;
+    memory_stall_remaining_ = next.new_memory_stall_remaining;
+    functional_unit_stall_cycles_ = next.new_functional_unit_stall_cycles;
+    functional_units_ = next.new_functional_units;
+    memory_controller_.restoreTimingState(next.new_memory_timing);
     branch_mispredictions_ = next.new_branch_mispredictions;
+    PredictorJournal::redo(next.branch_predictor_writes);
+    size_t offset = 0;
+    restore_pipeline_state(next.new_pipeline_state, offset);
 
     if_id_reg_ = next.pipeline_register_change.new_if_id_reg;
     id_ex_reg_ = next.pipeline_register_change.new_id_ex_reg;
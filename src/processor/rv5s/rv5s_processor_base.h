@@ -1,8 +1,10 @@
 #pragma once
+#include "processor/branch_prediction/branch_prediction_unit.h"
 #include "processor/pipeline_registers.h"
 #include "processor/processor_base.h"
 #include "processor/processor_manager.h"
 #include "rv5s_control_unit.h"
+#include "rv5s_functional_units.h"
 
 namespace Kites
 {
@@ -24,6 +26,15 @@ struct PipelineRegisterChange
 struct RV5StageStepDelta : public StepDelta
 {
     PipelineRegisterChange pipeline_register_change;
+    unsigned int old_memory_stall_remaining{};
+    unsigned int new_memory_stall_remaining{};
+    MemoryTimingModel::State old_memory_timing{};
+    MemoryTimingModel::State new_memory_timing{};
+    std::vector<PredictorWrite> branch_predictor_writes;
+    RV5SFunctionalUnits old_functional_units;
+    RV5SFunctionalUnits new_functional_units;
+    std::vector<uint8_t> old_pipeline_state; // see save_pipeline_state
+    std::vector<uint8_t> new_pipeline_state;
 };
 
 class RV5StageVM_Base : public ProcessorBase
@@ -43,6 +54,11 @@ class RV5StageVM_Base : public ProcessorBase
     void Undo() override;
     void Redo() override;
 
+    const BranchPredictionUnit *GetBranchPredictor() const override
+    {
+        return &branch_predictor_;
+    }
+
   protected:
     // Pipeline Registers
     IF_ID_Register if_id_reg_;
@@ -53,6 +69,20 @@ class RV5StageVM_Base : public ProcessorBase
     // The control unit for the pipeline
     RV5SControlUnit control_unit_;
 
+    // Cycles the whole pipeline still waits for a fetch or data access that missed. Only ever set
+    // with memory timing on, see MemoryController::timeAccess.
+    unsigned int memory_stall_remaining_{};
+
+    // Where fetch goes next, trained as branches and jumps resolve in EX
+    BranchPredictionUnit branch_predictor_;
+
+    // Branches and jumps resolve in ID instead, see resolve_in_decode(). Only the hazard
+    // detecting pipelines turn it on, from the config on reset.
+    bool early_branch_resolution_ = false;
+
+    // Instructions taking more than a cycle in EX, configured on reset
+    RV5SFunctionalUnits functional_units_;
+
     std::stack<RV5StageStepDelta> undo_stack_{};
     std::stack<RV5StageStepDelta> redo_stack_{};
     RV5StageStepDelta current_delta_;
@@ -70,28 +100,101 @@ class RV5StageVM_Base : public ProcessorBase
     void finalize_step_delta();
 
     void print_pipeline_registers_debug();
-    bool is_pipeline_drained() const;
+    virtual bool is_pipeline_drained() const;
     void setProcessorState() override;
     void Run() override; // run debug run adn reset are same across all rv5s vms
 
+    // time travel: the pipeline registers are checkpointed, the pipeline must drain to finish
+    bool ReplayFinished() const override;
+    void SaveCheckpointState(std::vector<uint8_t> &state) const override;
+    void LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset) override;
+    /**
+     * @brief State a pipeline keeps beyond the registers above, saved before and after every
+     * step for undo and redo and with every checkpoint.
+     */
+    virtual void save_pipeline_state(std::vector<uint8_t> &) const {}
+    virtual void restore_pipeline_state(const std::vector<uint8_t> &, size_t &) {}
+
+    /**
+     * @brief Spends this cycle waiting on memory if an earlier access is not done yet. Called
+     * at the start of Step(), which returns straight away when this does.
+     */
+    bool hold_for_memory();
+    /**
+     * @brief Keeps the pipeline waiting until an access that takes @p extra_cycles more than
+     * its stage's cycle is done. A fetch and a data access in the same cycle overlap.
+     */
+    void stall_for_memory(uint64_t extra_cycles);
+    /**
+     * @brief Reads the instruction at @p pc through the instruction cache, timing the fetch.
+     */
+    uint32_t fetch_instruction(uint64_t pc);
+    /**
+     * @brief Fetches the instruction at the program counter into IF/ID along with where the
+     * branch predictor expects the next fetch to be. The caller moves the program counter there.
+     */
+    void fetch_and_predict();
+    /**
+     * @brief Resolves the B-type instruction in EX, which pipeline_memory() redirects when the
+     * prediction it was fetched with was wrong.
+     */
+    void resolve_branch(bool taken);
+    /**
+     * @brief Resolves the jal or jalr in EX, redirecting fetch to @p target straight away when
+     * it was not predicted.
+     * @return whether fetch was redirected.
+     */
+    bool resolve_jump(uint64_t target);
+    /**
+     * @brief Resolves the branch or jump pipeline_decode() just latched into ID/EX with a
+     * comparator in ID. When fetch went the wrong way, this cycle's fetch is squashed and the
+     * next one goes to the right place, a single cycle penalty. EX then only passes the
+     * outcome on.
+     * @param forwarding forwards the ALU result latched for MEM into the comparator. The hazard
+     * unit stalls for anything nearer, see check_data_hazard.
+     * @return whether this cycle's fetch is squashed.
+     */
+    bool resolve_in_decode(bool forwarding);
+
     // --- Private methods for each pipeline stage ---
     virtual void pipeline_fetch() = 0;
 
     void pipeline_decode();
 
     virtual void pipeline_execute() = 0;
-    virtual uint64_t pipeline_execute_float() = 0;
-    virtual uint64_t pipeline_execute_double() = 0;
-
-    uint64_t execute_float();
-    uint64_t execute_double();
+    /**
+     * @brief Runs EX around pipeline_execute(), sending an instruction whose functional unit
+     * takes more than a cycle off to it and putting it back into EX/MEM once it is done.
+     * @return whether ID/EX is held this cycle, either for a finished instruction taking the
+     * EX/MEM slot or for the divider still being busy. Decode and fetch then wait too.
+     */
+    bool execute_stage();
+    /**
+     * @brief execute_stage() for one of several instructions going through EX in the same
+     * cycle: the units have already been ticked and the stall is not counted.
+     * @param hold keeps ID/EX for next cycle even if EX could take it, for an instruction that
+     * must not overtake an older one being held. A finished result still takes the slot.
+     */
+    bool execute_through_units(bool hold);
+    /**
+     * @brief Latches @p next into EX/MEM the way pipeline_execute() does, remembering what was
+     * there for the hazard unit and forwarding.
+     */
+    void latch_ex_mem(EX_MEM_Register next);
+    /**
+     * @brief Executes the F or D instruction in ID/EX, returning its result or, for loads and
+     * stores, the address. Also latches the store data.
+     * @param forwarding forwards GPR and FPR operands from EX/MEM and MEM/WB.
+     */
+    uint64_t execute_fp(bool forwarding);
+    // the value of a source register with what EX/MEM and MEM/WB hold for it forwarded
+    virtual uint64_t forward_gpr(uint8_t reg, uint64_t value) const;
+    virtual uint64_t forward_fpr(uint8_t reg, uint64_t value) const;
 
     void execute_csr() {};
 
     void pipeline_memory();
     void pipeline_writeback();
-    void pipeline_writeback_float();
-    void pipeline_writeback_double();
 
     // --- Specialized handler functions (called from pipeline stages) ---
     virtual void handle_syscall() = 0;
@@ -0,0 +1,453 @@
+/**
+ * @file rv5s_processor_dual_issue.cpp
+ * @brief Implementation for the dual-issue, in-order 5-stage pipelined VM (RV5S) with hazard
+ * detection and forwarding.
+ * * Up to two instructions are fetched, issued and retired each cycle. Pairing rules: one memory
+ * access, nothing after a branch or jump, and no dependency within the pair, see check_pairing.
+ * * Stall Rule: as the single-issue H_F pipeline, only Load-Use dependencies and results still
+ * in a multi-cycle unit stall, now against both lanes.
+ * * Branches and jumps always resolve in EX, early_branch_resolution stays off.
+ */
+#include "processor/rv5s/rv5s_processor_dual_issue.h"
+#include "common/instructions.h"
+#include "processor/alu.h"
+#include "processor/checkpoint_history.h"
+#include "ui/processor_tab/processor_designs/rv5s_processor_h_f_circuit_scene.h"
+
+#include <tuple>
+#include <utility>
+
+namespace Kites
+{
+RV5StageProcessorDualIssue::RV5StageProcessorDualIssue() : RV5StageVM_Base()
+{
+    // The circuit is the H_F pipeline's, showing lane 0
+#ifndef DISABLE_GUI
+    circuit_scene_ = std::make_unique<Kites::RV5StageVM_H_F_CircuitScene>();
+    connect(this, &ProcessorBase::updateCircuitStateSignal, circuit_scene_.get(),
+            &Kites::RV5StageVM_H_F_CircuitScene::updateCircuitState);
+#endif
+    Reset();
+
+    active_wires_.append("PC_to_IM");
+    active_wires_.append("IM_to_P1");
+    active_wires_.append("P1_to_P2_PCcarry");
+    active_wires_.append("P1_to_Control_RF_andall");
+    active_wires_.append("RF_to_P2_UP");
+    active_wires_.append("RFdown_to_P2");
+    active_wires_.append("PCMux_to_PC");
+    active_wires_.append("P2_to_ALU2");
+    active_wires_.append("P2_to_P3_MEMControl");
+    active_wires_.append("P2_to_P3_WBcontrol");
+    active_wires_.append("ALU2_to_P3");
+    active_wires_.append("P3_to_P4_WBcontrol");
+    active_wires_.append("P2_to_ALUControl");
+    active_wires_.append("ALU_to_P3");
+    active_wires_.append("ALUcontrol_to_ALU");
+    active_wires_.append("Fmux1_to_ALU");
+    active_wires_.append("Fmux_to_ALUMux_up");
+    active_wires_.append("P2_to_FMUX");
+    active_wires_.append("P2_to_FMUX2_UP");
+    active_wires_.append("P2_to_ALUMux");
+    active_wires_.append("P2_to_ALUcontrol_Control");
+
+    always_active_wires_count_ = active_wires_.size();
+}
+
+void RV5StageProcessorDualIssue::SetActiveWireNames()
+{
+    active_wires_.resize(always_active_wires_count_);
+
+    if (id_ex_reg_.alu_src)
+    {
+        active_wires_.append("Imm_to_P2");
+        active_wires_.append("P2Imm_to_ALU2_down");
+    }
+    if (ex_mem_reg_.mem_read)
+    {
+        active_wires_.append("P3_to_DM_Memread");
+        active_wires_.append("DMMux_to_DM");
+    }
+    if (ex_mem_reg_.mem_write)
+    {
+        active_wires_.append("P3_TO_DM_control_memwrite");
+        active_wires_.append("P3ALUres_to_DMup");
+    }
+    if (mem_wb_reg_.reg_write)
+    {
+        active_wires_.append("P4_wbcontrol_to_WBmux");
+        active_wires_.append("RdP4_to_FU");
+        active_wires_.append("WBMux_to_RF");
+    }
+    if (ex_mem_reg_.branch_taken)
+    {
+        active_wires_.append("ALU_zerores_to_P3");
+        active_wires_.append("ANDGate_lower_entry");
+        active_wires_.append("ANDGATE_to_PCMUX");
+        active_wires_.append("P3_to_PCMux");
+    }
+    else
+    {
+        active_wires_.append("ALU1_to_PCMuxUp");
+    }
+    if (stall_fetch_and_decode_)
+    {
+        active_wires_.append("HDU_to_P1");
+        active_wires_.append("HDUMux_to_P2");
+        active_wires_.append("HDU_mux_lowest_toP2");
+        active_wires_.append("HDU_to_HDU_mUX");
+    }
+}
+
+void RV5StageProcessorDualIssue::Reset()
+{
+    RV5StageVM_Base::Reset();
+    second_lane_ = Lane{};
+    stall_fetch_and_decode_ = false;
+    fetch_slots_ = 0;
+    jump_redirected_ = false;
+    issue_stats_ = IssueStats{};
+}
+
+void RV5StageProcessorDualIssue::swap_lanes()
+{
+    std::swap(if_id_reg_, second_lane_.if_id);
+    std::swap(id_ex_reg_, second_lane_.id_ex);
+    std::swap(ex_mem_reg_, second_lane_.ex_mem);
+    std::swap(mem_wb_reg_, second_lane_.mem_wb);
+}
+
+bool RV5StageProcessorDualIssue::is_pipeline_drained() const
+{
+    return RV5StageVM_Base::is_pipeline_drained() && second_lane_.if_id.instruction == NOP &&
+           second_lane_.id_ex.instruction == NOP && second_lane_.ex_mem.instruction == NOP &&
+           second_lane_.mem_wb.instruction == NOP && !second_lane_.mem_wb.reg_write;
+}
+
+void RV5StageProcessorDualIssue::save_pipeline_state(std::vector<uint8_t> &state) const
+{
+    appendCheckpointState(state, second_lane_);
+    appendCheckpointState(state, stall_fetch_and_decode_);
+    appendCheckpointState(state, issue_stats_);
+}
+
+void RV5StageProcessorDualIssue::restore_pipeline_state(const std::vector<uint8_t> &state,
+                                                        size_t &offset)
+{
+    readCheckpointState(state, offset, second_lane_);
+    readCheckpointState(state, offset, stall_fetch_and_decode_);
+    readCheckpointState(state, offset, issue_stats_);
+}
+
+void RV5StageProcessorDualIssue::Step()
+{
+    MaybeCheckpoint();
+    if (hold_for_memory())
+    {
+        return; // the whole pipeline waits for a miss
+    }
+
+    begin_step_delta();
+
+    // 1. Execute back stages (WB -> MEM -> EX), lane 0 first in each so that of two writes to
+    // the same register the younger lands last
+    pipeline_writeback();
+    in_second_lane([this] { pipeline_writeback(); });
+    memory_stage();
+    const bool execute_held = execute_lanes();
+
+    // 2. Issue what IF/ID holds, or keep it there while ID/EX waits for a functional unit
+    stall_fetch_and_decode_ = execute_held || issue();
+
+    // 3. Refill IF/ID from wherever EX or MEM redirected to, moving the PC on
+    pipeline_fetch();
+
+    cycle_s_++; // One clock cycle has passed
+
+    finalize_step_delta();
+}
+
+void RV5StageProcessorDualIssue::memory_stage()
+{
+    const uint64_t mispredictions = branch_mispredictions_;
+    pipeline_memory();
+    in_second_lane([this] { pipeline_memory(); });
+    if (branch_mispredictions_ != mispredictions)
+    {
+        // pipeline_memory() only flushed the lane the branch was in
+        if_id_reg_.reset();
+        id_ex_reg_.reset();
+        second_lane_.if_id.reset();
+        second_lane_.id_ex.reset();
+    }
+}
+
+bool RV5StageProcessorDualIssue::execute_lanes()
+{
+    functional_units_.Tick();
+    forward_ex_mem_[0] = ex_mem_reg_;
+    forward_ex_mem_[1] = second_lane_.ex_mem;
+    forward_mem_wb_[0] = mem_wb_reg_;
+    forward_mem_wb_[1] = second_lane_.mem_wb;
+    jump_redirected_ = false;
+
+    bool held = false;
+    if (second_lane_.id_ex.instruction == NOP)
+    {
+        // nothing for lane 1, so a finished result takes its EX/MEM slot rather than holding
+        // up lane 0
+        in_second_lane([this] { execute_through_units(false); });
+        held = execute_through_units(false);
+    }
+    else
+    {
+        // the younger instruction can't go on without the older
+        const bool first_held = execute_through_units(false);
+        bool second_held = false;
+        in_second_lane([&] { second_held = execute_through_units(first_held); });
+        if (second_held && !first_held)
+        {
+            // only the younger waits, the older must not go through EX again
+            id_ex_reg_.reset();
+        }
+        held = first_held || second_held;
+    }
+
+    if (jump_redirected_)
+    {
+        // resolve_jump() only emptied the IF/ID of the lane the jump was in
+        if_id_reg_.reset();
+        second_lane_.if_id.reset();
+    }
+    if (held)
+    {
+        functional_unit_stall_cycles_++;
+    }
+    return held;
+}
+
+bool RV5StageProcessorDualIssue::must_wait(const IF_ID_Register &candidate) const
+{
+    return check_data_hazard(candidate, id_ex_reg_, ex_mem_reg_, true, false,
+                             &functional_units_) != STALL_NONE ||
+           check_data_hazard(candidate, second_lane_.id_ex, second_lane_.ex_mem, true,
+                             false) != STALL_NONE;
+}
+
+bool RV5StageProcessorDualIssue::issue()
+{
+    if (must_wait(if_id_reg_))
+    {
+        // STALL: both IF/ID slots stay put and ID/EX gets a bubble in both lanes
+        id_ex_reg_.reset();
+        second_lane_.id_ex.reset();
+        return true;
+    }
+
+    std::optional<SingleIssueReason> single = check_pairing(if_id_reg_, second_lane_.if_id);
+    if (!single && second_lane_.if_id.instruction != NOP && must_wait(second_lane_.if_id))
+    {
+        single = SingleIssueReason::HAZARD;
+    }
+
+    const bool older_valid = if_id_reg_.instruction != NOP;
+    const bool younger_valid = second_lane_.if_id.instruction != NOP;
+    pipeline_decode();
+    if (single)
+    {
+        second_lane_.id_ex.reset();
+        if_id_reg_ = second_lane_.if_id;
+        second_lane_.if_id.reset();
+        fetch_slots_ = 1;
+    }
+    else
+    {
+        in_second_lane([this] { pipeline_decode(); });
+        if_id_reg_.reset();
+        second_lane_.if_id.reset();
+        fetch_slots_ = 2;
+    }
+
+    // nops are bubbles here as everywhere else in the pipeline
+    const unsigned int width = (older_valid ? 1 : 0) + (!single && younger_valid ? 1 : 0);
+    if (width == 2)
+    {
+        issue_stats_.dualIssueCycles++;
+    }
+    else if (width == 1)
+    {
+        issue_stats_.singleIssueCycles++;
+        issue_stats_.singleIssueReasons[static_cast<size_t>(
+            single.value_or(SingleIssueReason::FETCH))]++;
+    }
+    return false;
+}
+
+void RV5StageProcessorDualIssue::pipeline_fetch()
+{
+    if (stall_fetch_and_decode_)
+    {
+        // IF/ID register is intentionally NOT updated, holding the stalled instructions.
+        return;
+    }
+
+    if (fetch_slots_ == 2)
+    {
+        const uint64_t pc = program_counter_;
+        fetch_and_predict();
+        program_counter_ = if_id_reg_.prediction.next_pc;
+        if (program_counter_ != pc + 4)
+        {
+            // the fetch group ends at a branch or jump predicted taken
+            second_lane_.if_id.reset();
+            return;
+        }
+    }
+    in_second_lane([this] { fetch_and_predict(); });
+    program_counter_ = second_lane_.if_id.prediction.next_pc;
+}
+
+void RV5StageProcessorDualIssue::pipeline_execute()
+{
+    const uint32_t instruction = id_ex_reg_.instruction;
+    // decode has set the control unit up for whatever it decoded last, which need not be this
+    control_unit_.SetControlSignals(instruction);
+
+    uint64_t alu_result;
+    const bool is_fp_instruction = fp_operands(instruction).is_fp;
+    if (is_fp_instruction)
+    {
+        alu_result = execute_fp(true);
+    }
+    else
+    {
+        const uint64_t alu_in1 = forward_gpr(id_ex_reg_.rs1, id_ex_reg_.reg1_data);
+        const uint64_t rs2_value = forward_gpr(id_ex_reg_.rs2, id_ex_reg_.reg2_data);
+        const uint64_t alu_in2 =
+            id_ex_reg_.alu_src ? static_cast<uint64_t>(id_ex_reg_.imm) : rs2_value;
+
+        bool overflow;
+        alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
+        std::tie(alu_result, overflow) = alu::Alu::execute(alu_operation, alu_in1, alu_in2);
+        if ((instruction & 0b1111111) == 0b0110111) // lui
+        {
+            alu_result = static_cast<uint64_t>(id_ex_reg_.imm << 12);
+        }
+
+        // Store data, forwarded as well
+        ex_mem_reg_.reg2_data = rs2_value;
+    }
+
+    ex_mem_reg_.prev_reg_write = ex_mem_reg_.reg_write;
+    ex_mem_reg_.prev_rd = ex_mem_reg_.rd;
+    ex_mem_reg_.prev_freg_write = ex_mem_reg_.freg_write;
+    ex_mem_reg_.prev_frd = ex_mem_reg_.frd;
+    ex_mem_reg_.pc = id_ex_reg_.pc;
+    ex_mem_reg_.instruction = instruction;
+    ex_mem_reg_.alu_result = alu_result;
+    ex_mem_reg_.f_alu_result = is_fp_instruction ? alu_result : 0;
+    ex_mem_reg_.rd = id_ex_reg_.rd;
+    ex_mem_reg_.frd = id_ex_reg_.frd;
+    ex_mem_reg_.reg_write = id_ex_reg_.reg_write;
+    ex_mem_reg_.freg_write = id_ex_reg_.freg_write;
+    ex_mem_reg_.mem_to_reg = id_ex_reg_.mem_to_reg;
+    ex_mem_reg_.prev_mem_read = ex_mem_reg_.mem_read;
+    ex_mem_reg_.prev_mem_write = ex_mem_reg_.mem_write;
+    ex_mem_reg_.mem_read = id_ex_reg_.mem_read;
+    ex_mem_reg_.mem_write = id_ex_reg_.mem_write;
+    ex_mem_reg_.prev_branch_taken = ex_mem_reg_.branch_taken;
+    ex_mem_reg_.branch_taken = false;
+    ex_mem_reg_.branch_target_pc = 0;
+    ex_mem_reg_.branch_mispredicted = false;
+
+    const uint8_t opcode = instruction & 0b1111111;
+    if (id_ex_reg_.branch && opcode == 0b1100011)
+    {
+        // the ALU compared the operands, subtracting for equality and setting for less than
+        bool condition_met = false;
+        switch ((instruction >> 12) & 0b111)
+        {
+        case 0b000: // BEQ
+        case 0b101: // BGE
+        case 0b111: // BGEU
+            condition_met = alu_result == 0;
+            break;
+        case 0b001: // BNE
+            condition_met = alu_result != 0;
+            break;
+        case 0b100: // BLT
+        case 0b110: // BLTU
+            condition_met = alu_result == 1;
+            break;
+        }
+        resolve_branch(condition_met);
+    }
+    else if (opcode == 0b1101111 || opcode == 0b1100111)
+    {
+        const uint64_t jump_target =
+            opcode == 0b1101111 ? id_ex_reg_.pc + id_ex_reg_.imm : alu_result & ~1ULL;
+        if (resolve_jump(jump_target))
+        {
+            jump_redirected_ = true;
+        }
+    }
+}
+
+uint64_t RV5StageProcessorDualIssue::forward_gpr(uint8_t reg, uint64_t value) const
+{
+    if (reg == 0)
+    {
+        return value;
+    }
+    // EX/MEM is nearer than MEM/WB, and in each lane 1 holds the younger instruction
+    for (int lane = 1; lane >= 0; --lane)
+    {
+        const EX_MEM_Register &ex_mem = forward_ex_mem_[lane];
+        if (ex_mem.reg_write && ex_mem.rd == reg)
+        {
+            return ex_mem.alu_result;
+        }
+    }
+    for (int lane = 1; lane >= 0; --lane)
+    {
+        const MEM_WB_Register &mem_wb = forward_mem_wb_[lane];
+        if (mem_wb.prev_reg_write && mem_wb.prev_rd == reg)
+        {
+            return mem_wb.prev_mem_to_reg ? mem_wb.prev_memory_data : mem_wb.prev_alu_result;
+        }
+    }
+    return value;
+}
+
+uint64_t RV5StageProcessorDualIssue::forward_fpr(uint8_t reg, uint64_t value) const
+{
+    for (int lane = 1; lane >= 0; --lane)
+    {
+        const EX_MEM_Register &ex_mem = forward_ex_mem_[lane];
+        if (ex_mem.freg_write && ex_mem.frd == reg)
+        {
+            return ex_mem.f_alu_result;
+        }
+    }
+    for (int lane = 1; lane >= 0; --lane)
+    {
+        const MEM_WB_Register &mem_wb = forward_mem_wb_[lane];
+        if (mem_wb.prev_freg_write && mem_wb.prev_frd == reg)
+        {
+            return mem_wb.prev_mem_to_reg ? mem_wb.prev_f_memory_data
+                                          : mem_wb.prev_f_alu_result;
+        }
+    }
+    return value;
+}
+
+void RV5StageProcessorDualIssue::handle_syscall()
+{
+    if ((id_ex_reg_.instruction & 0x7F) == 0b1110011 &&
+        ((id_ex_reg_.instruction >> 12) & 0x7) == 0b000)
+    {
+        RequestStop();
+        output_status_ = "ECALL_EXIT";
+    }
+}
+}//namespace Kites
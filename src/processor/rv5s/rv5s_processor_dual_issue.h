@@ -0,0 +1,117 @@
+/**
+ * @file rv5s_processor_dual_issue.h
+ * @brief Header for the dual-issue, in-order 5-stage pipelined VM (RV5S) with hazard detection
+ * and forwarding.
+ */
+#pragma once
+
+#include "processor/pipeline_registers.h"
+#include "processor/rv5s/rv5s_hdu.h"
+#include "processor/rv5s/rv5s_issue_stats.h"
+#include "processor/rv5s/rv5s_processor_base.h"
+
+#include <iostream>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Fetches, decodes and issues up to two instructions a cycle and takes them through EX,
+ * MEM and WB side by side, the older in lane 0 and the younger in lane 1. Every pipeline register
+ * is there twice: lane 0's are the base class's, and lane 1's are swapped in to run a stage for
+ * it.
+ *
+ * The pair issues together unless check_pairing finds it can't, or the younger waits on a load
+ * or a functional unit further ahead. Then only the older issues and the younger moves up to
+ * lane 0, fetched along with the next instruction. If the older waits, neither issues. Forwarding
+ * looks through both lanes' EX/MEM and MEM/WB, see forward_gpr. Branches resolve in EX and flush
+ * both lanes from MEM when mispredicted, jumps redirect fetch from EX.
+ */
+class RV5StageProcessorDualIssue : public RV5StageVM_Base
+{
+  public:
+    RV5StageProcessorDualIssue();
+    ~RV5StageProcessorDualIssue() = default;
+
+    void Step() override;
+    void Reset() override;
+
+    void PrintType()
+    {
+        std::cout << "RV5StageProcessorDualIssue" << std::endl;
+    }
+
+    void SetActiveWireNames() override;
+
+    const IssueStats *GetIssueStats() const override
+    {
+        return &issue_stats_;
+    }
+
+  private:
+    struct Lane
+    {
+        IF_ID_Register if_id;
+        ID_EX_Register id_ex;
+        EX_MEM_Register ex_mem;
+        MEM_WB_Register mem_wb;
+    };
+
+    // Lane 1's pipeline registers while lane 0's are in the base class
+    Lane second_lane_;
+
+    // Both lanes' EX/MEM and MEM/WB from before either went through EX this cycle, what
+    // forwarding reads. Indexed by lane.
+    EX_MEM_Register forward_ex_mem_[2];
+    MEM_WB_Register forward_mem_wb_[2];
+
+    // Freezes IF/ID and the PC, like the single-issue pipelines
+    bool stall_fetch_and_decode_ = false;
+    // How many IF/ID slots this cycle's fetch refills: decode has emptied lane 1's or both
+    unsigned int fetch_slots_ = 0;
+    // A jump in either lane sent fetch elsewhere this cycle
+    bool jump_redirected_ = false;
+
+    IssueStats issue_stats_;
+
+    // exchanges the base class's pipeline registers with lane 1's
+    void swap_lanes();
+    template <typename Stage> void in_second_lane(Stage stage)
+    {
+        swap_lanes();
+        stage();
+        swap_lanes();
+    }
+
+    bool is_pipeline_drained() const override;
+    void save_pipeline_state(std::vector<uint8_t> &state) const override;
+    void restore_pipeline_state(const std::vector<uint8_t> &state, size_t &offset) override;
+
+    /**
+     * @brief Runs MEM for both lanes, flushing IF/ID and ID/EX in both when a branch in either
+     * was mispredicted.
+     */
+    void memory_stage();
+    /**
+     * @brief Runs EX for both lanes around the shared functional units.
+     * @return whether ID/EX is held in either lane, see execute_stage().
+     */
+    bool execute_lanes();
+    // whether the instruction in @p candidate must wait on one already in ID/EX or in a unit
+    bool must_wait(const IF_ID_Register &candidate) const;
+    /**
+     * @brief Decodes as many of the instructions in IF/ID as can issue together, counting the
+     * cycle in issue_stats_, and moves a younger one left behind up to lane 0.
+     * @return whether neither could issue.
+     */
+    bool issue();
+
+    // --- Private methods for each pipeline stage ---
+    void pipeline_fetch() override;
+    void pipeline_execute() override;
+    uint64_t forward_gpr(uint8_t reg, uint64_t value) const override;
+    uint64_t forward_fpr(uint8_t reg, uint64_t value) const override;
+
+    void handle_syscall() override;
+};
+}//namespace Kites
@@ -6,6 +6,8 @@
  * * Stall Rule: Only Load-Use GPR dependencies require a 1-cycle stall. All others are solved by
  * forwarding.
  * * Control Hazards (JAL/JALR, B-Type) are AUTOMATICALLY handled by flush/redirect.
+ * * With early_branch_resolution on they resolve in ID instead, see
+ * RV5StageVM_Base::resolve_in_decode.
  * @author Atharva and Harshit
  */
 #include "processor/rv5s/rv5s_processor_h_f.h" // Assuming this header now defines RV5StageProcessorHF
@@ -197,26 +199,46 @@ void RV5StageProcessorHF::Reset()
 {
     RV5StageVM_Base::Reset();
     stall_fetch_and_decode_ = false;
+    early_branch_resolution_ = vm_config::config.getEarlyBranchResolution();
+}
+
+void RV5StageProcessorHF::SaveCheckpointState(std::vector<uint8_t> &state) const
+{
+    RV5StageVM_Base::SaveCheckpointState(state);
+    appendCheckpointState(state, stall_fetch_and_decode_);
+}
+
+void RV5StageProcessorHF::LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    RV5StageVM_Base::LoadCheckpointState(state, offset);
+    readCheckpointState(state, offset, stall_fetch_and_decode_);
 }
 
 void RV5StageProcessorHF::Step()
 {
-    // Capture PC before potential redirection in EX/MEM stages
-    uint64_t old_pc_before_redirect = program_counter_;
+    MaybeCheckpoint();
+    if (hold_for_memory())
+    {
+        return; // the whole pipeline waits for a miss
+    }
 
     begin_step_delta();
 
     // 1. Execute back stages (WB -> MEM -> EX)
     pipeline_writeback();
     pipeline_memory();
-    pipeline_execute();
+    const bool execute_held = execute_stage();
 
     // --- Hazard Detection and Stall Logic (The core of Mode 4) ---
 
     int stalls_needed = 0;
     bool currently_stalling = (stall_cycles_ > 0);
 
-    if (currently_stalling)
+    if (execute_held)
+    {
+        // ID/EX waits for a functional unit and IF/ID behind it, nothing new to check
+    }
+    else if (currently_stalling)
     {
         // Stall is already active. Decrement counter and continue stall.
         stall_cycles_--;
@@ -226,7 +248,8 @@ void RV5StageProcessorHF::Step()
     {
         // Pipeline is free. Check for a NEW hazard using the external HDU function.
         stalls_needed = check_data_hazard(if_id_reg_, id_ex_reg_, ex_mem_reg_,
-                                          true /* is_forwarding_enabled */);
+                                          true /* is_forwarding_enabled */,
+                                          early_branch_resolution_, &functional_units_);
         if (stalls_needed > 0)
         {
             // Start the stall: stalls_needed cycles total. 1 cycle is handled now.
@@ -235,7 +258,13 @@ void RV5StageProcessorHF::Step()
     }
 
     // 2. Process Decode/Fetch based on stall status
-    if (stalls_needed > 0)
+    bool fetch_squashed = false;
+    if (execute_held)
+    {
+        // ID/EX keeps its instruction for EX to take next cycle
+        stall_fetch_and_decode_ = true;
+    }
+    else if (stalls_needed > 0)
     {
         // STALL: Freeze IF/ID (by preventing its update) and inject NOP into ID/EX
         id_ex_reg_.reset();
@@ -247,22 +276,21 @@ void RV5StageProcessorHF::Step()
         // NO STALL: Advance pipeline normally
         pipeline_decode();
         stall_fetch_and_decode_ = false;
+        fetch_squashed = early_branch_resolution_ && resolve_in_decode(true);
     }
 
-    // Fetch the instruction at the committed PC address.
-    pipeline_fetch();
-    // 3. PC Update and Fetch
-    uint64_t next_pc = program_counter_;
-
-    // Only advance the PC if we were not stalling this cycle (and thus fetched an instruction).
-    // Note: Control hazards (JAL/Branch) already override program_counter_ in EX/MEM.
-    if (!stall_fetch_and_decode_ && next_pc == old_pc_before_redirect)
+    // Fetch the instruction at the committed PC address, unless decode has just redirected it.
+    if (!fetch_squashed)
     {
-        next_pc = old_pc_before_redirect + 4;
+        pipeline_fetch();
+    }
+    // 3. PC Update
+    // Only move the PC on if we were not stalling this cycle (and thus fetched an instruction).
+    // Fetch read from wherever EX or MEM redirected to, so go on where it predicts.
+    if (!stall_fetch_and_decode_)
+    {
+        program_counter_ = if_id_reg_.prediction.next_pc;
     }
-
-    // Commit the new PC for the Fetch stage
-    program_counter_ = next_pc;
 
     cycle_s_++; // One clock cycle has passed
 
@@ -280,15 +308,7 @@ void RV5StageProcessorHF::pipeline_fetch()
         return;
     }
 
-    if (program_counter_ < program_size_)
-    {
-        if_id_reg_.instruction = memory_controller_.readInstruction(program_counter_);
-        if_id_reg_.pc = program_counter_;
-    }
-    else
-    {
-        if_id_reg_.reset();
-    }
+    fetch_and_predict();
 }
 
 void RV5StageProcessorHF::pipeline_execute()
@@ -297,16 +317,11 @@ void RV5StageProcessorHF::pipeline_execute()
     bool overflow;
     uint64_t alu_result;
 
-    bool is_f_instruction = instruction_set::isFInstruction(instruction);
-    bool is_d_instruction = instruction_set::isDInstruction(instruction);
+    const bool is_fp_instruction = fp_operands(instruction).is_fp;
 
-    if (is_f_instruction)
+    if (is_fp_instruction)
     {
-        alu_result = pipeline_execute_float();
-    }
-    else if (is_d_instruction)
-    {
-        alu_result = pipeline_execute_double();
+        alu_result = execute_fp(true);
     }
     else
     {
@@ -399,7 +414,7 @@ void RV5StageProcessorHF::pipeline_execute()
     ex_mem_reg_.pc = id_ex_reg_.pc;
     ex_mem_reg_.instruction = id_ex_reg_.instruction;
     ex_mem_reg_.alu_result = alu_result;
-    ex_mem_reg_.f_alu_result = (is_f_instruction || is_d_instruction) ? alu_result : 0;
+    ex_mem_reg_.f_alu_result = is_fp_instruction ? alu_result : 0;
     ex_mem_reg_.rd = id_ex_reg_.rd;
     ex_mem_reg_.frd = id_ex_reg_.frd;
     // NOTE: reg2_data and freg2_data are set inside the integer/FP execute
@@ -414,6 +429,7 @@ void RV5StageProcessorHF::pipeline_execute()
     ex_mem_reg_.prev_branch_taken = ex_mem_reg_.branch_taken;
     ex_mem_reg_.branch_taken = false;
     ex_mem_reg_.branch_target_pc = 0;
+    ex_mem_reg_.branch_mispredicted = false;
 
     uint8_t opcode = instruction & 0b1111111;
 
@@ -447,11 +463,7 @@ void RV5StageProcessorHF::pipeline_execute()
             break; // BGEU
         }
 
-        if (condition_met)
-        {
-            ex_mem_reg_.branch_taken = true;
-            ex_mem_reg_.branch_target_pc = id_ex_reg_.pc + id_ex_reg_.imm;
-        }
+        resolve_branch(condition_met);
     }
     // Unconditional Jump Check (JAL/JALR: 1-cycle penalty)
     else if (opcode == 0b1101111 || opcode == 0b1100111)
@@ -466,10 +478,7 @@ void RV5StageProcessorHF::pipeline_execute()
             jump_target = alu_result & ~1;              // JALR (ALU result is Reg + Imm)
             ex_mem_reg_.alu_result = id_ex_reg_.pc + 4; // Set link address (PC+4)
         }
-
-        program_counter_ = jump_target;
-        if_id_reg_.reset();
-        ex_mem_reg_.branch_taken = true;
+        resolve_jump(jump_target);
     }
 }
 
@@ -483,216 +492,4 @@ void RV5StageProcessorHF::handle_syscall()
         // DumpState("vm_state.json");
     }
 }
-
-uint64_t RV5StageProcessorHF::pipeline_execute_float()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // --- FORWARDING for FPR sources (frs1/frs2/frs3) ---
-    uint8_t fwd_a = 0; // 2 = EX/MEM, 1 = MEM/WB
-    uint8_t fwd_b = 0;
-    uint8_t fwd_c = 0;
-
-    // EX/MEM forwarding (highest priority)
-    if (ex_mem_reg_.freg_write && (ex_mem_reg_.frd != 0))
-    {
-        if (ex_mem_reg_.frd == id_ex_reg_.frs1)
-            fwd_a = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs2)
-            fwd_b = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs3)
-            fwd_c = 2;
-    }
-
-    // MEM/WB forwarding (lower priority)
-    if (mem_wb_reg_.prev_freg_write && (mem_wb_reg_.prev_frd != 0))
-    {
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs1 && fwd_a != 2)
-            fwd_a = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs2 && fwd_b != 2)
-            fwd_b = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs3 && fwd_c != 2)
-            fwd_c = 1;
-    }
-
-    // Apply forwarding to source values
-    if (fwd_a == 2)
-        reg1_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_a == 1)
-        reg1_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_b == 2)
-        reg2_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        reg2_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_c == 2)
-        reg3_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_c == 1)
-        reg3_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    // Re-apply GPR-read override (for conversion ops) after forwarding decision: if instruction
-    // requires GPR, use it.
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    // Re-apply immediate if ALUSrc was set (immediates take precedence for reg2)
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // Forward store data for FPR stores (frs2)
-    uint64_t fstore_data = id_ex_reg_.freg2_data;
-    if (fwd_b == 2)
-        fstore_data = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        fstore_data = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                  : mem_wb_reg_.prev_f_alu_result;
-
-    ex_mem_reg_.freg2_data = fstore_data;
-    // Execute FP operation
-    alu::AluOp aluOperation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::fpexecute(aluOperation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-
-    return alu_result;
-}
-
-uint64_t RV5StageProcessorHF::pipeline_execute_double()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // --- FORWARDING for FPR sources (frs1/frs2/frs3) ---
-    uint8_t fwd_a = 0; // 2 = EX/MEM, 1 = MEM/WB
-    uint8_t fwd_b = 0;
-    uint8_t fwd_c = 0;
-
-    if (ex_mem_reg_.freg_write && (ex_mem_reg_.frd != 0))
-    {
-        if (ex_mem_reg_.frd == id_ex_reg_.frs1)
-            fwd_a = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs2)
-            fwd_b = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs3)
-            fwd_c = 2;
-    }
-
-    if (mem_wb_reg_.prev_freg_write && (mem_wb_reg_.prev_frd != 0))
-    {
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs1 && fwd_a != 2)
-            fwd_a = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs2 && fwd_b != 2)
-            fwd_b = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs3 && fwd_c != 2)
-            fwd_c = 1;
-    }
-
-    if (fwd_a == 2)
-        reg1_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_a == 1)
-        reg1_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_b == 2)
-        reg2_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        reg2_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_c == 2)
-        reg3_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_c == 1)
-        reg3_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    // Re-apply GPR-read override for specific instructions
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    // Re-apply immediate for reg2
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // Forward store data for FPR stores
-    uint64_t fstore_data = id_ex_reg_.freg2_data;
-    if (fwd_b == 2)
-        fstore_data = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        fstore_data = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                  : mem_wb_reg_.prev_f_alu_result;
-
-    ex_mem_reg_.freg2_data = fstore_data;
-
-    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::dfpexecute(alu_operation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-
-    return alu_result;
-}
 }//namespace Kites
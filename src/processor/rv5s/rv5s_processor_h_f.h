@@ -43,12 +43,13 @@ class RV5StageProcessorHF : public RV5StageVM_Base
     // This flag controls freezing the front-end (IF/ID registers and PC)
     bool stall_fetch_and_decode_ = false;
 
+    void SaveCheckpointState(std::vector<uint8_t> &state) const override;
+    void LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset) override;
+
     // --- Private methods for each pipeline stage ---
     void pipeline_fetch() override;
     // void pipeline_decode() override;
     void pipeline_execute() override;
-    uint64_t pipeline_execute_float() override;
-    uint64_t pipeline_execute_double() override;
     // void pipeline_memory() override;
     //  void pipeline_writeback() override;
 
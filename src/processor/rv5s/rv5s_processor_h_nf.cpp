@@ -5,6 +5,8 @@
  * * NOTE: This VM is fully autonomous for all hazards (data and control).
  * * Stall Rule: Any GPR data dependency results in a 2-cycle stall (2 bubbles).
  * * Control Hazards (JAL/JALR, B-Type) are AUTOMATICALLY handled by flush/redirect.
+ * * With early_branch_resolution on they resolve in ID instead, see
+ * RV5StageVM_Base::resolve_in_decode.
  * @author Atharva and Harshit
  */
 #include "processor/rv5s/rv5s_processor_h_nf.h"
@@ -142,35 +144,63 @@ void RV5StageProcessorHNF::Reset()
 {
     RV5StageVM_Base::Reset();
     stall_fetch_and_decode_ = false;
+    early_branch_resolution_ = vm_config::config.getEarlyBranchResolution();
+}
+
+void RV5StageProcessorHNF::SaveCheckpointState(std::vector<uint8_t> &state) const
+{
+    RV5StageVM_Base::SaveCheckpointState(state);
+    appendCheckpointState(state, stall_fetch_and_decode_);
+}
+
+void RV5StageProcessorHNF::LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset)
+{
+    RV5StageVM_Base::LoadCheckpointState(state, offset);
+    readCheckpointState(state, offset, stall_fetch_and_decode_);
 }
 
 void RV5StageProcessorHNF::Step()
 {
-    uint64_t old_pc_before_redirect = program_counter_;
+    MaybeCheckpoint();
+    if (hold_for_memory())
+    {
+        return; // the whole pipeline waits for a miss
+    }
 
     begin_step_delta();
 
     pipeline_writeback();
     pipeline_memory();
-    pipeline_execute();
+    const bool execute_held = execute_stage();
 
     int stalls_needed = 0;
     bool currently_stalling = (stall_cycles_ > 0);
 
-    if (currently_stalling)
+    if (execute_held)
+    {
+        // ID/EX waits for a functional unit and IF/ID behind it, nothing new to check
+    }
+    else if (currently_stalling)
     {
         stall_cycles_--;
     }
     else
     {
-        stalls_needed = check_data_hazard(if_id_reg_, id_ex_reg_, ex_mem_reg_, false);
+        stalls_needed = check_data_hazard(if_id_reg_, id_ex_reg_, ex_mem_reg_, false,
+                                          early_branch_resolution_, &functional_units_);
         if (stalls_needed > 0)
         {
             stall_cycles_ = stalls_needed - 1;
         }
     }
 
-    if (currently_stalling || stalls_needed > 0)
+    bool fetch_squashed = false;
+    if (execute_held)
+    {
+        // ID/EX keeps its instruction for EX to take next cycle
+        stall_fetch_and_decode_ = true;
+    }
+    else if (currently_stalling || stalls_needed > 0)
     {
         id_ex_reg_.reset();
         stall_fetch_and_decode_ = true;
@@ -179,16 +209,18 @@ void RV5StageProcessorHNF::Step()
     {
         pipeline_decode();
         stall_fetch_and_decode_ = false;
+        // the stalls above leave the operands in the register file, nothing to forward
+        fetch_squashed = early_branch_resolution_ && resolve_in_decode(false);
     }
 
-    pipeline_fetch();
-    uint64_t next_pc = program_counter_;
-    if (!stall_fetch_and_decode_ && next_pc == old_pc_before_redirect)
+    if (!fetch_squashed)
     {
-        next_pc = old_pc_before_redirect + 4;
+        pipeline_fetch();
+    }
+    if (!stall_fetch_and_decode_)
+    {
+        program_counter_ = if_id_reg_.prediction.next_pc;
     }
-
-    program_counter_ = next_pc;
     cycle_s_++;
 
     finalize_step_delta();
@@ -206,22 +238,13 @@ void RV5StageProcessorHNF::pipeline_fetch()
         return;
     }
 
-    if (program_counter_ < program_size_)
-    {
-        if_id_reg_.instruction = memory_controller_.readInstruction(program_counter_);
-        if_id_reg_.pc = program_counter_;
-    }
-    else
-    {
-        if_id_reg_.reset();
-    }
+    fetch_and_predict();
 }
 
 void RV5StageProcessorHNF::pipeline_execute()
 {
     uint32_t cur_instruction = id_ex_reg_.instruction;
-    const bool is_f_instruction = instruction_set::isFInstruction(cur_instruction);
-    const bool is_d_instruction = instruction_set::isDInstruction(cur_instruction);
+    const bool is_fp_instruction = fp_operands(cur_instruction).is_fp;
 
     uint64_t alu_in1 = id_ex_reg_.reg1_data;
     uint64_t alu_in2 =
@@ -231,13 +254,9 @@ void RV5StageProcessorHNF::pipeline_execute()
     uint64_t alu_result = 0;
 
     bool overflow;
-    if (is_f_instruction)
+    if (is_fp_instruction)
     {
-        alu_result = pipeline_execute_float();
-    }
-    else if (is_d_instruction)
-    {
-        alu_result = pipeline_execute_double();
+        alu_result = execute_fp(false);
     }
     else
     {
@@ -255,11 +274,10 @@ void RV5StageProcessorHNF::pipeline_execute()
     ex_mem_reg_.pc = id_ex_reg_.pc;
     ex_mem_reg_.instruction = id_ex_reg_.instruction;
     ex_mem_reg_.alu_result = alu_result;
-    ex_mem_reg_.f_alu_result = (is_f_instruction || is_d_instruction) ? alu_result : 0;
+    ex_mem_reg_.f_alu_result = is_fp_instruction ? alu_result : 0;
     ex_mem_reg_.rd = id_ex_reg_.rd;
     ex_mem_reg_.frd = id_ex_reg_.frd;
     ex_mem_reg_.reg2_data = id_ex_reg_.reg2_data;
-    ex_mem_reg_.freg2_data = id_ex_reg_.freg2_data;
     ex_mem_reg_.reg_write = id_ex_reg_.reg_write;
     ex_mem_reg_.freg_write = id_ex_reg_.freg_write;
     ex_mem_reg_.mem_to_reg = id_ex_reg_.mem_to_reg;
@@ -270,6 +288,7 @@ void RV5StageProcessorHNF::pipeline_execute()
     ex_mem_reg_.prev_branch_taken = ex_mem_reg_.branch_taken;
     ex_mem_reg_.branch_taken = false;
     ex_mem_reg_.branch_target_pc = 0;
+    ex_mem_reg_.branch_mispredicted = false;
 
     uint32_t instruction = id_ex_reg_.instruction;
     uint8_t opcode = instruction & 0b1111111;
@@ -302,15 +321,7 @@ void RV5StageProcessorHNF::pipeline_execute()
             break;
         }
 
-        if (condition_met)
-        {
-            ex_mem_reg_.branch_taken = true;
-            ex_mem_reg_.branch_target_pc = id_ex_reg_.pc + id_ex_reg_.imm;
-            // program_counter_ = ex_mem_reg_.branch_target_pc;
-            std::cout << "Jump size: " << id_ex_reg_.imm << std::endl;
-            std::cout << "Branch taken to PC: 0x" << std::hex << ex_mem_reg_.branch_target_pc
-                      << std::dec << std::endl;
-        }
+        resolve_branch(condition_met);
     }
     else if (opcode == 0b1101111 || opcode == 0b1100111)
     {
@@ -324,10 +335,7 @@ void RV5StageProcessorHNF::pipeline_execute()
             jump_target = alu_result & ~1;
             ex_mem_reg_.alu_result = id_ex_reg_.pc + 4;
         }
-
-        program_counter_ = jump_target;
-        if_id_reg_.reset();
-        ex_mem_reg_.branch_taken = true;
+        resolve_jump(jump_target);
     }
 }
 
@@ -340,80 +348,4 @@ void RV5StageProcessorHNF::handle_syscall()
         output_status_ = "ECALL_EXIT";
     }
 }
-
-uint64_t RV5StageProcessorHNF::pipeline_execute_float()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    alu::AluOp aluOperation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::fpexecute(aluOperation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-    return alu_result;
-}
-
-uint64_t RV5StageProcessorHNF::pipeline_execute_double()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::dfpexecute(alu_operation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-    return alu_result;
-}
 }//namespace Kites
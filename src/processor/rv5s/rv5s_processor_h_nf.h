@@ -44,13 +44,13 @@ class RV5StageProcessorHNF : public RV5StageVM_Base
     // If true, the IF stage freezes the PC and does not update IF/ID.
     bool stall_fetch_and_decode_ = false;
 
+    void SaveCheckpointState(std::vector<uint8_t> &state) const override;
+    void LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset) override;
+
     // --- Private methods for each pipeline stage ---
     void pipeline_fetch() override;
     // void pipeline_decode() override;
     void pipeline_execute() override;
-
-    uint64_t pipeline_execute_float() override;
-    uint64_t pipeline_execute_double() override;
     // void pipeline_memory() override;
     //  void pipeline_writeback() override;
 
@@ -172,29 +172,30 @@ void RV5StageProcessorNHF::Reset()
 
 void RV5StageProcessorNHF::Step()
 {
-    // Capture PC before potential redirection in EX/MEM stages
-    uint64_t old_pc_before_redirect = program_counter_;
+    MaybeCheckpoint();
+    if (hold_for_memory())
+    {
+        return; // the whole pipeline waits for a miss
+    }
 
     begin_step_delta();
 
     // 1. Execute stages (WB -> MEM -> EX -> ID -> IF)
     pipeline_writeback();
     pipeline_memory();
-    pipeline_execute();
+    if (execute_stage())
+    {
+        // ID/EX waits for a functional unit, and decode and fetch behind it
+        cycle_s_++;
+        finalize_step_delta();
+        return;
+    }
     pipeline_decode();
     // Fetch the instruction at the committed PC address.
     pipeline_fetch();
-    // 2. Determine the next PC (Redirection logic overrides sequential advance)
-    uint64_t next_pc = program_counter_;
-
-    // If no redirect happened in EX or MEM, advance sequentially.
-    if (next_pc == old_pc_before_redirect)
-    {
-        next_pc = old_pc_before_redirect + 4;
-    }
-
-    // Commit the new PC for the Fetch stage
-    program_counter_ = next_pc;
+    // 2. Determine the next PC. Fetch read from wherever EX or MEM redirected to, so go on
+    // where it predicts.
+    program_counter_ = if_id_reg_.prediction.next_pc;
     cycle_s_++; // One clock cycle has passed
 
     finalize_step_delta();
@@ -204,17 +205,7 @@ void RV5StageProcessorNHF::Step()
 
 void RV5StageProcessorNHF::pipeline_fetch()
 {
-    if (program_counter_ < program_size_)
-    {
-        // Latch the instruction and PC for the next stage (IF/ID register)
-        if_id_reg_.instruction = memory_controller_.readInstruction(program_counter_);
-        if_id_reg_.pc = program_counter_;
-    }
-    else
-    {
-        // Once past the end of the program, inject NOPs to drain the pipeline.
-        if_id_reg_.reset();
-    }
+    fetch_and_predict();
 }
 
 void RV5StageProcessorNHF::pipeline_execute()
@@ -225,16 +216,11 @@ void RV5StageProcessorNHF::pipeline_execute()
     bool overflow;
     uint64_t alu_result;
 
-    bool is_f_instruction = instruction_set::isFInstruction(instruction);
-    bool is_d_instruction = instruction_set::isDInstruction(instruction);
+    const bool is_fp_instruction = fp_operands(instruction).is_fp;
 
-    if (is_f_instruction)
-    {
-        alu_result = pipeline_execute_float();
-    }
-    else if (is_d_instruction)
+    if (is_fp_instruction)
     {
-        alu_result = pipeline_execute_double();
+        alu_result = execute_fp(true);
     }
     else
     {
@@ -349,7 +335,7 @@ void RV5StageProcessorNHF::pipeline_execute()
     ex_mem_reg_.pc = id_ex_reg_.pc;
     ex_mem_reg_.instruction = id_ex_reg_.instruction;
     ex_mem_reg_.alu_result = alu_result;
-    ex_mem_reg_.f_alu_result = (is_f_instruction || is_d_instruction) ? alu_result : 0;
+    ex_mem_reg_.f_alu_result = is_fp_instruction ? alu_result : 0;
     ex_mem_reg_.rd = id_ex_reg_.rd;
     ex_mem_reg_.frd = id_ex_reg_.frd;
     // NOTE: reg2_data and freg2_data are set inside the integer/FP execute
@@ -364,6 +350,7 @@ void RV5StageProcessorNHF::pipeline_execute()
     ex_mem_reg_.prev_branch_taken = ex_mem_reg_.branch_taken;
     ex_mem_reg_.branch_taken = false;
     ex_mem_reg_.branch_target_pc = 0;
+    ex_mem_reg_.branch_mispredicted = false;
 
     uint8_t opcode = instruction & 0b1111111;
 
@@ -396,11 +383,7 @@ void RV5StageProcessorNHF::pipeline_execute()
             break; // BGEU
         }
 
-        if (condition_met)
-        {
-            ex_mem_reg_.branch_taken = true;
-            ex_mem_reg_.branch_target_pc = id_ex_reg_.pc + id_ex_reg_.imm;
-        }
+        resolve_branch(condition_met);
     }
     // --- Unconditional Jump Check (JAL/JALR: 1-cycle penalty) ---
     else if (opcode == 0b1101111 || opcode == 0b1100111)
@@ -415,225 +398,8 @@ void RV5StageProcessorNHF::pipeline_execute()
             jump_target = alu_result & ~1;              // JALR (ALU result is Reg + Imm)
             ex_mem_reg_.alu_result = id_ex_reg_.pc + 4; // Set link address (PC+4)
         }
-
-        program_counter_ = jump_target;
-        if_id_reg_.reset();
-        ex_mem_reg_.branch_taken = true;
-    }
-}
-
-uint64_t RV5StageProcessorNHF::pipeline_execute_float()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // --- FORWARDING for FPR sources (frs1/frs2/frs3) ---
-    uint8_t fwd_a = 0; // 2 = EX/MEM, 1 = MEM/WB
-    uint8_t fwd_b = 0;
-    uint8_t fwd_c = 0;
-
-    // EX/MEM forwarding (highest priority)
-    if (ex_mem_reg_.freg_write && (ex_mem_reg_.frd != 0))
-    {
-        if (ex_mem_reg_.frd == id_ex_reg_.frs1)
-            fwd_a = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs2)
-            fwd_b = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs3)
-            fwd_c = 2;
-    }
-
-    // MEM/WB forwarding (lower priority)
-    if (mem_wb_reg_.prev_freg_write && (mem_wb_reg_.prev_frd != 0))
-    {
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs1 && fwd_a != 2)
-            fwd_a = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs2 && fwd_b != 2)
-            fwd_b = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs3 && fwd_c != 2)
-            fwd_c = 1;
-    }
-
-    // Apply forwarding to source values
-    if (fwd_a == 2)
-        reg1_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_a == 1)
-        reg1_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_b == 2)
-        reg2_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        reg2_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_c == 2)
-        reg3_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_c == 1)
-        reg3_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    // Re-apply GPR-read override (for conversion ops) after forwarding decision: if instruction
-    // requires GPR, use it.
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    // Re-apply immediate if ALUSrc was set (immediates take precedence for reg2)
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // Forward store data for FPR stores (frs2)
-    uint64_t fstore_data = id_ex_reg_.freg2_data;
-    if (fwd_b == 2)
-        fstore_data = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        fstore_data = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                  : mem_wb_reg_.prev_f_alu_result;
-
-    ex_mem_reg_.freg2_data = fstore_data;
-    // Execute FP operation
-    alu::AluOp aluOperation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::fpexecute(aluOperation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-
-    return alu_result;
-}
-
-uint64_t RV5StageProcessorNHF::pipeline_execute_double()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        // two casts are necessary here the inner one extends the sign
-        //  and then we cast it back to uint64_t
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // --- FORWARDING for FPR sources (frs1/frs2/frs3) ---
-    uint8_t fwd_a = 0; // 2 = EX/MEM, 1 = MEM/WB
-    uint8_t fwd_b = 0;
-    uint8_t fwd_c = 0;
-
-    if (ex_mem_reg_.freg_write && (ex_mem_reg_.frd != 0))
-    {
-        if (ex_mem_reg_.frd == id_ex_reg_.frs1)
-            fwd_a = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs2)
-            fwd_b = 2;
-        if (ex_mem_reg_.frd == id_ex_reg_.frs3)
-            fwd_c = 2;
-    }
-
-    if (mem_wb_reg_.prev_freg_write && (mem_wb_reg_.prev_frd != 0))
-    {
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs1 && fwd_a != 2)
-            fwd_a = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs2 && fwd_b != 2)
-            fwd_b = 1;
-        if (mem_wb_reg_.prev_frd == id_ex_reg_.frs3 && fwd_c != 2)
-            fwd_c = 1;
+        resolve_jump(jump_target);
     }
-
-    if (fwd_a == 2)
-        reg1_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_a == 1)
-        reg1_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_b == 2)
-        reg2_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        reg2_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    if (fwd_c == 2)
-        reg3_value = ex_mem_reg_.f_alu_result;
-    else if (fwd_c == 1)
-        reg3_value = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                 : mem_wb_reg_.prev_f_alu_result;
-
-    // Re-apply GPR-read override for specific instructions
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    // Re-apply immediate for reg2
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    // Forward store data for FPR stores
-    uint64_t fstore_data = id_ex_reg_.freg2_data;
-    if (fwd_b == 2)
-        fstore_data = ex_mem_reg_.f_alu_result;
-    else if (fwd_b == 1)
-        fstore_data = mem_wb_reg_.prev_mem_to_reg ? mem_wb_reg_.prev_f_memory_data
-                                                  : mem_wb_reg_.prev_f_alu_result;
-
-    ex_mem_reg_.freg2_data = fstore_data;
-
-    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::dfpexecute(alu_operation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-
-    return alu_result;
 }
 
 void RV5StageProcessorNHF::handle_syscall()
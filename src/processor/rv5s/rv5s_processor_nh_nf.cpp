@@ -166,27 +166,28 @@ void RV5StageProcessorNHNF::Reset()
 
 void RV5StageProcessorNHNF::Step()
 {
-    // Capture PC before potential redirection in EX/MEM stages
-    uint64_t old_pc_before_redirect = program_counter_;
+    MaybeCheckpoint();
+    if (hold_for_memory())
+    {
+        return; // the whole pipeline waits for a miss
+    }
 
     begin_step_delta();
 
     pipeline_writeback();
     pipeline_memory();
-    pipeline_execute();
-    pipeline_decode();
-    pipeline_fetch();
-
-    uint64_t next_pc = program_counter_;
-
-    // If no redirect happened in EX or MEM, advance sequentially.
-    if (next_pc == old_pc_before_redirect)
+    if (execute_stage())
     {
-        next_pc = old_pc_before_redirect + 4;
+        // ID/EX waits for a functional unit, and decode and fetch behind it
+        cycle_s_++;
+        finalize_step_delta();
+        return;
     }
+    pipeline_decode();
+    pipeline_fetch();
 
-    // Commit the new PC for the Fetch stage
-    program_counter_ = next_pc;
+    // Fetch read from wherever EX or MEM redirected to, so go on where it predicts.
+    program_counter_ = if_id_reg_.prediction.next_pc;
     cycle_s_++;
 
     finalize_step_delta();
@@ -194,17 +195,7 @@ void RV5StageProcessorNHNF::Step()
 
 void RV5StageProcessorNHNF::pipeline_fetch()
 {
-    if (program_counter_ < program_size_)
-    {
-        // Latch the instruction and PC for the next stage (IF/ID register)
-        if_id_reg_.instruction = memory_controller_.readInstruction(program_counter_);
-        if_id_reg_.pc = program_counter_;
-    }
-    else
-    {
-        // Once past the end of the program, inject NOPs to drain the pipeline.
-        if_id_reg_.reset();
-    }
+    fetch_and_predict();
 }
 
 void RV5StageProcessorNHNF::pipeline_execute()
@@ -237,15 +228,10 @@ void RV5StageProcessorNHNF::pipeline_execute()
     // Execute the operation
     bool overflow; // Ignored for this simple model
     uint64_t alu_result = 0;
-    const bool is_f_instruction = instruction_set::isFInstruction(instruction);
-    const bool is_d_instruction = instruction_set::isDInstruction(instruction);
-    if (is_f_instruction)
-    {
-        alu_result = pipeline_execute_float();
-    }
-    else if (is_d_instruction)
+    const bool is_fp_instruction = fp_operands(instruction).is_fp;
+    if (is_fp_instruction)
     {
-        alu_result = pipeline_execute_double();
+        alu_result = execute_fp(false);
     }
     else
     {
@@ -264,11 +250,10 @@ void RV5StageProcessorNHNF::pipeline_execute()
     ex_mem_reg_.pc = id_ex_reg_.pc;
     ex_mem_reg_.instruction = id_ex_reg_.instruction;
     ex_mem_reg_.alu_result = alu_result;
-    ex_mem_reg_.f_alu_result = (is_f_instruction || is_d_instruction) ? alu_result : 0;
+    ex_mem_reg_.f_alu_result = is_fp_instruction ? alu_result : 0;
     ex_mem_reg_.rd = id_ex_reg_.rd;
     ex_mem_reg_.frd = id_ex_reg_.frd;
     ex_mem_reg_.reg2_data = id_ex_reg_.reg2_data;
-    ex_mem_reg_.freg2_data = id_ex_reg_.freg2_data;
     ex_mem_reg_.reg_write = id_ex_reg_.reg_write;
     ex_mem_reg_.freg_write = id_ex_reg_.freg_write;
     ex_mem_reg_.mem_to_reg = id_ex_reg_.mem_to_reg;
@@ -279,6 +264,7 @@ void RV5StageProcessorNHNF::pipeline_execute()
     ex_mem_reg_.prev_branch_taken = ex_mem_reg_.branch_taken;
     ex_mem_reg_.branch_taken = false;
     ex_mem_reg_.branch_target_pc = 0;
+    ex_mem_reg_.branch_mispredicted = false;
 
     // --- Conditional Branch Check (B-type: BLT, BGE, etc.) ---
     if (id_ex_reg_.branch && opcode == 0b1100011)
@@ -309,12 +295,7 @@ void RV5StageProcessorNHNF::pipeline_execute()
             break; // BGEU (Result of kSltu is 0 - Not Less Than Unsigned)
         }
 
-        if (condition_met)
-        {
-            // Misprediction detected. Flag MEM stage to handle the 3-cycle flush.
-            ex_mem_reg_.branch_taken = true;
-            ex_mem_reg_.branch_target_pc = id_ex_reg_.pc + id_ex_reg_.imm;
-        }
+        resolve_branch(condition_met);
     }
     // --- Unconditional Jump Check (JAL/JALR: 1-cycle penalty) ---
     else if (opcode == 0b1101111 || opcode == 0b1100111)
@@ -329,15 +310,7 @@ void RV5StageProcessorNHNF::pipeline_execute()
             jump_target = alu_result & ~1;              // JALR (ALU result is Reg + Imm)
             ex_mem_reg_.alu_result = id_ex_reg_.pc + 4; // Set link address (PC+4)
         }
-
-        // 1. Redirect PC (Auto-Advance)
-        program_counter_ = jump_target;
-
-        // 2. Kill the next instruction (IF/ID register) to incur the 1-bubble penalty.
-        if_id_reg_.reset();
-
-        // 3. Mark as taken (for link register write)
-        ex_mem_reg_.branch_taken = true;
+        resolve_jump(jump_target);
     }
 }
 
@@ -353,82 +326,4 @@ void RV5StageProcessorNHNF::handle_syscall()
         DumpState("vm_state.json");
     }
 }
-
-// --- FP Execute Handlers ---
-
-uint64_t RV5StageProcessorNHNF::pipeline_execute_float()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101000 || funct7 == 0b1111000 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    alu::AluOp aluOperation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::fpexecute(aluOperation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-    return alu_result;
-}
-
-uint64_t RV5StageProcessorNHNF::pipeline_execute_double()
-{
-    uint32_t instruction = id_ex_reg_.instruction;
-    uint8_t opcode = instruction & 0b1111111;
-    uint8_t funct3 = (instruction >> 12) & 0b111;
-    uint8_t funct7 = (instruction >> 25) & 0b1111111;
-    uint8_t rm = funct3;
-
-    uint8_t fcsr_status = 0;
-    uint64_t alu_result = 0;
-
-    if (rm == 0b111)
-    {
-        rm = registers_.ReadCsr(0x002);
-    }
-
-    uint64_t reg1_value = id_ex_reg_.freg1_data;
-    uint64_t reg2_value = id_ex_reg_.freg2_data;
-    uint64_t reg3_value = id_ex_reg_.freg3_data;
-
-    if (funct7 == 0b1101001 || funct7 == 0b1111001 || opcode == 0b0000111 || opcode == 0b0100111)
-    {
-        reg1_value = registers_.ReadGpr(id_ex_reg_.rs1);
-    }
-
-    if (id_ex_reg_.alu_src)
-    {
-        reg2_value = static_cast<uint64_t>(static_cast<int64_t>(id_ex_reg_.imm));
-    }
-
-    alu::AluOp alu_operation = control_unit_.GetAluSignal(instruction, id_ex_reg_.alu_op > 0);
-    std::tie(alu_result, fcsr_status) =
-        alu::Alu::dfpexecute(alu_operation, reg1_value, reg2_value, reg3_value, rm);
-
-    registers_.WriteCsr(0x003, fcsr_status);
-    return alu_result;
-}
 }//namespace Kites
@@ -62,9 +62,6 @@ class RV5StageProcessorNHNF : public RV5StageVM_Base
     void pipeline_fetch() override;
     // void pipeline_decode() override;
     void pipeline_execute() override;
-
-    uint64_t pipeline_execute_float() override;
-    uint64_t pipeline_execute_double() override;
     // void pipeline_memory() override;
     //  void pipeline_writeback() override;
 
@@ -0,0 +1,146 @@
+/**
+ * @file rvss_basic_block.cpp
+ * @brief Basic block discovery, chaining and invalidation for the RVSS fast interpreter.
+ */
+
+#include "processor/rvss/rvss_processor.h"
+
+#include <algorithm>
+
+namespace Kites
+{
+namespace
+{
+bool EndsBlock(const RVSSDecodedInstruction &decoded)
+{
+    return decoded.handler == &RVSSProcessor::OpBranch || decoded.handler == &RVSSProcessor::OpJal ||
+           decoded.handler == &RVSSProcessor::OpJalr || decoded.handler == &RVSSProcessor::OpFallback;
+}
+} // namespace
+
+RVSSBasicBlock *RVSSProcessor::TranslateBlock(uint64_t pc)
+{
+    RVSSBasicBlock *block = nullptr;
+    if (free_blocks_.empty())
+    {
+        basic_blocks_.push_back(std::make_unique<RVSSBasicBlock>());
+        block = basic_blocks_.back().get();
+    }
+    else
+    {
+        block = free_blocks_.back();
+        free_blocks_.pop_back();
+        *block = RVSSBasicBlock();
+    }
+    block->start_pc = pc;
+    block->first_index = pc >> 2;
+
+    for (uint64_t index = block->first_index; index < decoded_instructions_.size(); ++index)
+    {
+        RVSSDecodedInstruction &decoded = decoded_instructions_[index];
+        if (decoded.handler == nullptr)
+        {
+            decoded = DecodeInstruction(memory_controller_.readWord_d(index * 4));
+        }
+        ++block->length;
+        if (EndsBlock(decoded) || block->length == RVSSBasicBlock::max_length)
+        {
+            break;
+        }
+        // a breakpoint always starts a block so it can be checked at the boundary
+        const uint64_t next_pc = (index + 1) * 4;
+        if (std::find(breakpoints_.begin(), breakpoints_.end(), next_pc) != breakpoints_.end())
+        {
+            break;
+        }
+    }
+    block->fallthrough_pc = pc + 4 * static_cast<uint64_t>(block->length);
+    return block;
+}
+
+RVSSBasicBlock *RVSSProcessor::LookupBlock(uint64_t pc)
+{
+    const uint64_t index = pc >> 2;
+    if ((pc & 0b11) != 0 || index >= decoded_instructions_.size())
+    {
+        return nullptr;
+    }
+    if (block_map_.size() != decoded_instructions_.size())
+    {
+        block_map_.assign(decoded_instructions_.size(), nullptr);
+    }
+    RVSSBasicBlock *&block = block_map_[index];
+    if (block == nullptr || !block->valid)
+    {
+        block = TranslateBlock(pc);
+    }
+    return block;
+}
+
+void RVSSProcessor::InvalidateBlocks(uint64_t address, uint64_t size)
+{
+    if (size == 0 || block_map_.empty())
+    {
+        return;
+    }
+    const uint64_t first = address >> 2;
+    const uint64_t last = std::min<uint64_t>((address + size - 1) >> 2, block_map_.size() - 1);
+    // a block overlapping the range starts at most max_length - 1 instructions before it
+    const uint64_t reach = RVSSBasicBlock::max_length - 1;
+    for (uint64_t index = first > reach ? first - reach : 0; index <= last; ++index)
+    {
+        RVSSBasicBlock *block = block_map_[index];
+        if (block != nullptr && index + block->length > first)
+        {
+            block->valid = false;
+            block_map_[index] = nullptr;
+            free_blocks_.push_back(block);
+        }
+    }
+}
+
+void RVSSProcessor::FlushBlocks()
+{
+    block_map_.clear();
+    free_blocks_.clear();
+    basic_blocks_.clear();
+}
+
+RVSSBasicBlock *RVSSProcessor::ExecuteBlock(RVSSBasicBlock &block)
+{
+    for (uint32_t i = 0; i < block.length; ++i)
+    {
+        last_executed_pc_ = program_counter_;
+        // the instruction cache is still accessed so its statistics match a stepped run
+        current_instruction_ = memory_controller_.readInstruction(program_counter_);
+        RVSSDecodedInstruction &decoded = decoded_instructions_[block.first_index + i];
+        if (decoded.handler == nullptr || decoded.instruction != current_instruction_)
+        {
+            // the text changed under the block (e.g. from the memory editor while paused)
+            decoded = DecodeInstruction(current_instruction_);
+            InvalidateBlocks(program_counter_, 4);
+        }
+        UpdateProgramCounter(4);
+        (this->*decoded.handler)(decoded);
+        instructions_retired_++;
+        cycle_s_++;
+        if (!block.valid)
+        {
+            // a store rewrote this block; whatever follows has to be looked up again
+            break;
+        }
+    }
+    if (!block.valid)
+    {
+        return LookupBlock(program_counter_);
+    }
+
+    RVSSBasicBlock *&successor =
+        program_counter_ == block.fallthrough_pc ? block.fallthrough : block.taken;
+    if (successor == nullptr || !successor->valid || successor->start_pc != program_counter_)
+    {
+        successor = LookupBlock(program_counter_);
+    }
+    return successor;
+}
+}//namespace Kites
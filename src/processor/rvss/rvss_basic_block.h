@@ -0,0 +1,41 @@
+/**
+ * @file rvss_basic_block.h
+ * @brief Basic block record used by the RVSS fast interpreter.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Kites
+{
+/**
+ * @brief A run of predecoded instructions that is entered at the top and left at the bottom.
+ *
+ * A block ends after the first branch, jump or fallback instruction (syscalls, CSR accesses),
+ * at the end of the text section, or just before a breakpoint, so breakpoints, stop/pause
+ * requests and syscalls only ever have to be looked at between blocks. The instructions
+ * themselves are the records in RVSSProcessor::decoded_instructions_ starting at
+ * @ref first_index.
+ *
+ * Blocks are chained to their successors by pc. A chain link is only a hint: it is followed
+ * when the successor is still valid and starts at the pc control actually went to, which also
+ * holds once an invalidated block has been recycled for another pc.
+ *
+ * Blocks are at most @ref max_length instructions long, so the blocks a write can overlap all
+ * start within max_length instructions before it and are found through the block map.
+ */
+struct RVSSBasicBlock
+{
+    static constexpr uint32_t max_length = 64;
+
+    uint64_t start_pc{};
+    uint64_t first_index{}; // start_pc / 4
+    uint32_t length{};      // instructions, at least one
+    bool valid{true};       // cleared when a write lands in [start_pc, start_pc + 4 * length)
+
+    uint64_t fallthrough_pc{};
+    RVSSBasicBlock *fallthrough{nullptr};
+    RVSSBasicBlock *taken{nullptr}; // last non-fallthrough successor
+};
+}//namespace Kites
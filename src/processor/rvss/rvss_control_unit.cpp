@@ -54,6 +54,19 @@ void RVSSControlUnit::SetControlSignals(uint32_t instruction)
         alu_op_ = true;
         break;
     }
+    case 0b0111011:
+    { // R-type word instructions (ADDW, SUBW, SLLW, SRLW, SRAW, MULW, DIVW, ...)
+        reg_write_ = true;
+        alu_op_ = true;
+        break;
+    }
+    case 0b0011011:
+    { // I-type word instructions (ADDIW, SLLIW, SRLIW, SRAIW)
+        alu_src_ = true;
+        reg_write_ = true;
+        alu_op_ = true;
+        break;
+    }
     case 0b0110111:
     { // LUI (Load Upper Immediate)
         alu_src_ = true;
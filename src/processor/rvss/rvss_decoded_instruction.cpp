@@ -0,0 +1,476 @@
+/**
+ * @file rvss_decoded_instruction.cpp
+ * @brief Predecoded instruction cache and the handlers the RVSS fast interpreter dispatches to.
+ *
+ * Every handler mirrors the Execute/WriteMemory/WriteBack path of RVSSProcessor for its
+ * instruction class, but reads operands from the predecoded record instead of re-deriving
+ * them from the raw instruction. Register and memory writes go through the *Recorded helpers,
+ * which add them to the undo delta while history is being recorded, as the stages do.
+ * Instructions that are rare or have side effects the fast path does not model (syscalls, CSR
+ * accesses, anything unrecognised) go through OpFallback, which runs the regular stages.
+ */
+
+#include "processor/rvss/rvss_processor.h"
+
+#include "common/instructions.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace Kites
+{
+RVSSDecodedInstruction RVSSProcessor::DecodeInstruction(uint32_t instruction)
+{
+    RVSSControlUnit decoder;
+    decoder.SetControlSignals(instruction);
+
+    RVSSDecodedInstruction decoded;
+    decoded.instruction = instruction;
+    decoded.opcode = instruction & 0b1111111;
+    decoded.funct3 = (instruction >> 12) & 0b111;
+    decoded.funct7 = (instruction >> 25) & 0b1111111;
+    decoded.rd = (instruction >> 7) & 0b11111;
+    decoded.rs1 = (instruction >> 15) & 0b11111;
+    decoded.rs2 = (instruction >> 20) & 0b11111;
+    decoded.rs3 = (instruction >> 27) & 0b11111;
+    decoded.imm = ImmGenerator(instruction);
+    decoded.alu_op = decoder.GetAluSignal(instruction, decoder.GetAluOp());
+    decoded.alu_src = decoder.GetAluSrc();
+    decoded.reg_write = decoder.GetRegWrite();
+    decoded.mem_read = decoder.GetMemRead();
+    decoded.mem_write = decoder.GetMemWrite();
+    decoded.branch = decoder.GetBranch();
+
+    if (decoded.opcode == 0b1110011)
+    { // syscalls and CSR accesses
+        decoded.handler = &RVSSProcessor::OpFallback;
+        return decoded;
+    }
+    if (instruction_set::isFInstruction(instruction))
+    {
+        decoded.handler = &RVSSProcessor::OpFloat;
+        return decoded;
+    }
+    if (instruction_set::isDInstruction(instruction))
+    {
+        decoded.handler = &RVSSProcessor::OpDouble;
+        return decoded;
+    }
+
+    switch (decoded.opcode)
+    {
+    case 0b0110011: // R-Type
+    case 0b0010011: // I-Type
+    case 0b0111011: // R-Type word, the ALU sign-extends the low 32 bits of the result
+    case 0b0011011:
+    { // I-Type word
+        decoded.handler = &RVSSProcessor::OpAlu;
+        break;
+    }
+    case 0b0110111:
+    { // LUI
+        decoded.imm = static_cast<int32_t>(instruction & 0xFFFFF000);
+        decoded.handler = &RVSSProcessor::OpLui;
+        break;
+    }
+    case 0b0010111:
+    { // AUIPC
+        decoded.imm = static_cast<int32_t>(instruction & 0xFFFFF000);
+        decoded.handler = &RVSSProcessor::OpAuipc;
+        break;
+    }
+    case 0b1101111:
+    { // JAL
+        decoded.handler = &RVSSProcessor::OpJal;
+        break;
+    }
+    case 0b1100111:
+    { // JALR
+        decoded.handler = &RVSSProcessor::OpJalr;
+        break;
+    }
+    case 0b1100011:
+    { // Branch
+        decoded.handler = &RVSSProcessor::OpBranch;
+        break;
+    }
+    case 0b0000011:
+    { // Load
+        decoded.handler = &RVSSProcessor::OpLoad;
+        break;
+    }
+    case 0b0100011:
+    { // Store
+        decoded.handler = &RVSSProcessor::OpStore;
+        break;
+    }
+    default:
+    {
+        decoded.handler = &RVSSProcessor::OpFallback;
+        break;
+    }
+    }
+    return decoded;
+}
+
+void RVSSProcessor::PredecodeProgram()
+{
+    FlushBlocks();
+    decoded_instructions_.assign(program_size_ / 4, RVSSDecodedInstruction());
+    for (size_t i = 0; i < decoded_instructions_.size(); ++i)
+    {
+        decoded_instructions_[i] = DecodeInstruction(memory_controller_.readWord_d(i * 4));
+    }
+}
+
+const RVSSDecodedInstruction &RVSSProcessor::LookupDecoded(uint64_t pc, uint32_t instruction)
+{
+    const uint64_t index = pc >> 2;
+    if ((pc & 0b11) == 0 && index < decoded_instructions_.size())
+    {
+        RVSSDecodedInstruction &entry = decoded_instructions_[index];
+        // the raw word check also catches writes that bypassed the processor, e.g. from the
+        // memory editor
+        if (entry.handler == nullptr || entry.instruction != instruction)
+        {
+            entry = DecodeInstruction(instruction);
+        }
+        return entry;
+    }
+    scratch_decoded_ = DecodeInstruction(instruction);
+    return scratch_decoded_;
+}
+
+void RVSSProcessor::InvalidateDecoded(uint64_t address, uint64_t size)
+{
+    const uint64_t text_end = decoded_instructions_.size() * 4;
+    if (address >= text_end || size == 0)
+    {
+        return;
+    }
+    const uint64_t last = std::min(address + size - 1, text_end - 1);
+    for (uint64_t index = address >> 2; index <= (last >> 2); ++index)
+    {
+        decoded_instructions_[index].handler = nullptr;
+    }
+    InvalidateBlocks(address, size);
+}
+
+void RVSSProcessor::ExecuteDecoded()
+{
+    // the instruction cache is still accessed so its statistics match a stepped run
+    current_instruction_ = memory_controller_.readInstruction(program_counter_);
+    const RVSSDecodedInstruction &decoded = LookupDecoded(program_counter_, current_instruction_);
+    UpdateProgramCounter(4);
+    (this->*decoded.handler)(decoded);
+}
+
+void RVSSProcessor::WriteGprRecorded(uint8_t rd, uint64_t value)
+{
+    if (!record_history_)
+    {
+        registers_.WriteGpr(rd, value);
+        return;
+    }
+    const uint64_t old_value = registers_.ReadGpr(rd);
+    registers_.WriteGpr(rd, value);
+    // read back, x0 stays zero
+    const uint64_t new_value = registers_.ReadGpr(rd);
+    if (old_value != new_value)
+    {
+        current_delta_.register_changes.push_back({rd, 0, old_value, new_value});
+    }
+}
+
+void RVSSProcessor::WriteFprRecorded(uint8_t rd, uint64_t value)
+{
+    if (!record_history_)
+    {
+        registers_.WriteFpr(rd, value);
+        return;
+    }
+    const uint64_t old_value = registers_.ReadFpr(rd);
+    registers_.WriteFpr(rd, value);
+    if (old_value != value)
+    {
+        current_delta_.register_changes.push_back({rd, 2, old_value, value});
+    }
+}
+
+void RVSSProcessor::StoreRecorded(uint64_t address, uint64_t value, unsigned int size)
+{
+    // the old and new bytes are read through the data cache, like WriteMemory() does
+    std::vector<uint8_t> old_bytes_vec;
+    if (record_history_)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            old_bytes_vec.push_back(memory_controller_.readByte(address + i));
+        }
+    }
+    switch (size)
+    {
+    case 1:
+        memory_controller_.writeByte(address, value & 0xFF);
+        break;
+    case 2:
+        memory_controller_.writeHalfWord(address, value & 0xFFFF);
+        break;
+    case 4:
+        memory_controller_.writeWord(address, value & 0xFFFFFFFF);
+        break;
+    default:
+        memory_controller_.writeDoubleWord(address, value);
+        break;
+    }
+    InvalidateDecoded(address, size);
+    if (!record_history_)
+    {
+        return;
+    }
+    std::vector<uint8_t> new_bytes_vec;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        new_bytes_vec.push_back(memory_controller_.readByte(address + i));
+    }
+    if (old_bytes_vec != new_bytes_vec)
+    {
+        current_delta_.memory_changes.push_back({address, old_bytes_vec, new_bytes_vec});
+    }
+}
+
+void RVSSProcessor::OpAlu(const RVSSDecodedInstruction &decoded)
+{
+    const uint64_t reg1_value = registers_.ReadGpr(decoded.rs1);
+    const uint64_t reg2_value = decoded.alu_src ? static_cast<uint64_t>(decoded.imm)
+                                                : registers_.ReadGpr(decoded.rs2);
+    execution_result_ = alu::Alu::execute(decoded.alu_op, reg1_value, reg2_value).first;
+    WriteGprRecorded(decoded.rd, execution_result_);
+}
+
+void RVSSProcessor::OpLui(const RVSSDecodedInstruction &decoded)
+{
+    WriteGprRecorded(decoded.rd, decoded.imm);
+}
+
+void RVSSProcessor::OpAuipc(const RVSSDecodedInstruction &decoded)
+{
+    execution_result_ = static_cast<int64_t>(program_counter_) - 4 + decoded.imm;
+    WriteGprRecorded(decoded.rd, execution_result_);
+}
+
+void RVSSProcessor::OpJal(const RVSSDecodedInstruction &decoded)
+{
+    next_pc_ = static_cast<int64_t>(program_counter_);
+    UpdateProgramCounter(decoded.imm - 4);
+    WriteGprRecorded(decoded.rd, next_pc_);
+}
+
+void RVSSProcessor::OpJalr(const RVSSDecodedInstruction &decoded)
+{
+    next_pc_ = static_cast<int64_t>(program_counter_);
+    execution_result_ = registers_.ReadGpr(decoded.rs1) + decoded.imm;
+    program_counter_ = execution_result_;
+    WriteGprRecorded(decoded.rd, next_pc_);
+}
+
+void RVSSProcessor::OpBranch(const RVSSDecodedInstruction &decoded)
+{
+    execution_result_ = alu::Alu::execute(decoded.alu_op, registers_.ReadGpr(decoded.rs1),
+                                          registers_.ReadGpr(decoded.rs2))
+                            .first;
+    switch (decoded.funct3)
+    {
+    case 0b000: // BEQ
+    case 0b101: // BGE
+    case 0b111:
+    { // BGEU
+        branch_flag_ = (execution_result_ == 0);
+        break;
+    }
+    case 0b001:
+    { // BNE
+        branch_flag_ = (execution_result_ != 0);
+        break;
+    }
+    case 0b100: // BLT
+    case 0b110:
+    { // BLTU
+        branch_flag_ = (execution_result_ == 1);
+        break;
+    }
+    default:
+        break;
+    }
+    if (branch_flag_)
+    {
+        UpdateProgramCounter(decoded.imm - 4);
+    }
+}
+
+void RVSSProcessor::OpLoad(const RVSSDecodedInstruction &decoded)
+{
+    execution_result_ = registers_.ReadGpr(decoded.rs1) + decoded.imm;
+    switch (decoded.funct3)
+    {
+    case 0b000:
+    { // LB
+        memory_result_ = static_cast<int8_t>(memory_controller_.readByte(execution_result_));
+        break;
+    }
+    case 0b001:
+    { // LH
+        memory_result_ = static_cast<int16_t>(memory_controller_.readHalfWord(execution_result_));
+        break;
+    }
+    case 0b010:
+    { // LW
+        memory_result_ = static_cast<int32_t>(memory_controller_.readWord(execution_result_));
+        break;
+    }
+    case 0b011:
+    { // LD
+        memory_result_ = memory_controller_.readDoubleWord(execution_result_);
+        break;
+    }
+    case 0b100:
+    { // LBU
+        memory_result_ = static_cast<uint8_t>(memory_controller_.readByte(execution_result_));
+        break;
+    }
+    case 0b101:
+    { // LHU
+        memory_result_ = static_cast<uint16_t>(memory_controller_.readHalfWord(execution_result_));
+        break;
+    }
+    case 0b110:
+    { // LWU
+        memory_result_ = static_cast<uint32_t>(memory_controller_.readWord(execution_result_));
+        break;
+    }
+    default:
+        break;
+    }
+    WriteGprRecorded(decoded.rd, memory_result_);
+}
+
+void RVSSProcessor::OpStore(const RVSSDecodedInstruction &decoded)
+{
+    execution_result_ = registers_.ReadGpr(decoded.rs1) + decoded.imm;
+    const uint64_t value = registers_.ReadGpr(decoded.rs2);
+    if (decoded.funct3 <= 0b011)
+    { // SB, SH, SW, SD
+        StoreRecorded(execution_result_, value, 1u << decoded.funct3);
+    }
+}
+
+void RVSSProcessor::OpFloat(const RVSSDecodedInstruction &decoded)
+{
+    uint8_t rm = decoded.funct3;
+    if (rm == 0b111)
+    {
+        rm = registers_.ReadCsr(0x002);
+    }
+
+    uint64_t reg1_value = registers_.ReadFpr(decoded.rs1);
+    uint64_t reg2_value = registers_.ReadFpr(decoded.rs2);
+    const uint64_t reg3_value = registers_.ReadFpr(decoded.rs3);
+    if (decoded.funct7 == 0b1101000 || decoded.funct7 == 0b1111000 ||
+        decoded.opcode == 0b0000111 || decoded.opcode == 0b0100111)
+    {
+        reg1_value = registers_.ReadGpr(decoded.rs1);
+    }
+    if (decoded.alu_src)
+    {
+        reg2_value = static_cast<uint64_t>(decoded.imm);
+    }
+
+    uint8_t fcsr_status = 0;
+    std::tie(execution_result_, fcsr_status) =
+        alu::Alu::fpexecute(decoded.alu_op, reg1_value, reg2_value, reg3_value, rm);
+    registers_.WriteCsr(0x003, fcsr_status);
+
+    if (decoded.mem_read)
+    { // FLW
+        memory_result_ = memory_controller_.readWord(execution_result_);
+    }
+    if (decoded.mem_write)
+    { // FSW
+        StoreRecorded(execution_result_, registers_.ReadFpr(decoded.rs2) & 0xFFFFFFFF, 4);
+    }
+
+    if (!decoded.reg_write)
+    {
+        return;
+    }
+    if (decoded.funct7 == 0b1010000 || decoded.funct7 == 0b1100000 ||
+        decoded.funct7 == 0b1110000)
+    { // f(eq|lt|le).s, fcvt.(w|wu|l|lu).s
+        WriteGprRecorded(decoded.rd, execution_result_);
+    }
+    else if (decoded.opcode == 0b0000111)
+    {
+        WriteFprRecorded(decoded.rd, memory_result_);
+    }
+    else
+    {
+        WriteFprRecorded(decoded.rd, execution_result_);
+    }
+}
+
+void RVSSProcessor::OpDouble(const RVSSDecodedInstruction &decoded)
+{
+    uint64_t reg1_value = registers_.ReadFpr(decoded.rs1);
+    uint64_t reg2_value = registers_.ReadFpr(decoded.rs2);
+    const uint64_t reg3_value = registers_.ReadFpr(decoded.rs3);
+    if (decoded.funct7 == 0b1101001 || decoded.funct7 == 0b1111001 ||
+        decoded.opcode == 0b0000111 || decoded.opcode == 0b0100111)
+    {
+        reg1_value = registers_.ReadGpr(decoded.rs1);
+    }
+    if (decoded.alu_src)
+    {
+        reg2_value = static_cast<uint64_t>(decoded.imm);
+    }
+
+    execution_result_ = alu::Alu::dfpexecute(decoded.alu_op, reg1_value, reg2_value, reg3_value,
+                                             decoded.funct3)
+                            .first;
+
+    if (decoded.mem_read)
+    { // FLD
+        memory_result_ = memory_controller_.readDoubleWord(execution_result_);
+    }
+    if (decoded.mem_write)
+    { // FSD
+        StoreRecorded(execution_result_, registers_.ReadFpr(decoded.rs2), 8);
+    }
+
+    if (!decoded.reg_write)
+    {
+        return;
+    }
+    if (decoded.funct7 == 0b1010001 || decoded.funct7 == 0b1100001 ||
+        decoded.funct7 == 0b1110001)
+    { // f(eq|lt|le).d, fcvt.(w|wu|l|lu).d
+        WriteGprRecorded(decoded.rd, execution_result_);
+    }
+    else if (decoded.opcode == 0b0000111)
+    {
+        WriteFprRecorded(decoded.rd, memory_result_);
+    }
+    else
+    {
+        WriteFprRecorded(decoded.rd, execution_result_);
+    }
+}
+
+void RVSSProcessor::OpFallback(const RVSSDecodedInstruction &decoded)
+{
+    current_instruction_ = decoded.instruction;
+    Decode();
+    Execute();
+    WriteMemory();
+    WriteBack();
+}
+}//namespace Kites
@@ -0,0 +1,48 @@
+/**
+ * @file rvss_decoded_instruction.h
+ * @brief Predecoded instruction record used by the RVSS fast interpreter.
+ */
+
+#pragma once
+
+#include "processor/alu.h"
+
+#include <cstdint>
+
+namespace Kites
+{
+class RVSSProcessor;
+
+/**
+ * @brief Everything the interpreter needs to execute one instruction, resolved once
+ * when the instruction is first decoded.
+ *
+ * The record is keyed by PC in RVSSProcessor::decoded_instructions_ and dispatched
+ * through @ref handler, so steady-state execution never goes back to the control
+ * unit, ImmGenerator or the instruction encoding maps.
+ */
+struct RVSSDecodedInstruction
+{
+    using Handler = void (RVSSProcessor::*)(const RVSSDecodedInstruction &);
+
+    Handler handler{nullptr}; // nullptr marks an entry that still has to be decoded
+    uint32_t instruction{};
+    int64_t imm{};            // sign-extended; U-type already shifted into place
+    alu::AluOp alu_op{alu::AluOp::NONE};
+
+    uint8_t opcode{};
+    uint8_t funct3{};
+    uint8_t funct7{};
+    uint8_t rd{};
+    uint8_t rs1{};
+    uint8_t rs2{};
+    uint8_t rs3{};
+
+    // control bits, as produced by RVSSControlUnit::SetControlSignals
+    bool alu_src{};
+    bool reg_write{};
+    bool mem_read{};
+    bool mem_write{};
+    bool branch{};
+};
+}//namespace Kites
@@ -26,7 +26,9 @@
 
 namespace Kites
 {
-RVSSProcessor::RVSSProcessor() : ProcessorBase()
+RVSSProcessor::RVSSProcessor()
+    : ProcessorBase(),
+      history_(vm_config::config.getUndoHistoryDepth(), vm_config::config.getUndoHistoryMemoryCap())
 {
     DumpRegisters(globals::registers_dump_file_path, registers_);
     DumpState(globals::vm_state_dump_file_path);
@@ -54,6 +56,12 @@ RVSSProcessor::RVSSProcessor() : ProcessorBase()
 
 RVSSProcessor::~RVSSProcessor() = default;
 
+void RVSSProcessor::LoadProgram(const AssembledProgram &program)
+{
+    ProcessorBase::LoadProgram(program);
+    PredecodeProgram();
+}
+
 void RVSSProcessor::SetActiveWireNames()
 {
     // first clear the current list
@@ -76,6 +84,17 @@ void RVSSProcessor::SetActiveWireNames()
 
     // }
 
+    // instructions execute through the predecoded handlers, the control unit is only set up
+    // here to light the wires of the last one
+    active_wires_.erase(active_wires_.begin() + always_active_wires_count_, active_wires_.end());
+    Decode();
+    if (branch_flag_ && (current_instruction_ & 0b1111111) == 0b1100011)
+    {
+        // we have jumped so the branch alu wire will send signal to the pc mux
+        active_wires_.append("ALUzero_to_ANDGATElower");
+        active_wires_.append("BranchAND_to_PCMUX");
+    }
+
     if (control_unit_.GetMemWrite())
     {
         active_wires_.append("Control_to_MemWrite");
@@ -170,10 +189,91 @@ void RVSSProcessor::Run()
     DumpState(globals::vm_state_dump_file_path);
 }
 
-void RVSSProcessor::Fetch()
+void RVSSProcessor::FastRun()
 {
-    current_instruction_ = memory_controller_.readInstruction(program_counter_);
-    UpdateProgramCounter(4);
+    ClearStop();
+    // history recorded before a headless run no longer lines up with the state after it,
+    // and nothing is recorded during it
+    history_.clear();
+    record_history_ = false;
+    // blocks are split at breakpoints, which may have changed since the last run
+    breakpoints_changed_ = false;
+    FlushBlocks();
+    RVSSBasicBlock *block = nullptr;
+    while (!stop_requested_ && program_counter_ < program_size_)
+    {
+        if (breakpoints_changed_.load(std::memory_order_relaxed))
+        {
+            // set while paused, or from another thread while running
+            breakpoints_changed_ = false;
+            FlushBlocks();
+            block = nullptr;
+        }
+        if (last_breakpoint_pc_ != UINT64_MAX && program_counter_ != last_breakpoint_pc_)
+        {
+            last_breakpoint_pc_ = UINT64_MAX;
+        }
+
+        if (program_counter_ != last_breakpoint_pc_ &&
+            std::find(breakpoints_.begin(), breakpoints_.end(), program_counter_) !=
+                breakpoints_.end())
+        {
+            last_breakpoint_pc_ = program_counter_;
+            std::cout << "VM_BREAKPOINT_HIT " << program_counter_ << std::endl;
+            output_status_ = "VM_BREAKPOINT_HIT";
+            emit processorPausedAtBreakpointSignal();
+            break;
+        }
+
+        if (pause_requested_)
+        {
+            // only touch the mutex when someone actually asked us to pause
+            setProcessorState();
+            emit processorClockedSignal(processor_state_);
+            QMutexLocker locker(&pause_mutex_);
+            while (pause_requested_ && !stop_requested_)
+            {
+                pause_wait_condition_.wait(&pause_mutex_);
+            }
+            if (stop_requested_)
+            {
+                break;
+            }
+            // the text may have been edited while paused
+            block = nullptr;
+        }
+
+        MaybeCheckpoint();
+        if (block == nullptr || !block->valid || block->start_pc != program_counter_)
+        {
+            block = LookupBlock(program_counter_);
+        }
+        if (block != nullptr)
+        {
+            // breakpoints, stop/pause requests and syscalls are only looked at between blocks
+            block = ExecuteBlock(*block);
+            // the pc has moved on from a breakpoint we resumed at, even if it is back there now
+            last_breakpoint_pc_ = UINT64_MAX;
+            continue;
+        }
+
+        // misaligned pc: no block can start here
+        last_executed_pc_ = program_counter_;
+        ExecuteDecoded();
+        instructions_retired_++;
+        cycle_s_++;
+    }
+    record_history_ = true;
+
+    if (program_counter_ >= program_size_)
+    {
+        std::cout << "VM_PROGRAM_END" << std::endl;
+        output_status_ = "VM_PROGRAM_END";
+    }
+    setProcessorState();
+    emit processorClockedSignal(processor_state_);
+    DumpRegisters(globals::registers_dump_file_path, registers_);
+    DumpState(globals::vm_state_dump_file_path);
 }
 
 void RVSSProcessor::Decode()
@@ -230,8 +330,9 @@ void RVSSProcessor::Execute()
     if (control_unit_.GetBranch())
     {
         if (opcode == 0b1100111 || opcode == 0b1101111)
-        {                                                      // JALR or JAL
-            next_pc_ = static_cast<int64_t>(program_counter_); // PC was already updated in Fetch()
+        { // JALR or JAL
+            // PC was already updated in ExecuteDecoded()
+            next_pc_ = static_cast<int64_t>(program_counter_);
             UpdateProgramCounter(-4);
             return_address_ = program_counter_ + 4;
             if (opcode == 0b1100111)
@@ -314,9 +415,6 @@ void RVSSProcessor::Execute()
     {
         UpdateProgramCounter(-4);
         UpdateProgramCounter(imm);
-        // we have jumped so the branch alu wire will send signal to the pc mux
-        active_wires_.append("ALUzero_to_ANDGATElower");
-        active_wires_.append("BranchAND_to_PCMUX");
     }
 
     if (opcode == 0b0010111)
@@ -509,6 +607,9 @@ void RVSSProcessor::HandleSyscall()
         }
         output_status_ = "VM_EXIT";
         std::cout << "Exited with exit code: " << registers_.ReadGpr(10) << std::endl;
+        // a headless run has not dumped anything yet, so materialize the final state here
+        DumpRegisters(globals::registers_dump_file_path, registers_);
+        DumpState(globals::vm_state_dump_file_path);
         exit(0); // Exit the program
         break;
     }
@@ -520,19 +621,8 @@ void RVSSProcessor::HandleSyscall()
 
         if (file_descriptor == 0)
         {
-            // Read from stdin
-            std::string input;
-            {
-                std::cout << "VM_STDIN_START" << std::endl;
-                output_status_ = "VM_STDIN_START";
-                std::unique_lock<std::mutex> lock(input_mutex_);
-                input_cv_.wait(lock, [this]() { return !input_queue_.empty(); });
-                output_status_ = "VM_STDIN_END";
-                std::cout << "VM_STDIN_END" << std::endl;
-
-                input = input_queue_.front();
-                input_queue_.pop();
-            }
+            // Read from stdin, or from the input log when re-executing
+            std::string input = ConsumeInput();
 
             std::vector<uint8_t> old_bytes_vec(length, 0);
             std::vector<uint8_t> new_bytes_vec(length, 0);
@@ -556,7 +646,11 @@ void RVSSProcessor::HandleSyscall()
                 new_bytes_vec[i] = memory_controller_.readByte(buffer_address + i);
             }
 
-            current_delta_.memory_changes.push_back({buffer_address, old_bytes_vec, new_bytes_vec});
+            InvalidateDecoded(buffer_address, length);
+            if (record_history_)
+            {
+                current_delta_.memory_changes.push_back({buffer_address, old_bytes_vec, new_bytes_vec});
+            }
 
             uint64_t old_reg = registers_.ReadGpr(10);
             unsigned int reg_index = 10;
@@ -564,7 +658,7 @@ void RVSSProcessor::HandleSyscall()
             uint64_t new_reg =
                 std::min(static_cast<uint64_t>(length), static_cast<uint64_t>(input.size()));
             registers_.WriteGpr(10, new_reg);
-            if (old_reg != new_reg)
+            if (record_history_ && old_reg != new_reg)
             {
                 current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
             }
@@ -604,7 +698,7 @@ void RVSSProcessor::HandleSyscall()
             unsigned int reg_type = 0; // 0 for GPR, 1 for CSR, 2 for FPR
             uint64_t new_reg = std::min(static_cast<uint64_t>(length), bytes_printed);
             registers_.WriteGpr(10, new_reg);
-            if (old_reg != new_reg)
+            if (record_history_ && old_reg != new_reg)
             {
                 current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
             }
@@ -755,7 +849,11 @@ void RVSSProcessor::WriteMemory()
 
     if (old_bytes_vec != new_bytes_vec)
     {
-        current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        InvalidateDecoded(addr, new_bytes_vec.size());
+        if (record_history_)
+        {
+            current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        }
     }
 }
 
@@ -790,7 +888,11 @@ void RVSSProcessor::WriteMemoryFloat()
 
     if (old_bytes_vec != new_bytes_vec)
     {
-        current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        InvalidateDecoded(addr, new_bytes_vec.size());
+        if (record_history_)
+        {
+            current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        }
     }
 }
 
@@ -823,7 +925,11 @@ void RVSSProcessor::WriteMemoryDouble()
 
     if (old_bytes_vec != new_bytes_vec)
     {
-        current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        InvalidateDecoded(addr, new_bytes_vec.size());
+        if (record_history_)
+        {
+            current_delta_.memory_changes.push_back({addr, old_bytes_vec, new_bytes_vec});
+        }
     }
 }
 
@@ -865,6 +971,8 @@ void RVSSProcessor::WriteBack()
         {
         case 0b0110011: // R-Type
         case 0b0010011: // I-Type
+        case 0b0111011: // R-Type word
+        case 0b0011011: // I-Type word
         case 0b0010111:
         { // AUIPC
             registers_.WriteGpr(rd, execution_result_);
@@ -902,7 +1010,7 @@ void RVSSProcessor::WriteBack()
     }
 
     uint64_t new_reg = registers_.ReadGpr(rd);
-    if (old_reg != new_reg)
+    if (record_history_ && old_reg != new_reg)
     {
         current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
     }
@@ -946,7 +1054,7 @@ void RVSSProcessor::WriteBackFloat()
         }
     }
 
-    if (old_reg != new_reg)
+    if (record_history_ && old_reg != new_reg)
     {
         current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
     }
@@ -990,7 +1098,7 @@ void RVSSProcessor::WriteBackDouble()
         }
     }
 
-    if (old_reg != new_reg)
+    if (record_history_ && old_reg != new_reg)
     {
         current_delta_.register_changes.push_back({reg_index, reg_type, old_reg, new_reg});
     }
@@ -1061,11 +1169,11 @@ void RVSSProcessor::WriteBackCsr()
     uint64_t new_gpr = registers_.ReadGpr(rd);
     uint64_t new_csr = registers_.ReadCsr(csr_target_address_);
 
-    if (old_gpr != new_gpr)
+    if (record_history_ && old_gpr != new_gpr)
     {
         current_delta_.register_changes.push_back({rd, 0, old_gpr, new_gpr});
     }
-    if (old_csr != new_csr)
+    if (record_history_ && old_csr != new_csr)
     {
         current_delta_.register_changes.push_back({csr_target_address_, 1, old_csr, new_csr});
     }
@@ -1080,23 +1188,17 @@ void RVSSProcessor::DebugRun()
         if (std::find(breakpoints_.begin(), breakpoints_.end(), program_counter_) ==
             breakpoints_.end())
         {
-            Fetch();
-            Decode();
-            Execute();
-            WriteMemory();
-            WriteBack();
+            MaybeCheckpoint();
+            ExecuteDecoded();
             instructions_retired_++;
             cycle_s_++;
             std::cout << "Program Counter: " << program_counter_ << std::endl;
 
             current_delta_.new_pc = program_counter_;
-            // history_.push(current_delta_);
-            undo_stack_.push(current_delta_);
-            while (!redo_stack_.empty())
-            {
-                redo_stack_.pop();
-            }
-            current_delta_ = RVSingleStageStepDelta();
+            history_.push(current_delta_);
+            // clear rather than reassign, so the vectors keep their capacity
+            current_delta_.register_changes.clear();
+            current_delta_.memory_changes.clear();
             if (program_counter_ < program_size_)
             {
                 std::cout << "VM_STEP_COMPLETED" << std::endl;
@@ -1134,29 +1236,21 @@ void RVSSProcessor::DebugRun()
 
 void RVSSProcessor::Step()
 {
+    MaybeCheckpoint();
     current_delta_.old_pc = program_counter_;
     if (program_counter_ < program_size_)
     {
-        Fetch();
-        Decode();
-        Execute();
-        WriteMemory();
-        WriteBack();
+        ExecuteDecoded();
         instructions_retired_++;
         cycle_s_++;
         std::cout << "Program Counter: " << std::hex << program_counter_ << std::dec << std::endl;
 
         current_delta_.new_pc = program_counter_;
 
-        // history_.push(current_delta_);
-
-        undo_stack_.push(current_delta_);
-        while (!redo_stack_.empty())
-        {
-            redo_stack_.pop();
-        }
-
-        current_delta_ = RVSingleStageStepDelta();
+        history_.push(current_delta_);
+        // clear rather than reassign, so the vectors keep their capacity
+        current_delta_.register_changes.clear();
+        current_delta_.memory_changes.clear();
 
         if (program_counter_ < program_size_)
         {
@@ -1182,16 +1276,14 @@ void RVSSProcessor::Step()
 void RVSSProcessor::Undo()
 {
     qInfo() << "Attempting to undo last step in rvss";
-    if (undo_stack_.empty())
+    StepDelta &last = history_scratch_;
+    if (!history_.undo(last))
     {
         std::cout << "VM_NO_MORE_UNDO" << std::endl;
         output_status_ = "VM_NO_MORE_UNDO";
         return;
     }
 
-    StepDelta last = undo_stack_.top();
-    undo_stack_.pop();
-
     for (const auto &change : last.register_changes)
     {
         switch (change.reg_type)
@@ -1223,6 +1315,7 @@ void RVSSProcessor::Undo()
         {
             memory_controller_.writeByte(change.address + i, change.old_bytes_vec[i]);
         }
+        InvalidateDecoded(change.address, change.old_bytes_vec.size());
     }
 
     program_counter_ = last.old_pc;
@@ -1230,8 +1323,6 @@ void RVSSProcessor::Undo()
     cycle_s_--;
     std::cout << "Program Counter: " << program_counter_ << std::endl;
 
-    redo_stack_.push(last);
-
     output_status_ = "VM_UNDO_COMPLETED";
     std::cout << "VM_UNDO_COMPLETED" << std::endl;
 
@@ -1248,15 +1339,13 @@ void RVSSProcessor::Undo()
 void RVSSProcessor::Redo()
 {
     qInfo() << "Attempting to redo last undone step in rvss";
-    if (redo_stack_.empty())
+    StepDelta &next = history_scratch_;
+    if (!history_.redo(next))
     {
         std::cout << "VM_NO_MORE_REDO" << std::endl;
         return;
     }
 
-    StepDelta next = redo_stack_.top();
-    redo_stack_.pop();
-
     // if (!history_.can_redo()) {
     //       std::cout << "Nothing to redo.\n";
     //       return;
@@ -1295,6 +1384,7 @@ void RVSSProcessor::Redo()
         {
             memory_controller_.writeByte(change.address + i, change.new_bytes_vec[i]);
         }
+        InvalidateDecoded(change.address, change.new_bytes_vec.size());
     }
 
     program_counter_ = next.new_pc;
@@ -1303,7 +1393,6 @@ void RVSSProcessor::Redo()
     DumpRegisters(globals::registers_dump_file_path, registers_);
     DumpState(globals::vm_state_dump_file_path);
     std::cout << "Program Counter: " << program_counter_ << std::endl;
-    undo_stack_.push(next);
 
     SetActiveWireNames();
     setProcessorState();
@@ -1334,7 +1423,34 @@ void RVSSProcessor::Reset()
     current_delta_.memory_changes.clear();
     current_delta_.old_pc = 0;
     current_delta_.new_pc = 0;
-    undo_stack_ = std::stack<StepDelta>();
-    redo_stack_ = std::stack<StepDelta>();
+    history_.clear();
+    ClearCheckpoints();
+    // memory was wiped along with the text section
+    InvalidateDecoded(0, decoded_instructions_.size() * 4);
+}
+
+void RVSSProcessor::ReplayCycle()
+{
+    // Step() without the dumps; the undo history is rebuilt along the way
+    MaybeCheckpoint();
+    last_executed_pc_ = program_counter_;
+    current_delta_.old_pc = program_counter_;
+    ExecuteDecoded();
+    instructions_retired_++;
+    cycle_s_++;
+    current_delta_.new_pc = program_counter_;
+    history_.push(current_delta_);
+    current_delta_.register_changes.clear();
+    current_delta_.memory_changes.clear();
+}
+
+void RVSSProcessor::LoadCheckpointState([[maybe_unused]] const std::vector<uint8_t> &state,
+                                        [[maybe_unused]] size_t &offset)
+{
+    current_delta_.register_changes.clear();
+    current_delta_.memory_changes.clear();
+    history_.clear();
+    // the text section may differ from the one that was translated
+    InvalidateDecoded(0, decoded_instructions_.size() * 4);
 }
 }//namespaace Kites
@@ -8,15 +8,17 @@
 
 #include "processor/processor_base.h"
 #include "processor/processor_manager.h"
+#include "processor/step_history.h"
+#include "rvss_basic_block.h"
 #include "rvss_control_unit.h"
+#include "rvss_decoded_instruction.h"
 
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <stack>
 #include <vector>
 
-
-// TODO: use a circular buffer instead of a stack for undo/redo
 namespace Kites
 {
 struct RVSingleStageStepDelta : public StepDelta
@@ -47,12 +49,28 @@ class RVSSProcessor : public ProcessorBase
     uint64_t csr_write_val_{};
     uint8_t csr_uimm_{};
 
-    std::stack<StepDelta> undo_stack_;
-    std::stack<StepDelta> redo_stack_;
+    // bounded by vm_config undo_history_depth / undo_history_memory_cap
+    StepHistory history_;
+    // decode target for undo/redo, kept so its vectors are reused
+    StepDelta history_scratch_;
+    // false while running headless: nothing is captured for undo
+    bool record_history_ = true;
 
     RVSingleStageStepDelta current_delta_;
 
-    void Fetch();
+    // predecoded instructions of the text section, indexed by pc / 4
+    std::vector<RVSSDecodedInstruction> decoded_instructions_;
+    // holds the record for a pc outside the predecoded range
+    RVSSDecodedInstruction scratch_decoded_;
+
+    // every block FastRun has allocated; only a flush frees them. Invalidated blocks are reused
+    // for other pcs, so a chain link may point at a dead or repurposed block: ExecuteBlock only
+    // follows it when the target is valid and starts at the pc reached
+    std::vector<std::unique_ptr<RVSSBasicBlock>> basic_blocks_;
+    // invalidated blocks, reused by the next translations
+    std::vector<RVSSBasicBlock *> free_blocks_;
+    // valid block starting at pc / 4, if one has been translated
+    std::vector<RVSSBasicBlock *> block_map_;
 
     void Decode();
 
@@ -71,10 +89,63 @@ class RVSSProcessor : public ProcessorBase
     void WriteBackDouble();
     void WriteBackCsr();
 
+    RVSSDecodedInstruction DecodeInstruction(uint32_t instruction);
+    void PredecodeProgram();
+    const RVSSDecodedInstruction &LookupDecoded(uint64_t pc, uint32_t instruction);
+    /**
+     * @brief Drops the predecoded records overlapping [address, address + size), if any.
+     * Must be called for every write that can land in the text section.
+     */
+    virtual void InvalidateDecoded(uint64_t address, uint64_t size);
+    /**
+     * @brief Fetches and executes one instruction through the predecoded cache, recording it
+     * for undo/redo when record_history_ is set.
+     */
+    void ExecuteDecoded();
+
+    RVSSBasicBlock *TranslateBlock(uint64_t pc);
+    /**
+     * @brief Returns the valid block starting at pc, translating it on first use.
+     * Returns nullptr for a pc that is misaligned or outside the text section.
+     */
+    RVSSBasicBlock *LookupBlock(uint64_t pc);
+    void InvalidateBlocks(uint64_t address, uint64_t size);
+    void FlushBlocks();
+    /**
+     * @brief Executes a whole block through the predecoded handlers and returns its
+     * successor, following the chain links where possible.
+     */
+    RVSSBasicBlock *ExecuteBlock(RVSSBasicBlock &block);
+
+    // writes from the handlers, added to current_delta_ while history is recorded
+    void WriteGprRecorded(uint8_t rd, uint64_t value);
+    void WriteFprRecorded(uint8_t rd, uint64_t value);
+    /**
+     * @brief Stores the low @p size bytes of @p value through the data cache and drops the
+     * predecoded records they overwrite.
+     */
+    void StoreRecorded(uint64_t address, uint64_t value, unsigned int size);
+
+    // handlers dispatched from RVSSDecodedInstruction::handler
+    void OpAlu(const RVSSDecodedInstruction &decoded);
+    void OpLui(const RVSSDecodedInstruction &decoded);
+    void OpAuipc(const RVSSDecodedInstruction &decoded);
+    void OpJal(const RVSSDecodedInstruction &decoded);
+    void OpJalr(const RVSSDecodedInstruction &decoded);
+    void OpBranch(const RVSSDecodedInstruction &decoded);
+    void OpLoad(const RVSSDecodedInstruction &decoded);
+    void OpStore(const RVSSDecodedInstruction &decoded);
+    void OpFloat(const RVSSDecodedInstruction &decoded);
+    void OpDouble(const RVSSDecodedInstruction &decoded);
+    void OpFallback(const RVSSDecodedInstruction &decoded);
+
     RVSSProcessor();
     ~RVSSProcessor();
 
+    void LoadProgram(const AssembledProgram &program) override;
+
     void Run() override;
+    void FastRun() override;
     void DebugRun() override;
     void Step() override;
     void Undo() override;
@@ -84,6 +155,17 @@ class RVSSProcessor : public ProcessorBase
     void SetActiveWireNames() override;
     void setProcessorState() override;
 
+    /**
+     * @brief Re-executes one instruction exactly as Step() does, so caches see the same
+     * accesses, but without dumping state after it.
+     */
+    void ReplayCycle() override;
+    /**
+     * @brief Nothing beyond ProcessorBase is checkpointed; undo history and translations of the
+     * replaced state are dropped.
+     */
+    void LoadCheckpointState(const std::vector<uint8_t> &state, size_t &offset) override;
+
     void PrintType()
     {
         std::cout << "rvssvm" << std::endl;
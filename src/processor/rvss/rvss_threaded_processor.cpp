@@ -0,0 +1,664 @@
+/**
+ * @file rvss_threaded_processor.cpp
+ * @brief Threaded-code interpreter of RVSSThreadedProcessor.
+ *
+ * Each handler below mirrors the corresponding RVSSProcessor::Op* handler, operating on a
+ * local copy of the register file. Control only leaves the interpreter loop to go through
+ * the regular decoded path (syscalls, CSR accesses, misaligned pcs), to honour a pause or
+ * stop request, or when a breakpoint is reached. Pause and stop requests are polled on
+ * control transfers only, so straight-line code never touches the atomics.
+ */
+
+#include "processor/rvss/rvss_threaded_processor.h"
+
+#include "common/globals.h"
+#include "utils/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+#if defined(__GNUC__)
+#define KITES_COMPUTED_GOTO 1
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic" // labels as values
+#endif
+
+namespace Kites
+{
+RVSSThreadedProcessor::RVSSThreadedProcessor() : RVSSProcessor()
+{
+}
+
+RVSSThreadedProcessor::~RVSSThreadedProcessor() = default;
+
+RVSSThreadedProcessor::ThreadedInstruction
+RVSSThreadedProcessor::Translate(const RVSSDecodedInstruction &decoded) const
+{
+    using alu::AluOp;
+
+    ThreadedInstruction threaded;
+    threaded.imm = decoded.imm;
+    threaded.alu_op = decoded.alu_op;
+    threaded.rd = decoded.rd == 0 ? kSinkRegister : decoded.rd;
+    threaded.rs1 = decoded.rs1;
+    threaded.rs2 = decoded.rs2;
+
+    if (decoded.handler == &RVSSProcessor::OpAlu && !decoded.alu_src)
+    {
+        switch (decoded.alu_op)
+        {
+        case AluOp::ADD: threaded.op = ThreadedOp::Add; break;
+        case AluOp::SUB: threaded.op = ThreadedOp::Sub; break;
+        case AluOp::AND: threaded.op = ThreadedOp::And; break;
+        case AluOp::OR: threaded.op = ThreadedOp::Or; break;
+        case AluOp::XOR: threaded.op = ThreadedOp::Xor; break;
+        case AluOp::SLL: threaded.op = ThreadedOp::Sll; break;
+        case AluOp::SRL: threaded.op = ThreadedOp::Srl; break;
+        case AluOp::SRA: threaded.op = ThreadedOp::Sra; break;
+        case AluOp::SLT: threaded.op = ThreadedOp::Slt; break;
+        case AluOp::SLTU: threaded.op = ThreadedOp::Sltu; break;
+        case AluOp::MUL: threaded.op = ThreadedOp::Mul; break;
+        default: threaded.op = ThreadedOp::Alu; break;
+        }
+    }
+    else if (decoded.handler == &RVSSProcessor::OpAlu)
+    {
+        switch (decoded.alu_op)
+        {
+        case AluOp::ADD: threaded.op = ThreadedOp::Addi; break;
+        case AluOp::AND: threaded.op = ThreadedOp::Andi; break;
+        case AluOp::OR: threaded.op = ThreadedOp::Ori; break;
+        case AluOp::XOR: threaded.op = ThreadedOp::Xori; break;
+        case AluOp::SLL: threaded.op = ThreadedOp::Slli; break;
+        case AluOp::SRL:
+        case AluOp::SRLI: threaded.op = ThreadedOp::Srli; break;
+        case AluOp::SRA:
+        case AluOp::SRAI: threaded.op = ThreadedOp::Srai; break;
+        case AluOp::SLT: threaded.op = ThreadedOp::Slti; break;
+        case AluOp::SLTU: threaded.op = ThreadedOp::Sltiu; break;
+        default: threaded.op = ThreadedOp::AluImm; break;
+        }
+    }
+    else if (decoded.handler == &RVSSProcessor::OpLui)
+    {
+        threaded.op = ThreadedOp::Lui;
+    }
+    else if (decoded.handler == &RVSSProcessor::OpAuipc)
+    {
+        threaded.op = ThreadedOp::Auipc;
+    }
+    else if (decoded.handler == &RVSSProcessor::OpJal)
+    {
+        threaded.op = ThreadedOp::Jal;
+    }
+    else if (decoded.handler == &RVSSProcessor::OpJalr)
+    {
+        threaded.op = ThreadedOp::Jalr;
+    }
+    else if (decoded.handler == &RVSSProcessor::OpBranch)
+    {
+        // the branch condition only depends on funct3; reserved encodings keep the fallback
+        static constexpr std::array<ThreadedOp, 8> kBranchOps = {
+            ThreadedOp::Beq, ThreadedOp::Bne, ThreadedOp::Fallback, ThreadedOp::Fallback,
+            ThreadedOp::Blt, ThreadedOp::Bge, ThreadedOp::Bltu, ThreadedOp::Bgeu};
+        threaded.op = kBranchOps[decoded.funct3];
+    }
+    else if (decoded.handler == &RVSSProcessor::OpLoad)
+    {
+        static constexpr std::array<ThreadedOp, 8> kLoadOps = {
+            ThreadedOp::Lb, ThreadedOp::Lh, ThreadedOp::Lw, ThreadedOp::Ld,
+            ThreadedOp::Lbu, ThreadedOp::Lhu, ThreadedOp::Lwu, ThreadedOp::Fallback};
+        threaded.op = kLoadOps[decoded.funct3];
+    }
+    else if (decoded.handler == &RVSSProcessor::OpStore)
+    {
+        static constexpr std::array<ThreadedOp, 8> kStoreOps = {
+            ThreadedOp::Sb, ThreadedOp::Sh, ThreadedOp::Sw, ThreadedOp::Sd,
+            ThreadedOp::Fallback, ThreadedOp::Fallback, ThreadedOp::Fallback,
+            ThreadedOp::Fallback};
+        threaded.op = kStoreOps[decoded.funct3];
+    }
+    else if (decoded.handler == &RVSSProcessor::OpFloat)
+    {
+        threaded.op = ThreadedOp::Float;
+    }
+    else if (decoded.handler == &RVSSProcessor::OpDouble)
+    {
+        threaded.op = ThreadedOp::Double;
+    }
+    else
+    {
+        threaded.op = ThreadedOp::Fallback;
+    }
+    return threaded;
+}
+
+void RVSSThreadedProcessor::TranslateProgram()
+{
+    const size_t count = program_size_ / 4;
+    decoded_instructions_.resize(count);
+    threaded_code_.assign(count + 1, ThreadedInstruction());
+    for (size_t i = 0; i < count; ++i)
+    {
+        // memory is authoritative: pick up anything written behind the processor's back
+        const uint32_t instruction = memory_controller_.readWord_d(i * 4);
+        RVSSDecodedInstruction &decoded = decoded_instructions_[i];
+        if (decoded.handler == nullptr || decoded.instruction != instruction)
+        {
+            decoded = DecodeInstruction(instruction);
+        }
+        threaded_code_[i] = Translate(decoded);
+    }
+    threaded_code_[count].op = ThreadedOp::End;
+
+    for (uint64_t breakpoint : breakpoints_)
+    {
+        if ((breakpoint & 0b11) == 0 && (breakpoint >> 2) < count)
+        {
+            threaded_code_[breakpoint >> 2].breakpoint = true;
+        }
+    }
+}
+
+void RVSSThreadedProcessor::InvalidateDecoded(uint64_t address, uint64_t size)
+{
+    RVSSProcessor::InvalidateDecoded(address, size);
+
+    const uint64_t text_end = decoded_instructions_.size() * 4;
+    if (address >= text_end || size == 0 || threaded_code_.size() != decoded_instructions_.size() + 1)
+    {
+        return;
+    }
+    const uint64_t last = std::min(address + size - 1, text_end - 1);
+    for (uint64_t index = address >> 2; index <= (last >> 2); ++index)
+    {
+        ThreadedInstruction &entry = threaded_code_[index];
+        entry.op = ThreadedOp::Retranslate;
+        // a breakpoint entry keeps its target and dispatches on op once it is passed
+        if (!entry.breakpoint && threaded_handlers_ != nullptr)
+        {
+            entry.target = threaded_handlers_[static_cast<size_t>(ThreadedOp::Retranslate)];
+        }
+    }
+}
+
+void RVSSThreadedProcessor::FastRun()
+{
+    ClearStop();
+    history_.clear();
+    record_history_ = false;
+
+    // the interpreter talks to main memory directly, so nothing may be left dirty in a cache
+    memory_controller_.flushCaches();
+    TranslateProgram();
+
+#ifdef KITES_COMPUTED_GOTO
+    // must list a label for every ThreadedOp, in declaration order
+    static const void *const kHandlers[] = {
+        &&op_Add, &&op_Sub, &&op_And, &&op_Or, &&op_Xor, &&op_Sll, &&op_Srl, &&op_Sra,
+        &&op_Slt, &&op_Sltu, &&op_Mul, &&op_Alu,
+        &&op_Addi, &&op_Andi, &&op_Ori, &&op_Xori, &&op_Slli, &&op_Srli, &&op_Srai,
+        &&op_Slti, &&op_Sltiu, &&op_AluImm,
+        &&op_Lui, &&op_Auipc, &&op_Jal, &&op_Jalr,
+        &&op_Beq, &&op_Bne, &&op_Blt, &&op_Bge, &&op_Bltu, &&op_Bgeu,
+        &&op_Lb, &&op_Lh, &&op_Lw, &&op_Ld, &&op_Lbu, &&op_Lhu, &&op_Lwu,
+        &&op_Sb, &&op_Sh, &&op_Sw, &&op_Sd,
+        &&op_Float, &&op_Double, &&op_Fallback, &&op_Retranslate, &&op_End};
+    static_assert(std::size(kHandlers) == static_cast<size_t>(ThreadedOp::OpCount),
+                  "kHandlers out of sync with ThreadedOp");
+    for (ThreadedInstruction &entry : threaded_code_)
+    {
+        entry.target = entry.breakpoint ? &&op_Breakpoint : kHandlers[static_cast<size_t>(entry.op)];
+    }
+    threaded_handlers_ = kHandlers;
+#endif
+
+    // x[32] absorbs writes to x0
+    std::array<uint64_t, kSinkRegister + 1> x{};
+    std::array<uint64_t, 32> f{};
+    const auto syncIn = [&]()
+    {
+        for (uint8_t i = 0; i < 32; ++i)
+        {
+            x[i] = registers_.ReadGpr(i);
+            f[i] = registers_.ReadFpr(i);
+        }
+    };
+    const auto syncOut = [&]()
+    {
+        // only write what changed, every write is a signal
+        for (uint8_t i = 1; i < 32; ++i)
+        {
+            if (registers_.ReadGpr(i) != x[i])
+            {
+                registers_.WriteGpr(i, x[i]);
+            }
+        }
+        for (uint8_t i = 0; i < 32; ++i)
+        {
+            if (registers_.ReadFpr(i) != f[i])
+            {
+                registers_.WriteFpr(i, f[i]);
+            }
+        }
+    };
+
+    uint64_t pc = program_counter_;
+    const uint64_t text_end = (threaded_code_.size() - 1) * 4;
+    const unsigned int retired_base = instructions_retired_;
+    const unsigned int cycle_base = cycle_s_;
+    unsigned int retired = 0;
+    uint64_t skip_breakpoint_pc = (last_breakpoint_pc_ == pc) ? pc : INVALID_PC;
+    uint64_t checkpoint_cycle = checkpoints_.nextCycle();
+    bool breakpoint_hit = false;
+    bool in_slow_path = false;
+    ThreadedInstruction *code = threaded_code_.data();
+    const ThreadedInstruction *insn = nullptr;
+
+    const auto syncState = [&]()
+    {
+        syncOut();
+        program_counter_ = pc;
+        instructions_retired_ = retired_base + retired;
+        cycle_s_ = cycle_base + retired;
+    };
+
+#ifdef KITES_COMPUTED_GOTO
+#define OP(name) op_##name:
+#define EXECUTE() goto *kHandlers[static_cast<size_t>(insn->op)]
+#define DISPATCH()                                                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        insn = &code[pc >> 2];                                                                     \
+        goto *insn->target;                                                                        \
+    } while (0)
+#else
+#define OP(name) case ThreadedOp::name:
+#define EXECUTE() goto execute
+#define DISPATCH() goto dispatch
+#endif
+// sequential successor: the End sentinel stops a run that falls off the text section
+#define NEXT()                                                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        pc += 4;                                                                                   \
+        ++retired;                                                                                 \
+        DISPATCH();                                                                                \
+    } while (0)
+#define JUMP()                                                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        ++retired;                                                                                 \
+        goto jump;                                                                                 \
+    } while (0)
+#define BRANCH(condition)                                                                          \
+    do                                                                                             \
+    {                                                                                              \
+        if (condition)                                                                             \
+        {                                                                                          \
+            pc += insn->imm;                                                                       \
+            JUMP();                                                                                \
+        }                                                                                          \
+        NEXT();                                                                                    \
+    } while (0)
+
+    syncIn();
+    try
+    {
+        goto jump;
+
+    jump:
+        if (pc >= text_end)
+        {
+            goto finish;
+        }
+        if (pc & 0b11)
+        {
+            goto slow_path;
+        }
+        if (stop_requested_.load(std::memory_order_relaxed) ||
+            pause_requested_.load(std::memory_order_relaxed))
+        {
+            goto poll;
+        }
+        if (cycle_base + retired >= checkpoint_cycle)
+        {
+            goto checkpoint;
+        }
+        DISPATCH();
+
+    checkpoint:
+        syncState();
+        CaptureCheckpoint();
+        checkpoint_cycle = checkpoints_.nextCycle();
+        DISPATCH();
+
+    poll:
+        if (pause_requested_)
+        {
+            syncState();
+            setProcessorState();
+            emit processorClockedSignal(processor_state_);
+            {
+                QMutexLocker locker(&pause_mutex_);
+                while (pause_requested_ && !stop_requested_)
+                {
+                    pause_wait_condition_.wait(&pause_mutex_);
+                }
+            }
+            // the register file may have been edited while paused
+            syncIn();
+        }
+        if (stop_requested_)
+        {
+            goto finish;
+        }
+        DISPATCH();
+
+    slow_path:
+        syncState();
+        in_slow_path = true;
+        RVSSProcessor::ExecuteDecoded();
+        in_slow_path = false;
+        // syscalls and the like went through the caches, hand their writes back to main memory
+        // and drop the lines so the next one sees what the interpreter stores
+        memory_controller_.flushCaches();
+        ++retired;
+        syncIn();
+        pc = program_counter_;
+        goto jump;
+
+#ifdef KITES_COMPUTED_GOTO
+    op_Breakpoint:
+        if (pc != skip_breakpoint_pc)
+        {
+            breakpoint_hit = true;
+            goto finish;
+        }
+        skip_breakpoint_pc = INVALID_PC;
+        EXECUTE();
+#else
+    dispatch:
+        insn = &code[pc >> 2];
+        if (insn->breakpoint)
+        {
+            if (pc != skip_breakpoint_pc)
+            {
+                breakpoint_hit = true;
+                goto finish;
+            }
+            skip_breakpoint_pc = INVALID_PC;
+        }
+    execute:
+        switch (insn->op)
+        {
+#endif
+
+        OP(Add) { x[insn->rd] = x[insn->rs1] + x[insn->rs2]; NEXT(); }
+        OP(Sub) { x[insn->rd] = x[insn->rs1] - x[insn->rs2]; NEXT(); }
+        OP(And) { x[insn->rd] = x[insn->rs1] & x[insn->rs2]; NEXT(); }
+        OP(Or) { x[insn->rd] = x[insn->rs1] | x[insn->rs2]; NEXT(); }
+        OP(Xor) { x[insn->rd] = x[insn->rs1] ^ x[insn->rs2]; NEXT(); }
+        OP(Sll) { x[insn->rd] = x[insn->rs1] << (x[insn->rs2] & 63); NEXT(); }
+        OP(Srl) { x[insn->rd] = x[insn->rs1] >> (x[insn->rs2] & 63); NEXT(); }
+        OP(Sra)
+        {
+            x[insn->rd] = static_cast<uint64_t>(static_cast<int64_t>(x[insn->rs1]) >>
+                                                (x[insn->rs2] & 63));
+            NEXT();
+        }
+        OP(Slt)
+        {
+            x[insn->rd] = static_cast<int64_t>(x[insn->rs1]) < static_cast<int64_t>(x[insn->rs2]);
+            NEXT();
+        }
+        OP(Sltu) { x[insn->rd] = x[insn->rs1] < x[insn->rs2]; NEXT(); }
+        OP(Mul) { x[insn->rd] = x[insn->rs1] * x[insn->rs2]; NEXT(); } // low half is sign-agnostic
+        OP(Alu)
+        {
+            x[insn->rd] = alu::Alu::execute(insn->alu_op, x[insn->rs1], x[insn->rs2]).first;
+            NEXT();
+        }
+
+        OP(Addi) { x[insn->rd] = x[insn->rs1] + static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Andi) { x[insn->rd] = x[insn->rs1] & static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Ori) { x[insn->rd] = x[insn->rs1] | static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Xori) { x[insn->rd] = x[insn->rs1] ^ static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Slli) { x[insn->rd] = x[insn->rs1] << (insn->imm & 63); NEXT(); }
+        OP(Srli) { x[insn->rd] = x[insn->rs1] >> (insn->imm & 63); NEXT(); }
+        OP(Srai)
+        {
+            x[insn->rd] = static_cast<uint64_t>(static_cast<int64_t>(x[insn->rs1]) >> (insn->imm & 63));
+            NEXT();
+        }
+        OP(Slti) { x[insn->rd] = static_cast<int64_t>(x[insn->rs1]) < insn->imm; NEXT(); }
+        OP(Sltiu) { x[insn->rd] = x[insn->rs1] < static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(AluImm)
+        {
+            x[insn->rd] =
+                alu::Alu::execute(insn->alu_op, x[insn->rs1], static_cast<uint64_t>(insn->imm)).first;
+            NEXT();
+        }
+
+        OP(Lui) { x[insn->rd] = static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Auipc) { x[insn->rd] = pc + static_cast<uint64_t>(insn->imm); NEXT(); }
+        OP(Jal)
+        {
+            x[insn->rd] = pc + 4;
+            pc += insn->imm;
+            JUMP();
+        }
+        OP(Jalr)
+        {
+            // no &~1, matching RVSSProcessor
+            const uint64_t target = x[insn->rs1] + static_cast<uint64_t>(insn->imm);
+            x[insn->rd] = pc + 4;
+            pc = target;
+            JUMP();
+        }
+
+        OP(Beq) { BRANCH(x[insn->rs1] == x[insn->rs2]); }
+        OP(Bne) { BRANCH(x[insn->rs1] != x[insn->rs2]); }
+        OP(Blt) { BRANCH(static_cast<int64_t>(x[insn->rs1]) < static_cast<int64_t>(x[insn->rs2])); }
+        OP(Bge) { BRANCH(static_cast<int64_t>(x[insn->rs1]) >= static_cast<int64_t>(x[insn->rs2])); }
+        OP(Bltu) { BRANCH(x[insn->rs1] < x[insn->rs2]); }
+        OP(Bgeu) { BRANCH(x[insn->rs1] >= x[insn->rs2]); }
+
+#define LOAD(type, read)                                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        const uint64_t address = x[insn->rs1] + static_cast<uint64_t>(insn->imm);                \
+        x[insn->rd] = static_cast<uint64_t>(static_cast<type>(memory_controller_.read(address)));  \
+        NEXT();                                                                                    \
+    } while (0)
+        OP(Lb) { LOAD(int8_t, readByte_d); }
+        OP(Lh) { LOAD(int16_t, readHalfWord_d); }
+        OP(Lw) { LOAD(int32_t, readWord_d); }
+        OP(Ld) { LOAD(uint64_t, readDoubleWord_d); }
+        OP(Lbu) { LOAD(uint8_t, readByte_d); }
+        OP(Lhu) { LOAD(uint16_t, readHalfWord_d); }
+        OP(Lwu) { LOAD(uint32_t, readWord_d); }
+#undef LOAD
+
+#define STORE(type, write)                                                                         \
+    do                                                                                             \
+    {                                                                                              \
+        const uint64_t address = x[insn->rs1] + static_cast<uint64_t>(insn->imm);                \
+        memory_controller_.write(address, static_cast<type>(x[insn->rs2]));                        \
+        if (address < text_end)                                                                    \
+        {                                                                                          \
+            InvalidateDecoded(address, sizeof(type));                                              \
+        }                                                                                          \
+        NEXT();                                                                                    \
+    } while (0)
+        OP(Sb) { STORE(uint8_t, writeByteQuiet_d); }
+        OP(Sh) { STORE(uint16_t, writeHalfWordQuiet_d); }
+        OP(Sw) { STORE(uint32_t, writeWordQuiet_d); }
+        OP(Sd) { STORE(uint64_t, writeDoubleWordQuiet_d); }
+#undef STORE
+
+        OP(Float)
+        {
+            const RVSSDecodedInstruction &decoded = decoded_instructions_[pc >> 2];
+            uint8_t rm = decoded.funct3;
+            if (rm == 0b111)
+            {
+                rm = registers_.ReadCsr(0x002);
+            }
+            uint64_t reg1_value = f[decoded.rs1];
+            uint64_t reg2_value = decoded.alu_src ? static_cast<uint64_t>(decoded.imm) : f[decoded.rs2];
+            if (decoded.funct7 == 0b1101000 || decoded.funct7 == 0b1111000 ||
+                decoded.opcode == 0b0000111 || decoded.opcode == 0b0100111)
+            {
+                reg1_value = x[decoded.rs1];
+            }
+            const auto [result, fcsr_status] =
+                alu::Alu::fpexecute(decoded.alu_op, reg1_value, reg2_value, f[decoded.rs3], rm);
+            registers_.WriteCsr(0x003, fcsr_status);
+
+            if (decoded.mem_read)
+            { // FLW
+                f[decoded.rd] = memory_controller_.readWord_d(result);
+            }
+            else if (decoded.mem_write)
+            { // FSW
+                memory_controller_.writeWordQuiet_d(result, f[decoded.rs2] & 0xFFFFFFFF);
+                if (result < text_end)
+                {
+                    InvalidateDecoded(result, 4);
+                }
+            }
+            else if (decoded.reg_write)
+            {
+                if (decoded.funct7 == 0b1010000 || decoded.funct7 == 0b1100000 ||
+                    decoded.funct7 == 0b1110000)
+                { // f(eq|lt|le).s, fcvt.(w|wu|l|lu).s
+                    x[decoded.rd == 0 ? kSinkRegister : decoded.rd] = result;
+                }
+                else
+                {
+                    f[decoded.rd] = result;
+                }
+            }
+            NEXT();
+        }
+        OP(Double)
+        {
+            const RVSSDecodedInstruction &decoded = decoded_instructions_[pc >> 2];
+            uint64_t reg1_value = f[decoded.rs1];
+            uint64_t reg2_value = decoded.alu_src ? static_cast<uint64_t>(decoded.imm) : f[decoded.rs2];
+            if (decoded.funct7 == 0b1101001 || decoded.funct7 == 0b1111001 ||
+                decoded.opcode == 0b0000111 || decoded.opcode == 0b0100111)
+            {
+                reg1_value = x[decoded.rs1];
+            }
+            const uint64_t result = alu::Alu::dfpexecute(decoded.alu_op, reg1_value, reg2_value,
+                                                         f[decoded.rs3], decoded.funct3)
+                                        .first;
+
+            if (decoded.mem_read)
+            { // FLD
+                f[decoded.rd] = memory_controller_.readDoubleWord_d(result);
+            }
+            else if (decoded.mem_write)
+            { // FSD
+                memory_controller_.writeDoubleWordQuiet_d(result, f[decoded.rs2]);
+                if (result < text_end)
+                {
+                    InvalidateDecoded(result, 8);
+                }
+            }
+            else if (decoded.reg_write)
+            {
+                if (decoded.funct7 == 0b1010001 || decoded.funct7 == 0b1100001 ||
+                    decoded.funct7 == 0b1110001)
+                { // f(eq|lt|le).d, fcvt.(w|wu|l|lu).d
+                    x[decoded.rd == 0 ? kSinkRegister : decoded.rd] = result;
+                }
+                else
+                {
+                    f[decoded.rd] = result;
+                }
+            }
+            NEXT();
+        }
+
+        OP(Fallback) { goto slow_path; }
+        OP(Retranslate)
+        {
+            const size_t index = pc >> 2;
+            decoded_instructions_[index] = DecodeInstruction(memory_controller_.readWord_d(pc));
+            const bool breakpoint = code[index].breakpoint;
+            code[index] = Translate(decoded_instructions_[index]);
+            code[index].breakpoint = breakpoint;
+#ifdef KITES_COMPUTED_GOTO
+            code[index].target =
+                breakpoint ? &&op_Breakpoint : kHandlers[static_cast<size_t>(code[index].op)];
+#endif
+            EXECUTE();
+        }
+        OP(End) { goto finish; }
+
+#ifndef KITES_COMPUTED_GOTO
+        default:
+            goto finish;
+        }
+#endif
+
+    finish:
+        // a stop resets the processor from the requesting thread, there is nothing to write back
+        if (!stop_requested_)
+        {
+            syncState();
+        }
+    }
+    catch (...)
+    {
+        // leave the state where RVSSProcessor would: registers written so far, pc past the faulting
+        // instruction
+        threaded_handlers_ = nullptr;
+        record_history_ = true;
+        memory_controller_.notifyMemoryChanged();
+        if (!in_slow_path)
+        {
+            syncState();
+            program_counter_ = pc + 4;
+        }
+        throw;
+    }
+    threaded_handlers_ = nullptr;
+    record_history_ = true;
+    // stores did not signal one by one
+    memory_controller_.notifyMemoryChanged();
+
+#undef OP
+#undef EXECUTE
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+#undef BRANCH
+
+    if (breakpoint_hit)
+    {
+        last_breakpoint_pc_ = pc;
+        std::cout << "VM_BREAKPOINT_HIT " << pc << std::endl;
+        output_status_ = "VM_BREAKPOINT_HIT";
+        emit processorPausedAtBreakpointSignal();
+    }
+    else if (program_counter_ >= program_size_)
+    {
+        std::cout << "VM_PROGRAM_END" << std::endl;
+        output_status_ = "VM_PROGRAM_END";
+    }
+    setProcessorState();
+    emit processorClockedSignal(processor_state_);
+    DumpRegisters(globals::registers_dump_file_path, registers_);
+    DumpState(globals::vm_state_dump_file_path);
+}
+}//namespace Kites
+
+#ifdef KITES_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#undef KITES_COMPUTED_GOTO
+#endif
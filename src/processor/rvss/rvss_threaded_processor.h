@@ -0,0 +1,87 @@
+/**
+ * @file rvss_threaded_processor.h
+ * @brief Single cycle processor with a threaded-code interpreter for FastRun
+ */
+#ifndef RVSS_THREADED_PROCESSOR_H
+#define RVSS_THREADED_PROCESSOR_H
+
+#include "processor/rvss/rvss_processor.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief RV64IMFD single cycle processor whose FastRun() goes through a direct-threaded
+ * interpreter.
+ *
+ * Stepping, Run(), undo/redo and the circuit view are inherited from RVSSProcessor unchanged,
+ * so the GUI still animates a run instruction by instruction.
+ * A run translates the predecoded text section into threaded code, keeps the register
+ * file in locals and dispatches straight from one handler to the next (computed goto
+ * where the compiler supports it, a switch otherwise). The architectural results are
+ * bit-identical to RVSSProcessor.
+ *
+ * The run is functional only: caches are flushed before it starts and data accesses go
+ * straight to main memory, so cache statistics do not advance while it runs. Instructions left
+ * to RVSSProcessor (syscalls, CSR accesses) go through the caches, which are flushed again after
+ * each of them. Stores are not signalled one by one, views are told to reload once the run
+ * ends.
+ */
+class RVSSThreadedProcessor : public RVSSProcessor
+{
+  public:
+    enum class ThreadedOp : uint8_t
+    {
+        Add, Sub, And, Or, Xor, Sll, Srl, Sra, Slt, Sltu, Mul,
+        Alu,    // any other register-register ALU op, through alu::Alu::execute
+        Addi, Andi, Ori, Xori, Slli, Srli, Srai, Slti, Sltiu,
+        AluImm, // any other register-immediate ALU op
+        Lui, Auipc, Jal, Jalr,
+        Beq, Bne, Blt, Bge, Bltu, Bgeu,
+        Lb, Lh, Lw, Ld, Lbu, Lhu, Lwu,
+        Sb, Sh, Sw, Sd,
+        Float,       // RV64F, operands taken from the predecoded record
+        Double,      // RV64D, operands taken from the predecoded record
+        Fallback,    // executed through RVSSProcessor::ExecuteDecoded
+        Retranslate, // the text under this entry was written since it was translated
+        End,         // sentinel one past the last instruction
+
+        OpCount
+    };
+
+    // x0 is never written: instructions targeting it write this slot instead
+    static constexpr uint8_t kSinkRegister = 32;
+
+    struct ThreadedInstruction
+    {
+        const void *target{nullptr}; // handler address when dispatching with computed goto
+        int64_t imm{};
+        alu::AluOp alu_op{alu::AluOp::NONE};
+        ThreadedOp op{ThreadedOp::Fallback};
+        uint8_t rd{};
+        uint8_t rs1{};
+        uint8_t rs2{};
+        bool breakpoint{};
+    };
+
+    // threaded code of the text section, indexed by pc / 4, plus the End sentinel
+    std::vector<ThreadedInstruction> threaded_code_;
+    // handler table of the run in progress, used to retarget entries on invalidation
+    const void *const *threaded_handlers_{nullptr};
+
+    RVSSThreadedProcessor();
+    ~RVSSThreadedProcessor();
+
+    ThreadedInstruction Translate(const RVSSDecodedInstruction &decoded) const;
+    /**
+     * @brief Rebuilds the threaded code from the text section and the current breakpoints.
+     */
+    void TranslateProgram();
+    void InvalidateDecoded(uint64_t address, uint64_t size) override;
+
+    void FastRun() override;
+};
+}//namespace Kites
+#endif // RVSS_THREADED_PROCESSOR_H
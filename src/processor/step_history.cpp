@@ -0,0 +1,278 @@
+/**
+ * @file step_history.cpp
+ * @brief Packed encoding and ring management of StepHistory.
+ *
+ * Record layout, all fields unaligned and host endian:
+ *   u64 old_pc, u64 new_pc, 4 x (u32 old, u32 new) counters, u32 register count, u32 memory count
+ *   per register change: u16 index, u8 type, u64 old value, u64 new value
+ *   per memory change:   u64 address, u32 length, length old bytes, length new bytes
+ */
+
+#include "processor/step_history.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Kites
+{
+namespace
+{
+constexpr size_t kHeaderSize = 2 * sizeof(uint64_t) + 8 * sizeof(uint32_t) + 2 * sizeof(uint32_t);
+constexpr size_t kRegisterChangeSize = sizeof(uint16_t) + sizeof(uint8_t) + 2 * sizeof(uint64_t);
+constexpr size_t kMemoryChangeHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+template <typename T>
+uint8_t *put(uint8_t *out, T value)
+{
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+template <typename T>
+const uint8_t *get(const uint8_t *in, T &value)
+{
+    std::memcpy(&value, in, sizeof(T));
+    return in + sizeof(T);
+}
+} // namespace
+
+StepHistory::StepHistory(size_t maxDepth, size_t memoryCap)
+{
+    configure(maxDepth, memoryCap);
+}
+
+void StepHistory::configure(size_t maxDepth, size_t memoryCap)
+{
+    m_maxDepth = maxDepth;
+    m_memoryCap = memoryCap;
+    // push allocates both at the new size
+    m_records = std::vector<Record>();
+    m_arena = std::vector<uint8_t>();
+    clear();
+}
+
+void StepHistory::clear()
+{
+    m_oldest = 0;
+    m_count = 0;
+    m_current = 0;
+    m_head = 0;
+}
+
+size_t StepHistory::bytesUsed() const
+{
+    size_t used = 0;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        used += record(i).size;
+    }
+    return used;
+}
+
+size_t StepHistory::encodedSize(const StepDelta &delta)
+{
+    size_t size = kHeaderSize + delta.register_changes.size() * kRegisterChangeSize;
+    for (const MemoryChange &change : delta.memory_changes)
+    {
+        size += kMemoryChangeHeaderSize + change.old_bytes_vec.size() + change.new_bytes_vec.size();
+    }
+    return size;
+}
+
+StepHistory::Record &StepHistory::record(size_t logicalIndex)
+{
+    return m_records[(m_oldest + logicalIndex) % m_records.size()];
+}
+
+const StepHistory::Record &StepHistory::record(size_t logicalIndex) const
+{
+    return m_records[(m_oldest + logicalIndex) % m_records.size()];
+}
+
+void StepHistory::dropOldest()
+{
+    m_oldest = (m_oldest + 1) % m_records.size();
+    --m_count;
+    if (m_current > 0)
+    {
+        --m_current;
+    }
+    if (m_count == 0)
+    {
+        m_head = 0;
+    }
+}
+
+void StepHistory::push(const StepDelta &delta)
+{
+    // whatever could have been redone is gone
+    m_count = m_current;
+    if (m_count == 0)
+    {
+        m_head = 0;
+    }
+    else
+    {
+        const Record &newest = record(m_count - 1);
+        m_head = newest.offset + newest.size;
+    }
+
+    const size_t size = encodedSize(delta);
+    if (m_maxDepth == 0 || size > m_memoryCap)
+    {
+        // this step cannot be undone, so neither can anything before it
+        clear();
+        return;
+    }
+    if (m_arena.empty())
+    {
+        m_records.assign(m_maxDepth, Record{0, 0});
+        m_arena.assign(m_memoryCap, 0);
+    }
+    if (m_count == m_records.size())
+    {
+        dropOldest();
+    }
+
+    // find room for the record at the head, dropping the oldest records until it fits
+    size_t offset = 0;
+    for (;;)
+    {
+        if (m_count == 0)
+        {
+            offset = 0;
+            break;
+        }
+        const size_t oldest = record(0).offset;
+        if (oldest >= m_head)
+        {
+            // free space is [m_head, oldest)
+            if (m_head + size <= oldest)
+            {
+                offset = m_head;
+                break;
+            }
+        }
+        else
+        {
+            // free space is [m_head, end) and [0, oldest)
+            if (m_head + size <= m_arena.size())
+            {
+                offset = m_head;
+                break;
+            }
+            if (size <= oldest)
+            {
+                offset = 0;
+                break;
+            }
+        }
+        dropOldest();
+    }
+
+    uint8_t *out = m_arena.data() + offset;
+    out = put<uint64_t>(out, delta.old_pc);
+    out = put<uint64_t>(out, delta.new_pc);
+    out = put<uint32_t>(out, delta.old_cycle);
+    out = put<uint32_t>(out, delta.new_cycle);
+    out = put<uint32_t>(out, delta.old_instructions_retired);
+    out = put<uint32_t>(out, delta.new_instructions_retired);
+    out = put<uint32_t>(out, delta.old_stall_cycles);
+    out = put<uint32_t>(out, delta.new_stall_cycles);
+    out = put<uint32_t>(out, delta.old_branch_mispredictions);
+    out = put<uint32_t>(out, delta.new_branch_mispredictions);
+    out = put<uint32_t>(out, static_cast<uint32_t>(delta.register_changes.size()));
+    out = put<uint32_t>(out, static_cast<uint32_t>(delta.memory_changes.size()));
+    for (const RegisterChange &change : delta.register_changes)
+    {
+        out = put<uint16_t>(out, static_cast<uint16_t>(change.reg_index));
+        out = put<uint8_t>(out, static_cast<uint8_t>(change.reg_type));
+        out = put<uint64_t>(out, change.old_value);
+        out = put<uint64_t>(out, change.new_value);
+    }
+    for (const MemoryChange &change : delta.memory_changes)
+    {
+        // old and new cover the same bytes; the shorter one bounds what can be restored
+        const uint32_t length = static_cast<uint32_t>(
+            std::min(change.old_bytes_vec.size(), change.new_bytes_vec.size()));
+        out = put<uint64_t>(out, change.address);
+        out = put<uint32_t>(out, length);
+        std::memcpy(out, change.old_bytes_vec.data(), length);
+        out += length;
+        std::memcpy(out, change.new_bytes_vec.data(), length);
+        out += length;
+    }
+
+    record(m_count) = Record{offset, static_cast<size_t>(out - (m_arena.data() + offset))};
+    ++m_count;
+    m_current = m_count;
+    m_head = offset + record(m_count - 1).size;
+}
+
+bool StepHistory::undo(StepDelta &delta)
+{
+    if (m_current == 0)
+    {
+        return false;
+    }
+    --m_current;
+    decode(record(m_current), delta);
+    return true;
+}
+
+bool StepHistory::redo(StepDelta &delta)
+{
+    if (m_current == m_count)
+    {
+        return false;
+    }
+    decode(record(m_current), delta);
+    ++m_current;
+    return true;
+}
+
+void StepHistory::decode(const Record &record, StepDelta &delta) const
+{
+    const uint8_t *in = m_arena.data() + record.offset;
+    uint32_t register_count = 0;
+    uint32_t memory_count = 0;
+    in = get(in, delta.old_pc);
+    in = get(in, delta.new_pc);
+    in = get(in, delta.old_cycle);
+    in = get(in, delta.new_cycle);
+    in = get(in, delta.old_instructions_retired);
+    in = get(in, delta.new_instructions_retired);
+    in = get(in, delta.old_stall_cycles);
+    in = get(in, delta.new_stall_cycles);
+    in = get(in, delta.old_branch_mispredictions);
+    in = get(in, delta.new_branch_mispredictions);
+    in = get(in, register_count);
+    in = get(in, memory_count);
+
+    delta.register_changes.resize(register_count);
+    for (RegisterChange &change : delta.register_changes)
+    {
+        uint16_t index = 0;
+        uint8_t type = 0;
+        in = get(in, index);
+        in = get(in, type);
+        in = get(in, change.old_value);
+        in = get(in, change.new_value);
+        change.reg_index = index;
+        change.reg_type = type;
+    }
+
+    // resize keeps the existing elements, so their byte vectors are reused
+    delta.memory_changes.resize(memory_count);
+    for (MemoryChange &change : delta.memory_changes)
+    {
+        uint32_t length = 0;
+        in = get(in, change.address);
+        in = get(in, length);
+        change.old_bytes_vec.assign(in, in + length);
+        in += length;
+        change.new_bytes_vec.assign(in, in + length);
+        in += length;
+    }
+}
+}//namespace Kites
@@ -0,0 +1,94 @@
+/**
+ * @file step_history.h
+ * @brief Bounded undo/redo history of StepDelta records packed into a fixed arena.
+ */
+#pragma once
+
+#include "processor/processor_base.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Kites
+{
+/**
+ * @brief Undo/redo history with a fixed depth and a fixed memory budget.
+ *
+ * Steps are serialized back to back into a byte arena that is allocated once, and indexed
+ * by a ring of record positions that is also allocated once, both on the first push so a
+ * processor that never records a step pays nothing for them. When either the depth or the
+ * arena runs out, the oldest steps are dropped. Pushing a new step discards everything that
+ * could have been redone. Steps are decoded into a caller-owned StepDelta whose vectors are
+ * reused, so undo and redo do not allocate once they have warmed up.
+ */
+class StepHistory
+{
+  public:
+    StepHistory(size_t maxDepth, size_t memoryCap);
+
+    /**
+     * @brief Resizes the history. Everything recorded so far is dropped.
+     */
+    void configure(size_t maxDepth, size_t memoryCap);
+    void clear();
+
+    void push(const StepDelta &delta);
+    /**
+     * @brief Moves one step back and decodes the step being undone into @p delta.
+     * @return false if there is nothing left to undo.
+     */
+    bool undo(StepDelta &delta);
+    /**
+     * @brief Moves one step forward and decodes the step being redone into @p delta.
+     * @return false if there is nothing left to redo.
+     */
+    bool redo(StepDelta &delta);
+
+    [[nodiscard]] size_t undoDepth() const
+    {
+        return m_current;
+    }
+    [[nodiscard]] size_t redoDepth() const
+    {
+        return m_count - m_current;
+    }
+    [[nodiscard]] size_t maxDepth() const
+    {
+        return m_maxDepth;
+    }
+    [[nodiscard]] size_t memoryCap() const
+    {
+        return m_memoryCap;
+    }
+    // bytes held by the arena and the record ring, zero until the first push
+    [[nodiscard]] size_t bytesAllocated() const
+    {
+        return m_arena.capacity() + m_records.capacity() * sizeof(Record);
+    }
+    [[nodiscard]] size_t bytesUsed() const;
+
+    static size_t encodedSize(const StepDelta &delta);
+
+  private:
+    struct Record
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    Record &record(size_t logicalIndex);
+    const Record &record(size_t logicalIndex) const;
+    void dropOldest();
+    void decode(const Record &record, StepDelta &delta) const;
+
+    size_t m_maxDepth{0};
+    size_t m_memoryCap{0};
+    std::vector<uint8_t> m_arena;  // m_memoryCap bytes once allocated
+    std::vector<Record> m_records; // ring of m_maxDepth once allocated, oldest at m_oldest
+    size_t m_oldest{0};
+    size_t m_count{0};   // records held, including the ones that can be redone
+    size_t m_current{0}; // records that can be undone
+    size_t m_head{0};    // arena offset one past the newest record
+};
+}//namespace Kites
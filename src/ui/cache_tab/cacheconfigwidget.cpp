@@ -16,6 +16,10 @@ CacheConfigWidget::CacheConfigWidget(QWidget *parent)
     ui->missesLineEdit->setReadOnly(true);
     ui->writeBackLineEdit->setReadOnly(true);
     ui->hitrateLineEdit->setReadOnly(true);
+    ui->prefetchAccuracyLineEdit->setReadOnly(true);
+    ui->prefetchCoverageLineEdit->setReadOnly(true);
+    ui->prefetchLateLineEdit->setReadOnly(true);
+    ui->prefetchUselessLineEdit->setReadOnly(true);
 
     ui->customPolicyScriptlineEdit->setReadOnly(true);
 
@@ -30,10 +34,17 @@ CacheConfigWidget::CacheConfigWidget(QWidget *parent)
             &CacheConfigWidget::configChangedSignal);
     connect(ui->writeMissComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
             &CacheConfigWidget::configChangedSignal);
+    connect(ui->prefetcherComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &CacheConfigWidget::configChangedSignal);
+    connect(ui->prefetchDegreeSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &CacheConfigWidget::configChangedSignal);
+    connect(ui->prefetchDistanceSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &CacheConfigWidget::configChangedSignal);
     connect(ui->repPolComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
     [this]
     {
-        if (ui->repPolComboBox->currentData().value<ReplacementPolicy>() == 
+        // the items follow the ReplacementPolicy order, like the other combo boxes
+        if (static_cast<ReplacementPolicy>(ui->repPolComboBox->currentIndex()) ==
         ReplacementPolicy::Custom)
         {
             onCustomPolicyClicked();
@@ -77,7 +88,10 @@ CacheConfig CacheConfigWidget::getConfig() const
     config.wayCount = 1ULL << ui->waysSpinBox->value();
     config.writePolicy = ui->writeHitComboBox->currentData().value<WritePolicy>();
     config.allocationPolicy = ui->writeMissComboBox->currentData().value<AllocationPolicy>();
-    config.replacementPolicy = ui->repPolComboBox->currentData().value<ReplacementPolicy>();
+    config.replacementPolicy = static_cast<ReplacementPolicy>(ui->repPolComboBox->currentIndex());
+    config.prefetcher = static_cast<PrefetcherType>(ui->prefetcherComboBox->currentIndex());
+    config.prefetchDegree = static_cast<size_t>(ui->prefetchDegreeSpinBox->value());
+    config.prefetchDistance = static_cast<size_t>(ui->prefetchDistanceSpinBox->value());
     return config;
 }
 
@@ -120,6 +134,9 @@ void CacheConfigWidget::setConfig(CacheConfig config)
     ui->writeHitComboBox->setCurrentIndex(static_cast<int>(config.writePolicy));
     ui->writeMissComboBox->setCurrentIndex(static_cast<int>(config.allocationPolicy));
     ui->repPolComboBox->setCurrentIndex(static_cast<int>(config.replacementPolicy));
+    ui->prefetcherComboBox->setCurrentIndex(static_cast<int>(config.prefetcher));
+    ui->prefetchDegreeSpinBox->setValue(static_cast<int>(config.prefetchDegree));
+    ui->prefetchDistanceSpinBox->setValue(static_cast<int>(config.prefetchDistance));
 }
 
 void CacheConfigWidget::cacheStatsUpdatedSlot(CacheStats newStats)
@@ -129,6 +146,10 @@ void CacheConfigWidget::cacheStatsUpdatedSlot(CacheStats newStats)
     ui->missesLineEdit->setText(QString::number(newStats.missCount));
     ui->writeBackLineEdit->setText(QString::number(newStats.writeBackCount));
     ui->hitrateLineEdit->setText(QString::number(newStats.hitRate, 'f', 2) + " %");
+    ui->prefetchAccuracyLineEdit->setText(QString::number(newStats.prefetchAccuracy * 100, 'f', 2) + " %");
+    ui->prefetchCoverageLineEdit->setText(QString::number(newStats.prefetchCoverage * 100, 'f', 2) + " %");
+    ui->prefetchLateLineEdit->setText(QString::number(newStats.prefetchLateCount));
+    ui->prefetchUselessLineEdit->setText(QString::number(newStats.prefetchUselessCount));
 }
 
 void CacheConfigWidget::customPolicyScriptLoadedSlot(bool success, const std::string &message)
@@ -23,17 +23,18 @@ void CacheModel::attachCache(Cache *cache)
     //     disconnect(m_cache,nullptr , this, nullptr);
     // }
     m_cache = cache;
+    m_last_hit_row = -1;
+    m_last_miss_row = -1;
     if (m_cache)
     {
-        connect(m_cache, &Cache::cacheLineUpdatedSignal, this, &CacheModel::updateCacheData);
+        m_cache->setObserved(true);
+        connect(m_cache, &Cache::cacheChangesPublishedSignal, this, &CacheModel::applyCacheUpdate);
         connect(m_cache, &Cache::cacheReconfiguredSignal, this,
                 [this]()
                 {
                     beginResetModel();
                     endResetModel();
                 });
-        connect(m_cache, &Cache::cacheMissSignal, this, &CacheModel::onCacheMiss);
-        connect(m_cache, &Cache::cacheHitSignal, this, &CacheModel::onCacheHit);
     }
 
     endResetModel();
@@ -219,40 +220,58 @@ int CacheModel::addressToHitRow(uint64_t address) const
     return static_cast<int>(setIndex * m_cache->getWayCount());
 }
 
-void CacheModel::updateCacheData(uint64_t address)
-{
-    Q_UNUSED(address);
-    if (rowCount() == 0 || columnCount() == 0)
-    {
-        return;
-    }
-    emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
-}
-
 void CacheModel::updateCacheConfig(CacheConfig newConfig)
 {
     beginResetModel();
     endResetModel();
 }
 
-void CacheModel::onCacheMiss(uint64_t address)
+void CacheModel::applyCacheUpdate(const CacheUpdate &update)
 {
-    if (!m_cache)
+    if (!m_cache || rowCount() == 0 || columnCount() == 0)
         return;
 
-    m_last_miss_row = addressToRow(address);
-    beginResetModel();
-    endResetModel();
+    if (update.allLinesChanged)
+    {
+        m_last_hit_row = -1;
+        m_last_miss_row = -1;
+        emitRowsChanged(0, rowCount() - 1);
+        return;
+    }
+
+    // only the last access of the batch is highlighted, so repaint the rows losing the highlight
+    const int previousHitRow = m_last_hit_row;
+    const int previousMissRow = m_last_miss_row;
+    if (update.hasAccess)
+    {
+        if (update.lastAccessHit)
+            m_last_hit_row = addressToHitRow(update.lastAddress);
+        else
+            m_last_miss_row = addressToRow(update.lastAddress);
+    }
+    for (int row : {previousHitRow, previousMissRow, m_last_hit_row, m_last_miss_row})
+    {
+        if (row >= 0 && row < rowCount())
+            emitRowsChanged(row, row);
+    }
+
+    // changedLines is ascending, so runs of adjacent lines go out as one range. An update queued
+    // before a reconfiguration may name lines that no longer exist.
+    const auto &lines = update.changedLines;
+    const size_t rows = static_cast<size_t>(rowCount());
+    for (size_t first = 0; first < lines.size() && lines[first] < rows;)
+    {
+        size_t last = first;
+        while (last + 1 < lines.size() && lines[last + 1] == lines[last] + 1 && lines[last + 1] < rows)
+            ++last;
+        emitRowsChanged(static_cast<int>(lines[first]), static_cast<int>(lines[last]));
+        first = last + 1;
+    }
 }
 
-void CacheModel::onCacheHit(uint64_t address)
+void CacheModel::emitRowsChanged(int firstRow, int lastRow)
 {
-    if (!m_cache)
-        return;
-
-    m_last_hit_row = addressToHitRow(address);
-    beginResetModel();
-    endResetModel();
+    emit dataChanged(index(firstRow, 0), index(lastRow, columnCount() - 1));
 }
 
 size_t CacheModel::rowToSetIndex(int row) const
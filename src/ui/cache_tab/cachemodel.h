@@ -20,16 +20,15 @@ public:
 
     void attachCache(Cache *cache);
 public slots:
-    void updateCacheData(uint64_t address);
     void updateCacheConfig(CacheConfig newConfig);
-    void onCacheMiss(uint64_t address);
-    void onCacheHit(uint64_t address);
+    void applyCacheUpdate(const CacheUpdate &update);
 
 private:
     size_t rowToSetIndex(int row) const;
     size_t rowToWayIndex(int row) const;
     int addressToRow(uint64_t address) const;
     int addressToHitRow(uint64_t address) const;
+    void emitRowsChanged(int firstRow, int lastRow);
 
     enum class Column
     {
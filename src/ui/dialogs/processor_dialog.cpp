@@ -44,6 +44,14 @@ void ProcessorDialog::on_buttonBox_accepted()
         {
             emit vmSelected(ProcessorType::RV5Stage_H_F);
         }
+        else if (processorType == "Single cycle processor (threaded interpreter)")
+        {
+            emit vmSelected(ProcessorType::RVSS_Threaded);
+        }
+        else if (processorType == "5 stage dual-issue Processor w/ hazard detection w/ forwarding")
+        {
+            emit vmSelected(ProcessorType::RV5Stage_Dual_Issue);
+        }
     }
 }
 
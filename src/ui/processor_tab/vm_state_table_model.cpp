@@ -1,4 +1,5 @@
 #include "vm_state_table_model.h"
+#include "processor/branch_prediction/branch_prediction_unit.h"
 
 namespace Kites
 {
@@ -11,7 +12,7 @@ VMStateTableModel::VMStateTableModel(QObject *parent, ProcessorManager *vmManage
 int VMStateTableModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return 7;
+    return 11;
 }
 
 int VMStateTableModel::columnCount(const QModelIndex &parent) const
@@ -37,7 +38,8 @@ QVariant VMStateTableModel::data(const QModelIndex &index, int role) const
     // cuz we dont want to display all the keys in vm state map
     static const QStringList keys = {
         "ProgramCounter",      "Cycles", "InstructionsRetired", "CPI", "IPC", "StallCycles",
-        "BranchMispredictions"};
+        "MemoryStallCycles", "FunctionalUnitStallCycles", "BranchMispredictions",
+        "BranchPredictor", "BranchPredictionAccuracy"};
     enum class VMStateKey
     {
         ProgramCounter,
@@ -46,7 +48,11 @@ QVariant VMStateTableModel::data(const QModelIndex &index, int role) const
         CPI,
         IPC,
         StallCycles,
-        BranchMispredictions
+        MemoryStallCycles,
+        FunctionalUnitStallCycles,
+        BranchMispredictions,
+        BranchPredictor,
+        BranchPredictionAccuracy
     };
   
     if (!m_vmManager)
@@ -78,8 +84,25 @@ QVariant VMStateTableModel::data(const QModelIndex &index, int role) const
                     return m_vmManager->getIPC();
                 case VMStateKey::StallCycles:
                     return m_vmManager->getStallCycles();
+                case VMStateKey::MemoryStallCycles:
+                    return m_vmManager->getMemoryStallCycles();
+                case VMStateKey::FunctionalUnitStallCycles:
+                    return m_vmManager->getFunctionalUnitStallCycles();
                 case VMStateKey::BranchMispredictions:
                     return m_vmManager->getBranchMispredictions();
+                case VMStateKey::BranchPredictor:
+                    if (const BranchPredictionUnit *predictor = m_vmManager->getBranchPredictor())
+                    {
+                        return QString::fromUtf8(predictor->name().data(),
+                                                 static_cast<int>(predictor->name().size()));
+                    }
+                    return QString("-");
+                case VMStateKey::BranchPredictionAccuracy:
+                    if (const BranchPredictionUnit *predictor = m_vmManager->getBranchPredictor())
+                    {
+                        return predictor->stats().accuracy();
+                    }
+                    return QString("-");
             }
         }
     }
@@ -450,11 +450,17 @@ void SetupConfigFile()
     config_file << "processor_type=single_stage\n";
     config_file << "hazard_detection=false\n";
     config_file << "forwarding=false\n";
-    config_file << "branch_prediction=none\n\n";
+    config_file << "branch_prediction=none\n";
+    config_file << "undo_history_depth=100000\n";
+    config_file << "undo_history_memory_cap=16777216   ; in bytes\n";
+    config_file << "checkpoint_interval=100000   ; cycles between time-travel checkpoints\n";
+    config_file << "checkpoint_max_count=64\n\n";
 
     config_file << "[Memory]\n";
     config_file << "memory_size=0xffffffffffffffff\n";
-    config_file << "block_size=1024\n\n";
+    config_file << "memory_backend=sparse   ; or mmap\n";
+    config_file << "data_window_size=0x10000000\n";
+    config_file << "stack_window_size=0x4000000\n\n";
 
     config_file << "[Cache]\n";
     config_file << "cache_enabled=false\n";
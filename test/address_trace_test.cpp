@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "assembler/assembler.h"
+#include "processor/address_trace.h"
+#include "processor/cache/trace_replay.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+std::string tracePath(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / ("kites_" + name + ".trace")).string();
+}
+
+// strided loads and stores over 1 KiB, so the small caches below miss, evict and write back
+const std::string kStrideProgram = R"(.data
+buf: .zero 1024
+.text
+    la x10, buf
+    li x5, 300
+    li x9, 0
+loop:
+    mul x6, x5, x9
+    andi x6, x6, 1016
+    add x7, x6, x10
+    ld x8, 0(x7)
+    add x8, x8, x5
+    sd x8, 0(x7)
+    lbu x11, 3(x7)
+    sh x11, 6(x7)
+    addi x9, x9, 7
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+void expectSameStats(const CacheStats &replayed, const Cache &live)
+{
+    const CacheStats stats = live.getStats();
+    EXPECT_EQ(replayed.hitCount, stats.hitCount);
+    EXPECT_EQ(replayed.missCount, stats.missCount);
+    EXPECT_EQ(replayed.writeBackCount, stats.writeBackCount);
+}
+
+} // namespace
+
+TEST(AddressTraceTest, RecordsRoundTrip)
+{
+    const std::vector<TraceRecord> records = {
+        {.address = 0x0, .pc = 0x0, .size = 4, .access = TraceAccess::FETCH},
+        {.address = 0x10000000, .pc = 0x0, .size = 8, .access = TraceAccess::LOAD},
+        {.address = 0x4, .pc = 0x4, .size = 4, .access = TraceAccess::FETCH},
+        {.address = 0x0FFFFFF8, .pc = 0x4, .size = 1, .access = TraceAccess::STORE},
+        {.address = 0xFFFFFFFFFFFFFFF0, .pc = 0x4, .size = 2, .access = TraceAccess::LOAD},
+        {.address = 0x20, .pc = 0x1234, .size = 8, .access = TraceAccess::STORE},
+        {.address = 0x8, .pc = 0x8, .size = 4, .access = TraceAccess::FETCH},
+        {.address = 0x24, .pc = 0x4, .size = 4, .access = TraceAccess::LOAD},
+    };
+
+    const std::string path = tracePath("round_trip");
+    {
+        AddressTraceWriter writer(path);
+        for (const TraceRecord &record : records)
+        {
+            writer.append(record.access, record.address, record.size, record.pc);
+        }
+        EXPECT_EQ(writer.recordCount(), records.size());
+    }
+
+    const AddressTrace trace = AddressTrace::load(path);
+    AddressTraceCursor cursor(trace);
+    TraceRecord record;
+    for (const TraceRecord &expected : records)
+    {
+        ASSERT_TRUE(cursor.next(record));
+        EXPECT_EQ(record.address, expected.address);
+        EXPECT_EQ(record.pc, expected.pc);
+        EXPECT_EQ(record.size, expected.size);
+        EXPECT_EQ(record.access, expected.access);
+    }
+    EXPECT_FALSE(cursor.next(record));
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(AddressTrace(std::vector<uint8_t>{'n', 'o', 't'}), std::runtime_error);
+}
+
+TEST(AddressTraceTest, ReplayReproducesTheLiveCacheStatistics)
+{
+    setupVmStateDirectory();
+    std::istringstream source(kStrideProgram);
+    AssembledProgram program = assemble(source);
+
+    RVSSProcessor vm;
+    MemoryController &memory = vm.memory_controller_;
+    const CacheHierarchyConfig config{
+        .l1 = {.lineCount = 4, .lineSizeInBytes = 16, .wayCount = 2,
+               .writePolicy = WritePolicy::WriteBack,
+               .allocationPolicy = AllocationPolicy::WriteAllocate,
+               .replacementPolicy = ReplacementPolicy::LRU},
+        .instruction = {.lineCount = 2, .lineSizeInBytes = 16, .wayCount = 2,
+                        .writePolicy = WritePolicy::WriteThrough,
+                        .allocationPolicy = AllocationPolicy::WriteAllocate,
+                        .replacementPolicy = ReplacementPolicy::FIFO},
+        .l2 = {.lineCount = 8, .lineSizeInBytes = 32, .wayCount = 4,
+               .writePolicy = WritePolicy::WriteBack,
+               .allocationPolicy = AllocationPolicy::NoWriteAllocate,
+               .replacementPolicy = ReplacementPolicy::LRU},
+    };
+    memory.getL1Cache()->reconfigure(config.l1);
+    memory.getInstructionCache()->reconfigure(config.instruction);
+    memory.getL2Cache()->reconfigure(config.l2);
+    vm.LoadProgram(program);
+
+    const std::string path = tracePath("stride");
+    memory.startTrace(path);
+    EXPECT_TRUE(memory.isTracing());
+    vm.FastRun();
+    const uint64_t recorded = memory.stopTrace();
+    EXPECT_FALSE(memory.isTracing());
+
+    const TraceReplayResult result = replayTrace(AddressTrace::load(path), config);
+    std::filesystem::remove(path);
+
+    // every instruction is fetched, and each pass round the loop does two loads and two stores
+    EXPECT_EQ(result.accesses, recorded);
+    EXPECT_EQ(result.accesses, vm.instructions_retired_ + 300u * 4u);
+    expectSameStats(result.l1, *memory.getL1Cache());
+    expectSameStats(result.instruction, *memory.getInstructionCache());
+    expectSameStats(result.l2, *memory.getL2Cache());
+    EXPECT_GT(result.l1.writeBackCount, 0u);
+}
+
+TEST(AddressTraceTest, ReplayThroughput)
+{
+    constexpr uint64_t ACCESSES = 4'000'000;
+    const std::string path = tracePath("throughput");
+    {
+        // a loop fetching 16 instructions and touching a 64 KiB working set at a 40 byte stride
+        AddressTraceWriter writer(path);
+        uint64_t pc = 0;
+        uint64_t data = 0x10000000;
+        for (uint64_t i = 0; i < ACCESSES; ++i)
+        {
+            if (i % 3 != 0)
+            {
+                writer.append(TraceAccess::FETCH, pc, 4, pc);
+                pc = (pc + 4) & 0x3F;
+            }
+            else
+            {
+                writer.append(i % 2 ? TraceAccess::STORE : TraceAccess::LOAD, data, 8, pc);
+                data = 0x10000000 + ((data + 40) & 0xFFF8);
+            }
+        }
+    }
+    const AddressTrace trace = AddressTrace::load(path);
+    std::filesystem::remove(path);
+
+    CacheConfig l1{.lineCount = 64, .lineSizeInBytes = 64, .wayCount = 8,
+                   .writePolicy = WritePolicy::WriteBack,
+                   .allocationPolicy = AllocationPolicy::WriteAllocate,
+                   .replacementPolicy = ReplacementPolicy::LRU};
+    CacheConfig l2 = l1;
+    l2.lineCount = 512;
+    const TraceReplayResult result = replayTrace(trace, {.l1 = l1, .instruction = l1, .l2 = l2});
+
+    EXPECT_EQ(result.accesses, ACCESSES);
+    EXPECT_EQ(result.l1.hitCount + result.l1.missCount + result.instruction.hitCount +
+                  result.instruction.missCount,
+              ACCESSES);
+    std::cout << "[ BENCH    ] trace replay: " << trace.bytes().size() / 1024 << " KiB for "
+              << ACCESSES << " accesses, "
+              << (result.seconds > 0.0 ? ACCESSES / result.seconds / 1e6 : 0.0)
+              << " M accesses/s" << std::endl;
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/branch_prediction/bimodal.h"
+#include "processor/branch_prediction/branch_prediction_unit.h"
+#include "processor/branch_prediction/gshare.h"
+#include "processor/branch_prediction/predictor_comparison.h"
+#include "processor/branch_prediction/static_predictor.h"
+#include "processor/branch_prediction/tage.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rv5s/rv5s_processor_h_nf.h"
+#include "processor/rv5s/rv5s_processor_nh_f.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+using vm_config::BranchPredictorType;
+
+namespace
+{
+
+const std::vector<BranchPredictorType> kAllPredictors = {
+    BranchPredictorType::NOT_TAKEN, BranchPredictorType::BTFN,       BranchPredictorType::ONE_BIT,
+    BranchPredictorType::TWO_BIT,   BranchPredictorType::GSHARE,     BranchPredictorType::TOURNAMENT,
+    BranchPredictorType::TAGE};
+
+// a short inner loop, a branch taken every other outer iteration, and a call and return
+const std::string kBranchyProgram = R"(.text
+    li x5, 20
+    li x6, 0
+    li x7, 0
+outer:
+    li x8, 3
+inner:
+    addi x6, x6, 1
+    addi x8, x8, -1
+    bne x8, x0, inner
+    andi x9, x5, 1
+    beq x9, x0, skip
+    jal x1, bump
+skip:
+    addi x5, x5, -1
+    bne x5, x0, outer
+    j end
+bump:
+    addi x7, x7, 1
+    jalr x0, 0(x1)
+end:
+    addi x6, x6, 1000
+)";
+
+AssembledProgram assembleBranchyProgram()
+{
+    std::istringstream source(kBranchyProgram);
+    return assemble(source);
+}
+
+struct RunResult
+{
+    unsigned int cycles = 0;
+    unsigned int retired = 0;
+    unsigned int mispredictions = 0;
+    uint64_t x6 = 0;
+    uint64_t x7 = 0;
+};
+
+template <typename Processor> RunResult runBranchyProgram(BranchPredictorType type)
+{
+    BranchPredictorGuard guard(type);
+    Finishing<Processor> vm;
+    runToEnd(vm, kBranchyProgram);
+    return {vm.cycle_s_, vm.instructions_retired_, vm.branch_mispredictions_,
+            vm.registers_.ReadGpr(6), vm.registers_.ReadGpr(7)};
+}
+
+template <typename Processor> void expectSameResultsUnderEveryPredictor()
+{
+    const RunResult unpredicted = runBranchyProgram<Processor>(BranchPredictorType::NOT_TAKEN);
+    EXPECT_EQ(unpredicted.x6, 1060u);
+    EXPECT_EQ(unpredicted.x7, 10u);
+    for (BranchPredictorType type : kAllPredictors)
+    {
+        const RunResult predicted = runBranchyProgram<Processor>(type);
+        EXPECT_EQ(predicted.x6, unpredicted.x6) << branchPredictorName(type);
+        EXPECT_EQ(predicted.x7, unpredicted.x7) << branchPredictorName(type);
+        EXPECT_EQ(predicted.retired, unpredicted.retired) << branchPredictorName(type);
+        EXPECT_LE(predicted.cycles, unpredicted.cycles) << branchPredictorName(type);
+    }
+}
+
+// trains @p predictor on @p pattern repeated @p rounds times at one branch, then counts the
+// mispredictions of one more round
+unsigned int mispredictionsAfterTraining(DirectionPredictor &predictor,
+                                         const std::vector<bool> &pattern, int rounds)
+{
+    const uint64_t pc = 0x40;
+    uint64_t history = 0;
+    unsigned int mispredictions = 0;
+    for (int round = 0; round <= rounds; ++round)
+    {
+        for (bool taken : pattern)
+        {
+            if (round == rounds && predictor.predict(pc, 0x20, history) != taken)
+            {
+                ++mispredictions;
+            }
+            predictor.update(pc, 0x20, history, taken);
+            history = (history << 1) | (taken ? 1 : 0);
+        }
+    }
+    return mispredictions;
+}
+
+} // namespace
+
+TEST(BranchPredictorTest, StaticPredictorsFollowTheDirection)
+{
+    PredictorJournal journal;
+    StaticPredictor notTaken(journal, false);
+    StaticPredictor btfn(journal, true);
+    EXPECT_FALSE(notTaken.predict(0x40, 0x20, 0));
+    EXPECT_TRUE(btfn.predict(0x40, 0x20, 0));
+    EXPECT_FALSE(btfn.predict(0x40, 0x60, 0));
+}
+
+TEST(BranchPredictorTest, CountersNeedHysteresisToKeepLoopsTaken)
+{
+    PredictorJournal journal;
+    BimodalPredictor oneBit(journal, 6, 1);
+    BimodalPredictor twoBit(journal, 6, 2);
+    // a loop of four: the exit flips a one bit counter, so the next entry mispredicts too
+    const std::vector<bool> loop = {true, true, true, false};
+    EXPECT_EQ(mispredictionsAfterTraining(oneBit, loop, 4), 2u);
+    EXPECT_EQ(mispredictionsAfterTraining(twoBit, loop, 4), 1u);
+}
+
+TEST(BranchPredictorTest, HistoryTellsPatternsApart)
+{
+    PredictorJournal journal;
+    const std::vector<bool> alternating = {true, false};
+    BimodalPredictor twoBit(journal, 6, 2);
+    GsharePredictor gshare(journal, 8, 6);
+    EXPECT_GE(mispredictionsAfterTraining(twoBit, alternating, 8), 1u);
+    EXPECT_EQ(mispredictionsAfterTraining(gshare, alternating, 8), 0u);
+
+    // a period of seven needs more history than the shortest tagged table has
+    const std::vector<bool> longPattern = {true, true, false, true, false, false, false};
+    TagePredictor tage(journal, 8);
+    EXPECT_EQ(mispredictionsAfterTraining(tage, longPattern, 40), 0u);
+}
+
+TEST(BranchPredictorTest, ReturnAddressStackPredictsReturns)
+{
+    vm_config::BranchPredictorConfig config;
+    config.type = BranchPredictorType::TWO_BIT;
+    BranchPredictionUnit unit;
+    unit.configure(config);
+
+    const uint32_t callInstruction = 0x0000006F | (1u << 7);  // jal x1
+    const uint32_t returnInstruction = 0x00000067 | (1u << 15); // jalr x0, 0(x1)
+    EXPECT_EQ(branchKindOf(callInstruction), BranchKind::Call);
+    EXPECT_EQ(branchKindOf(returnInstruction), BranchKind::Return);
+    EXPECT_EQ(branchKindOf(0x0000006F), BranchKind::Jump);
+    EXPECT_EQ(branchKindOf(0x00000063), BranchKind::Conditional);
+
+    // first time round neither is in the target buffer
+    FetchPrediction call = unit.predict(0x100);
+    EXPECT_TRUE(unit.resolve(0x100, callInstruction, call, true, 0x400));
+    FetchPrediction ret = unit.predict(0x404);
+    EXPECT_TRUE(unit.resolve(0x404, returnInstruction, ret, true, 0x104));
+
+    // the same function called from elsewhere returns there
+    call = unit.predict(0x180);
+    EXPECT_TRUE(unit.resolve(0x180, callInstruction, call, true, 0x400));
+    ret = unit.predict(0x404);
+    EXPECT_EQ(ret.next_pc, 0x184u);
+    EXPECT_FALSE(unit.resolve(0x404, returnInstruction, ret, true, 0x184));
+
+    call = unit.predict(0x100);
+    EXPECT_EQ(call.next_pc, 0x400u);
+    EXPECT_EQ(unit.predict(0x404).next_pc, 0x104u);
+    EXPECT_EQ(unit.stats().jumpCount, 4u);
+    EXPECT_EQ(unit.stats().jumpMispredictions, 3u);
+}
+
+TEST(BranchPredictorTest, PipelinesComputeTheSameUnderEveryPredictor)
+{
+    setupVmStateDirectory();
+    expectSameResultsUnderEveryPredictor<RV5StageProcessorHF>();
+    expectSameResultsUnderEveryPredictor<RV5StageProcessorHNF>();
+    expectSameResultsUnderEveryPredictor<RV5StageProcessorNHF>();
+}
+
+TEST(BranchPredictorTest, PredictionSavesCycles)
+{
+    setupVmStateDirectory();
+    const RunResult unpredicted =
+        runBranchyProgram<RV5StageProcessorHF>(BranchPredictorType::NOT_TAKEN);
+    const RunResult twoBit = runBranchyProgram<RV5StageProcessorHF>(BranchPredictorType::TWO_BIT);
+    EXPECT_LT(twoBit.mispredictions, unpredicted.mispredictions);
+    EXPECT_LT(twoBit.cycles, unpredicted.cycles);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    const std::vector<BranchPredictorResult> results = compareBranchPredictors(
+        assembleBranchyProgram(), {BranchPredictorType::NOT_TAKEN, BranchPredictorType::TWO_BIT,
+                                   BranchPredictorType::TAGE});
+    std::cout.rdbuf(coutBuffer);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].cpiChange, 0.0);
+    EXPECT_EQ(results[1].cycles, twoBit.cycles);
+    EXPECT_LT(results[1].cpiChange, 0.0);
+    EXPECT_LT(results[2].cpiChange, 0.0);
+    EXPECT_GT(results[2].stats.accuracy(), results[0].stats.accuracy());
+    EXPECT_NE(formatPredictorTable(results).find("tage"), std::string::npos);
+}
+
+TEST(BranchPredictorTest, UndoRestoresThePredictor)
+{
+    setupVmStateDirectory();
+    BranchPredictorGuard guard(BranchPredictorType::TAGE);
+    const RunResult straight = runBranchyProgram<RV5StageProcessorHF>(BranchPredictorType::TAGE);
+
+    Finishing<RV5StageProcessorHF> vm;
+    vm.LoadProgram(assembleBranchyProgram());
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int cycle = 0; cycle < 80; ++cycle)
+    {
+        vm.Step();
+    }
+    const BranchPredictionStats halfway = vm.GetBranchPredictor()->stats();
+    for (int cycle = 0; cycle < 40; ++cycle)
+    {
+        vm.Step();
+    }
+    for (int cycle = 0; cycle < 40; ++cycle)
+    {
+        vm.Undo();
+    }
+    EXPECT_EQ(vm.GetBranchPredictor()->stats().conditionalCount, halfway.conditionalCount);
+    EXPECT_EQ(vm.GetBranchPredictor()->stats().conditionalMispredictions,
+              halfway.conditionalMispredictions);
+
+    // stepping on from the restored tables gives the run that never went back
+    while (!vm.finished())
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.cycle_s_, straight.cycles);
+    EXPECT_EQ(vm.branch_mispredictions_, straight.mispredictions);
+    EXPECT_EQ(vm.registers_.ReadGpr(6), straight.x6);
+}
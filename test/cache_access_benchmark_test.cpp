@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+constexpr size_t LINE_SIZE = 64;
+constexpr size_t SET_COUNT = 64;
+constexpr size_t WAY_COUNT = 8;
+constexpr size_t WORKING_SET = 16 * 1024; // half of the 32 KB cache, so every access hits
+
+template <typename T, typename Access>
+double nanosecondsPerAccess(Access access)
+{
+    constexpr size_t ROUNDS = 40;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round)
+    {
+        for (uint64_t address = 0; address < WORKING_SET; address += sizeof(T))
+        {
+            access(address);
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double accesses = static_cast<double>(ROUNDS * (WORKING_SET / sizeof(T)));
+    return std::chrono::duration<double, std::nano>(elapsed).count() / accesses;
+}
+
+template <typename T>
+void benchmarkHits(Cache &cache, const char *name)
+{
+    uint64_t checksum = 0;
+    const double readNs = nanosecondsPerAccess<T>(
+        [&](uint64_t address)
+        {
+            if constexpr (sizeof(T) == 1)
+                checksum += cache.readByte(address);
+            else if constexpr (sizeof(T) == 2)
+                checksum += cache.readHalfWord(address);
+            else if constexpr (sizeof(T) == 4)
+                checksum += cache.readWord(address);
+            else
+                checksum += cache.readDoubleWord(address);
+        });
+    const double writeNs = nanosecondsPerAccess<T>(
+        [&](uint64_t address)
+        {
+            if constexpr (sizeof(T) == 1)
+                cache.writeByte(address, static_cast<T>(address));
+            else if constexpr (sizeof(T) == 2)
+                cache.writeHalfWord(address, static_cast<T>(address));
+            else if constexpr (sizeof(T) == 4)
+                cache.writeWord(address, static_cast<T>(address));
+            else
+                cache.writeDoubleWord(address, static_cast<T>(address));
+        });
+    std::cout << "[ BENCH    ] L1 hit, " << name << ": read " << readNs << " ns, write " << writeNs
+              << " ns per access (checksum " << checksum << ")" << std::endl;
+}
+
+} // namespace
+
+TEST(CacheAccessBenchmark, HitLatencyPerAccessSize)
+{
+    MainMemory memory;
+    Cache cache(memory, SET_COUNT, LINE_SIZE, WAY_COUNT, WritePolicy::WriteBack);
+    for (uint64_t address = 0; address < WORKING_SET; address += LINE_SIZE)
+    {
+        cache.readByte(address);
+    }
+    const size_t warmMisses = cache.getMissCount();
+
+    benchmarkHits<uint8_t>(cache, "byte");
+    benchmarkHits<uint16_t>(cache, "half word");
+    benchmarkHits<uint32_t>(cache, "word");
+    benchmarkHits<uint64_t>(cache, "double word");
+    EXPECT_EQ(cache.getMissCount(), warmMisses);
+}
+
+TEST(CacheAccessBenchmark, AccessesCrossingLinesMatchMemory)
+{
+    MainMemory memory;
+    for (uint64_t address = 0; address < 4 * LINE_SIZE; ++address)
+    {
+        memory.writeByte(address, static_cast<uint8_t>(address * 7 + 3));
+    }
+
+    Cache cache(memory, 2, LINE_SIZE, 1, WritePolicy::WriteBack);
+    EXPECT_EQ(cache.readDoubleWord(LINE_SIZE - 3), memory.readDoubleWord(LINE_SIZE - 3));
+    EXPECT_EQ(cache.getMissCount(), 1u);
+    EXPECT_EQ(cache.readWord(LINE_SIZE - 2), memory.readWord(LINE_SIZE - 2));
+    EXPECT_EQ(cache.getHitCount(), 1u);
+
+    // line 1 is cached and line 2 is not, so the access misses and replaces line 0
+    cache.writeDoubleWord(2 * LINE_SIZE - 4, 0x1122334455667788ull);
+    EXPECT_EQ(cache.getMissCount(), 2u);
+    EXPECT_EQ(cache.readDoubleWord(2 * LINE_SIZE - 4), 0x1122334455667788ull);
+    EXPECT_EQ(cache.getHitCount(), 2u);
+    EXPECT_EQ(cache.getCacheLine(0, 0).tag, cache.getTag(2 * LINE_SIZE));
+
+    cache.flush();
+    EXPECT_EQ(memory.readDoubleWord(2 * LINE_SIZE - 4), 0x1122334455667788ull);
+}
+
+TEST(CacheAccessBenchmark, NoWriteAllocateUpdatesCachedHalfOfASplitWrite)
+{
+    MainMemory memory;
+    Cache cache(memory, 2, LINE_SIZE, 1, WritePolicy::WriteThrough,
+                AllocationPolicy::NoWriteAllocate);
+    cache.readByte(0);
+
+    cache.writeWord(LINE_SIZE - 2, 0xAABBCCDDu);
+    EXPECT_EQ(cache.getMissCount(), 2u);
+    EXPECT_EQ(memory.readWord(LINE_SIZE - 2), 0xAABBCCDDu);
+    EXPECT_EQ(cache.readHalfWord(LINE_SIZE - 2), 0xCCDDu);
+    EXPECT_EQ(cache.getHitCount(), 1u);
+}
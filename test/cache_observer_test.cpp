@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "processor/cache/cache.h"
+#include "processor/cache/cache_observer.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+TEST(CacheObserverTest, CoalescesRepeatedChangesIntoOneSortedUpdate)
+{
+    CacheObserver observer(16);
+    EXPECT_FALSE(observer.hasChanges());
+
+    observer.noteLine(9);
+    observer.noteLine(2);
+    observer.noteLine(9);
+    observer.noteLine(3);
+    observer.noteAccess(0x40, false);
+    observer.noteAccess(0x80, true);
+    EXPECT_TRUE(observer.hasChanges());
+
+    CacheStats stats;
+    stats.hitCount = 5;
+    const CacheUpdate update = observer.take(stats);
+    EXPECT_EQ(update.changedLines, (std::vector<size_t>{2, 3, 9}));
+    EXPECT_FALSE(update.allLinesChanged);
+    EXPECT_TRUE(update.hasAccess);
+    EXPECT_EQ(update.lastAddress, 0x80u);
+    EXPECT_TRUE(update.lastAccessHit);
+    EXPECT_EQ(update.stats.hitCount, 5u);
+
+    EXPECT_FALSE(observer.hasChanges());
+    observer.noteLine(9);
+    EXPECT_EQ(observer.take(stats).changedLines, std::vector<size_t>{9});
+}
+
+TEST(CacheObserverTest, AllLinesChangedReplacesTheLineList)
+{
+    CacheObserver observer(4);
+    observer.noteLine(1);
+    observer.noteAllLines();
+    const CacheUpdate update = observer.take({});
+    EXPECT_TRUE(update.allLinesChanged);
+    EXPECT_TRUE(update.changedLines.empty());
+
+    // marks were dropped with the list, so the line is collected again
+    observer.noteLine(1);
+    EXPECT_EQ(observer.take({}).changedLines, std::vector<size_t>{1});
+}
+
+TEST(CacheObserverTest, StatisticsAreCountedWithOrWithoutAnObserver)
+{
+    MainMemory memory;
+    for (bool observed : {false, true})
+    {
+        Cache cache(memory, 4, 16, 2, WritePolicy::WriteBack);
+        cache.setObserved(observed);
+        EXPECT_EQ(cache.isObserved(), observed);
+
+        cache.readWord(0x10);
+        cache.readWord(0x14);
+        cache.writeWord(0x50, 1);
+        cache.publishChanges();
+
+        const CacheStats stats = cache.getStats();
+        EXPECT_EQ(stats.hitCount, 1u);
+        EXPECT_EQ(stats.missCount, 2u);
+        EXPECT_DOUBLE_EQ(stats.hitRate, 1.0 / 3.0);
+        EXPECT_EQ(stats.cacheSizeInBytes, 4u * 16u * 2u);
+    }
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "processor/cache/cache.h"
+#include "processor/cache/cache_storage.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+TEST(CacheStorageTest, MatchTagsAgreesWithAScalarCompare)
+{
+    std::vector<uint64_t> tags(64);
+    for (size_t i = 0; i < tags.size(); ++i)
+    {
+        // equal low halves with different high halves must not match on any path
+        tags[i] = (i % 3 == 0) ? 0x1234 : (uint64_t{i} << 32) | 0x1234;
+    }
+    for (size_t count = 0; count <= tags.size(); ++count)
+    {
+        uint64_t expected = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            expected |= static_cast<uint64_t>(tags[i] == 0x1234) << i;
+        }
+        EXPECT_EQ(matchTags(tags.data(), count, 0x1234), expected) << "count " << count;
+    }
+}
+
+TEST(CacheStorageTest, FindWayIgnoresInvalidLinesAndSpansMaskWords)
+{
+    CacheStorage storage;
+    storage.resize(2, 80, 16);
+    EXPECT_EQ(storage.firstInvalidWay(1), 0u);
+
+    storage.tag(1, 70) = 42;
+    EXPECT_EQ(storage.findWay(1, 42), 80u);
+    storage.setValid(1, 70, true);
+    EXPECT_EQ(storage.findWay(1, 42), 70u);
+    EXPECT_EQ(storage.findWay(0, 42), 80u);
+
+    for (size_t way = 0; way < 80; ++way)
+    {
+        storage.setValid(0, way, way != 65);
+    }
+    EXPECT_EQ(storage.firstInvalidWay(0), 65u);
+    storage.setValid(0, 65, true);
+    EXPECT_EQ(storage.firstInvalidWay(0), 80u);
+
+    storage.setDirty(1, 70, true);
+    EXPECT_TRUE(storage.isDirty(1, 70));
+    EXPECT_FALSE(storage.isDirty(1, 69));
+    storage.clear();
+    EXPECT_FALSE(storage.isValid(1, 70));
+    EXPECT_FALSE(storage.isDirty(1, 70));
+}
+
+TEST(CacheStorageTest, WideSetsEvictTheLeastRecentlyUsedLine)
+{
+    for (size_t ways : {16u, 32u, 128u})
+    {
+        MainMemory memory;
+        const size_t lineSize = 16;
+        for (uint64_t address = 0; address < (ways + 1) * lineSize; address += 8)
+        {
+            memory.writeDoubleWord(address, address * 3 + 1);
+        }
+
+        // fully associative, so every line competes for the same set
+        Cache cache(memory, 1, lineSize, ways, WritePolicy::WriteBack);
+        for (uint64_t line = 0; line < ways; ++line)
+        {
+            EXPECT_EQ(cache.readDoubleWord(line * lineSize), line * lineSize * 3 + 1);
+        }
+        EXPECT_EQ(cache.getMissCount(), ways);
+
+        cache.writeDoubleWord(0, 7);                   // line 0 is now the most recent
+        EXPECT_EQ(cache.readDoubleWord(ways * lineSize), ways * lineSize * 3 + 1);
+        EXPECT_EQ(cache.getHitCount(), 1u);
+        EXPECT_EQ(cache.getMissCount(), ways + 1);
+
+        // line 1 was the least recently used and is gone, line 0 is still cached and dirty
+        EXPECT_EQ(cache.readDoubleWord(0), 7u);
+        EXPECT_EQ(cache.getHitCount(), 2u);
+        EXPECT_EQ(memory.readDoubleWord(0), 1u);
+        cache.readDoubleWord(lineSize);
+        EXPECT_EQ(cache.getMissCount(), ways + 2);
+
+        cache.flush();
+        EXPECT_EQ(memory.readDoubleWord(0), 7u);
+    }
+}
+
+TEST(CacheStorageTest, SavedStateRestoresLinesAndFlags)
+{
+    MainMemory memory;
+    Cache cache(memory, 4, 16, 16, WritePolicy::WriteBack);
+    cache.writeWord(0x40, 0xCAFEF00D);
+    const CacheState state = cache.saveState();
+
+    cache.reset();
+    EXPECT_FALSE(cache.getCacheLine(0, 0).valid);
+    cache.restoreState(state);
+
+    const CacheLine line = cache.getCacheLine(cache.getSetIndex(0x40), 0);
+    EXPECT_TRUE(line.valid);
+    EXPECT_TRUE(line.dirty);
+    EXPECT_EQ(line.tag, cache.getTag(0x40));
+    EXPECT_EQ(line.data[0], 0x0Du);
+    EXPECT_EQ(cache.readWord(0x40), 0xCAFEF00Du);
+    EXPECT_EQ(cache.getHitCount(), 1u);
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "processor/cache/cache_sweep.h"
+
+using namespace Kites;
+
+namespace
+{
+
+const CacheConfig kBaseCache{.lineCount = 16, .lineSizeInBytes = 32, .wayCount = 2,
+                             .writePolicy = WritePolicy::WriteBack,
+                             .allocationPolicy = AllocationPolicy::WriteAllocate,
+                             .replacementPolicy = ReplacementPolicy::LRU};
+
+const CacheHierarchyConfig kBase{.l1 = kBaseCache, .instruction = kBaseCache,
+                                 .l2 = {.lineCount = 64, .lineSizeInBytes = 64, .wayCount = 4,
+                                        .writePolicy = WritePolicy::WriteBack,
+                                        .allocationPolicy = AllocationPolicy::WriteAllocate,
+                                        .replacementPolicy = ReplacementPolicy::LRU}};
+
+// a small loop streaming through 16 KiB with a store every third data access
+AddressTrace makeTrace(uint64_t accesses)
+{
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "kites_cache_sweep.trace").string();
+    {
+        AddressTraceWriter writer(path);
+        uint64_t pc = 0;
+        uint64_t data = 0;
+        for (uint64_t i = 0; i < accesses; ++i)
+        {
+            if (i % 2 == 0)
+            {
+                writer.append(TraceAccess::FETCH, pc, 4, pc);
+                pc = (pc + 4) & 0x7F;
+            }
+            else
+            {
+                writer.append(i % 3 == 0 ? TraceAccess::STORE : TraceAccess::LOAD,
+                              0x10000000 + data, 4, pc);
+                data = (data + 12) & 0x3FFC;
+            }
+        }
+    }
+    AddressTrace trace = AddressTrace::load(path);
+    std::filesystem::remove(path);
+    return trace;
+}
+
+} // namespace
+
+TEST(CacheSweepTest, EnumeratesEveryCombinationOfTheSweptLevel)
+{
+    CacheSweepSpace space;
+    space.level = CacheLevel::L2;
+    space.setCounts = {4, 8};
+    space.wayCounts = {1, 2, 4};
+    space.lineSizes = {16};
+    space.replacementPolicies = {ReplacementPolicy::LRU, ReplacementPolicy::FIFO};
+
+    const std::vector<CacheHierarchyConfig> points = enumerateSweep(space, kBase);
+    ASSERT_EQ(points.size(), 2u * 3u * 2u);
+    for (const CacheHierarchyConfig &point : points)
+    {
+        EXPECT_EQ(point.l1.lineCount, kBaseCache.lineCount);
+        EXPECT_EQ(point.instruction.wayCount, kBaseCache.wayCount);
+        EXPECT_EQ(point.l2.lineSizeInBytes, 16u);
+    }
+    EXPECT_EQ(points[0].l2.lineCount, 4u);
+    EXPECT_EQ(points[0].l2.wayCount, 1u);
+    EXPECT_EQ(points[0].l2.replacementPolicy, ReplacementPolicy::LRU);
+    EXPECT_EQ(points[1].l2.replacementPolicy, ReplacementPolicy::FIFO);
+    EXPECT_EQ(points[2].l2.wayCount, 2u);
+    EXPECT_EQ(points.back().l2.lineCount, 8u);
+    EXPECT_EQ(points.back().l2.wayCount, 4u);
+
+    space.lineSizes = {24};
+    EXPECT_THROW(enumerateSweep(space, kBase), std::invalid_argument);
+}
+
+TEST(CacheSweepTest, ParallelResultsMatchSingleReplays)
+{
+    const AddressTrace trace = makeTrace(200'000);
+    CacheSweepSpace space;
+    space.setCounts = {1, 8, 64};
+    space.wayCounts = {1, 4};
+    space.lineSizes = {16, 64};
+    space.writePolicies = {WritePolicy::WriteThrough, WritePolicy::WriteBack};
+    const std::vector<CacheHierarchyConfig> points = enumerateSweep(space, kBase);
+
+    const CacheLatencies latencies{.l1Hit = 1.0, .l2Hit = 8.0, .memory = 50.0};
+    const std::vector<CacheSweepResult> results =
+        runCacheSweep(trace, points, space.level, latencies, 4);
+    ASSERT_EQ(results.size(), points.size());
+    for (size_t i = 0; i < points.size(); i += 5)
+    {
+        const TraceReplayResult replay = replayTrace(trace, points[i]);
+        EXPECT_EQ(results[i].config.lineCount, points[i].l1.lineCount);
+        EXPECT_EQ(results[i].stats.hitCount, replay.l1.hitCount);
+        EXPECT_EQ(results[i].stats.missCount, replay.l1.missCount);
+        EXPECT_EQ(results[i].stats.writeBackCount, replay.l1.writeBackCount);
+
+        const double l1Miss = static_cast<double>(replay.l1.missCount) /
+                              (replay.l1.hitCount + replay.l1.missCount);
+        const double l2Miss = static_cast<double>(replay.l2.missCount) /
+                              (replay.l2.hitCount + replay.l2.missCount);
+        EXPECT_DOUBLE_EQ(results[i].missRate, l1Miss);
+        EXPECT_DOUBLE_EQ(results[i].amat, 1.0 + l1Miss * (8.0 + l2Miss * 50.0));
+    }
+    EXPECT_NE(formatSweepTable(results).find("WB"), std::string::npos);
+
+    // an l1 line longer than the l2 line cannot be filled
+    space.lineSizes = {128};
+    EXPECT_THROW(runCacheSweep(trace, enumerateSweep(space, kBase), space.level), std::invalid_argument);
+}
+
+TEST(CacheSweepTest, ScalesWithThreads)
+{
+    const AddressTrace trace = makeTrace(400'000);
+    CacheSweepSpace space;
+    space.setCounts = {4, 16, 64, 256};
+    space.wayCounts = {1, 2, 4, 8};
+    space.lineSizes = {32};
+    const std::vector<CacheHierarchyConfig> points = enumerateSweep(space, kBase);
+
+    auto timeSweep = [&](unsigned int threads, std::vector<CacheSweepResult> &results)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        results = runCacheSweep(trace, points, space.level, {}, threads);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::vector<CacheSweepResult> sequential;
+    std::vector<CacheSweepResult> parallel;
+    const unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    const double sequentialSeconds = timeSweep(1, sequential);
+    const double parallelSeconds = timeSweep(threads, parallel);
+
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (size_t i = 0; i < parallel.size(); ++i)
+    {
+        EXPECT_EQ(parallel[i].stats.hitCount, sequential[i].stats.hitCount);
+        EXPECT_EQ(parallel[i].stats.writeBackCount, sequential[i].stats.writeBackCount);
+    }
+    std::cout << "[ BENCH    ] cache sweep of " << points.size() << " configurations: "
+              << sequentialSeconds << " s on 1 thread, " << parallelSeconds << " s on " << threads
+              << " threads (" << (parallelSeconds > 0.0 ? sequentialSeconds / parallelSeconds : 0.0)
+              << "x)" << std::endl;
+}
@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/checkpoint_history.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+// 4 + 40 * 8 instructions (la is two); every pass adds into one of eight words, read back next time round
+const std::string kAccumulateProgram = R"(.data
+arr: .word 0, 0, 0, 0, 0, 0, 0, 0
+.text
+    la x10, arr
+    li x5, 40
+    li x9, 0
+loop:
+    andi x6, x5, 7
+    slli x7, x6, 2
+    add x7, x7, x10
+    lw x8, 0(x7)
+    add x8, x8, x5
+    sw x8, 0(x7)
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+AssembledProgram assembleSource(const std::string &text)
+{
+    std::istringstream source(text);
+    return assemble(source);
+}
+
+struct VmSnapshot
+{
+    uint64_t pc = 0;
+    unsigned int cycles = 0;
+    unsigned int retired = 0;
+    std::array<uint64_t, 32> gprs{};
+    size_t l1_hits = 0;
+    size_t l1_misses = 0;
+};
+
+VmSnapshot captureSnapshot(ProcessorBase &vm)
+{
+    VmSnapshot snapshot;
+    snapshot.pc = vm.program_counter_;
+    snapshot.cycles = vm.cycle_s_;
+    snapshot.retired = vm.instructions_retired_;
+    for (size_t i = 0; i < snapshot.gprs.size(); ++i)
+    {
+        snapshot.gprs[i] = vm.registers_.ReadGpr(i);
+    }
+    snapshot.l1_hits = vm.memory_controller_.getL1Cache()->getHitCount();
+    snapshot.l1_misses = vm.memory_controller_.getL1Cache()->getMissCount();
+    return snapshot;
+}
+
+void expectSnapshotsEqual(const VmSnapshot &actual, const VmSnapshot &expected)
+{
+    EXPECT_EQ(actual.pc, expected.pc);
+    EXPECT_EQ(actual.cycles, expected.cycles);
+    EXPECT_EQ(actual.retired, expected.retired);
+    EXPECT_EQ(actual.gprs, expected.gprs);
+    EXPECT_EQ(actual.l1_hits, expected.l1_hits);
+    EXPECT_EQ(actual.l1_misses, expected.l1_misses);
+}
+
+// snapshot i is the state at the start of cycle i
+std::vector<VmSnapshot> stepAndRecord(ProcessorBase &vm, unsigned int cycles)
+{
+    std::vector<VmSnapshot> snapshots;
+    snapshots.push_back(captureSnapshot(vm));
+    for (unsigned int i = 0; i < cycles; ++i)
+    {
+        vm.Step();
+        snapshots.push_back(captureSnapshot(vm));
+    }
+    return snapshots;
+}
+
+/**
+ * @brief Small interval and count, so the tests thin the checkpoints out many times.
+ */
+class CheckpointConfigGuard
+{
+  public:
+    CheckpointConfigGuard(uint64_t interval, uint64_t maxCount)
+        : interval_(vm_config::config.getCheckpointInterval()),
+          max_count_(vm_config::config.getCheckpointMaxCount())
+    {
+        vm_config::config.setCheckpointInterval(interval);
+        vm_config::config.setCheckpointMaxCount(maxCount);
+    }
+    ~CheckpointConfigGuard()
+    {
+        vm_config::config.setCheckpointInterval(interval_);
+        vm_config::config.setCheckpointMaxCount(max_count_);
+    }
+
+  private:
+    uint64_t interval_;
+    uint64_t max_count_;
+};
+
+ProcessorCheckpoint makeCheckpoint(uint64_t cycle, std::vector<uint64_t> blocks)
+{
+    ProcessorCheckpoint checkpoint;
+    checkpoint.cycle = cycle;
+    for (uint64_t block_index : blocks)
+    {
+        MemoryBlock block;
+        block.data[0] = static_cast<uint8_t>(cycle);
+        checkpoint.memory_blocks.emplace(block_index, block);
+    }
+    return checkpoint;
+}
+
+} // namespace
+
+TEST(CheckpointHistoryTest, ThinningKeepsTheEndsAndFoldsMemoryForward)
+{
+    CheckpointHistory history(10, 4);
+    EXPECT_TRUE(history.due(0));
+    history.add(makeCheckpoint(0, {0, 1}));
+    EXPECT_FALSE(history.due(9));
+    EXPECT_TRUE(history.due(10));
+    history.add(makeCheckpoint(10, {1, 2}));
+    history.add(makeCheckpoint(20, {3}));
+    history.add(makeCheckpoint(30, {1}));
+    history.add(makeCheckpoint(40, {4}));
+
+    // 10 and 30 were dropped
+    ASSERT_EQ(history.size(), 3u);
+    EXPECT_EQ(history.at(0).cycle, 0u);
+    EXPECT_EQ(history.at(1).cycle, 20u);
+    EXPECT_EQ(history.at(2).cycle, 40u);
+    EXPECT_EQ(history.interval(), 20u);
+    EXPECT_EQ(history.nextCycle(), 60u);
+
+    std::unordered_map<uint64_t, MemoryBlock> memory = history.memoryAt(2);
+    ASSERT_EQ(memory.size(), 5u);
+    EXPECT_EQ(memory.at(0).data[0], 0u);
+    EXPECT_EQ(memory.at(1).data[0], 30u);
+    EXPECT_EQ(memory.at(2).data[0], 10u);
+    EXPECT_EQ(memory.at(3).data[0], 20u);
+    EXPECT_EQ(memory.at(4).data[0], 40u);
+    EXPECT_EQ(history.memoryAt(1).at(1).data[0], 10u);
+
+    EXPECT_EQ(history.indexAtOrBefore(39), 1u);
+    EXPECT_EQ(history.indexAtOrBefore(40), 2u);
+
+    std::vector<uint64_t> dropped;
+    history.truncate(20, dropped);
+    EXPECT_EQ(history.size(), 1u);
+    // 20 holds its own block and the two folded in from 10, 40 its own and the one from 30
+    EXPECT_EQ(dropped.size(), 5u);
+}
+
+TEST(CheckpointHistoryTest, RVSSTravelMatchesAForwardRun)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(16, 4);
+    AssembledProgram program = assembleSource(kAccumulateProgram);
+
+    RVSSProcessor reference;
+    reference.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    const std::vector<VmSnapshot> expected = stepAndRecord(reference, 300);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    for (int i = 0; i < 300; ++i)
+    {
+        vm.Step();
+    }
+    EXPECT_LE(vm.checkpoints_.size(), 4u);
+    EXPECT_GT(vm.checkpoints_.interval(), 16u);
+
+    for (unsigned int cycle = 300; cycle > 290; --cycle)
+    {
+        vm.ReverseStep();
+        EXPECT_EQ(vm.output_status_, "VM_REVERSE_STEP_COMPLETED");
+        expectSnapshotsEqual(captureSnapshot(vm), expected[cycle - 1]);
+    }
+    for (unsigned int cycle : {0u, 1u, 17u, 150u, 64u, 299u, 5u})
+    {
+        vm.GoToCycle(cycle);
+        EXPECT_EQ(vm.output_status_, "VM_GOTO_CYCLE_COMPLETED");
+        expectSnapshotsEqual(captureSnapshot(vm), expected[cycle]);
+    }
+    vm.ReverseStep();
+    vm.ReverseStep();
+    vm.ReverseStep();
+    vm.ReverseStep();
+    vm.ReverseStep();
+    EXPECT_EQ(vm.cycle_s_, 0u);
+    vm.ReverseStep();
+    EXPECT_EQ(vm.output_status_, "VM_NO_MORE_UNDO");
+
+    // stepping on from a travelled-to state keeps matching
+    vm.GoToCycle(200);
+    for (int i = 0; i < 100; ++i)
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    expectSnapshotsEqual(captureSnapshot(vm), expected[300]);
+    for (uint64_t address = 0x10000000; address < 0x10000020; address += 4)
+    {
+        EXPECT_EQ(vm.memory_controller_.readWord(address),
+                  reference.memory_controller_.readWord(address));
+    }
+}
+
+TEST(CheckpointHistoryTest, RVSSReverseContinueStopsAtTheLastBreakpoint)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(16, 8);
+    AssembledProgram program = assembleSource(kAccumulateProgram);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 100; ++i)
+    {
+        vm.Step();
+    }
+    // "sw x8, 0(x7)", at pc 36, is the sixth instruction of every pass, the first pass starting
+    // at cycle 4
+    vm.AddBreakpoint(36, false);
+    vm.ReverseContinue();
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+    EXPECT_EQ(vm.program_counter_, 36u);
+    EXPECT_EQ(vm.cycle_s_, 4u + 11u * 8u + 5u);
+    vm.ReverseContinue();
+    EXPECT_EQ(vm.cycle_s_, 4u + 10u * 8u + 5u);
+
+    vm.RemoveBreakpoint(36, false);
+    vm.ReverseContinue();
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.output_status_, "VM_REVERSE_START_REACHED");
+    EXPECT_EQ(vm.cycle_s_, 0u);
+    EXPECT_EQ(vm.program_counter_, 0u);
+}
+
+TEST(CheckpointHistoryTest, RVSSFastRunIsCheckpointed)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(32, 8);
+    AssembledProgram program = assembleSource(kAccumulateProgram);
+
+    RVSSProcessor reference;
+    reference.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    const std::vector<VmSnapshot> expected = stepAndRecord(reference, 200);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+    EXPECT_EQ(vm.output_status_, "VM_PROGRAM_END");
+    EXPECT_GT(vm.checkpoints_.size(), 2u);
+
+    vm.GoToCycle(123);
+    EXPECT_EQ(vm.cycle_s_, 123u);
+    EXPECT_EQ(vm.program_counter_, expected[123].pc);
+    EXPECT_EQ(vm.registers_.GetGprValues(),
+              std::vector<uint64_t>(expected[123].gprs.begin(), expected[123].gprs.end()));
+
+    vm.GoToCycle(100000);
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.output_status_, "VM_PROGRAM_END");
+    EXPECT_EQ(vm.cycle_s_, 4u + 40u * 8u);
+}
+
+TEST(CheckpointHistoryTest, ReexecutionReplaysLoggedInput)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(4, 8);
+    AssembledProgram program = assembleSource(R"(.data
+buf: .word 0, 0
+.text
+    li x5, 7
+    li x10, 0
+    la x11, buf
+    li x12, 8
+    li x17, 63
+    ecall
+    li x5, 9
+    lw x6, 0(x11)
+)");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.PushInput("abc");
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    while (vm.program_counter_ < vm.program_size_)
+    {
+        vm.Step();
+    }
+    const uint64_t word = vm.registers_.ReadGpr(6);
+    const unsigned int end = vm.cycle_s_;
+    EXPECT_EQ(word & 0xFFFFFF, 0x636261u);
+
+    vm.GoToCycle(2);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 7u);
+    // nothing is queued: the read has to come from the log or this would block
+    vm.GoToCycle(end);
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.registers_.ReadGpr(6), word);
+    EXPECT_EQ(vm.registers_.ReadGpr(10), 3u);
+}
+
+TEST(CheckpointHistoryTest, EditingStateForgetsTheFuture)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(8, 8);
+    AssembledProgram program = assembleSource(kAccumulateProgram);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 60; ++i)
+    {
+        vm.Step();
+    }
+    vm.GoToCycle(30);
+    vm.ModifyRegister("x9", 1234);
+    EXPECT_EQ(vm.checkpoints_.at(vm.checkpoints_.size() - 1).cycle, 30u);
+    for (int i = 0; i < 10; ++i)
+    {
+        vm.Step();
+    }
+    vm.GoToCycle(35);
+    EXPECT_EQ(vm.registers_.ReadGpr(9), 1234u);
+    vm.GoToCycle(29);
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.registers_.ReadGpr(9), 0u);
+}
+
+TEST(CheckpointHistoryTest, RV5STravelRestoresThePipeline)
+{
+    setupVmStateDirectory();
+    CheckpointConfigGuard config(16, 4);
+    AssembledProgram program = assembleSource(kAccumulateProgram);
+
+    RV5StageProcessorHF reference;
+    reference.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    const std::vector<VmSnapshot> expected = stepAndRecord(reference, 250);
+
+    RV5StageProcessorHF vm;
+    vm.LoadProgram(program);
+    for (int i = 0; i < 250; ++i)
+    {
+        vm.Step();
+    }
+    for (unsigned int cycle : {249u, 248u, 100u, 33u, 1u, 0u, 200u})
+    {
+        vm.GoToCycle(cycle);
+        expectSnapshotsEqual(captureSnapshot(vm), expected[cycle]);
+    }
+    // the restored pipeline registers carry on exactly like the original ones
+    for (int i = 0; i < 50; ++i)
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    expectSnapshotsEqual(captureSnapshot(vm), expected[250]);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+constexpr size_t LINE_SIZE = 64;
+constexpr size_t SET_COUNT = 64;
+constexpr size_t WAY_COUNT = 8;
+
+// LRU over the lastAccess stamps the cache keeps, so it evicts exactly what the native one does
+const char *const LUA_LRU = R"(hooks = { "chooseVictim" }
+
+function chooseVictim(lines, request, cache)
+    local victim = 1
+    for i = 1, #lines do
+        if not lines[i].valid then
+            return i
+        end
+        if lines[i].lastAccess < lines[victim].lastAccess then
+            victim = i
+        end
+    end
+    return victim
+end
+)";
+
+// the same LRU as a policy table, compiled instead of interpreted
+const char *const COMPILED_LRU = R"(policy = { victim = "min lastAccess" }
+)";
+
+std::string writeScript(const std::string &name, const char *source)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path) << source;
+    return path;
+}
+
+// a working set twice the cache size with some reuse, so about half the accesses miss
+template <typename Body> double secondsFor(Body body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void mixedAccesses(Cache &cache, size_t count)
+{
+    uint64_t state = 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint64_t line = (state >> 33) % (2 * SET_COUNT * WAY_COUNT);
+        (void)cache.readWord(line * LINE_SIZE);
+    }
+}
+
+} // namespace
+
+TEST(CustomPolicyBenchmark, LuaLRUAgainstNativeLRU)
+{
+    constexpr size_t ACCESSES = 400000;
+    const std::string script = writeScript("kites_lua_lru.lua", LUA_LRU);
+
+    MainMemory memory;
+    Cache native(memory, SET_COUNT, LINE_SIZE, WAY_COUNT, WritePolicy::WriteBack,
+                 AllocationPolicy::WriteAllocate, ReplacementPolicy::LRU);
+    Cache lua(memory, SET_COUNT, LINE_SIZE, WAY_COUNT, WritePolicy::WriteBack,
+              AllocationPolicy::WriteAllocate, ReplacementPolicy::LRU);
+    lua.loadCustomPolicyScript(script);
+    ASSERT_EQ(lua.getConfig().replacementPolicy, ReplacementPolicy::Custom);
+
+    const double nativeSeconds = secondsFor([&] { mixedAccesses(native, ACCESSES); });
+    const double luaSeconds = secondsFor([&] { mixedAccesses(lua, ACCESSES); });
+
+    EXPECT_EQ(lua.getHitCount(), native.getHitCount());
+    EXPECT_EQ(lua.getMissCount(), native.getMissCount());
+    std::cout << "[ BENCH    ] " << ACCESSES << " accesses, " << native.getMissCount()
+              << " misses: native LRU " << nativeSeconds * 1e9 / ACCESSES << " ns, Lua LRU "
+              << luaSeconds * 1e9 / ACCESSES << " ns per access (" << luaSeconds / nativeSeconds
+              << "x)" << std::endl;
+    std::filesystem::remove(script);
+}
+
+TEST(CustomPolicyBenchmark, CompiledLRUAgainstNativeLRU)
+{
+    constexpr size_t ACCESSES = 400000;
+    const std::string script = writeScript("kites_compiled_lru.lua", COMPILED_LRU);
+
+    MainMemory memory;
+    Cache native(memory, SET_COUNT, LINE_SIZE, WAY_COUNT, WritePolicy::WriteBack,
+                 AllocationPolicy::WriteAllocate, ReplacementPolicy::LRU);
+    Cache compiled(memory, SET_COUNT, LINE_SIZE, WAY_COUNT, WritePolicy::WriteBack,
+                   AllocationPolicy::WriteAllocate, ReplacementPolicy::LRU);
+    compiled.loadCustomPolicyScript(script);
+    ASSERT_EQ(compiled.getConfig().replacementPolicy, ReplacementPolicy::Custom);
+
+    const double nativeSeconds = secondsFor([&] { mixedAccesses(native, ACCESSES); });
+    const double compiledSeconds = secondsFor([&] { mixedAccesses(compiled, ACCESSES); });
+
+    EXPECT_EQ(compiled.getHitCount(), native.getHitCount());
+    EXPECT_EQ(compiled.getMissCount(), native.getMissCount());
+    std::cout << "[ BENCH    ] " << ACCESSES << " accesses, " << native.getMissCount()
+              << " misses: native LRU " << nativeSeconds * 1e9 / ACCESSES
+              << " ns, compiled LRU " << compiledSeconds * 1e9 / ACCESSES << " ns per access ("
+              << compiledSeconds / nativeSeconds << "x)" << std::endl;
+    std::filesystem::remove(script);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "processor/cache/cache.h"
+#include "processor/cache/custom_policy_engine.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+class ScriptFile
+{
+  public:
+    ScriptFile(const std::string &name, const std::string &source)
+        : m_path((std::filesystem::temp_directory_path() / name).string())
+    {
+        std::ofstream(m_path) << source;
+    }
+    ~ScriptFile()
+    {
+        std::filesystem::remove(m_path);
+    }
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+  private:
+    std::string m_path;
+};
+
+// FIFO over insertTime, failing loudly if the tables it is handed are stale
+const std::string CHECKED_FIFO = R"(
+function chooseVictim(lines, request, cache)
+    if #lines ~= cache.wayCount then
+        error("expected the whole set, got " .. #lines .. " lines")
+    end
+    local victim = 1
+    for i = 2, #lines do
+        if lines[i].insertTime < lines[victim].insertTime then
+            victim = i
+        end
+    end
+    return victim
+end
+
+function onAccess(lines, request, cache)
+    if #lines ~= 1 or lines[1].lastAccess ~= cache.tick then
+        error("stale line table")
+    end
+end
+)";
+
+size_t runFifoPattern(Cache &cache)
+{
+    for (int round = 0; round < 50; ++round)
+    {
+        for (uint64_t line : {0, 1, 0, 2, 3, 0, 4, 1})
+        {
+            (void)cache.readWord(0x1000 + line * 16 * 4);
+        }
+    }
+    return cache.getHitCount();
+}
+
+} // namespace
+
+TEST(CustomPolicyEngineTest, TablesAreRefreshedOnEveryCall)
+{
+    ScriptFile script("kites_checked_fifo.lua", CHECKED_FIFO);
+    MainMemory memory;
+    Cache custom(memory, 4, 16, 4, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                 ReplacementPolicy::LRU);
+    custom.loadCustomPolicyScript(script.path());
+    ASSERT_EQ(custom.getConfig().replacementPolicy, ReplacementPolicy::Custom);
+    Cache native(memory, 4, 16, 4, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                 ReplacementPolicy::FIFO);
+
+    EXPECT_EQ(runFifoPattern(custom), runFifoPattern(native));
+    EXPECT_EQ(custom.getMissCount(), native.getMissCount());
+}
+
+TEST(CustomPolicyEngineTest, DeclaredHooksAreTheOnlyOnesCalled)
+{
+    const std::string failingHooks = R"(
+function chooseVictim(lines, request, cache) return 1 end
+function onAccess(lines, request, cache) error("onAccess called") end
+function onInsert(lines, request, cache) error("onInsert called") end
+)";
+    ScriptFile undeclared("kites_undeclared_hooks.lua", failingHooks);
+    ScriptFile declared("kites_declared_hooks.lua", "hooks = { \"onEvict\" }\n" + failingHooks +
+                                                        "function onEvict() end\n");
+
+    CustomPolicyEngine engine;
+    engine.loadCustomPolicyScript(undeclared.path());
+    EXPECT_TRUE(engine.hasHook(CustomPolicyHook::ChooseVictim));
+    EXPECT_TRUE(engine.hasHook(CustomPolicyHook::OnAccess));
+    EXPECT_TRUE(engine.hasHook(CustomPolicyHook::OnInsert));
+    EXPECT_FALSE(engine.hasHook(CustomPolicyHook::OnEvict));
+    const CacheLineView line{.valid = true};
+    EXPECT_THROW(engine.callOnInsert(std::span(&line, 1), {}, {1, 1, 16, 0}), std::runtime_error);
+
+    // reloading drops the hooks the new declaration leaves out, chooseVictim is always kept
+    engine.loadCustomPolicyScript(declared.path());
+    EXPECT_TRUE(engine.hasHook(CustomPolicyHook::ChooseVictim));
+    EXPECT_FALSE(engine.hasHook(CustomPolicyHook::OnAccess));
+    EXPECT_FALSE(engine.hasHook(CustomPolicyHook::OnInsert));
+    EXPECT_TRUE(engine.hasHook(CustomPolicyHook::OnEvict));
+    EXPECT_NO_THROW(engine.callOnInsert(std::span(&line, 1), {}, {1, 1, 16, 0}));
+
+    MainMemory memory;
+    Cache cache(memory, 1, 16, 2, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                ReplacementPolicy::LRU);
+    cache.loadCustomPolicyScript(declared.path());
+    ASSERT_EQ(cache.getConfig().replacementPolicy, ReplacementPolicy::Custom);
+    for (uint64_t address = 0; address < 256; address += 4)
+    {
+        (void)cache.readWord(address);
+    }
+    EXPECT_EQ(cache.getMissCount(), 256u / 16u);
+}
+
+TEST(CustomPolicyEngineTest, RejectsUnknownHooks)
+{
+    ScriptFile typo("kites_hook_typo.lua", "hooks = { \"chooseVictim\", \"onAcces\" }\n"
+                                           "function chooseVictim() return 1 end\n");
+    CustomPolicyEngine engine;
+    EXPECT_THROW(engine.loadCustomPolicyScript(typo.path()), std::runtime_error);
+    EXPECT_FALSE(engine.hasScript());
+
+    ScriptFile notAList("kites_hook_string.lua", "hooks = \"chooseVictim\"\n");
+    EXPECT_THROW(engine.loadCustomPolicyScript(notAList.path()), std::runtime_error);
+}
@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "assembler/assembler.h"
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+class MemoryBackendGuard
+{
+  public:
+    explicit MemoryBackendGuard(vm_config::MemoryBackend backend)
+        : saved_(vm_config::config.getMemoryBackend())
+    {
+        vm_config::config.setMemoryBackend(backend);
+    }
+    ~MemoryBackendGuard()
+    {
+        vm_config::config.setMemoryBackend(saved_);
+    }
+
+  private:
+    vm_config::MemoryBackend saved_;
+};
+
+} // namespace
+
+TEST(MainMemoryTest, UnwrittenMemoryReadsZeroWithoutAllocating)
+{
+    MainMemory memory;
+    EXPECT_EQ(memory.readDoubleWord(0x10000000), 0u);
+    EXPECT_EQ(memory.readByte(0xFFFFFFFF00000000ull), 0u);
+
+    std::unordered_map<uint64_t, MemoryBlock> pages;
+    memory.collectDirtyBlocks(pages);
+    EXPECT_TRUE(pages.empty());
+}
+
+TEST(MainMemoryTest, AccessesStraddlingPagesAreLittleEndian)
+{
+    MainMemory memory;
+    const uint64_t boundary = 5 * MEMORY_PAGE_SIZE;
+    memory.writeDoubleWord(boundary - 3, 0x0807060504030201ull);
+    EXPECT_EQ(memory.readByte(boundary - 3), 0x01u);
+    EXPECT_EQ(memory.readByte(boundary), 0x04u);
+    EXPECT_EQ(memory.readDoubleWord(boundary - 3), 0x0807060504030201ull);
+    EXPECT_EQ(memory.readWord(boundary - 2), 0x05040302u);
+    EXPECT_EQ(memory.readHalfWord(boundary - 1), 0x0403u);
+
+    memory.writeDouble(boundary - 4, 2.5);
+    EXPECT_EQ(memory.readDouble(boundary - 4), 2.5);
+    memory.writeFloat(boundary + 8, -1.25f);
+    EXPECT_EQ(memory.readFloat(boundary + 8), -1.25f);
+
+    std::unordered_map<uint64_t, MemoryBlock> pages;
+    memory.collectDirtyBlocks(pages);
+    ASSERT_EQ(pages.size(), 2u);
+    EXPECT_EQ(pages.at(4).data[MEMORY_PAGE_SIZE - 1], memory.readByte(boundary - 1));
+    EXPECT_EQ(pages.at(5).data[3], memory.readByte(boundary + 3));
+    EXPECT_EQ(pages.at(5).data[8], memory.readByte(boundary + 8));
+}
+
+TEST(MainMemoryTest, LinesLargerThanAPageAreAssembledAcrossPages)
+{
+    MainMemory memory;
+    const uint64_t lineSize = 2 * MEMORY_PAGE_SIZE;
+    memory.writeWord(MEMORY_PAGE_SIZE - 4, 0x11223344);
+    memory.writeWord(MEMORY_PAGE_SIZE, 0x55667788);
+    // the second page of the second line is never written
+    memory.writeByte(lineSize + 1, 0x99);
+
+    Cache cache(memory, 1, lineSize, 1, WritePolicy::WriteBack);
+    EXPECT_EQ(cache.readWord(MEMORY_PAGE_SIZE - 4), 0x11223344u);
+    EXPECT_EQ(cache.readWord(MEMORY_PAGE_SIZE), 0x55667788u);
+    EXPECT_EQ(cache.readByte(lineSize + 1), 0x99u);
+    EXPECT_EQ(cache.readWord(lineSize + MEMORY_PAGE_SIZE), 0u);
+
+    // writing the dirty line back spans both pages of the first line
+    cache.writeWord(MEMORY_PAGE_SIZE - 2, 0xAABBCCDD);
+    cache.readByte(lineSize);
+    EXPECT_EQ(memory.readWord(MEMORY_PAGE_SIZE - 2), 0xAABBCCDDu);
+    EXPECT_EQ(memory.readWord(MEMORY_PAGE_SIZE - 4), 0xCCDD3344u);
+    EXPECT_EQ(memory.readWord(MEMORY_PAGE_SIZE), 0x5566AABBu);
+}
+
+TEST(MainMemoryTest, RestoreReplacesEveryPage)
+{
+    MainMemory memory;
+    memory.writeWord(0x1000, 1);
+    memory.writeWord(0x20000000, 2);
+
+    std::unordered_map<uint64_t, MemoryBlock> pages;
+    memory.collectDirtyBlocks(pages);
+    ASSERT_EQ(pages.size(), 2u);
+    pages.erase(0x20000000 >> MEMORY_PAGE_SHIFT);
+
+    memory.writeWord(0x1000, 3);
+    memory.writeWord(0x30000000, 4);
+    memory.restoreBlocks(pages);
+    EXPECT_EQ(memory.readWord(0x1000), 1u);
+    EXPECT_EQ(memory.readWord(0x20000000), 0u);
+    EXPECT_EQ(memory.readWord(0x30000000), 0u);
+
+    std::unordered_map<uint64_t, MemoryBlock> dirty;
+    memory.collectDirtyBlocks(dirty);
+    EXPECT_TRUE(dirty.empty());
+    memory.markBlockDirty(1);
+    memory.collectDirtyBlocks(dirty);
+    EXPECT_EQ(dirty.size(), 1u);
+}
+
+TEST(MainMemoryTest, WindowsAndPageTableHoldTheSameContents)
+{
+    const uint64_t windowEnd =
+        vm_config::config.getDataSectionStart() + vm_config::config.getDataWindowSize();
+    const uint64_t addresses[] = {0x100, 0x10000010, windowEnd - 4, 0xFFFFFFFFFFFFFFF0ull,
+                                  0x7000000000000000ull};
+    for (vm_config::MemoryBackend backend :
+         {vm_config::MemoryBackend::SPARSE, vm_config::MemoryBackend::MAPPED})
+    {
+        MemoryBackendGuard guard(backend);
+        MainMemory memory;
+        for (uint64_t address : addresses)
+        {
+            memory.writeDoubleWord(address, address ^ 0x0123456789ABCDEFull);
+        }
+        for (uint64_t address : addresses)
+        {
+            EXPECT_EQ(memory.readDoubleWord(address), address ^ 0x0123456789ABCDEFull);
+        }
+        // the word across the end of the data window is split between a window and a page
+        EXPECT_EQ(memory.readWord(windowEnd - 2),
+                  static_cast<uint32_t>(((windowEnd - 4) ^ 0x0123456789ABCDEFull) >> 16));
+
+        std::unordered_map<uint64_t, MemoryBlock> pages;
+        memory.collectDirtyBlocks(pages);
+        EXPECT_EQ(pages.size(), 6u);
+        EXPECT_EQ(pages.count(windowEnd >> MEMORY_PAGE_SHIFT), 1u);
+
+        memory.restoreBlocks({});
+        for (uint64_t address : addresses)
+        {
+            EXPECT_EQ(memory.readDoubleWord(address), 0u);
+        }
+        memory.restoreBlocks(pages);
+        for (uint64_t address : addresses)
+        {
+            EXPECT_EQ(memory.readDoubleWord(address), address ^ 0x0123456789ABCDEFull);
+        }
+    }
+}
+
+TEST(MainMemoryTest, SnapshotRestoresOnlyWhatChanged)
+{
+    for (vm_config::MemoryBackend backend :
+         {vm_config::MemoryBackend::SPARSE, vm_config::MemoryBackend::MAPPED})
+    {
+        MemoryBackendGuard guard(backend);
+        MainMemory memory;
+        memory.writeWord(0x10000000, 7);
+        memory.writeWord(0x7000000000000000ull, 8);
+        memory.takeSnapshot();
+
+        memory.writeWord(0x10000000, 70);
+        memory.writeWord(0x10000004, 71);
+        memory.writeWord(0x7000000000001000ull, 9);
+        memory.writeDoubleWord(0xFFFFFFFFFFFFFFF0ull, 10);
+        memory.restoreSnapshot();
+        EXPECT_EQ(memory.readWord(0x10000000), 7u);
+        EXPECT_EQ(memory.readWord(0x10000004), 0u);
+        EXPECT_EQ(memory.readWord(0x7000000000000000ull), 8u);
+        EXPECT_EQ(memory.readWord(0x7000000000001000ull), 0u);
+        EXPECT_EQ(memory.readDoubleWord(0xFFFFFFFFFFFFFFF0ull), 0u);
+
+        // the snapshot survives a restore, and restored pages are reported to checkpoints
+        memory.writeWord(0x7000000000000000ull, 80);
+        memory.restoreSnapshot();
+        EXPECT_EQ(memory.readWord(0x7000000000000000ull), 8u);
+        std::unordered_map<uint64_t, MemoryBlock> dirty;
+        memory.collectDirtyBlocks(dirty);
+        EXPECT_EQ(dirty.count(0x7000000000000000ull >> MEMORY_PAGE_SHIFT), 1u);
+
+        memory.discardSnapshot();
+        memory.writeWord(0x10000000, 700);
+        EXPECT_FALSE(memory.hasSnapshot());
+        EXPECT_EQ(memory.readWord(0x10000000), 700u);
+    }
+}
+
+TEST(MainMemoryTest, ReloadingTheSameProgramRestoresItsImage)
+{
+    setupVmStateDirectory();
+    std::istringstream source(R"(.data
+counter: .word 5
+.text
+    la x10, counter
+    lw x5, 0(x10)
+    addi x5, x5, 1
+    sw x5, 0(x10)
+    li x11, 0x10002000
+    sd x5, 0(x11)
+)");
+    AssembledProgram program = assemble(source);
+    std::istringstream otherSource(".text\n    addi x5, x0, 1\n");
+    AssembledProgram other = assemble(otherSource);
+    const uint64_t counter = vm_config::config.getDataSectionStart();
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+    EXPECT_EQ(vm.memory_controller_.readWord_d(counter), 6u);
+    EXPECT_EQ(vm.memory_controller_.readDoubleWord_d(counter + 0x2000), 6u);
+
+    for (int run = 0; run < 3; ++run)
+    {
+        vm.Reset();
+        vm.LoadProgram(program);
+        EXPECT_EQ(vm.memory_controller_.readWord_d(counter), 5u);
+        EXPECT_EQ(vm.memory_controller_.readDoubleWord_d(counter + 0x2000), 0u);
+        vm.FastRun();
+        EXPECT_EQ(vm.registers_.ReadGpr(5), 6u);
+        EXPECT_EQ(vm.memory_controller_.readWord_d(counter), 6u);
+    }
+
+    // another program starts from empty memory, not from the image of the previous one
+    vm.Reset();
+    vm.LoadProgram(other);
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.memory_controller_.readWord_d(counter), 0u);
+    EXPECT_EQ(vm.memory_controller_.readWord_d(4), 0u);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/memory_timing.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rv5s/rv5s_processor_nh_nf.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+
+namespace
+{
+
+const vm_config::MemoryTimingConfig kTiming{.enabled = true,
+                                            .l1_hit_latency = 1,
+                                            .instruction_hit_latency = 1,
+                                            .l2_hit_latency = 10,
+                                            .memory_latency = 100,
+                                            .memory_bandwidth = 8,
+                                            .mshr_count = 2};
+
+// strided loads and stores over 1 KiB, so the small caches below miss, evict and write back
+const std::string kStrideProgram = R"(.data
+buf: .zero 1024
+.text
+    la x10, buf
+    li x5, 120
+    li x9, 0
+loop:
+    mul x6, x5, x9
+    andi x6, x6, 1016
+    add x7, x6, x10
+    ld x8, 0(x7)
+    add x8, x8, x5
+    sd x8, 0(x7)
+    addi x9, x9, 7
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+struct RunResult
+{
+    unsigned int cycles = 0;
+    unsigned int retired = 0;
+    unsigned int hazard_stalls = 0;
+    unsigned int memory_stalls = 0;
+    uint64_t x8 = 0;
+};
+
+template <typename Processor> RunResult runStrideProgram()
+{
+    Finishing<Processor> vm;
+    const CacheConfig small{.lineCount = 4, .lineSizeInBytes = 16, .wayCount = 2,
+                            .writePolicy = WritePolicy::WriteBack,
+                            .allocationPolicy = AllocationPolicy::WriteAllocate,
+                            .replacementPolicy = ReplacementPolicy::LRU};
+    vm.memory_controller_.getL1Cache()->reconfigure(small);
+    vm.memory_controller_.getInstructionCache()->reconfigure(small);
+    runToEnd(vm, kStrideProgram);
+    return {vm.cycle_s_, vm.instructions_retired_, vm.stall_cycles_, vm.memory_stall_cycles_,
+            vm.registers_.ReadGpr(8)};
+}
+
+template <typename Processor> void expectOnlyMemoryStallsAdded()
+{
+    RunResult ideal;
+    {
+        MemoryTimingGuard guard({});
+        ideal = runStrideProgram<Processor>();
+    }
+    MemoryTimingGuard guard(kTiming);
+    const RunResult timed = runStrideProgram<Processor>();
+
+    EXPECT_EQ(ideal.memory_stalls, 0u);
+    EXPECT_GT(timed.memory_stalls, 0u);
+    // the pipeline freezes while it waits, so nothing else about the run changes
+    EXPECT_EQ(timed.x8, ideal.x8);
+    EXPECT_EQ(timed.retired, ideal.retired);
+    EXPECT_EQ(timed.hazard_stalls, ideal.hazard_stalls);
+    EXPECT_EQ(timed.cycles, ideal.cycles + timed.memory_stalls);
+}
+
+} // namespace
+
+TEST(MemoryTimingTest, ChargesEachLevelItsLatency)
+{
+    MemoryTimingModel model;
+    model.configure(kTiming);
+
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 1, MemoryLevel::L1, 0, 64), 0u);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 2, MemoryLevel::L2, 0, 64), 10u);
+    // l1 and l2 lookups, memory, then 64 bytes at 8 a cycle; the stage's own cycle is not extra
+    EXPECT_EQ(model.access(TimedAccess::FETCH, 3, MemoryLevel::MEMORY, 100, 64),
+              1u + 10u + 100u + 8u - 1u);
+
+    vm_config::MemoryTimingConfig slow = kTiming;
+    slow.l1_hit_latency = 3;
+    model.configure(slow);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 1, MemoryLevel::L1, 0, 64), 2u);
+    EXPECT_EQ(model.access(TimedAccess::FETCH, 1, MemoryLevel::L1, 0, 64), 0u);
+}
+
+TEST(MemoryTimingTest, MissesShareTheBusAndTheMshrs)
+{
+    MemoryTimingModel model;
+    vm_config::MemoryTimingConfig config = kTiming;
+    config.mshr_count = 4;
+    model.configure(config);
+
+    // the second line comes in behind the first
+    const uint64_t first = model.access(TimedAccess::LOAD, 1, MemoryLevel::MEMORY, 0, 64);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 2, MemoryLevel::MEMORY, 0, 64), first + 8);
+
+    // a store miss only waits for the lookup, a load of the same line waits for the data
+    model.reset();
+    EXPECT_EQ(model.access(TimedAccess::STORE, 5, MemoryLevel::MEMORY, 0, 64), 0u);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 5, MemoryLevel::L1, 20, 64), first - 20);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 5, MemoryLevel::L1, first + 1, 64), 0u);
+
+    // with every MSHR taken a miss has to wait for the first one to free up
+    config.mshr_count = 1;
+    model.configure(config);
+    EXPECT_EQ(model.access(TimedAccess::STORE, 1, MemoryLevel::L2, 0, 64), 0u);
+    EXPECT_EQ(model.access(TimedAccess::STORE, 2, MemoryLevel::L2, 0, 64), 11u);
+    const MemoryTimingModel::State saved = model.saveState();
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 3, MemoryLevel::L2, 0, 64), 32u);
+    model.restoreState(saved);
+    EXPECT_EQ(model.access(TimedAccess::LOAD, 3, MemoryLevel::L2, 0, 64), 32u);
+}
+
+TEST(MemoryTimingTest, PipelinesStallOnlyForMemory)
+{
+    setupVmStateDirectory();
+    expectOnlyMemoryStallsAdded<RV5StageProcessorHF>();
+    expectOnlyMemoryStallsAdded<RV5StageProcessorNHNF>();
+}
+
+TEST(MemoryTimingTest, UndoRestoresTheMemoryStall)
+{
+    setupVmStateDirectory();
+    MemoryTimingGuard guard(kTiming);
+    std::istringstream source(kStrideProgram);
+    AssembledProgram program = assemble(source);
+    RV5StageProcessorHF vm;
+    vm.LoadProgram(program);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    // the first fetch goes all the way to memory
+    vm.Step();
+    const unsigned int waiting_from = vm.cycle_s_;
+    while (vm.memory_stall_cycles_ < 5)
+    {
+        vm.Step();
+    }
+    EXPECT_EQ(vm.cycle_s_, waiting_from + 5);
+    vm.Undo();
+    vm.Undo();
+    EXPECT_EQ(vm.memory_stall_cycles_, 3u);
+    vm.Redo();
+    vm.Step();
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.memory_stall_cycles_, 5u);
+    EXPECT_EQ(vm.cycle_s_, waiting_from + 5);
+}
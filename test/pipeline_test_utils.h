@@ -0,0 +1,148 @@
+/**
+ * @file pipeline_test_utils.h
+ * @brief Configuration guards and run helpers shared by the pipeline tests.
+ */
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/rvss/rvss_processor.h"
+
+namespace Kites::test
+{
+// --- Guards putting a piece of the VM configuration back when they go out of scope ---
+
+class BranchPredictorGuard
+{
+  public:
+    explicit BranchPredictorGuard(vm_config::BranchPredictorType type)
+        : saved_(vm_config::config.getBranchPredictor())
+    {
+        vm_config::BranchPredictorConfig config = saved_;
+        config.type = type;
+        vm_config::config.setBranchPredictor(config);
+    }
+    ~BranchPredictorGuard()
+    {
+        vm_config::config.setBranchPredictor(saved_);
+    }
+
+  private:
+    vm_config::BranchPredictorConfig saved_;
+};
+
+class FunctionalUnitGuard
+{
+  public:
+    explicit FunctionalUnitGuard(const vm_config::FunctionalUnitConfig &units)
+        : saved_(vm_config::config.getFunctionalUnits())
+    {
+        vm_config::config.setFunctionalUnits(units);
+    }
+    ~FunctionalUnitGuard()
+    {
+        vm_config::config.setFunctionalUnits(saved_);
+    }
+
+  private:
+    vm_config::FunctionalUnitConfig saved_;
+};
+
+class MemoryTimingGuard
+{
+  public:
+    explicit MemoryTimingGuard(const vm_config::MemoryTimingConfig &timing)
+        : saved_(vm_config::config.getMemoryTiming())
+    {
+        vm_config::config.setMemoryTiming(timing);
+    }
+    ~MemoryTimingGuard()
+    {
+        vm_config::config.setMemoryTiming(saved_);
+    }
+
+  private:
+    vm_config::MemoryTimingConfig saved_;
+};
+
+// --- Running programs to the end ---
+
+// exposes whether a pipeline has drained past the last instruction
+template <typename Processor> struct Finishing : Processor
+{
+    [[nodiscard]] bool finished() const
+    {
+        return this->ReplayFinished();
+    }
+};
+
+// loads @p source into @p vm and steps it until it finishes, with its output muted
+template <typename Processor> void runToEnd(Processor &vm, const std::string &source)
+{
+    std::istringstream stream(source);
+    vm.LoadProgram(assemble(stream));
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    while (!vm.finished())
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+}
+
+template <typename Processor> unsigned int cycles(const std::string &source)
+{
+    Finishing<Processor> vm;
+    runToEnd(vm, source);
+    return vm.cycle_s_;
+}
+
+// runs @p source on Processor and on RVSSProcessor and compares the register files
+template <typename Processor> void expectSameRegisters(const std::string &source)
+{
+    std::istringstream stream(source);
+    RVSSProcessor reference;
+    reference.LoadProgram(assemble(stream));
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    while (reference.program_counter_ < reference.program_size_)
+    {
+        reference.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+
+    Finishing<Processor> vm;
+    runToEnd(vm, source);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(vm.registers_.ReadGpr(i), reference.registers_.ReadGpr(i)) << "x" << int(i);
+        EXPECT_EQ(vm.registers_.ReadFpr(i), reference.registers_.ReadFpr(i)) << "f" << int(i);
+    }
+}
+
+// the variants without hazard detection need room between dependent instructions, more the
+// longer the units take: puts @p nops after every instruction of @p source
+inline std::string padded(const std::string &source, unsigned int nops = 4)
+{
+    std::istringstream lines(source);
+    std::ostringstream out;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        out << line << "\n";
+        if (line.rfind("    ", 0) == 0)
+        {
+            for (unsigned int i = 0; i < nops; ++i)
+            {
+                out << "    nop\n";
+            }
+        }
+    }
+    return out.str();
+}
+} // namespace Kites::test
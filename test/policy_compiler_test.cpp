@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "processor/cache/cache.h"
+#include "processor/cache/policies/custom_policy.h"
+#include "processor/cache/policy_compiler.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+class ScriptFile
+{
+  public:
+    ScriptFile(const std::string &name, const std::string &source)
+        : m_path((std::filesystem::temp_directory_path() / name).string())
+    {
+        std::ofstream(m_path) << source;
+    }
+    ~ScriptFile()
+    {
+        std::filesystem::remove(m_path);
+    }
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+  private:
+    std::string m_path;
+};
+
+// the native LFU: fewest hits since insertion, least recently used on a tie
+const std::string LFU_POLICY = R"(
+policy = {
+    counters = { "hits" },
+    onAccess = "hits = hits + 1",
+    victim = { "min hits", "min lastAccess" },
+}
+)";
+
+const CacheContextView CONTEXT{.setCount = 2, .wayCount = 2, .blockSize = 16, .tick = 7};
+
+int64_t valueAfterInsert(const std::string &expression)
+{
+    CompiledPolicy policy = CompiledPolicy::compile(
+        {.counters = {"x", "y"}, .onInsert = "y = 5; x = " + expression, .victim = {"min x"}});
+    const CacheLineView line{.valid = true, .tag = 3, .frequency = 4, .lastAccess = 6};
+    policy.onInsert(line, {.setIndex = 1, .wayIndex = 1}, CONTEXT);
+    return policy.counter(1, 1, 0);
+}
+
+std::vector<bool> runMixed(Cache &cache, int count)
+{
+    std::vector<bool> hits;
+    uint64_t state = 5;
+    for (int i = 0; i < count; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const size_t before = cache.getHitCount();
+        (void)cache.readWord(((state >> 33) % 160) * 16);
+        hits.push_back(cache.getHitCount() != before);
+    }
+    return hits;
+}
+
+} // namespace
+
+TEST(PolicyCompilerTest, EvaluatesExpressions)
+{
+    EXPECT_EQ(valueAfterInsert("2 + 3 * 4 - (1 - -1)"), 12);
+    EXPECT_EQ(valueAfterInsert("17 / 5 + 17 % 5"), 5);
+    EXPECT_EQ(valueAfterInsert("7 / (y - 5) + 7 % 0"), 0);
+    EXPECT_EQ(valueAfterInsert("min(y, 3) * 10 + max(-y, tag)"), 33);
+    EXPECT_EQ(valueAfterInsert("frequency + lastAccess + valid + dirty + way + set + tick"),
+              4 + 6 + 1 + 0 + 1 + 1 + 7);
+    // a new line starts from zero before onInsert runs
+    EXPECT_EQ(valueAfterInsert("x + 1"), 1);
+}
+
+TEST(PolicyCompilerTest, RejectsWhatItCannotCompile)
+{
+    const auto compile = [](PolicyDescription description)
+    {
+        if (description.victim.empty())
+        {
+            description.victim = {"min hits"};
+        }
+        description.counters.push_back("hits");
+        return CompiledPolicy::compile(description);
+    };
+    EXPECT_NO_THROW(compile({.onAccess = "hits = hits + 1;"}));
+    EXPECT_THROW(compile({.onAccess = "hits = misses"}), PolicyCompileError);
+    EXPECT_THROW(compile({.onAccess = "age = 1"}), PolicyCompileError);
+    EXPECT_THROW(compile({.onAccess = "hits = hits + 1 hits = 0"}), PolicyCompileError);
+    EXPECT_THROW(compile({.onAccess = "hits = (hits"}), PolicyCompileError);
+    EXPECT_THROW(compile({.onAccess = "if hits then hits = 0 end"}), PolicyCompileError);
+    EXPECT_THROW(compile({.onAccess = "hits = " + std::string(200, '(') + "1" +
+                                      std::string(200, ')')}),
+                 PolicyCompileError);
+    EXPECT_THROW(compile({.victim = {"lowest hits"}}), PolicyCompileError);
+    EXPECT_THROW(compile({.counters = {"age"}}), PolicyCompileError);
+    EXPECT_THROW(CompiledPolicy::compile({.counters = {"hits"}}), PolicyCompileError);
+}
+
+TEST(PolicyCompilerTest, CompiledLFUMatchesTheNativeOne)
+{
+    ScriptFile script("kites_compiled_lfu.lua", LFU_POLICY);
+    CustomReplacementPolicy policy(script.path());
+    EXPECT_TRUE(policy.isCompiled());
+    EXPECT_EQ(policy.getCompileError(), "");
+
+    MainMemory memory;
+    Cache compiled(memory, 8, 16, 4, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                   ReplacementPolicy::LRU);
+    compiled.loadCustomPolicyScript(script.path());
+    ASSERT_EQ(compiled.getConfig().replacementPolicy, ReplacementPolicy::Custom);
+    Cache native(memory, 8, 16, 4, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                 ReplacementPolicy::LFU);
+    EXPECT_EQ(runMixed(compiled, 5000), runMixed(native, 5000));
+
+    // the counters come back with the rest of the cache
+    const CacheState saved = compiled.saveState();
+    const std::vector<bool> hits = runMixed(compiled, 2000);
+    compiled.restoreState(saved);
+    EXPECT_EQ(runMixed(compiled, 2000), hits);
+}
+
+TEST(PolicyCompilerTest, FallsBackToLuaForUnsupportedPolicies)
+{
+    ScriptFile fallback("kites_policy_fallback.lua", R"(
+policy = { counters = { "hits" }, onAccess = function() end, victim = "min hits" }
+
+function chooseVictim(lines, request, cache)
+    return 1
+end
+)");
+    CustomReplacementPolicy policy(fallback.path());
+    EXPECT_FALSE(policy.isCompiled());
+    EXPECT_NE(policy.getCompileError().find("onAccess"), std::string::npos);
+    const std::vector<CacheLineView> lines(2, CacheLineView{.valid = true});
+    EXPECT_EQ(policy.chooseVictim(lines, {}, {1, 2, 16, 0}), 0u);
+
+    ScriptFile noFallback("kites_policy_no_fallback.lua",
+                          "policy = { victim = \"min rrpv\" }\n");
+    EXPECT_THROW(CustomReplacementPolicy{noFallback.path()}, std::runtime_error);
+}
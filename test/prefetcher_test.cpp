@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+constexpr uint64_t BASE = 0x10000;
+
+Cache makeCache(MainMemory &memory, size_t sets = 16, size_t ways = 2)
+{
+    return Cache(memory, sets, 16, ways, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                 ReplacementPolicy::LRU);
+}
+
+// word loads walking forwards or backwards through @p bytes
+void streamThrough(Cache &cache, uint64_t bytes, bool descending = false)
+{
+    for (uint64_t offset = 0; offset < bytes; offset += 4)
+    {
+        (void)cache.readWord(BASE + (descending ? bytes - 4 - offset : offset));
+    }
+}
+
+} // namespace
+
+TEST(PrefetcherTest, NoPrefetcherLeavesTheStatisticsAlone)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory);
+    streamThrough(cache, 1024);
+    const CacheStats stats = cache.getStats();
+    EXPECT_EQ(stats.missCount, 1024u / 16u);
+    EXPECT_EQ(stats.prefetchIssuedCount, 0u);
+    EXPECT_EQ(stats.prefetchAccuracy, 0.0);
+    EXPECT_EQ(cache.getConfig().prefetcher, PrefetcherType::None);
+}
+
+TEST(PrefetcherTest, NextLineCoversASequentialStream)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory);
+    cache.setPrefetcher(PrefetcherType::NextLine, 2, 1);
+    streamThrough(cache, 1024);
+
+    const CacheStats stats = cache.getStats();
+    // only the first line misses, every later one is brought in while the one before is read
+    EXPECT_EQ(stats.missCount, 1u);
+    EXPECT_GE(stats.prefetchUsefulCount, 1024u / 16u - 1u);
+    EXPECT_GT(stats.prefetchAccuracy, 0.9);
+    EXPECT_GT(stats.prefetchCoverage, 0.9);
+    EXPECT_EQ(cache.getConfig().prefetcher, PrefetcherType::NextLine);
+    EXPECT_EQ(cache.getConfig().prefetchDegree, 2u);
+}
+
+TEST(PrefetcherTest, StrideLearnsPerInstruction)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, 64, 4);
+    cache.setPrefetcher(PrefetcherType::Stride, 1, 2);
+
+    // two loads interleaved: one striding 96 bytes, the other stuck on one word
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        cache.setAccessPc(0x100);
+        (void)cache.readWord(BASE + i * 96);
+        cache.setAccessPc(0x104);
+        (void)cache.readWord(BASE - 64);
+    }
+    const CacheStats stats = cache.getStats();
+    // after a few iterations of training the strided load always finds its line waiting
+    EXPECT_LT(stats.missCount, 10u);
+    EXPECT_GT(stats.prefetchAccuracy, 0.9);
+
+    // without pcs both loads share one table entry and never settle on a stride
+    Cache untrained = makeCache(memory, 64, 4);
+    untrained.setPrefetcher(PrefetcherType::Stride, 1, 2);
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        (void)untrained.readWord(BASE + i * 96);
+        (void)untrained.readWord(BASE - 64);
+    }
+    EXPECT_GT(untrained.getMissCount(), 150u);
+}
+
+TEST(PrefetcherTest, StreamFollowsADescendingWalk)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory);
+    cache.setPrefetcher(PrefetcherType::Stream, 2, 1);
+    streamThrough(cache, 2048, true);
+
+    const CacheStats stats = cache.getStats();
+    EXPECT_LT(stats.missCount, 4u);
+    EXPECT_GT(stats.prefetchCoverage, 0.9);
+}
+
+TEST(PrefetcherTest, CountsLateAndUselessPrefetches)
+{
+    MainMemory memory;
+    // one queued line is filled per access, so skipping every other line outruns the queue
+    Cache late = makeCache(memory, 64, 4);
+    late.setPrefetcher(PrefetcherType::NextLine, 8, 1);
+    for (uint64_t line = 0; line < 256; line += 2)
+    {
+        (void)late.readWord(BASE + line * 16);
+    }
+    EXPECT_GT(late.getStats().prefetchLateCount, 0u);
+
+    // random lines: next-line guesses are never used and get evicted again
+    Cache useless = makeCache(memory, 4, 1);
+    useless.setPrefetcher(PrefetcherType::NextLine, 1, 1);
+    uint64_t state = 1;
+    for (int i = 0; i < 500; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        (void)useless.readWord(BASE + ((state >> 33) % 4096) * 16);
+    }
+    const CacheStats stats = useless.getStats();
+    EXPECT_GT(stats.prefetchUselessCount, stats.prefetchUsefulCount);
+    EXPECT_LT(stats.prefetchAccuracy, 0.2);
+}
+
+TEST(PrefetcherTest, StateRestoresAndResetClearsCounters)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory);
+    cache.setPrefetcher(PrefetcherType::NextLine, 1, 1);
+    streamThrough(cache, 256);
+    const CacheState saved = cache.saveState();
+    const CacheStats before = cache.getStats();
+    ASSERT_GT(before.prefetchIssuedCount, 0u);
+
+    cache.setPrefetcher(PrefetcherType::None, 1, 1);
+    streamThrough(cache, 512);
+    cache.restoreState(saved);
+    const CacheStats restored = cache.getStats();
+    EXPECT_EQ(cache.getConfig().prefetcher, PrefetcherType::NextLine);
+    EXPECT_EQ(restored.prefetchIssuedCount, before.prefetchIssuedCount);
+    EXPECT_EQ(restored.prefetchUsefulCount, before.prefetchUsefulCount);
+
+    cache.reset();
+    const CacheStats cleared = cache.getStats();
+    EXPECT_EQ(cleared.prefetchIssuedCount, 0u);
+    EXPECT_EQ(cleared.prefetchUsefulCount, 0u);
+    EXPECT_EQ(cleared.prefetchLateCount, 0u);
+    EXPECT_EQ(cache.getConfig().prefetcher, PrefetcherType::NextLine);
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "processor/cache/cache.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+constexpr uint64_t BASE = 0x10000;
+constexpr size_t LINE = 16;
+
+Cache makeCache(MainMemory &memory, ReplacementPolicy policy, size_t sets = 1, size_t ways = 4)
+{
+    return Cache(memory, sets, LINE, ways, WritePolicy::WriteBack, AllocationPolicy::WriteAllocate,
+                 policy);
+}
+
+// address of line @p index of set @p set
+uint64_t lineAddress(uint64_t index, size_t sets = 1, size_t set = 0)
+{
+    return BASE + (index * sets + set) * LINE;
+}
+
+void touch(Cache &cache, std::initializer_list<uint64_t> lines)
+{
+    for (uint64_t line : lines)
+    {
+        (void)cache.readWord(lineAddress(line));
+    }
+}
+
+// which of lines 0..count-1 of a one set cache are still held
+std::vector<bool> resident(const Cache &cache, uint64_t count)
+{
+    std::vector<bool> held;
+    for (uint64_t line = 0; line < count; ++line)
+    {
+        held.push_back(cache.contains(lineAddress(line)));
+    }
+    return held;
+}
+
+// three hot lines reused between bursts of two lines that are never seen again
+size_t hitsWithScans(ReplacementPolicy policy)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, policy);
+    uint64_t scanLine = 100;
+    for (int round = 0; round < 100; ++round)
+    {
+        touch(cache, {0, 1, 2, 0, 1, 2});
+        touch(cache, {scanLine, scanLine + 1});
+        scanLine += 2;
+    }
+    return cache.getHitCount();
+}
+
+// every set loops over six lines with only four ways
+size_t hitsWhenThrashing(ReplacementPolicy policy, size_t sets = 1)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, policy, sets);
+    for (int round = 0; round < 200; ++round)
+    {
+        for (uint64_t line = 0; line < 6; ++line)
+        {
+            for (size_t set = 0; set < sets; ++set)
+            {
+                (void)cache.readWord(lineAddress(line, sets, set));
+            }
+        }
+    }
+    return cache.getHitCount();
+}
+
+// a mix of reuse and misses over 8 sets, returning the hit (true) or miss of every access
+std::vector<bool> runMixed(Cache &cache, uint64_t seed, int count)
+{
+    std::vector<bool> hits;
+    uint64_t state = seed;
+    for (int i = 0; i < count; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const size_t before = cache.getHitCount();
+        (void)cache.readWord(BASE + ((state >> 33) % 96) * LINE);
+        hits.push_back(cache.getHitCount() != before);
+    }
+    return hits;
+}
+
+} // namespace
+
+TEST(ReplacementPolicyTest, TreePLRUFollowsTheTree)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, ReplacementPolicy::TreePLRU);
+    touch(cache, {0, 1, 2, 3, 0});
+    // the root points at ways 2-3 after line 0, their node at way 2 after line 3; true LRU
+    // would have picked line 1
+    touch(cache, {4});
+    EXPECT_EQ(resident(cache, 5), (std::vector<bool>{true, true, false, true, true}));
+    EXPECT_EQ(cache.getConfig().replacementPolicy, ReplacementPolicy::TreePLRU);
+}
+
+TEST(ReplacementPolicyTest, TreePLRUSkipsMissingWays)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, ReplacementPolicy::TreePLRU, 1, 3);
+    touch(cache, {0, 1, 2});
+    touch(cache, {3}); // line 2 turned the root towards ways 0-1
+    EXPECT_EQ(resident(cache, 4), (std::vector<bool>{false, true, true, true}));
+    // line 1 turns the root towards ways 2-3, where only way 2 exists
+    touch(cache, {1, 4});
+    EXPECT_EQ(resident(cache, 5), (std::vector<bool>{false, true, false, true, true}));
+}
+
+TEST(ReplacementPolicyTest, BitPLRUStartsANewRoundWhenAllBitsAreSet)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, ReplacementPolicy::BitPLRU);
+    // the fourth line sets the last bit, so only its own stays set; line 0 sets its bit again
+    touch(cache, {0, 1, 2, 3, 0, 4});
+    EXPECT_EQ(resident(cache, 5), (std::vector<bool>{true, false, true, true, true}));
+    touch(cache, {5});
+    EXPECT_EQ(resident(cache, 6), (std::vector<bool>{true, false, false, true, true, true}));
+}
+
+TEST(ReplacementPolicyTest, SRRIPEvictsTheDistantLines)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, ReplacementPolicy::SRRIP);
+    touch(cache, {0, 1, 2, 3, 0, 2});
+    // lines 1 and 3 were never reused, ageing the set takes them to distant first
+    touch(cache, {4});
+    EXPECT_EQ(resident(cache, 5), (std::vector<bool>{true, false, true, true, true}));
+    touch(cache, {5});
+    EXPECT_EQ(resident(cache, 6), (std::vector<bool>{true, false, true, false, true, true}));
+}
+
+TEST(ReplacementPolicyTest, RRIPKeepsTheWorkingSetThroughScans)
+{
+    const size_t lru = hitsWithScans(ReplacementPolicy::LRU);
+    const size_t srrip = hitsWithScans(ReplacementPolicy::SRRIP);
+    // only the warm up misses on the hot lines
+    EXPECT_EQ(srrip, 100u * 6u - 3u);
+    // LRU loses the hot lines to every scan and only hits their second pass
+    EXPECT_EQ(lru, 100u * 3u);
+    EXPECT_GT(hitsWithScans(ReplacementPolicy::DRRIP), lru);
+}
+
+TEST(ReplacementPolicyTest, BimodalInsertionResistsThrashing)
+{
+    EXPECT_EQ(hitsWhenThrashing(ReplacementPolicy::LRU), 0u);
+    const size_t srrip = hitsWhenThrashing(ReplacementPolicy::SRRIP);
+    const size_t brrip = hitsWhenThrashing(ReplacementPolicy::BRRIP);
+    // BRRIP pins most of the loop in the cache and lets the rest stream through
+    EXPECT_GT(brrip, 200u * 6u / 3u);
+    EXPECT_GT(brrip, srrip);
+
+    // with enough sets to duel, DRRIP's followers learn to insert like BRRIP
+    const size_t sets = 64;
+    EXPECT_GT(hitsWhenThrashing(ReplacementPolicy::DRRIP, sets),
+              hitsWhenThrashing(ReplacementPolicy::SRRIP, sets) * 2);
+}
+
+TEST(ReplacementPolicyTest, LFUEvictsTheLeastUsedLine)
+{
+    MainMemory memory;
+    Cache cache = makeCache(memory, ReplacementPolicy::LFU);
+    touch(cache, {0, 1, 2, 3, 0, 0, 1, 3, 3});
+    touch(cache, {4});
+    EXPECT_EQ(resident(cache, 5), (std::vector<bool>{true, true, false, true, true}));
+    // once line 4 is hit it ties with line 1 at one hit, and line 1 was used longer ago
+    touch(cache, {4, 5});
+    EXPECT_EQ(resident(cache, 6), (std::vector<bool>{true, false, false, true, true, true}));
+}
+
+TEST(ReplacementPolicyTest, RandomIsReproducibleFromItsSeed)
+{
+    MainMemory memory;
+    Cache first = makeCache(memory, ReplacementPolicy::Random, 8);
+    Cache second = makeCache(memory, ReplacementPolicy::Random, 8);
+    const std::vector<bool> hits = runMixed(first, 1, 2000);
+    EXPECT_EQ(runMixed(second, 1, 2000), hits);
+    first.reset();
+    EXPECT_EQ(runMixed(first, 1, 2000), hits);
+
+    // every way gets picked
+    Cache single = makeCache(memory, ReplacementPolicy::Random);
+    touch(single, {0, 1, 2, 3});
+    std::vector<bool> evicted(4, false);
+    for (uint64_t line = 4; line < 100; ++line)
+    {
+        const std::vector<bool> before = resident(single, line);
+        touch(single, {line});
+        for (uint64_t old = 0; old < 4; ++old)
+        {
+            if (before[old] && !single.contains(lineAddress(old)))
+            {
+                evicted[old] = true;
+            }
+        }
+    }
+    EXPECT_EQ(evicted, (std::vector<bool>{true, true, true, true}));
+}
+
+TEST(ReplacementPolicyTest, RestoredStatePicksTheSameVictims)
+{
+    for (ReplacementPolicy policy :
+         {ReplacementPolicy::TreePLRU, ReplacementPolicy::BitPLRU, ReplacementPolicy::SRRIP,
+          ReplacementPolicy::BRRIP, ReplacementPolicy::DRRIP, ReplacementPolicy::LFU,
+          ReplacementPolicy::Random})
+    {
+        MainMemory memory;
+        Cache cache = makeCache(memory, policy, 8);
+        (void)runMixed(cache, 7, 500);
+        const CacheState saved = cache.saveState();
+        const std::vector<bool> hits = runMixed(cache, 11, 1000);
+
+        // a fresh cache of the same kind must end up in the same place, whatever it did before
+        Cache restored = makeCache(memory, policy, 8);
+        (void)runMixed(restored, 3, 300);
+        restored.restoreState(saved);
+        EXPECT_EQ(runMixed(restored, 11, 1000), hits) << static_cast<int>(policy);
+    }
+}
@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/rv5s/rv5s_hdu.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rv5s/rv5s_processor_h_nf.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+using vm_config::BranchPredictorType;
+
+namespace
+{
+
+class ResolutionGuard
+{
+  public:
+    ResolutionGuard(bool early, BranchPredictorType type)
+        : savedEarly_(vm_config::config.getEarlyBranchResolution()), predictor_(type)
+    {
+        vm_config::config.setEarlyBranchResolution(early);
+    }
+    ~ResolutionGuard()
+    {
+        vm_config::config.setEarlyBranchResolution(savedEarly_);
+    }
+
+  private:
+    bool savedEarly_;
+    BranchPredictorGuard predictor_;
+};
+
+// the loop counter is updated two instructions before the branch, so forwarding covers it
+const std::string kLoopProgram = R"(.text
+    li x5, 10
+    li x6, 0
+loop:
+    addi x5, x5, -1
+    addi x6, x6, 2
+    bne x5, x0, loop
+    addi x6, x6, 100
+)";
+
+// the loop counter is updated right before the branch
+const std::string kTightLoopProgram = R"(.text
+    li x5, 10
+    li x6, 0
+loop:
+    addi x6, x6, 2
+    addi x5, x5, -1
+    bne x5, x0, loop
+    addi x6, x6, 100
+)";
+
+// branches and a return reading a load or ALU result one or two instructions ahead, with the
+// data section at its default start
+const std::string kHazardProgram = R"(.data
+values: .word 3, 0, 5
+.text
+    lui x10, 65536
+    li x6, 0
+    lw x5, 0(x10)
+    bne x5, x0, first
+    addi x6, x6, 1000
+first:
+    lw x5, 4(x10)
+    addi x6, x6, 1
+    beq x5, x0, second
+    addi x6, x6, 1000
+second:
+    jal x1, skip_next
+    addi x6, x6, 1000
+    li x5, 4
+loop:
+    addi x6, x6, 10
+    addi x5, x5, -1
+    bne x5, x0, loop
+    lw x7, 8(x10)
+    blt x0, x7, done
+    addi x6, x6, 1000
+done:
+    addi x6, x6, 2
+    j end
+skip_next:
+    addi x1, x1, 4
+    jalr x0, 0(x1)
+end:
+    addi x6, x6, 0
+)";
+
+struct RunResult
+{
+    unsigned int cycles = 0;
+    unsigned int mispredictions = 0;
+    uint64_t x6 = 0;
+};
+
+template <typename Processor>
+RunResult run(const std::string &source, bool early,
+              BranchPredictorType type = BranchPredictorType::NOT_TAKEN)
+{
+    ResolutionGuard guard(early, type);
+    Finishing<Processor> vm;
+    runToEnd(vm, source);
+    return {vm.cycle_s_, vm.branch_mispredictions_, vm.registers_.ReadGpr(6)};
+}
+
+// beq x5, x6 and jalr x0, 0(x5) as decode sees them
+IF_ID_Register decoding(uint32_t instruction)
+{
+    IF_ID_Register if_id;
+    if_id.instruction = instruction;
+    if_id.pc = 0x40;
+    return if_id;
+}
+const uint32_t kBeqX5X6 = 0x00000063 | (5u << 15) | (6u << 20);
+const uint32_t kJalrX5 = 0x00000067 | (5u << 15) | (6u << 20); // imm 6 reads like rs2 = x6
+
+EX_MEM_Register producing(uint8_t rd, bool load, bool twoAhead)
+{
+    EX_MEM_Register ex_mem;
+    if (twoAhead)
+    {
+        ex_mem.prev_rd = rd;
+        ex_mem.prev_reg_write = true;
+        ex_mem.prev_mem_read = load;
+    }
+    else
+    {
+        ex_mem.rd = rd;
+        ex_mem.reg_write = true;
+        ex_mem.mem_read = load;
+    }
+    return ex_mem;
+}
+
+} // namespace
+
+TEST(RV5StageBranchResolutionTest, HazardUnitWaitsForBranchOperands)
+{
+    ID_EX_Register id_ex;
+    auto stalls = [&](uint32_t instruction, const EX_MEM_Register &ex_mem, bool early)
+    {
+        id_ex.mem_read = ex_mem.mem_read;
+        id_ex.reg_write = ex_mem.reg_write;
+        id_ex.rd = ex_mem.rd;
+        return check_data_hazard(decoding(instruction), id_ex, ex_mem, true, early);
+    };
+
+    // an ALU result in EX, then a load in EX, then a load two ahead
+    EXPECT_EQ(stalls(kBeqX5X6, producing(6, false, false), true), STALL_ONE_CYCLE);
+    EXPECT_EQ(stalls(kBeqX5X6, producing(5, true, false), true), STALL_TWO_CYCLES);
+    EXPECT_EQ(stalls(kBeqX5X6, producing(6, true, true), true), STALL_ONE_CYCLE);
+    EXPECT_EQ(stalls(kBeqX5X6, producing(5, false, true), true), STALL_NONE);
+    EXPECT_EQ(stalls(kJalrX5, producing(5, false, false), true), STALL_ONE_CYCLE);
+    EXPECT_EQ(stalls(kJalrX5, producing(6, false, false), true), STALL_NONE);
+
+    // resolved in EX only the load right ahead holds the branch up
+    EXPECT_EQ(stalls(kBeqX5X6, producing(6, false, false), false), STALL_NONE);
+    EXPECT_EQ(stalls(kBeqX5X6, producing(5, true, false), false), STALL_ONE_CYCLE);
+    EXPECT_EQ(stalls(kBeqX5X6, producing(6, true, true), false), STALL_NONE);
+}
+
+TEST(RV5StageBranchResolutionTest, TakenBranchesCostOneCycleLess)
+{
+    setupVmStateDirectory();
+    const RunResult inExecute = run<RV5StageProcessorHF>(kLoopProgram, false);
+    const RunResult inDecode = run<RV5StageProcessorHF>(kLoopProgram, true);
+    EXPECT_EQ(inExecute.x6, 120u);
+    EXPECT_EQ(inDecode.x6, 120u);
+    EXPECT_EQ(inExecute.mispredictions, 9u);
+    EXPECT_EQ(inDecode.mispredictions, 9u);
+    EXPECT_EQ(inExecute.cycles - inDecode.cycles, 9u);
+
+    // the branch now waits a cycle for the counter, which the taken iterations win back
+    const RunResult tightInExecute = run<RV5StageProcessorHF>(kTightLoopProgram, false);
+    const RunResult tightInDecode = run<RV5StageProcessorHF>(kTightLoopProgram, true);
+    EXPECT_EQ(tightInDecode.x6, 120u);
+    EXPECT_EQ(tightInDecode.cycles, tightInExecute.cycles + 1);
+
+    // without forwarding decode waits for the register file either way
+    const RunResult noForwardingInExecute = run<RV5StageProcessorHNF>(kTightLoopProgram, false);
+    const RunResult noForwardingInDecode = run<RV5StageProcessorHNF>(kTightLoopProgram, true);
+    EXPECT_EQ(noForwardingInDecode.x6, 120u);
+    EXPECT_EQ(noForwardingInExecute.cycles - noForwardingInDecode.cycles, 9u);
+}
+
+TEST(RV5StageBranchResolutionTest, HazardsResolveTheSameInDecode)
+{
+    setupVmStateDirectory();
+    for (BranchPredictorType type : {BranchPredictorType::NOT_TAKEN, BranchPredictorType::TWO_BIT,
+                                     BranchPredictorType::TAGE})
+    {
+        EXPECT_EQ(run<RV5StageProcessorHF>(kHazardProgram, false, type).x6, 43u);
+        EXPECT_EQ(run<RV5StageProcessorHF>(kHazardProgram, true, type).x6, 43u);
+        EXPECT_EQ(run<RV5StageProcessorHNF>(kHazardProgram, false, type).x6, 43u);
+        EXPECT_EQ(run<RV5StageProcessorHNF>(kHazardProgram, true, type).x6, 43u);
+    }
+}
+
+TEST(RV5StageBranchResolutionTest, UndoRestoresADecodeRedirect)
+{
+    setupVmStateDirectory();
+    const RunResult straight = run<RV5StageProcessorHF>(kHazardProgram, true);
+
+    ResolutionGuard guard(true, BranchPredictorType::NOT_TAKEN);
+    Finishing<RV5StageProcessorHF> vm;
+    std::istringstream stream(kHazardProgram);
+    vm.LoadProgram(assemble(stream));
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int cycle = 0; cycle < 30; ++cycle)
+    {
+        vm.Step();
+    }
+    for (int cycle = 0; cycle < 20; ++cycle)
+    {
+        vm.Undo();
+    }
+    while (!vm.finished())
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.cycle_s_, straight.cycles);
+    EXPECT_EQ(vm.branch_mispredictions_, straight.mispredictions);
+    EXPECT_EQ(vm.registers_.ReadGpr(6), straight.x6);
+}
@@ -0,0 +1,297 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/rv5s/rv5s_processor_dual_issue.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+using vm_config::BranchPredictorType;
+
+namespace
+{
+
+// loads and stores, a call and a return, and a loop, with the data section at its default start
+const std::string kIntegerProgram = R"(.data
+values: .word 3, 0, 5, 7
+.text
+    lui x10, 65536
+    li x5, 6
+    li x6, 0
+    li x9, 0
+loop:
+    lw x7, 0(x10)
+    lw x8, 12(x10)
+    add x6, x6, x7
+    add x6, x6, x8
+    sw x6, 4(x10)
+    lw x11, 4(x10)
+    sub x12, x11, x5
+    jal x1, helper
+    addi x5, x5, -1
+    bne x5, x0, loop
+    j end
+helper:
+    slli x13, x12, 2
+    add x9, x9, x13
+    jalr x0, 0(x1)
+end:
+    sd x9, 8(x10)
+    ld x14, 8(x10)
+    lui x16, 5
+)";
+
+const std::string kArithmeticProgram = R"(.text
+    li x5, 12
+    li x6, -7
+    li x20, 0
+loop:
+    mul x7, x5, x6
+    mulh x8, x7, x6
+    div x11, x7, x5
+    rem x13, x7, x5
+    mulw x15, x13, x6
+    divw x16, x15, x5
+    add x20, x20, x11
+    add x20, x20, x16
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+const std::string kFloatProgram = R"(.text
+    lui x10, 65536
+    li x5, 6
+    li x6, 0
+    li x7, 3
+    fcvt.s.w f3, x7
+loop:
+    fcvt.s.w f1, x5
+    fmul.s f4, f1, f3
+    fadd.s f2, f2, f4
+    fsw f2, 0(x10)
+    flw f5, 0(x10)
+    fdiv.s f6, f5, f3
+    fsqrt.s f7, f6
+    fsub.s f14, f7, f1
+    fcvt.d.w f8, x5
+    fmul.d f9, f8, f8
+    fadd.d f10, f10, f9
+    feq.d x8, f10, f10
+    add x6, x6, x8
+    fcvt.w.s x9, f2
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+std::string independentProgram()
+{
+    std::ostringstream out;
+    out << ".text\n";
+    for (int i = 0; i < 32; ++i)
+    {
+        out << "    addi x" << 5 + i % 8 << ", x0, " << i << "\n";
+    }
+    return out.str();
+}
+
+double ipc(const ProcessorBase &vm)
+{
+    return static_cast<double>(vm.instructions_retired_) / static_cast<double>(vm.cycle_s_);
+}
+
+uint64_t singleIssues(const Finishing<RV5StageProcessorDualIssue> &vm, SingleIssueReason reason)
+{
+    return vm.GetIssueStats()->reasonCount(reason);
+}
+
+} // namespace
+
+TEST(RV5StageDualIssueTest, MatchesTheSingleCycleProcessor)
+{
+    setupVmStateDirectory();
+    for (BranchPredictorType type : {BranchPredictorType::NOT_TAKEN, BranchPredictorType::GSHARE})
+    {
+        BranchPredictorGuard guard(type);
+        expectSameRegisters<RV5StageProcessorDualIssue>(kIntegerProgram);
+        expectSameRegisters<RV5StageProcessorDualIssue>(kArithmeticProgram);
+        expectSameRegisters<RV5StageProcessorDualIssue>(kFloatProgram);
+    }
+
+    // and with the units taking a while, results coming back into either lane
+    vm_config::FunctionalUnitConfig slow;
+    slow.fp_add_latency = 3;
+    slow.fp_mul_latency = 4;
+    slow.fp_fma_latency = 5;
+    slow.fp_div_latency = 12;
+    slow.fp_sqrt_latency = 15;
+    slow.int_mul_latency = 3;
+    slow.int_div_latency = 20;
+    FunctionalUnitGuard guard(slow);
+    expectSameRegisters<RV5StageProcessorDualIssue>(kArithmeticProgram);
+    expectSameRegisters<RV5StageProcessorDualIssue>(kFloatProgram);
+}
+
+TEST(RV5StageDualIssueTest, IndependentInstructionsIssueInPairs)
+{
+    setupVmStateDirectory();
+    const std::string source = independentProgram();
+    Finishing<RV5StageProcessorDualIssue> vm;
+    runToEnd(vm, source);
+    Finishing<RV5StageProcessorHF> single;
+    runToEnd(single, source);
+
+    EXPECT_EQ(vm.instructions_retired_, 32u);
+    EXPECT_GT(ipc(vm), 1.0);
+    EXPECT_LT(ipc(single), 1.0);
+    // 16 pairs, then the pipeline drains
+    EXPECT_EQ(vm.GetIssueStats()->dualIssueCycles, 16u);
+    EXPECT_EQ(vm.GetIssueStats()->singleIssueCycles, 0u);
+    EXPECT_EQ(vm.cycle_s_, 16u + 4u);
+    EXPECT_EQ(vm.registers_.ReadGpr(12), 31u);
+}
+
+TEST(RV5StageDualIssueTest, PairingRulesIssueOneInstruction)
+{
+    setupVmStateDirectory();
+    {
+        Finishing<RV5StageProcessorDualIssue> vm;
+        runToEnd(vm, R"(.text
+    addi x5, x0, 1
+    addi x5, x5, 1
+    addi x5, x5, 1
+    addi x5, x5, 1
+)");
+        // each reads the one before, and the last has nothing behind it
+        EXPECT_EQ(singleIssues(vm, SingleIssueReason::DEPENDENCY), 3u);
+        EXPECT_EQ(singleIssues(vm, SingleIssueReason::FETCH), 1u);
+        EXPECT_EQ(vm.GetIssueStats()->dualIssueCycles, 0u);
+        EXPECT_EQ(vm.registers_.ReadGpr(5), 4u);
+    }
+    {
+        Finishing<RV5StageProcessorDualIssue> vm;
+        runToEnd(vm, R"(.text
+    lui x10, 65536
+    addi x5, x0, 1
+    sw x5, 0(x10)
+    lw x6, 0(x10)
+    addi x7, x0, 2
+    addi x8, x0, 3
+)");
+        // the store and the load share the data memory port, then lw pairs with addi
+        EXPECT_EQ(singleIssues(vm, SingleIssueReason::MEMORY_PORT), 1u);
+        EXPECT_EQ(vm.GetIssueStats()->dualIssueCycles, 2u);
+        EXPECT_EQ(vm.registers_.ReadGpr(6), 1u);
+    }
+    {
+        Finishing<RV5StageProcessorDualIssue> vm;
+        runToEnd(vm, R"(.text
+    bne x0, x0, skip
+    addi x5, x0, 1
+skip:
+    addi x6, x0, 2
+)");
+        EXPECT_EQ(singleIssues(vm, SingleIssueReason::CONTROL), 1u);
+        EXPECT_EQ(vm.GetIssueStats()->dualIssueCycles, 1u);
+    }
+    {
+        Finishing<RV5StageProcessorDualIssue> vm;
+        runToEnd(vm, R"(.text
+    lui x10, 65536
+    addi x5, x0, 1
+    lw x6, 0(x10)
+    addi x8, x0, 3
+    addi x9, x0, 4
+    add x7, x6, x6
+)");
+        // add waits on the load issued right ahead of it, addi goes on without it
+        EXPECT_EQ(singleIssues(vm, SingleIssueReason::HAZARD), 1u);
+    }
+}
+
+TEST(RV5StageDualIssueTest, DumpsTheIssueHistogram)
+{
+    setupVmStateDirectory();
+    Finishing<RV5StageProcessorDualIssue> vm;
+    runToEnd(vm, kIntegerProgram);
+    const IssueStats &stats = *vm.GetIssueStats();
+    EXPECT_GT(stats.dualIssueCycles, 0u);
+    uint64_t reasons = 0;
+    for (uint64_t count : stats.singleIssueReasons)
+    {
+        reasons += count;
+    }
+    EXPECT_EQ(reasons, stats.singleIssueCycles);
+    EXPECT_LE(stats.singleIssueCycles + stats.dualIssueCycles, vm.cycle_s_);
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "rv5s_dual_issue_state.json";
+    vm.DumpState(path);
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::filesystem::remove(path);
+    std::ostringstream histogram;
+    histogram << "\"issue_width_histogram\": ["
+              << vm.cycle_s_ - stats.singleIssueCycles - stats.dualIssueCycles << ", "
+              << stats.singleIssueCycles << ", " << stats.dualIssueCycles << "]";
+    EXPECT_NE(contents.str().find(histogram.str()), std::string::npos);
+    EXPECT_NE(contents.str().find("\"single_issue_reasons\": {\"fetch\": "), std::string::npos);
+
+    // the single-issue pipelines have nothing to report
+    RV5StageProcessorHF single;
+    EXPECT_EQ(single.GetIssueStats(), nullptr);
+}
+
+TEST(RV5StageDualIssueTest, UndoRestoresBothLanes)
+{
+    setupVmStateDirectory();
+    vm_config::FunctionalUnitConfig units;
+    units.fp_add_latency = 3;
+    units.fp_div_latency = 10;
+    FunctionalUnitGuard guard(units);
+    Finishing<RV5StageProcessorDualIssue> straight;
+    runToEnd(straight, kFloatProgram);
+
+    Finishing<RV5StageProcessorDualIssue> vm;
+    std::istringstream stream(kFloatProgram);
+    vm.LoadProgram(assemble(stream));
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int cycle = 0; cycle < 50; ++cycle)
+    {
+        vm.Step();
+    }
+    for (int cycle = 0; cycle < 20; ++cycle)
+    {
+        vm.Undo();
+    }
+    for (int cycle = 0; cycle < 5; ++cycle)
+    {
+        vm.Redo();
+    }
+    while (!vm.finished())
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.cycle_s_, straight.cycle_s_);
+    EXPECT_EQ(vm.instructions_retired_, straight.instructions_retired_);
+    EXPECT_EQ(vm.GetIssueStats()->dualIssueCycles, straight.GetIssueStats()->dualIssueCycles);
+    EXPECT_EQ(vm.GetIssueStats()->singleIssueCycles,
+              straight.GetIssueStats()->singleIssueCycles);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(vm.registers_.ReadGpr(i), straight.registers_.ReadGpr(i)) << "x" << int(i);
+        EXPECT_EQ(vm.registers_.ReadFpr(i), straight.registers_.ReadFpr(i)) << "f" << int(i);
+    }
+}
@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "config/config.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rv5s/rv5s_processor_h_nf.h"
+#include "processor/rv5s/rv5s_processor_nh_f.h"
+#include "processor/rv5s/rv5s_processor_nh_nf.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+
+namespace
+{
+
+// single and double precision computation, loads and stores, compares and moves, most of it
+// reading the result right ahead, with the data section at its default start
+const std::string kFloatProgram = R"(.text
+    lui x10, 65536
+    li x5, 6
+    li x6, 0
+    li x7, 3
+    fcvt.s.w f3, x7
+loop:
+    fcvt.s.w f1, x5
+    fmul.s f4, f1, f3
+    fadd.s f2, f2, f4
+    fsw f2, 0(x10)
+    flw f5, 0(x10)
+    fdiv.s f6, f5, f3
+    fsqrt.s f7, f6
+    fsub.s f14, f7, f1
+    fcvt.d.w f8, x5
+    fmul.d f9, f8, f8
+    fadd.d f10, f10, f9
+    fsd f10, 8(x10)
+    fld f11, 8(x10)
+    feq.d x8, f11, f10
+    add x6, x6, x8
+    fcvt.w.s x9, f2
+    addi x5, x5, -1
+    bne x5, x0, loop
+    fmv.x.w x11, f7
+    fle.s x12, f3, f2
+    fsgnj.s f12, f2, f3
+    fmin.s f13, f2, f3
+    fsqrt.d f15, f10
+    fdiv.d f16, f15, f8
+)";
+
+const std::string kFusedProgram = R"(.text
+    li x5, 3
+    li x6, 4
+    li x7, 5
+    fcvt.s.w f1, x5
+    fcvt.s.w f2, x6
+    fcvt.s.w f3, x7
+    fmadd.s f4, f1, f2, f3
+    fmsub.s f5, f4, f1, f3
+    fnmadd.s f6, f5, f1, f3
+    fnmsub.s f7, f6, f1, f3
+    fcvt.w.s x10, f4
+    fcvt.w.s x11, f5
+    fcvt.w.s x12, f6
+    fcvt.w.s x13, f7
+    fcvt.d.w f8, x5
+    fmadd.d f9, f8, f8, f8
+    fcvt.w.d x14, f9
+)";
+
+// every fadd reads the one right ahead of it
+const std::string kChainProgram = R"(.text
+    li x5, 2
+    fcvt.s.w f1, x5
+    fadd.s f2, f1, f1
+    fadd.s f3, f2, f2
+    fadd.s f4, f3, f3
+    fadd.s f5, f4, f4
+    fcvt.w.s x6, f5
+)";
+
+const std::string kIndependentProgram = R"(.text
+    li x5, 2
+    fcvt.s.w f1, x5
+    fadd.s f2, f1, f1
+    fadd.s f3, f1, f1
+    fadd.s f4, f1, f1
+    fadd.s f5, f1, f1
+    addi x6, x5, 1
+)";
+
+const std::string kDividerProgram = R"(.text
+    li x5, 7
+    fcvt.s.w f1, x5
+    fdiv.s f2, f1, f1
+    fsqrt.s f3, f1
+    addi x6, x5, 1
+)";
+
+vm_config::FunctionalUnitConfig latencies(uint64_t add, uint64_t divide)
+{
+    vm_config::FunctionalUnitConfig units;
+    units.fp_add_latency = add;
+    units.fp_div_latency = divide;
+    units.fp_sqrt_latency = divide;
+    return units;
+}
+
+} // namespace
+
+TEST(RV5StageFpPipelineTest, AllVariantsMatchTheSingleCycleProcessor)
+{
+    setupVmStateDirectory();
+    expectSameRegisters<RV5StageProcessorHF>(kFloatProgram);
+    expectSameRegisters<RV5StageProcessorHNF>(kFloatProgram);
+    expectSameRegisters<RV5StageProcessorNHF>(padded(kFloatProgram));
+    expectSameRegisters<RV5StageProcessorNHNF>(padded(kFloatProgram));
+
+    // and the same with every unit taking a while
+    vm_config::FunctionalUnitConfig slow;
+    slow.fp_add_latency = 3;
+    slow.fp_mul_latency = 4;
+    slow.fp_fma_latency = 5;
+    slow.fp_div_latency = 12;
+    slow.fp_sqrt_latency = 15;
+    FunctionalUnitGuard guard(slow);
+    expectSameRegisters<RV5StageProcessorHF>(kFloatProgram);
+    expectSameRegisters<RV5StageProcessorHNF>(kFloatProgram);
+    expectSameRegisters<RV5StageProcessorNHF>(padded(kFloatProgram, 18));
+    expectSameRegisters<RV5StageProcessorNHNF>(padded(kFloatProgram, 18));
+}
+
+TEST(RV5StageFpPipelineTest, FusedMultiplyAdd)
+{
+    setupVmStateDirectory();
+    for (uint64_t latency : {1u, 4u})
+    {
+        vm_config::FunctionalUnitConfig units;
+        units.fp_fma_latency = latency;
+        FunctionalUnitGuard guard(units);
+
+        Finishing<RV5StageProcessorHF> forwarding;
+        Finishing<RV5StageProcessorHNF> noForwarding;
+        runToEnd(forwarding, kFusedProgram);
+        runToEnd(noForwarding, kFusedProgram);
+        for (auto *registers : {&forwarding.registers_, &noForwarding.registers_})
+        {
+            EXPECT_EQ(registers->ReadGpr(10), 17u);
+            EXPECT_EQ(registers->ReadGpr(11), 46u);
+            EXPECT_EQ(static_cast<int64_t>(registers->ReadGpr(12)), -143);
+            EXPECT_EQ(registers->ReadGpr(13), 434u);
+            EXPECT_EQ(registers->ReadGpr(14), 12u);
+        }
+    }
+}
+
+TEST(RV5StageFpPipelineTest, DependentInstructionsWaitForTheLatency)
+{
+    setupVmStateDirectory();
+    const unsigned int chain = cycles<RV5StageProcessorHF>(kChainProgram);
+    const unsigned int independent = cycles<RV5StageProcessorHF>(kIndependentProgram);
+
+    FunctionalUnitGuard guard(latencies(4, 1));
+    Finishing<RV5StageProcessorHF> vm;
+    runToEnd(vm, kChainProgram);
+    EXPECT_EQ(vm.registers_.ReadGpr(6), 32u);
+    // five links from fcvt.s.w to fcvt.w.s, three cycles each, and fcvt.w.s draining
+    EXPECT_EQ(vm.cycle_s_ - chain, 18u);
+    EXPECT_EQ(vm.functional_unit_stall_cycles_, 0u);
+
+    // the fadds only wait for fcvt.s.w, then go through the pipelined adder a cycle apart, and
+    // the last one drains three cycles later
+    EXPECT_EQ(cycles<RV5StageProcessorHF>(kIndependentProgram) - independent, 6u);
+}
+
+TEST(RV5StageFpPipelineTest, TheDividerIsNotPipelined)
+{
+    setupVmStateDirectory();
+    const unsigned int quick = cycles<RV5StageProcessorHF>(kDividerProgram);
+
+    FunctionalUnitGuard guard(latencies(1, 10));
+    Finishing<RV5StageProcessorHF> vm;
+    runToEnd(vm, kDividerProgram);
+    // fsqrt waits in ID/EX until the fdiv has left the divider nine cycles later, then drains
+    // through it while addi goes on ahead
+    EXPECT_EQ(vm.functional_unit_stall_cycles_, 9u);
+    EXPECT_EQ(vm.cycle_s_ - quick, 17u);
+    EXPECT_EQ(vm.registers_.ReadFpr(2) & 0xFFFFFFFF, 0x3F800000u);
+    EXPECT_EQ(vm.registers_.ReadGpr(6), 8u);
+
+    // the same stall on the variant without hazard detection
+    Finishing<RV5StageProcessorNHF> interlocked;
+    runToEnd(interlocked, kDividerProgram);
+    EXPECT_EQ(interlocked.functional_unit_stall_cycles_, 9u);
+    EXPECT_EQ(interlocked.registers_.ReadGpr(6), 8u);
+}
+
+TEST(RV5StageFpPipelineTest, UndoRestoresTheFunctionalUnits)
+{
+    setupVmStateDirectory();
+    FunctionalUnitGuard guard(latencies(3, 10));
+    Finishing<RV5StageProcessorHF> straight;
+    runToEnd(straight, kFloatProgram);
+
+    Finishing<RV5StageProcessorHF> vm;
+    std::istringstream stream(kFloatProgram);
+    vm.LoadProgram(assemble(stream));
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int cycle = 0; cycle < 60; ++cycle)
+    {
+        vm.Step();
+    }
+    for (int cycle = 0; cycle < 25; ++cycle)
+    {
+        vm.Undo();
+    }
+    while (!vm.finished())
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.cycle_s_, straight.cycle_s_);
+    EXPECT_EQ(vm.functional_unit_stall_cycles_, straight.functional_unit_stall_cycles_);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(vm.registers_.ReadFpr(i), straight.registers_.ReadFpr(i)) << "f" << int(i);
+    }
+}
+
+TEST(RV5StageFpPipelineTest, LatenciesAreConfigurable)
+{
+    const vm_config::FunctionalUnitConfig saved = vm_config::config.getFunctionalUnits();
+    vm_config::config.modifyConfig("Execution", "fp_div_latency", "20");
+    EXPECT_EQ(vm_config::config.getFunctionalUnits().fp_div_latency, 20u);
+    EXPECT_THROW(vm_config::config.modifyConfig("Execution", "fp_mul_latency", "0"),
+                 std::invalid_argument);
+    vm_config::config.setFunctionalUnits(saved);
+}
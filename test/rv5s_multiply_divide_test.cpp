@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "config/config.h"
+#include "processor/rv5s/rv5s_processor_h_f.h"
+#include "processor/rv5s/rv5s_processor_h_nf.h"
+#include "processor/rv5s/rv5s_processor_nh_f.h"
+#include "processor/rv5s/rv5s_processor_nh_nf.h"
+#include "utils/utils.h"
+
+#include "pipeline_test_utils.h"
+
+using namespace Kites;
+using namespace Kites::test;
+
+namespace
+{
+
+vm_config::FunctionalUnitConfig units(uint64_t multiply, uint64_t divide, bool mulPipelined = true,
+                                      bool divPipelined = false)
+{
+    vm_config::FunctionalUnitConfig config;
+    config.int_mul_latency = multiply;
+    config.int_div_latency = divide;
+    config.int_mul_pipelined = mulPipelined;
+    config.int_div_pipelined = divPipelined;
+    return config;
+}
+
+// every form of multiply, divide and remainder, mostly reading the result right ahead, and a
+// loop branching on a remainder
+const std::string kArithmeticProgram = R"(.text
+    li x5, 12
+    li x6, -7
+    li x20, 0
+loop:
+    mul x7, x5, x6
+    mulh x8, x7, x6
+    mulhu x9, x7, x5
+    mulhsu x10, x6, x5
+    div x11, x7, x5
+    divu x12, x7, x6
+    rem x13, x7, x5
+    remu x14, x11, x5
+    mulw x15, x13, x6
+    divw x16, x15, x5
+    remw x17, x16, x6
+    divuw x18, x7, x5
+    remuw x19, x7, x5
+    add x20, x20, x11
+    add x20, x20, x17
+    addi x5, x5, -1
+    rem x21, x5, x5
+    addi x22, x5, -3
+    bne x22, x21, loop
+    div x23, x20, x0
+    rem x24, x20, x0
+)";
+
+// every mul reads the one right ahead of it
+const std::string kChainProgram = R"(.text
+    li x5, 3
+    mul x6, x5, x5
+    mul x7, x6, x5
+    mul x8, x7, x5
+    mul x9, x8, x5
+    addi x10, x9, 1
+)";
+
+const std::string kIndependentProgram = R"(.text
+    li x5, 3
+    mul x6, x5, x5
+    mul x7, x5, x5
+    mul x8, x5, x5
+    mul x9, x5, x5
+    addi x10, x5, 1
+)";
+
+const std::string kDivideProgram = R"(.text
+    li x5, 100
+    li x6, 7
+    div x7, x5, x6
+    rem x8, x5, x6
+    addi x9, x5, 1
+)";
+
+} // namespace
+
+TEST(RV5StageMultiplyDivideTest, AllVariantsMatchTheSingleCycleProcessor)
+{
+    setupVmStateDirectory();
+    expectSameRegisters<RV5StageProcessorHF>(kArithmeticProgram);
+    expectSameRegisters<RV5StageProcessorHNF>(kArithmeticProgram);
+    expectSameRegisters<RV5StageProcessorNHF>(padded(kArithmeticProgram, 4));
+    expectSameRegisters<RV5StageProcessorNHNF>(padded(kArithmeticProgram, 4));
+
+    FunctionalUnitGuard guard(units(3, 20));
+    expectSameRegisters<RV5StageProcessorHF>(kArithmeticProgram);
+    expectSameRegisters<RV5StageProcessorHNF>(kArithmeticProgram);
+    expectSameRegisters<RV5StageProcessorNHF>(padded(kArithmeticProgram, 22));
+    expectSameRegisters<RV5StageProcessorNHNF>(padded(kArithmeticProgram, 22));
+}
+
+TEST(RV5StageMultiplyDivideTest, DependentMultipliesWaitForTheLatency)
+{
+    setupVmStateDirectory();
+    const unsigned int chain = cycles<RV5StageProcessorHF>(kChainProgram);
+    const unsigned int independent = cycles<RV5StageProcessorHF>(kIndependentProgram);
+
+    FunctionalUnitGuard guard(units(3, 1));
+    Finishing<RV5StageProcessorHF> vm;
+    runToEnd(vm, kChainProgram);
+    EXPECT_EQ(vm.registers_.ReadGpr(10), 244u);
+    // four links from the first mul to addi, two cycles each
+    EXPECT_EQ(vm.cycle_s_ - chain, 8u);
+    EXPECT_EQ(vm.functional_unit_stall_cycles_, 0u);
+
+    // independent ones go through the multiplier a cycle apart, and addi waits while the
+    // results come back
+    Finishing<RV5StageProcessorHF> pipelined;
+    runToEnd(pipelined, kIndependentProgram);
+    EXPECT_EQ(pipelined.cycle_s_ - independent, 2u);
+    EXPECT_EQ(pipelined.functional_unit_stall_cycles_, 2u);
+    EXPECT_EQ(pipelined.registers_.ReadGpr(9), 9u);
+}
+
+TEST(RV5StageMultiplyDivideTest, WithoutForwardingResultsWaitForWriteback)
+{
+    setupVmStateDirectory();
+    const unsigned int chain = cycles<RV5StageProcessorHNF>(kChainProgram);
+
+    FunctionalUnitGuard guard(units(3, 1));
+    Finishing<RV5StageProcessorHNF> vm;
+    runToEnd(vm, kChainProgram);
+    EXPECT_EQ(vm.registers_.ReadGpr(10), 244u);
+    EXPECT_EQ(vm.cycle_s_ - chain, 8u);
+}
+
+TEST(RV5StageMultiplyDivideTest, TheDividerIsNotPipelined)
+{
+    setupVmStateDirectory();
+    const unsigned int quick = cycles<RV5StageProcessorHF>(kDivideProgram);
+
+    FunctionalUnitGuard guard(units(1, 20));
+    Finishing<RV5StageProcessorHF> vm;
+    runToEnd(vm, kDivideProgram);
+    // rem waits in ID/EX until div has left the divider, then drains through it while addi
+    // goes on ahead
+    EXPECT_EQ(vm.functional_unit_stall_cycles_, 19u);
+    EXPECT_EQ(vm.cycle_s_ - quick, 37u);
+    EXPECT_EQ(vm.registers_.ReadGpr(7), 14u);
+    EXPECT_EQ(vm.registers_.ReadGpr(8), 2u);
+    EXPECT_EQ(vm.registers_.ReadGpr(9), 101u);
+
+    // the variant without hazard detection still waits for the divider
+    Finishing<RV5StageProcessorNHF> interlocked;
+    runToEnd(interlocked, kDivideProgram);
+    EXPECT_EQ(interlocked.functional_unit_stall_cycles_, 19u);
+    EXPECT_EQ(interlocked.registers_.ReadGpr(8), 2u);
+}
+
+TEST(RV5StageMultiplyDivideTest, PipeliningIsConfigurable)
+{
+    setupVmStateDirectory();
+    {
+        FunctionalUnitGuard guard(units(1, 20, true, true));
+        Finishing<RV5StageProcessorHF> vm;
+        runToEnd(vm, kDivideProgram);
+        EXPECT_EQ(vm.functional_unit_stall_cycles_, 0u);
+        EXPECT_EQ(vm.registers_.ReadGpr(8), 2u);
+    }
+    {
+        FunctionalUnitGuard guard(units(3, 1, false));
+        Finishing<RV5StageProcessorHF> vm;
+        runToEnd(vm, kIndependentProgram);
+        // every mul after the first waits two cycles for the multiplier
+        EXPECT_EQ(vm.functional_unit_stall_cycles_, 6u);
+        EXPECT_EQ(vm.registers_.ReadGpr(9), 9u);
+    }
+}
+
+TEST(RV5StageMultiplyDivideTest, UnitsAreConfigurable)
+{
+    const vm_config::FunctionalUnitConfig saved = vm_config::config.getFunctionalUnits();
+    vm_config::config.modifyConfig("Execution", "int_mul_latency", "3");
+    vm_config::config.modifyConfig("Execution", "int_div_latency", "20");
+    vm_config::config.modifyConfig("Execution", "int_mul_pipelined", "off");
+    vm_config::config.modifyConfig("Execution", "int_div_pipelined", "on");
+    EXPECT_EQ(vm_config::config.getFunctionalUnits().int_mul_latency, 3u);
+    EXPECT_EQ(vm_config::config.getFunctionalUnits().int_div_latency, 20u);
+    EXPECT_FALSE(vm_config::config.getFunctionalUnits().int_mul_pipelined);
+    EXPECT_TRUE(vm_config::config.getFunctionalUnits().int_div_pipelined);
+    EXPECT_THROW(vm_config::config.modifyConfig("Execution", "int_div_latency", "0"),
+                 std::invalid_argument);
+    EXPECT_THROW(vm_config::config.modifyConfig("Execution", "int_mul_pipelined", "maybe"),
+                 std::invalid_argument);
+    vm_config::config.setFunctionalUnits(saved);
+}
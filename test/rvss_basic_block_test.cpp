@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+AssembledProgram assembleSource(const std::string &text)
+{
+    std::istringstream source(text);
+    return assemble(source);
+}
+
+// 3 instructions of setup, then a 5 instruction loop body starting at pc 12
+const std::string kLoopProgram = R"(.text
+    li x5, 10
+    li x6, 0
+    li x7, 3
+loop:
+    add x6, x6, x7
+    xori x6, x6, 5
+    slli x28, x6, 1
+    addi x5, x5, -1
+    bne x5, x0, loop
+)";
+
+} // namespace
+
+TEST(RVSSBasicBlockTest, LoopBodyIsOneSelfChainedBlock)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(kLoopProgram);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 0u);
+    EXPECT_EQ(vm.instructions_retired_, 3u + 10u * 5u);
+    // the setup block ends where the loop label is jumped back to, so it runs into the body
+    ASSERT_EQ(vm.block_map_.size(), 8u);
+    RVSSBasicBlock *setup = vm.block_map_[0];
+    ASSERT_NE(setup, nullptr);
+    EXPECT_EQ(setup->length, 8u);
+
+    RVSSBasicBlock *body = vm.block_map_[3];
+    ASSERT_NE(body, nullptr);
+    EXPECT_EQ(body->start_pc, 12u);
+    EXPECT_EQ(body->length, 5u);
+    EXPECT_EQ(body->taken, body);
+    EXPECT_EQ(setup->taken, body);
+}
+
+TEST(RVSSBasicBlockTest, BreakpointSplitsBlocks)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(kLoopProgram);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    // third instruction of the loop body
+    vm.AddBreakpoint(20, false);
+
+    vm.FastRun();
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+    EXPECT_EQ(vm.program_counter_, 20u);
+    EXPECT_EQ(vm.instructions_retired_, 5u);
+    ASSERT_NE(vm.block_map_[0], nullptr);
+    EXPECT_EQ(vm.block_map_[0]->length, 5u);
+
+    vm.FastRun();
+    EXPECT_EQ(vm.program_counter_, 20u);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 9u);
+    EXPECT_EQ(vm.instructions_retired_, 10u);
+}
+
+TEST(RVSSBasicBlockTest, StoreIntoTextInvalidatesOverlappingBlocks)
+{
+    setupVmStateDirectory();
+    // the loop runs twice; its first pass overwrites "addi x7, x0, 1" after the loop
+    AssembledProgram program = assembleSource(R"(.text
+    li x5, 2
+    li x9, 0x02a00393
+loop:
+    sw x9, 32(x0)
+    addi x5, x5, -1
+    bne x5, x0, loop
+    jal x0, after
+    nop
+after:
+    addi x7, x0, 1
+    addi x8, x0, 2
+)");
+
+    RVSSProcessor stepped;
+    stepped.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    while (stepped.program_counter_ < stepped.program_size_)
+    {
+        stepped.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.registers_.ReadGpr(7), stepped.registers_.ReadGpr(7));
+    EXPECT_EQ(vm.registers_.ReadGpr(8), 2u);
+    EXPECT_EQ(vm.instructions_retired_, stepped.instructions_retired_);
+
+    // the loop block itself was never written, the block after it was translated after the stores
+    ASSERT_NE(vm.block_map_[3], nullptr);
+    EXPECT_TRUE(vm.block_map_[3]->valid);
+
+    // a later store into the loop invalidates it, and its storage goes to the next translation
+    RVSSBasicBlock *loop = vm.block_map_[3];
+    vm.InvalidateDecoded(12, 4);
+    EXPECT_FALSE(loop->valid);
+    EXPECT_EQ(vm.block_map_[3], nullptr);
+    EXPECT_EQ(vm.decoded_instructions_[3].handler, nullptr);
+    EXPECT_EQ(vm.LookupBlock(12), loop);
+    EXPECT_EQ(loop->length, 3u);
+    EXPECT_TRUE(loop->valid);
+}
+
+TEST(RVSSBasicBlockTest, InvalidatedBlocksAreRecycled)
+{
+    setupVmStateDirectory();
+    // every pass rewrites the nop in its own block with the same nop
+    AssembledProgram program = assembleSource(R"(.text
+    li x5, 1000
+    li x9, 19
+loop:
+    sw x9, 16(x0)
+    addi x5, x5, -1
+    nop
+    bne x5, x0, loop
+)");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 0u);
+    EXPECT_EQ(vm.instructions_retired_, 2u + 1000u * 4u);
+    EXPECT_LE(vm.basic_blocks_.size(), 4u);
+}
+
+TEST(RVSSBasicBlockTest, LongRunsAreSplitAtMaxLength)
+{
+    setupVmStateDirectory();
+    std::string source = ".text\n";
+    for (uint32_t i = 0; i < RVSSBasicBlock::max_length + 10; ++i)
+    {
+        source += "    addi x5, x5, 1\n";
+    }
+    AssembledProgram program = assembleSource(source);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.registers_.ReadGpr(5), RVSSBasicBlock::max_length + 10u);
+    ASSERT_NE(vm.block_map_[0], nullptr);
+    EXPECT_EQ(vm.block_map_[0]->length, RVSSBasicBlock::max_length);
+
+    // a write at the end of the first block still finds it
+    vm.InvalidateDecoded(4 * (RVSSBasicBlock::max_length - 1), 4);
+    EXPECT_EQ(vm.block_map_[0], nullptr);
+    EXPECT_NE(vm.block_map_[RVSSBasicBlock::max_length], nullptr);
+}
+
+namespace
+{
+// adds a breakpoint on the instruction before the second store it sees, once the loop body has
+// been translated, standing in for one set from the GUI while the run is paused
+struct BreakpointOnStore : RVSSProcessor
+{
+    uint64_t breakpoint = 0;
+    unsigned int stores = 0;
+
+    void InvalidateDecoded(uint64_t address, uint64_t size) override
+    {
+        if (++stores == 2)
+        {
+            breakpoint = last_executed_pc_ - 4;
+            AddBreakpoint(breakpoint, false);
+        }
+        RVSSProcessor::InvalidateDecoded(address, size);
+    }
+};
+} // namespace
+
+TEST(RVSSBasicBlockTest, BreakpointAddedDuringRunSplitsBlocks)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(R"(.data
+slot: .dword 0
+.text
+    la x10, slot
+    li x5, 0
+loop:
+    addi x5, x5, 1
+    addi x6, x5, 0
+    sd x5, 0(x10)
+    li x28, 4
+    blt x5, x28, loop
+)");
+
+    BreakpointOnStore vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+    EXPECT_EQ(vm.program_counter_, vm.breakpoint);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 3u);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+AssembledProgram assembleSource(const std::string &text)
+{
+    std::istringstream source(text);
+    return assemble(source);
+}
+
+void stepToEnd(RVSSProcessor &vm)
+{
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    while (vm.program_counter_ < vm.program_size_)
+    {
+        vm.Step();
+    }
+    std::cout.rdbuf(coutBuffer);
+}
+
+const std::string kMixedProgram = R"(.data
+values: .dword 7, -3, 11, 0
+.text
+    la x10, values
+    li x5, 3
+    li x6, 0
+loop:
+    ld x7, 0(x10)
+    mul x8, x7, x5
+    add x6, x6, x8
+    sd x6, 24(x10)
+    lw x9, 24(x10)
+    lbu x11, 24(x10)
+    addi x10, x10, 8
+    addi x5, x5, -1
+    blt x0, x5, loop
+    lui x12, 0xfffff
+    auipc x13, 1
+    jal x1, target
+    addi x14, x0, 99
+target:
+    slli x15, x6, 3
+    sra x16, x12, x5
+    bgeu x15, x6, done
+    addi x17, x0, 1
+done:
+    fcvt.d.l f1, x6
+    fadd.d f2, f1, f1
+    fcvt.l.d x18, f2
+)";
+
+} // namespace
+
+TEST(RVSSDecodedInstructionTest, FastRunMatchesSteppedExecution)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(kMixedProgram);
+
+    RVSSProcessor stepped;
+    stepped.LoadProgram(program);
+    stepToEnd(stepped);
+
+    RVSSProcessor fast;
+    fast.LoadProgram(program);
+    fast.FastRun();
+
+    EXPECT_EQ(fast.program_counter_, stepped.program_counter_);
+    EXPECT_EQ(fast.instructions_retired_, stepped.instructions_retired_);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(fast.registers_.ReadGpr(i), stepped.registers_.ReadGpr(i)) << "x" << int(i);
+        EXPECT_EQ(fast.registers_.ReadFpr(i), stepped.registers_.ReadFpr(i)) << "f" << int(i);
+    }
+    const uint64_t data = vm_config::config.getDataSectionStart();
+    EXPECT_EQ(fast.memory_controller_.readDoubleWord(data + 24),
+              stepped.memory_controller_.readDoubleWord(data + 24));
+}
+
+TEST(RVSSDecodedInstructionTest, ProgramIsPredecodedAtLoad)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(".text\n    addi x5, x0, 1\n    sd x5, 0(x0)\n");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    ASSERT_EQ(vm.decoded_instructions_.size(), 2u);
+    EXPECT_EQ(vm.decoded_instructions_[0].handler, &RVSSProcessor::OpAlu);
+    EXPECT_EQ(vm.decoded_instructions_[0].rd, 5);
+    EXPECT_EQ(vm.decoded_instructions_[0].imm, 1);
+    EXPECT_EQ(vm.decoded_instructions_[1].handler, &RVSSProcessor::OpStore);
+}
+
+TEST(RVSSDecodedInstructionTest, StoreIntoTextInvalidatesRecords)
+{
+    setupVmStateDirectory();
+    // the doubleword store overwrites the first two instructions
+    AssembledProgram program = assembleSource(".text\n    addi x5, x0, 1\n    nop\n    sd x5, 0(x0)\n");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+
+    ASSERT_EQ(vm.decoded_instructions_.size(), 3u);
+    EXPECT_EQ(vm.decoded_instructions_[0].handler, nullptr);
+    EXPECT_EQ(vm.decoded_instructions_[1].handler, nullptr);
+    EXPECT_NE(vm.decoded_instructions_[2].handler, nullptr);
+}
+
+TEST(RVSSDecodedInstructionTest, RedecodesWhenTextChangesBehindTheProcessor)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(".text\n    addi x5, x0, 1\n");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    // addi x5, x0, 42 written straight to memory, as the memory editor would
+    vm.memory_controller_.writeWord_d(0, 0x02a00293);
+    vm.FastRun();
+
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 42u);
+}
+
+TEST(RVSSDecodedInstructionTest, WordInstructionsHaveHandlers)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(
+        ".text\n    li x5, 2147483647\n    nop\n    nop\n    nop\n    nop\n    nop\n    nop\n");
+    // the assembler doesn't take these yet, so they go in over the nops
+    const std::array<uint32_t, 6> words = {
+        0x0012831B, // addiw x6, x5, 1
+        0x005283BB, // addw x7, x5, x5
+        0x4050043B, // subw x8, x0, x5
+        0x005294BB, // sllw x9, x5, x5
+        0x4043551B, // sraiw x10, x6, 4
+        0x025285BB, // mulw x11, x5, x5
+    };
+
+    RVSSProcessor stepped;
+    RVSSProcessor fast;
+    for (RVSSProcessor *vm : {&stepped, &fast})
+    {
+        vm->LoadProgram(program);
+        const uint64_t first = vm->program_size_ - 4 * words.size();
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            vm->memory_controller_.writeWord_d(first + 4 * i, words[i]);
+            EXPECT_NE(vm->DecodeInstruction(words[i]).handler, &RVSSProcessor::OpFallback) << i;
+        }
+    }
+    stepToEnd(stepped);
+    fast.FastRun();
+
+    for (RVSSProcessor *vm : {&stepped, &fast})
+    {
+        EXPECT_EQ(vm->registers_.ReadGpr(6), 0xffffffff80000000u);
+        EXPECT_EQ(vm->registers_.ReadGpr(7), 0xfffffffffffffffeu);
+        EXPECT_EQ(vm->registers_.ReadGpr(8), 0xffffffff80000001u);
+        EXPECT_EQ(vm->registers_.ReadGpr(9), 0xffffffff80000000u);
+        EXPECT_EQ(vm->registers_.ReadGpr(10), 0xfffffffff8000000u);
+        EXPECT_EQ(vm->registers_.ReadGpr(11), 1u);
+    }
+}
+
+TEST(RVSSDecodedInstructionTest, SteppedHandlersRecordUndo)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(R"(.data
+slot: .dword 5
+.text
+    la x10, slot
+    li x5, 9
+    sd x5, 0(x10)
+    fcvt.d.l f1, x5
+)");
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    stepToEnd(vm);
+    const uint64_t slot = vm.registers_.ReadGpr(10);
+    ASSERT_EQ(vm.memory_controller_.readDoubleWord(slot), 9u);
+    ASSERT_NE(vm.registers_.ReadFpr(1), 0u);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    vm.Undo();
+    EXPECT_EQ(vm.registers_.ReadFpr(1), 0u);
+    vm.Undo();
+    EXPECT_EQ(vm.memory_controller_.readDoubleWord(slot), 5u);
+    vm.Undo();
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 0u);
+    vm.Redo();
+    vm.Redo();
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 9u);
+    EXPECT_EQ(vm.memory_controller_.readDoubleWord(slot), 9u);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "processor/rvss/rvss_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+// compute-bound loop: 5 instructions per iteration, no memory traffic
+std::string makeLoopProgram(unsigned int iterations)
+{
+    std::ostringstream source;
+    source << ".text\n"
+           << "    li x5, " << iterations << "\n"
+           << "    li x6, 0\n"
+           << "    li x7, 3\n"
+           << "loop:\n"
+           << "    add x6, x6, x7\n"
+           << "    xori x6, x6, 5\n"
+           << "    slli x28, x6, 1\n"
+           << "    addi x5, x5, -1\n"
+           << "    bne x5, x0, loop\n";
+    return source.str();
+}
+
+std::array<uint64_t, 32> readGprs(RVSSProcessor &vm)
+{
+    std::array<uint64_t, 32> gprs{};
+    for (size_t i = 0; i < gprs.size(); ++i)
+    {
+        gprs[i] = vm.registers_.ReadGpr(static_cast<uint8_t>(i));
+    }
+    return gprs;
+}
+
+double millionInstructionsPerSecond(unsigned int instructions,
+                                    std::chrono::steady_clock::duration elapsed)
+{
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? instructions / seconds / 1e6 : 0.0;
+}
+
+} // namespace
+
+TEST(RVSSFastRunBenchmark, MatchesSteppedExecution)
+{
+    setupVmStateDirectory();
+    std::istringstream source(makeLoopProgram(2000));
+    AssembledProgram program = assemble(source);
+
+    RVSSProcessor stepped;
+    stepped.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    const auto steppedStart = std::chrono::steady_clock::now();
+    while (stepped.program_counter_ < stepped.program_size_)
+    {
+        stepped.Step();
+    }
+    const auto steppedElapsed = std::chrono::steady_clock::now() - steppedStart;
+    std::cout.rdbuf(coutBuffer);
+
+    RVSSProcessor fast;
+    fast.LoadProgram(program);
+    const auto fastStart = std::chrono::steady_clock::now();
+    fast.FastRun();
+    const auto fastElapsed = std::chrono::steady_clock::now() - fastStart;
+
+    EXPECT_EQ(fast.program_counter_, stepped.program_counter_);
+    EXPECT_EQ(fast.instructions_retired_, stepped.instructions_retired_);
+    EXPECT_EQ(fast.cycle_s_, stepped.cycle_s_);
+    EXPECT_EQ(readGprs(fast), readGprs(stepped));
+    EXPECT_EQ(fast.output_status_, "VM_PROGRAM_END");
+
+    const double steppedMips =
+        millionInstructionsPerSecond(stepped.instructions_retired_, steppedElapsed);
+    const double fastMips = millionInstructionsPerSecond(fast.instructions_retired_, fastElapsed);
+    std::cout << "[ BENCH    ] rvss step loop: " << steppedMips << " MIPS, fast run: " << fastMips
+              << " MIPS (" << fast.instructions_retired_ << " instructions)" << std::endl;
+}
+
+TEST(RVSSFastRunBenchmark, ActiveWiresDoNotGrowWithoutAGui)
+{
+    setupVmStateDirectory();
+    std::istringstream source(makeLoopProgram(100));
+    AssembledProgram program = assemble(source);
+
+    RVSSProcessor stepped;
+    stepped.LoadProgram(program);
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    size_t mostWires = 0;
+    while (stepped.program_counter_ < stepped.program_size_)
+    {
+        stepped.Step();
+        mostWires = std::max<size_t>(mostWires, stepped.active_wires_.size());
+    }
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_LE(mostWires, stepped.always_active_wires_count_ + 2);
+
+    RVSSProcessor fast;
+    fast.LoadProgram(program);
+    fast.FastRun();
+    EXPECT_EQ(static_cast<size_t>(fast.active_wires_.size()), fast.always_active_wires_count_);
+}
+
+TEST(RVSSFastRunBenchmark, StopsAtBreakpointAndResumes)
+{
+    setupVmStateDirectory();
+    std::istringstream source(makeLoopProgram(10));
+    AssembledProgram program = assemble(source);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    // first instruction of the loop body
+    vm.AddBreakpoint(12, false);
+
+    vm.FastRun();
+    EXPECT_EQ(vm.program_counter_, 12u);
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+
+    // resuming from the breakpoint executes it once and stops on the next iteration
+    vm.FastRun();
+    EXPECT_EQ(vm.program_counter_, 12u);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 9u);
+
+    vm.RemoveBreakpoint(12, false);
+    vm.FastRun();
+    EXPECT_EQ(vm.output_status_, "VM_PROGRAM_END");
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 0u);
+}
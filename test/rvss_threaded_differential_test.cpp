@@ -0,0 +1,410 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "processor/rvss/rvss_processor.h"
+#include "processor/rvss/rvss_threaded_processor.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+AssembledProgram assembleSource(const std::string &text)
+{
+    std::istringstream source(text);
+    return assemble(source);
+}
+
+void stepToEnd(RVSSProcessor &vm)
+{
+    while (vm.program_counter_ < vm.program_size_)
+    {
+        vm.Step();
+    }
+}
+
+// runs the program stepped on RVSSProcessor and threaded on RVSSThreadedProcessor and
+// compares the architectural state, including the first dataBytes bytes of .data
+void expectSameState(const std::string &text, uint64_t dataBytes)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(text);
+
+    RVSSProcessor reference;
+    RVSSThreadedProcessor threaded;
+    reference.LoadProgram(program);
+    threaded.LoadProgram(program);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    stepToEnd(reference);
+    threaded.FastRun();
+    std::cout.rdbuf(coutBuffer);
+
+    EXPECT_EQ(threaded.output_status_, "VM_PROGRAM_END");
+    EXPECT_EQ(threaded.program_counter_, reference.program_counter_);
+    EXPECT_EQ(threaded.instructions_retired_, reference.instructions_retired_);
+    EXPECT_EQ(threaded.cycle_s_, reference.cycle_s_);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(threaded.registers_.ReadGpr(i), reference.registers_.ReadGpr(i)) << "x" << int(i);
+        EXPECT_EQ(threaded.registers_.ReadFpr(i), reference.registers_.ReadFpr(i)) << "f" << int(i);
+    }
+    EXPECT_EQ(threaded.registers_.ReadCsr(0x003), reference.registers_.ReadCsr(0x003));
+
+    // the reference may still hold dirty lines in its caches
+    reference.memory_controller_.flushCaches();
+    const uint64_t data = vm_config::config.getDataSectionStart();
+    for (uint64_t address = data; address < data + dataBytes; ++address)
+    {
+        EXPECT_EQ(threaded.memory_controller_.readByte_d(address),
+                  reference.memory_controller_.readByte_d(address))
+            << "at 0x" << std::hex << address;
+    }
+}
+
+std::string makeLoopProgram(unsigned int iterations)
+{
+    std::ostringstream source;
+    source << ".text\n"
+           << "    li x5, " << iterations << "\n"
+           << "    li x6, 0\n"
+           << "    li x7, 3\n"
+           << "loop:\n"
+           << "    add x6, x6, x7\n"
+           << "    xori x6, x6, 5\n"
+           << "    slli x28, x6, 1\n"
+           << "    addi x5, x5, -1\n"
+           << "    bne x5, x0, loop\n";
+    return source.str();
+}
+
+} // namespace
+
+TEST(RVSSThreadedDifferentialTest, IntegerAlu)
+{
+    expectSameState(R"(.text
+    li x5, -17
+    li x6, 5
+    add x7, x5, x6
+    sub x8, x5, x6
+    and x9, x5, x6
+    or x10, x5, x6
+    xor x11, x5, x6
+    sll x12, x5, x6
+    srl x13, x5, x6
+    sra x14, x5, x6
+    slt x15, x5, x6
+    sltu x16, x5, x6
+    andi x17, x5, 0x7f
+    ori x18, x6, -256
+    xori x19, x5, -1
+    slli x20, x5, 63
+    srli x21, x5, 60
+    srai x22, x5, 2
+    slti x23, x5, -20
+    sltiu x24, x6, -1
+    lui x25, 0x80000
+    auipc x26, 0xfffff
+    addi x0, x5, 1
+    add x0, x5, x6
+)",
+                    0);
+}
+
+TEST(RVSSThreadedDifferentialTest, MulDivIncludingDivisionByZero)
+{
+    expectSameState(R"(.text
+    li x5, -7
+    li x6, 3
+    li x7, 0
+    mul x8, x5, x6
+    mulh x9, x5, x6
+    mulhu x10, x5, x6
+    mulhsu x11, x5, x6
+    div x12, x5, x6
+    divu x13, x5, x6
+    rem x14, x5, x6
+    remu x15, x5, x6
+    div x16, x5, x7
+    rem x17, x5, x7
+    divu x18, x6, x7
+    remu x19, x6, x7
+)",
+                    0);
+}
+
+TEST(RVSSThreadedDifferentialTest, LoadsAndStores)
+{
+    expectSameState(R"(.data
+bytes: .dword 0x8081828384858687, 0xfffefdfcfbfaf9f8, 0, 0
+.text
+    la x10, bytes
+    lb x5, 0(x10)
+    lbu x6, 1(x10)
+    lh x7, 2(x10)
+    lhu x8, 4(x10)
+    lw x9, 8(x10)
+    lwu x11, 8(x10)
+    ld x12, 8(x10)
+    sb x5, 16(x10)
+    sh x7, 18(x10)
+    sw x9, 20(x10)
+    sd x12, 24(x10)
+    ld x13, 16(x10)
+)",
+                    32);
+}
+
+TEST(RVSSThreadedDifferentialTest, CallsAndBranches)
+{
+    // recursive sum 1..n through the stack, then every branch flavour taken and not taken
+    expectSameState(R"(.text
+    li sp, 0x20000
+    li a0, 12
+    jal ra, sum
+    mv x20, a0
+    li x5, -1
+    li x6, 1
+    blt x5, x6, l1
+    addi x21, x21, 1
+l1: bge x5, x6, l2
+    addi x21, x21, 2
+l2: bltu x5, x6, l3
+    addi x21, x21, 4
+l3: bgeu x5, x6, l4
+    addi x21, x21, 8
+l4: beq x5, x5, l5
+    addi x21, x21, 16
+l5: bne x5, x5, end
+    addi x21, x21, 32
+    j end
+sum:
+    addi sp, sp, -16
+    sd ra, 8(sp)
+    sd a0, 0(sp)
+    li t0, 1
+    bge t0, a0, base
+    addi a0, a0, -1
+    jal ra, sum
+    ld t1, 0(sp)
+    add a0, a0, t1
+    ld ra, 8(sp)
+    addi sp, sp, 16
+    jalr x0, 0(ra)
+base:
+    ld ra, 8(sp)
+    addi sp, sp, 16
+    ret
+end:
+    nop
+)",
+                    0);
+}
+
+TEST(RVSSThreadedDifferentialTest, SingleAndDoublePrecision)
+{
+    expectSameState(R"(.data
+vals: .dword 0, 0, 0, 0
+.text
+    la x10, vals
+    li x5, 7
+    li x6, -3
+    fcvt.s.l f1, x5
+    fcvt.s.l f2, x6
+    fadd.s f3, f1, f2
+    fmul.s f4, f1, f2
+    fdiv.s f5, f1, f2
+    fmadd.s f6, f1, f2, f3
+    fsqrt.s f7, f1
+    flt.s x11, f2, f1
+    feq.s x12, f1, f1
+    fsw f5, 0(x10)
+    flw f8, 0(x10)
+    fcvt.w.s x13, f5
+    fcvt.d.l f10, x5
+    fcvt.d.l f11, x6
+    fadd.d f12, f10, f11
+    fdiv.d f13, f10, f11
+    fmsub.d f14, f10, f11, f12
+    fle.d x14, f10, f11
+    fsd f13, 8(x10)
+    fld f15, 8(x10)
+    fcvt.l.d x15, f13
+    fmv.x.d x16, f13
+    fsgnjn.d f16, f10, f11
+)",
+                    16);
+}
+
+TEST(RVSSThreadedDifferentialTest, SyscallsGoThroughTheFallback)
+{
+    expectSameState(R"(.text
+    li a7, 1
+    li a0, 42
+    ecall
+    li x5, 0
+    li x6, 4
+loop:
+    addi x5, x5, 1
+    mv a0, x5
+    ecall
+    blt x5, x6, loop
+    csrrs x7, fcsr, x0
+)",
+                    0);
+}
+
+TEST(RVSSThreadedDifferentialTest, SyscallsSeeWhatTheProgramStored)
+{
+    setupVmStateDirectory();
+    // prints the buffer, overwrites it from the interpreter and prints it again, then reads
+    // into it and loads what the read left there
+    AssembledProgram program = assembleSource(R"(.data
+buffer: .string "AB"
+.text
+    la x9, buffer
+    li a7, 4
+    mv a0, x9
+    ecall
+    li x5, 88
+    sb x5, 0(x9)
+    ecall
+    li a7, 64
+    li a0, 1
+    mv a1, x9
+    li a2, 2
+    ecall
+    li a7, 63
+    li a0, 0
+    mv a1, x9
+    li a2, 3
+    ecall
+    lbu x6, 0(x9)
+    lbu x7, 1(x9)
+    sb x5, 1(x9)
+    li a7, 4
+    mv a0, x9
+    ecall
+)");
+
+    RVSSProcessor reference;
+    RVSSThreadedProcessor threaded;
+    reference.LoadProgram(program);
+    threaded.LoadProgram(program);
+    reference.PushInput("yz");
+    threaded.PushInput("yz");
+
+    std::ostringstream referenceOutput;
+    std::ostringstream threadedOutput;
+    std::streambuf *coutBuffer = std::cout.rdbuf(referenceOutput.rdbuf());
+    stepToEnd(reference);
+    std::cout.rdbuf(threadedOutput.rdbuf());
+    threaded.FastRun();
+    std::cout.rdbuf(coutBuffer);
+
+    // stepping reports every instruction, only the program's own output is compared
+    const auto programOutput = [](const std::ostringstream &output)
+    {
+        std::istringstream lines(output.str());
+        std::string kept;
+        for (std::string line; std::getline(lines, line);)
+        {
+            if (line.starts_with("[Syscall output: ") || line.starts_with("VM_STDOUT_START"))
+            {
+                kept += line + "\n";
+            }
+        }
+        return kept;
+    };
+    EXPECT_EQ(programOutput(referenceOutput), "[Syscall output: AB]\n"
+                                              "[Syscall output: XB]\n"
+                                              "VM_STDOUT_STARTXBVM_STDOUT_END\n"
+                                              "[Syscall output: yX]\n");
+    EXPECT_EQ(programOutput(threadedOutput), programOutput(referenceOutput));
+    EXPECT_EQ(threaded.registers_.ReadGpr(6), uint64_t{'y'});
+    EXPECT_EQ(threaded.registers_.ReadGpr(7), uint64_t{'z'});
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(threaded.registers_.ReadGpr(i), reference.registers_.ReadGpr(i)) << "x" << int(i);
+    }
+}
+
+TEST(RVSSThreadedDifferentialTest, StopsAtBreakpointAndResumes)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(makeLoopProgram(10));
+
+    RVSSThreadedProcessor vm;
+    vm.LoadProgram(program);
+    vm.AddBreakpoint(12, false);
+
+    vm.FastRun();
+    EXPECT_EQ(vm.program_counter_, 12u);
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+    EXPECT_EQ(vm.instructions_retired_, 3u);
+
+    vm.FastRun();
+    EXPECT_EQ(vm.program_counter_, 12u);
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 9u);
+
+    vm.RemoveBreakpoint(12, false);
+    vm.FastRun();
+    EXPECT_EQ(vm.output_status_, "VM_PROGRAM_END");
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 0u);
+    EXPECT_EQ(vm.instructions_retired_, 3u + 10u * 5u);
+}
+
+TEST(RVSSThreadedDifferentialTest, StoreIntoTextIsRetranslated)
+{
+    setupVmStateDirectory();
+    // overwrites "addi x6, x0, 1" with "addi x6, x0, 42" before reaching it
+    AssembledProgram program = assembleSource(R"(.text
+    li x5, 0x02a00313
+    sw x5, 12(x0)
+    addi x6, x0, 1
+)");
+
+    RVSSThreadedProcessor vm;
+    vm.LoadProgram(program);
+    vm.FastRun();
+    EXPECT_EQ(vm.registers_.ReadGpr(6), 42u);
+}
+
+TEST(RVSSThreadedDifferentialTest, MatchesDecodedFastRun)
+{
+    setupVmStateDirectory();
+    AssembledProgram program = assembleSource(makeLoopProgram(200000));
+
+    RVSSProcessor decoded;
+    decoded.LoadProgram(program);
+    const auto decodedStart = std::chrono::steady_clock::now();
+    decoded.FastRun();
+    const auto decodedElapsed = std::chrono::steady_clock::now() - decodedStart;
+
+    RVSSThreadedProcessor threaded;
+    threaded.LoadProgram(program);
+    const auto threadedStart = std::chrono::steady_clock::now();
+    threaded.FastRun();
+    const auto threadedElapsed = std::chrono::steady_clock::now() - threadedStart;
+
+    EXPECT_EQ(threaded.instructions_retired_, decoded.instructions_retired_);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        EXPECT_EQ(threaded.registers_.ReadGpr(i), decoded.registers_.ReadGpr(i)) << "x" << int(i);
+    }
+
+    const auto mips = [](unsigned int instructions, std::chrono::steady_clock::duration elapsed)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0.0 ? instructions / seconds / 1e6 : 0.0;
+    };
+    std::cout << "[ BENCH    ] rvss fast run: " << mips(decoded.instructions_retired_, decodedElapsed)
+              << " MIPS, threaded: " << mips(threaded.instructions_retired_, threadedElapsed)
+              << " MIPS (" << threaded.instructions_retired_ << " instructions)" << std::endl;
+}
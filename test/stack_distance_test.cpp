@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "processor/cache/cache.h"
+#include "processor/cache/stack_distance.h"
+#include "processor/main_memory.h"
+
+using namespace Kites;
+
+namespace
+{
+
+struct Access
+{
+    uint64_t address;
+    bool write;
+};
+
+// aligned word accesses: a hot 2 KiB region, a 48 KiB stream and scattered stragglers
+std::vector<Access> makeAccesses(size_t count)
+{
+    std::vector<Access> accesses;
+    accesses.reserve(count);
+    uint64_t state = 12345;
+    uint64_t stream = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint64_t random = state >> 33;
+        uint64_t offset = 0;
+        switch (random % 4)
+        {
+        case 0:
+        case 1:
+            offset = random % 2048;
+            break;
+        case 2:
+            stream = (stream + 24) % (48 * 1024);
+            offset = 4096 + stream;
+            break;
+        default:
+            offset = 65536 + (random % (512 * 1024));
+            break;
+        }
+        accesses.push_back({0x10000 + (offset & ~uint64_t{3}), (random & 0x100) != 0});
+    }
+    return accesses;
+}
+
+uint64_t simulateLruHits(const std::vector<Access> &accesses, size_t sets, size_t lineSize,
+                         size_t ways)
+{
+    MainMemory memory;
+    Cache cache(memory, sets, lineSize, ways, WritePolicy::WriteBack,
+                AllocationPolicy::WriteAllocate, ReplacementPolicy::LRU);
+    for (const Access &access : accesses)
+    {
+        if (access.write)
+            cache.writeWord(access.address, 0);
+        else
+            (void)cache.readWord(access.address);
+    }
+    return cache.getHitCount();
+}
+
+} // namespace
+
+TEST(StackDistanceTest, CountsDistinctLinesSinceThePreviousAccess)
+{
+    StackDistanceAnalyzer analyzer(16, 2, 4);
+    // lines A B C A B D A
+    for (uint64_t line : {0, 1, 2, 0, 1, 3, 0})
+    {
+        analyzer.access(line * 16, 4);
+    }
+    EXPECT_EQ(analyzer.getAccessCount(), 7u);
+    EXPECT_EQ(analyzer.getColdMissCount(), 4u);
+    EXPECT_EQ(analyzer.hitCount(1, 2), 0u);
+    EXPECT_EQ(analyzer.hitCount(1, 3), 3u);
+    // two sets: A C | B D, so A C A A and B B D
+    EXPECT_EQ(analyzer.hitCount(2, 1), 2u);
+    EXPECT_EQ(analyzer.hitCount(2, 2), 3u);
+
+    // a word straddling two lines touches both
+    analyzer.access(14, 4);
+    EXPECT_EQ(analyzer.getAccessCount(), 9u);
+
+    EXPECT_THROW((void)analyzer.hitCount(8, 2), std::out_of_range);
+    EXPECT_THROW((void)analyzer.hitCount(2, 5), std::out_of_range);
+    EXPECT_THROW(StackDistanceAnalyzer(24), std::invalid_argument);
+}
+
+TEST(StackDistanceTest, MatchesSimulatedLruCachesOfEverySize)
+{
+    const std::vector<Access> accesses = makeAccesses(150'000);
+    for (size_t lineSize : {16, 64})
+    {
+        StackDistanceAnalyzer analyzer(lineSize, 6, 8);
+        for (const Access &access : accesses)
+        {
+            analyzer.access(access.address, 4);
+        }
+        for (size_t sets : {1, 2, 8, 64})
+        {
+            for (size_t ways : {1, 2, 4, 8})
+            {
+                EXPECT_EQ(analyzer.hitCount(sets, ways),
+                          simulateLruHits(accesses, sets, lineSize, ways))
+                    << sets << " sets, " << ways << " ways, " << lineSize << " byte lines";
+            }
+        }
+        // fully associative distances have no depth limit
+        EXPECT_EQ(analyzer.hitCount(1, 512), simulateLruHits(accesses, 1, lineSize, 512));
+
+        const std::vector<MissRatioPoint> curve = analyzer.fullyAssociativeCurve();
+        ASSERT_FALSE(curve.empty());
+        EXPECT_EQ(curve.back().missCount, analyzer.getColdMissCount());
+        for (size_t i = 1; i < curve.size(); ++i)
+        {
+            EXPECT_LE(curve[i].missCount, curve[i - 1].missCount);
+            EXPECT_EQ(curve[i].capacityInBytes, 2 * curve[i - 1].capacityInBytes);
+        }
+        EXPECT_EQ(analyzer.setAssociativeCurve(4).size(), 7u);
+    }
+}
+
+TEST(StackDistanceTest, OnePassIsFasterThanSimulatingEachSize)
+{
+    const std::vector<Access> accesses = makeAccesses(300'000);
+
+    const auto analysisStart = std::chrono::steady_clock::now();
+    StackDistanceAnalyzer analyzer(64, 8, 16);
+    for (const Access &access : accesses)
+    {
+        analyzer.access(access.address, 4);
+    }
+    uint64_t analysisHits = 0;
+    for (size_t sets = 1; sets <= 256; sets *= 2)
+    {
+        for (size_t ways = 1; ways <= 16; ways *= 2)
+        {
+            analysisHits += analyzer.hitCount(sets, ways);
+        }
+    }
+    const double analysisSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - analysisStart).count();
+
+    const auto simulationStart = std::chrono::steady_clock::now();
+    uint64_t simulationHits = 0;
+    for (size_t sets = 1; sets <= 256; sets *= 2)
+    {
+        for (size_t ways = 1; ways <= 16; ways *= 2)
+        {
+            simulationHits += simulateLruHits(accesses, sets, 64, ways);
+        }
+    }
+    const double simulationSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - simulationStart).count();
+
+    EXPECT_EQ(analysisHits, simulationHits);
+    std::cout << "[ BENCH    ] 45 LRU configurations: stack distance pass " << analysisSeconds
+              << " s, one simulation each " << simulationSeconds << " s" << std::endl;
+}
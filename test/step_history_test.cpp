@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "assembler/assembler.h"
+#include "common/undo_buffer.h"
+#include "processor/rvss/rvss_processor.h"
+#include "processor/step_history.h"
+#include "utils/utils.h"
+
+using namespace Kites;
+
+namespace
+{
+
+StepDelta makeDelta(uint64_t pc, size_t memoryBytes = 0)
+{
+    StepDelta delta;
+    delta.old_pc = pc;
+    delta.new_pc = pc + 4;
+    delta.old_cycle = static_cast<unsigned int>(pc);
+    delta.new_cycle = static_cast<unsigned int>(pc + 1);
+    delta.register_changes.push_back({5, 0, pc, pc * 2});
+    delta.register_changes.push_back({0x003, 1, 0, 1});
+    if (memoryBytes > 0)
+    {
+        std::vector<uint8_t> oldBytes(memoryBytes, 0xAA);
+        std::vector<uint8_t> newBytes(memoryBytes, static_cast<uint8_t>(pc));
+        delta.memory_changes.push_back({0x10000000 + pc, oldBytes, newBytes});
+    }
+    return delta;
+}
+
+} // namespace
+
+TEST(StepHistoryTest, UndoAndRedoRoundTrip)
+{
+    StepHistory history(8, 4096);
+    history.push(makeDelta(0, 8));
+    history.push(makeDelta(4));
+
+    StepDelta delta;
+    ASSERT_TRUE(history.undo(delta));
+    EXPECT_EQ(delta.old_pc, 4u);
+    EXPECT_EQ(delta.memory_changes.size(), 0u);
+    ASSERT_EQ(delta.register_changes.size(), 2u);
+    EXPECT_EQ(delta.register_changes[0].new_value, 8u);
+    EXPECT_EQ(delta.register_changes[1].reg_index, 0x003u);
+    EXPECT_EQ(delta.register_changes[1].reg_type, 1u);
+
+    ASSERT_TRUE(history.undo(delta));
+    EXPECT_EQ(delta.old_pc, 0u);
+    EXPECT_EQ(delta.new_pc, 4u);
+    EXPECT_EQ(delta.new_cycle, 1u);
+    ASSERT_EQ(delta.memory_changes.size(), 1u);
+    EXPECT_EQ(delta.memory_changes[0].address, 0x10000000u);
+    EXPECT_EQ(delta.memory_changes[0].old_bytes_vec, std::vector<uint8_t>(8, 0xAA));
+    EXPECT_EQ(delta.memory_changes[0].new_bytes_vec, std::vector<uint8_t>(8, 0));
+    EXPECT_FALSE(history.undo(delta));
+
+    ASSERT_TRUE(history.redo(delta));
+    EXPECT_EQ(delta.old_pc, 0u);
+    ASSERT_TRUE(history.redo(delta));
+    EXPECT_EQ(delta.old_pc, 4u);
+    EXPECT_FALSE(history.redo(delta));
+}
+
+TEST(StepHistoryTest, PushDiscardsRedo)
+{
+    StepHistory history(8, 4096);
+    history.push(makeDelta(0));
+    history.push(makeDelta(4));
+
+    StepDelta delta;
+    ASSERT_TRUE(history.undo(delta));
+    EXPECT_EQ(history.redoDepth(), 1u);
+    history.push(makeDelta(100));
+    EXPECT_EQ(history.redoDepth(), 0u);
+    EXPECT_EQ(history.undoDepth(), 2u);
+    ASSERT_TRUE(history.undo(delta));
+    EXPECT_EQ(delta.old_pc, 100u);
+}
+
+TEST(StepHistoryTest, DepthIsBounded)
+{
+    StepHistory history(4, 4096);
+    for (uint64_t pc = 0; pc < 40; pc += 4)
+    {
+        history.push(makeDelta(pc));
+    }
+    EXPECT_EQ(history.undoDepth(), 4u);
+
+    StepDelta delta;
+    for (uint64_t pc = 36; pc >= 24; pc -= 4)
+    {
+        ASSERT_TRUE(history.undo(delta));
+        EXPECT_EQ(delta.old_pc, pc);
+    }
+    EXPECT_FALSE(history.undo(delta));
+}
+
+TEST(StepHistoryTest, MemoryIsBoundedAndOldestStepsAreDropped)
+{
+    const size_t recordSize = StepHistory::encodedSize(makeDelta(0, 100));
+    // room for three and a half records
+    StepHistory history(1000, recordSize * 7 / 2);
+    for (uint64_t pc = 0; pc < 400; pc += 4)
+    {
+        history.push(makeDelta(pc, 100));
+        EXPECT_LE(history.bytesUsed(), history.memoryCap());
+    }
+    EXPECT_EQ(history.memoryCap(), recordSize * 7 / 2);
+    EXPECT_GE(history.undoDepth(), 2u);
+    EXPECT_LE(history.undoDepth(), 3u);
+
+    // the newest steps survive, intact, across arena wrap-arounds
+    StepDelta delta;
+    uint64_t pc = 396;
+    while (history.undo(delta))
+    {
+        EXPECT_EQ(delta.old_pc, pc);
+        ASSERT_EQ(delta.memory_changes.size(), 1u);
+        EXPECT_EQ(delta.memory_changes[0].new_bytes_vec,
+                  std::vector<uint8_t>(100, static_cast<uint8_t>(pc)));
+        pc -= 4;
+    }
+}
+
+TEST(StepHistoryTest, EncodedSizeIsWhatPushWrites)
+{
+    StepHistory history(8, 4096);
+    size_t expected = 0;
+    for (size_t memoryBytes : {size_t{0}, size_t{1}, size_t{100}})
+    {
+        const StepDelta delta = makeDelta(memoryBytes * 4, memoryBytes);
+        history.push(delta);
+        expected += StepHistory::encodedSize(delta);
+        EXPECT_EQ(history.bytesUsed(), expected) << memoryBytes << " bytes of memory";
+    }
+}
+
+TEST(StepHistoryTest, OversizedStepClearsHistory)
+{
+    StepHistory history(8, 256);
+    history.push(makeDelta(0));
+    history.push(makeDelta(4, 512));
+    EXPECT_EQ(history.undoDepth(), 0u);
+    EXPECT_EQ(history.redoDepth(), 0u);
+}
+
+TEST(StepHistoryTest, StorageIsAllocatedOnTheFirstPush)
+{
+    StepHistory history(100000, 16 << 20);
+    EXPECT_EQ(history.bytesAllocated(), 0u);
+    EXPECT_EQ(history.maxDepth(), 100000u);
+    EXPECT_EQ(history.memoryCap(), size_t{16 << 20});
+
+    history.push(makeDelta(0));
+    EXPECT_GE(history.bytesAllocated(), size_t{16 << 20});
+    EXPECT_EQ(history.undoDepth(), 1u);
+
+    history.configure(8, 4096);
+    EXPECT_EQ(history.bytesAllocated(), 0u);
+    history.push(makeDelta(0));
+    history.push(makeDelta(4));
+    StepDelta delta;
+    ASSERT_TRUE(history.undo(delta));
+    EXPECT_EQ(delta.old_pc, 4u);
+}
+
+TEST(UndoBufferTest, CapacityIsTheConfiguredDepth)
+{
+    UndoBuffer<int> buffer(3);
+    EXPECT_EQ(buffer.capacity(), 3u);
+    for (int i = 0; i < 5; ++i)
+    {
+        buffer.push(i);
+    }
+    EXPECT_EQ(buffer.current(), 4);
+    EXPECT_EQ(buffer.undo()->get(), 3);
+    EXPECT_EQ(buffer.undo()->get(), 2);
+    EXPECT_FALSE(buffer.undo().has_value());
+    EXPECT_EQ(buffer.redo()->get(), 3);
+
+    buffer.setCapacity(2);
+    EXPECT_EQ(buffer.capacity(), 2u);
+    EXPECT_FALSE(buffer.canUndo());
+}
+
+TEST(StepHistoryTest, RVSSUndoIsBoundedAndFastRunRecordsNothing)
+{
+    setupVmStateDirectory();
+    std::istringstream source(".text\n    li x5, 0\nloop:\n    addi x5, x5, 1\n    j loop\n");
+    AssembledProgram program = assemble(source);
+
+    RVSSProcessor vm;
+    vm.LoadProgram(program);
+    vm.history_.configure(4, 1 << 16);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 9; ++i)
+    {
+        vm.Step();
+    }
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 4u);
+    for (int i = 0; i < 4; ++i)
+    {
+        vm.Undo();
+    }
+    EXPECT_EQ(vm.output_status_, "VM_UNDO_COMPLETED");
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 2u);
+    vm.Undo();
+    EXPECT_EQ(vm.output_status_, "VM_NO_MORE_UNDO");
+    vm.Redo();
+    EXPECT_EQ(vm.registers_.ReadGpr(5), 3u);
+
+    vm.AddBreakpoint(4, false);
+    vm.FastRun();
+    vm.FastRun();
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(vm.output_status_, "VM_BREAKPOINT_HIT");
+    EXPECT_EQ(vm.history_.undoDepth(), 0u);
+    EXPECT_EQ(vm.history_.redoDepth(), 0u);
+    EXPECT_TRUE(vm.current_delta_.register_changes.empty());
+    EXPECT_TRUE(vm.record_history_);
+}